@@ -1946,6 +1946,30 @@ slurm_load_slurmd_status(slurmd_status_t **slurmd_status_ptr)
 	return SLURM_SUCCESS;
 }
 
+/* Format the non-empty buckets of a slurmd launch latency histogram */
+static char *_launch_hist_str(uint32_t *hist, uint32_t cnt)
+{
+	char *str = NULL, *sep = "";
+	uint32_t i;
+
+	for (i = 0; i < cnt; i++) {
+		if (!hist[i])
+			continue;
+		if (i == 0)
+			xstrfmtcat(str, "%s<1ms:%u", sep, hist[i]);
+		else if (i == (cnt - 1))
+			xstrfmtcat(str, "%s>=%ums:%u", sep, 1 << (i - 1),
+				   hist[i]);
+		else
+			xstrfmtcat(str, "%s%u-%ums:%u", sep, 1 << (i - 1),
+				   1 << i, hist[i]);
+		sep = " ";
+	}
+	if (!str)
+		str = xstrdup("NONE");
+	return str;
+}
+
 /*
  * slurm_print_slurmd_status - output the contents of slurmd status
  *	message as loaded using slurm_load_slurmd_status
@@ -1955,7 +1979,7 @@ slurm_load_slurmd_status(slurmd_status_t **slurmd_status_ptr)
 void slurm_print_slurmd_status (FILE* out,
 				slurmd_status_t * slurmd_status_ptr)
 {
-	char time_str[32];
+	char time_str[32], *tmp_str;
 
 	if (slurmd_status_ptr == NULL )
 		return ;
@@ -1993,12 +2017,24 @@ void slurm_print_slurmd_status (FILE* out,
 	} else
 		fprintf(out, "Last slurmctld msg time  = NONE\n");
 
+	tmp_str = _launch_hist_str(slurmd_status_ptr->launch_hist_new,
+				   slurmd_status_ptr->launch_hist_cnt);
+	fprintf(out, "Launch latency new       = %s\n", tmp_str);
+	xfree(tmp_str);
+	tmp_str = _launch_hist_str(slurmd_status_ptr->launch_hist_pooled,
+				   slurmd_status_ptr->launch_hist_cnt);
+	fprintf(out, "Launch latency pooled    = %s\n", tmp_str);
+	xfree(tmp_str);
+
 	fprintf(out, "Slurmd PID               = %u\n",
 		slurmd_status_ptr->pid);
 	fprintf(out, "Slurmd Debug             = %u\n",
 		slurmd_status_ptr->slurmd_debug);
 	fprintf(out, "Slurmd Logfile           = %s\n",
 		slurmd_status_ptr->slurmd_logfile);
+	fprintf(out, "Slurmstepd pool          = %u/%u idle\n",
+		slurmd_status_ptr->stepd_pool_idle,
+		slurmd_status_ptr->stepd_pool_size);
 	fprintf(out, "Version                  = %s\n",
 		slurmd_status_ptr->version);
 	return;
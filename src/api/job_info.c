@@ -1050,6 +1050,7 @@ _load_cluster_jobs(slurm_msg_t *req_msg, job_info_msg_t **job_info_msg_pptr,
 
 	switch (resp_msg.msg_type) {
 	case RESPONSE_JOB_INFO:
+	case RESPONSE_JOB_INFO_DELTA:
 		*job_info_msg_pptr = (job_info_msg_t *)resp_msg.data;
 		resp_msg.data = NULL;
 		break;
@@ -1344,6 +1345,42 @@ slurm_load_jobs (time_t update_time, job_info_msg_t **job_info_msg_pptr,
 	return rc;
 }
 
+/*
+ * slurm_load_jobs_delta - issue RPC to get slurm job information for the
+ *	local cluster changed since update_time
+ * IN update_time - last_update of the previous job information
+ * IN/OUT job_info_msg_pptr - place to store a job configuration pointer
+ * IN show_flags - job filtering options
+ * RET 0 or -1 on error, errno is SLURM_PROTOCOL_VERSION_ERROR if the
+ *	slurmctld is too old to send deltas, use slurm_load_jobs() then
+ * NOTE: free the response using slurm_free_job_info_msg
+ */
+extern int slurm_load_jobs_delta(time_t update_time,
+				 job_info_msg_t **job_info_msg_pptr,
+				 uint16_t show_flags)
+{
+	slurm_msg_t req_msg;
+	job_info_request_msg_t req;
+
+	if (working_cluster_rec &&
+	    (working_cluster_rec->rpc_version <
+	     SLURM_20_02_EXT_PROTOCOL_VERSION)) {
+		*job_info_msg_pptr = NULL;
+		slurm_seterrno(SLURM_PROTOCOL_VERSION_ERROR);
+		return SLURM_ERROR;
+	}
+
+	slurm_msg_t_init(&req_msg);
+	memset(&req, 0, sizeof(req));
+	req.last_update  = update_time;
+	req.show_flags   = (show_flags | SHOW_LOCAL) & (~SHOW_FEDERATION);
+	req_msg.msg_type = REQUEST_JOB_INFO_DELTA;
+	req_msg.data     = &req;
+
+	return _load_cluster_jobs(&req_msg, job_info_msg_pptr,
+				  working_cluster_rec);
+}
+
 /*
  * slurm_load_job_user - issue RPC to get slurm information about all jobs
  *	to be run as the specified user
@@ -77,6 +77,19 @@
 
 #define MAX_THREADS      8	/* These can be huge messages, so
 				 * only run MAX_THREADS at one time */
+#define MAX_WINDOW      64	/* blocks in flight when pipelined */
+
+/* State shared by the threads of a pipelined broadcast */
+typedef struct {
+	struct bcast_parameters *params;
+	file_bcast_msg_t *bcast_msg;	/* fields common to all blocks */
+	uint32_t block_cnt;
+	uint32_t next_block;		/* next block for a window thread */
+	pthread_mutex_t mutex;
+	int rc;				/* first error, stops the window */
+	uint64_t size_compressed;
+	uint32_t time_compression;
+} bcast_window_t;
 
 int block_len;				/* block size */
 int fd;					/* source file descriptor */
@@ -212,7 +225,9 @@ static int _file_bcast(struct bcast_parameters *params,
 		error("REQUEST_FILE_BCAST(%s): %s",
 		      ret_data_info->node_name,
 		      slurm_strerror(msg_rc));
-		rc = MAX(rc, msg_rc);
+		/* SLURM_ERROR is negative, keep it over success */
+		if ((rc == SLURM_SUCCESS) || (msg_rc > rc))
+			rc = msg_rc;
 	}
 	list_iterator_destroy(itr);
 	FREE_NULL_LIST(ret_list);
@@ -244,69 +259,79 @@ static int _get_block_none(char **buffer, int *orig_len, bool *more)
 	return size;
 }
 
-static int _get_block_zlib(struct bcast_parameters *params,
-			   char **buffer,
-			   int *orig_len,
-			   bool *more)
-{
 #if HAVE_LIBZ
-	static z_stream strm;
+/* compress len bytes at in into out (of size out_len) as one zlib stream,
+ * return the compressed size or -1 on error */
+static int _deflate_block(void *in, int len, char *out, int out_len)
+{
+	z_stream strm;
 	int chunk = (256 * 1024);
-	int flush = Z_NO_FLUSH;
+	int flush = Z_NO_FLUSH, chunk_bite;
 
-	static int64_t remaining = -1;
-	static int max_out;
-	static void *position;
-	int chunk_remaining, out_remaining, chunk_bite, size = 0;
-
-	/* allocate deflate state, compress each block independently */
 	strm.zalloc = Z_NULL;
 	strm.zfree = Z_NULL;
 	strm.opaque = Z_NULL;
 	strm.avail_in = 0;
 	strm.next_in = Z_NULL;
-	if (deflateInit(&strm, Z_DEFAULT_COMPRESSION) != Z_OK) {
-		error("File compression configuration error,"
-		      "sending uncompressed file.");
-		params->compress = 0;
-		return _get_block_none(buffer, orig_len, more);
+	if (deflateInit(&strm, Z_DEFAULT_COMPRESSION) != Z_OK)
+		return -1;
+
+	strm.next_out = (void *) out;
+	strm.avail_out = out_len;
+	while (len) {
+		strm.next_in = in;
+		chunk_bite = MIN(chunk, len);
+		strm.avail_in = chunk_bite;
+
+		if (len <= chunk)
+			flush = Z_FINISH;
+
+		if (deflate(&strm, flush) == Z_STREAM_ERROR)
+			fatal("Error compressing file");
+
+		in += chunk_bite;
+		len -= chunk_bite;
 	}
+	(void) deflateEnd(&strm);
+
+	return (out_len - strm.avail_out);
+}
+#endif
+
+static int _get_block_zlib(struct bcast_parameters *params,
+			   char **buffer,
+			   int *orig_len,
+			   bool *more)
+{
+#if HAVE_LIBZ
+	static int64_t remaining = -1;
+	static int max_out;
+	static void *position;
+	int size, size_out;
 
 	/* first pass through, initialize */
 	if (remaining < 0) {
 		remaining = f_stat.st_size;
-		max_out = deflateBound(&strm, block_len);
+		max_out = compressBound(block_len);
 		*buffer = xmalloc(max_out);
 		position = src;
 	}
 
-	chunk_remaining = MIN(block_len, remaining);
-	out_remaining = max_out;
-	strm.next_out = (void *) *buffer;
-	while (chunk_remaining) {
-		strm.next_in = position;
-		chunk_bite = MIN(chunk, chunk_remaining);
-		strm.avail_in = chunk_bite;
-		strm.avail_out = out_remaining;
-
-		if (chunk_remaining <= chunk)
-			flush = Z_FINISH;
-
-		if (deflate(&strm, flush) == Z_STREAM_ERROR)
-			fatal("Error compressing file");
-
-		position += chunk_bite;
-		size += chunk_bite;
-		chunk_remaining -= chunk_bite;
-		out_remaining = strm.avail_out;
+	/* compress each block independently */
+	size = MIN(block_len, remaining);
+	if ((size_out = _deflate_block(position, size, *buffer,
+				       max_out)) < 0) {
+		error("File compression configuration error,"
+		      "sending uncompressed file.");
+		params->compress = 0;
+		return _get_block_none(buffer, orig_len, more);
 	}
+	position += size;
 	remaining -= size;
 
-	(void) deflateEnd(&strm);
-
 	*orig_len = size;
 	*more = (remaining) ? true : false;
-	return (max_out - out_remaining);
+	return size_out;
 #else
 	info("zlib compression not supported, sending uncompressed file.");
 	params->compress = 0;
@@ -379,6 +404,160 @@ static int _next_block(struct bcast_parameters *params,
 	return _get_block_none(buffer, orig_len, more);
 }
 
+/*
+ * Compress len bytes at in for a pipelined broadcast, compressing each block
+ * independently of the others so blocks may be compressed in any order.
+ * Set *buffer to the compressed data (or NULL to send the data at in as is)
+ * and return its length.
+ */
+static int _compress_block(struct bcast_parameters *params, char *in,
+			   int len, char **buffer)
+{
+	int size_out = -1;
+
+	*buffer = NULL;
+	switch (params->compress) {
+#if HAVE_LIBZ
+	case COMPRESS_ZLIB:
+		size_out = compressBound(len);
+		*buffer = xmalloc_nz(size_out);
+		size_out = _deflate_block(in, len, *buffer, size_out);
+		break;
+#endif
+#if HAVE_LZ4
+	case COMPRESS_LZ4:
+		size_out = LZ4_compressBound(len);
+		*buffer = xmalloc_nz(size_out);
+		size_out = LZ4_compress_default(in, *buffer, len, size_out);
+		break;
+#endif
+	}
+	if (size_out <= 0)
+		fatal("Error compressing file");
+
+	return size_out;
+}
+
+/* Compress and send one block of a pipelined broadcast */
+static void _window_send_block(bcast_window_t *window, uint32_t block_no)
+{
+	struct bcast_parameters *params = window->params;
+	file_bcast_msg_t bcast_msg = *window->bcast_msg;
+	uint64_t offset = (uint64_t) (block_no - 1) * block_len;
+	int32_t orig_len = MIN(block_len, f_stat.st_size - offset);
+	char *buffer = NULL;
+	int rc;
+	DEF_TIMERS;
+
+	START_TIMER;
+	if (params->compress)
+		bcast_msg.block_len = _compress_block(params, src + offset,
+						      orig_len, &buffer);
+	else
+		bcast_msg.block_len = orig_len;
+	END_TIMER;
+	debug("block %u, size %u", block_no, bcast_msg.block_len);
+
+	/* uncompressed data is packed straight from the mmap'd file */
+	bcast_msg.block = buffer ? buffer : (char *) src + offset;
+	bcast_msg.block_no = block_no;
+	bcast_msg.block_offset = offset;
+	bcast_msg.compress = params->compress;
+	bcast_msg.uncomp_len = orig_len;
+	bcast_msg.last_block = (block_no == window->block_cnt);
+
+	rc = _file_bcast(params, &bcast_msg, sbcast_cred);
+	xfree(buffer);
+
+	slurm_mutex_lock(&window->mutex);
+	window->size_compressed += bcast_msg.block_len;
+	window->time_compression += DELTA_TIMER;
+	if (rc && !window->rc)
+		window->rc = rc;
+	slurm_mutex_unlock(&window->mutex);
+}
+
+static void *_window_thread(void *arg)
+{
+	bcast_window_t *window = arg;
+	uint32_t block_no;
+
+	while (1) {
+		slurm_mutex_lock(&window->mutex);
+		if (window->rc || (window->next_block >= window->block_cnt)) {
+			slurm_mutex_unlock(&window->mutex);
+			break;
+		}
+		block_no = window->next_block++;
+		slurm_mutex_unlock(&window->mutex);
+
+		_window_send_block(window, block_no);
+	}
+
+	return NULL;
+}
+
+/*
+ * Broadcast the file with up to params->window blocks in flight, each
+ * compressed and sent by its own thread. The first block creates the file
+ * on the compute nodes, so it is sent before any other, and the last block
+ * closes it, so it is sent after all others are written. Blocks in between
+ * may be written in any order.
+ */
+static int _bcast_file_window(struct bcast_parameters *params,
+			      file_bcast_msg_t *bcast_msg,
+			      uint64_t *size_compressed,
+			      uint32_t *time_compression)
+{
+	bcast_window_t window;
+	pthread_t *threads;
+	int i, thread_cnt;
+
+	switch (params->compress) {
+	case COMPRESS_OFF:
+		break;
+#if HAVE_LIBZ
+	case COMPRESS_ZLIB:
+		break;
+#endif
+#if HAVE_LZ4
+	case COMPRESS_LZ4:
+		break;
+#endif
+	default:
+		info("File compression type %u not supported,"
+		     " sending uncompressed file.", params->compress);
+		params->compress = 0;
+	}
+
+	memset(&window, 0, sizeof(window));
+	window.params = params;
+	window.bcast_msg = bcast_msg;
+	window.block_cnt = (f_stat.st_size + block_len - 1) / block_len;
+	window.next_block = 2;
+	slurm_mutex_init(&window.mutex);
+
+	_window_send_block(&window, 1);
+
+	thread_cnt = MIN(params->window, window.block_cnt - 2);
+	threads = xcalloc(thread_cnt, sizeof(pthread_t));
+	for (i = 0; (i < thread_cnt) && !window.rc; i++)
+		slurm_thread_create(&threads[i], _window_thread, &window);
+	thread_cnt = i;
+	for (i = 0; i < thread_cnt; i++)
+		pthread_join(threads[i], NULL);
+	xfree(threads);
+
+	if (!window.rc)
+		_window_send_block(&window, window.block_cnt);
+
+	slurm_mutex_destroy(&window.mutex);
+	*size_compressed = window.size_compressed;
+	*time_compression = window.time_compression;
+
+	return window.rc;
+}
+
 /* read and broadcast the file */
 static int _bcast_file(struct bcast_parameters *params)
 {
@@ -416,6 +595,21 @@ static int _bcast_file(struct bcast_parameters *params)
 		params->fanout = MAX_THREADS;
 	slurm_set_tree_width(MIN(MAX_THREADS, params->fanout));
 
+	if (params->window > MAX_WINDOW)
+		params->window = MAX_WINDOW;
+	/* Older slurmd daemons write blocks in the order they arrive */
+	if ((params->window > 1) &&
+	    (sbcast_cred->protocol_version < SLURM_20_02_EXT_PROTOCOL_VERSION)) {
+		verbose("Some nodes have an older slurmd, sending blocks in order");
+		params->window = 1;
+	}
+	if ((params->window > 1) && (f_stat.st_size > (2 * block_len))) {
+		size_uncompressed = f_stat.st_size;
+		rc = _bcast_file_window(params, &bcast_msg, &size_compressed,
+					&time_compression);
+		more = false;
+	}
+
 	while (more) {
 		START_TIMER;
 		bcast_msg.block_len = _next_block(params, &buffer, &orig_len,
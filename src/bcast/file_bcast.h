@@ -53,6 +53,7 @@ struct bcast_parameters {
 	uint32_t step_id;
 	int timeout;
 	int verbose;
+	uint32_t window;		/* blocks in flight, serial if <= 1 */
 };
 
 typedef struct file_bcast_info {
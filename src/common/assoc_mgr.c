@@ -45,13 +45,19 @@
 #include <ctype.h>
 
 #include "src/common/uid.h"
+#include "src/common/xhash.h"
 #include "src/common/xstring.h"
 #include "src/common/slurm_priority.h"
 #include "src/common/slurmdbd_pack.h"
 #include "src/slurmdbd/read_config.h"
 
+/*
+ * The association hash tables start at ASSOC_HASH_SIZE buckets and are
+ * grown to at least twice the number of associations, so chains stay short
+ * on sites with many thousands of associations.
+ */
 #define ASSOC_HASH_SIZE 1000
-#define ASSOC_HASH_ID_INX(_assoc_id)	(_assoc_id % ASSOC_HASH_SIZE)
+#define ASSOC_HASH_ID_INX(_assoc_id)	(_assoc_id % assoc_hash_size)
 
 slurmdb_assoc_rec_t *assoc_mgr_root_assoc = NULL;
 uint32_t g_qos_max_priority = 0;
@@ -77,8 +83,26 @@ static pthread_mutex_t assoc_lock_init = PTHREAD_MUTEX_INITIALIZER;
 static assoc_init_args_t init_setup;
 static slurmdb_assoc_rec_t **assoc_hash_id = NULL;
 static slurmdb_assoc_rec_t **assoc_hash = NULL;
+static uint32_t assoc_hash_size = ASSOC_HASH_SIZE;
+static uint32_t assoc_hash_cnt = 0;
 static int *assoc_mgr_tres_old_pos = NULL;
 
+/*
+ * Indexes into assoc_mgr_user_list (by uid and by lower case name) and
+ * assoc_mgr_qos_list (by id and by lower case name). They are rebuilt
+ * whenever the lists are replaced or have records added, removed or renamed,
+ * under the same write lock as the list itself.
+ */
+typedef struct {
+	char *name;	/* lower case copy of the record's name */
+	void *rec;	/* slurmdb_user_rec_t or slurmdb_qos_rec_t */
+} assoc_mgr_name_inx_t;
+
+static xhash_t *user_uid_hash = NULL;
+static xhash_t *user_name_hash = NULL;
+static xhash_t *qos_id_hash = NULL;
+static xhash_t *qos_name_hash = NULL;
+
 static bool _running_cache(void)
 {
 	if (init_setup.running_cache && *init_setup.running_cache)
@@ -122,24 +146,57 @@ static int _assoc_hash_index(slurmdb_assoc_rec_t *assoc)
 	if (assoc->partition)
 		index += _get_str_inx(assoc->partition);
 
-	index %= ASSOC_HASH_SIZE;
+	index %= (int) assoc_hash_size;
 	if (index < 0)
-		index += ASSOC_HASH_SIZE;
+		index += assoc_hash_size;
 
 	return index;
 
 }
 
+static void _add_assoc_hash(slurmdb_assoc_rec_t *assoc);
+
+/* Rebuild both association hash tables with new_size buckets */
+static void _resize_assoc_hash(uint32_t new_size)
+{
+	slurmdb_assoc_rec_t **old_hash_id = assoc_hash_id;
+	slurmdb_assoc_rec_t *assoc, *next;
+	uint32_t i, old_size = assoc_hash_size;
+
+	xfree(assoc_hash);
+	assoc_hash_id = NULL;
+	assoc_hash_size = new_size;
+	assoc_hash_cnt = 0;
+
+	if (!old_hash_id)
+		return;
+
+	/* Every association is on exactly one chain of the id table */
+	for (i = 0; i < old_size; i++) {
+		for (assoc = old_hash_id[i]; assoc; assoc = next) {
+			next = assoc->assoc_next_id;
+			_add_assoc_hash(assoc);
+		}
+	}
+	xfree(old_hash_id);
+}
+
 static void _add_assoc_hash(slurmdb_assoc_rec_t *assoc)
 {
-	int inx = ASSOC_HASH_ID_INX(assoc->id);
+	int inx;
+
+	if (assoc_hash_cnt >= (assoc_hash_size * 2))
+		_resize_assoc_hash(assoc_hash_size * 4);
+
+	inx = ASSOC_HASH_ID_INX(assoc->id);
 
 	if (!assoc_hash_id)
-		assoc_hash_id = xcalloc(ASSOC_HASH_SIZE,
+		assoc_hash_id = xcalloc(assoc_hash_size,
 					sizeof(slurmdb_assoc_rec_t *));
 	if (!assoc_hash)
-		assoc_hash = xcalloc(ASSOC_HASH_SIZE,
+		assoc_hash = xcalloc(assoc_hash_size,
 				     sizeof(slurmdb_assoc_rec_t *));
+	assoc_hash_cnt++;
 
 	assoc->assoc_next_id = assoc_hash_id[inx];
 	assoc_hash_id[inx] = assoc;
@@ -314,6 +371,159 @@ static void _delete_assoc_hash(slurmdb_assoc_rec_t *assoc)
 		return;	/* Fix CLANG false positive error */
 	} else
 		*assoc_pptr = assoc_ptr->assoc_next;
+
+	if (assoc_hash_cnt)
+		assoc_hash_cnt--;
+}
+
+static void _name_inx_free(void *x)
+{
+	assoc_mgr_name_inx_t *name_inx = x;
+
+	xfree(name_inx->name);
+	xfree(name_inx);
+}
+
+static void _name_inx_id(void *item, const char **key, uint32_t *key_len)
+{
+	assoc_mgr_name_inx_t *name_inx = item;
+
+	*key = name_inx->name;
+	*key_len = strlen(name_inx->name);
+}
+
+static void _user_uid_id(void *item, const char **key, uint32_t *key_len)
+{
+	slurmdb_user_rec_t *user = item;
+
+	*key = (const char *) &user->uid;
+	*key_len = sizeof(user->uid);
+}
+
+static void _qos_id_id(void *item, const char **key, uint32_t *key_len)
+{
+	slurmdb_qos_rec_t *qos = item;
+
+	*key = (const char *) &qos->id;
+	*key_len = sizeof(qos->id);
+}
+
+/* Add rec to a name index, the first record added under a name wins */
+static void _add_name_inx(xhash_t *table, char *name, void *rec)
+{
+	assoc_mgr_name_inx_t *name_inx;
+	char *lower;
+
+	if (!name)
+		return;
+
+	lower = xstrdup(name);
+	xstrtolower(lower);
+	if (xhash_get_str(table, lower)) {
+		xfree(lower);
+		return;
+	}
+
+	name_inx = xmalloc(sizeof(*name_inx));
+	name_inx->name = lower;
+	name_inx->rec = rec;
+	xhash_add(table, name_inx);
+}
+
+static void *_find_name_inx(xhash_t *table, char *name)
+{
+	assoc_mgr_name_inx_t *name_inx;
+	char *lower;
+
+	if (!table || !name)
+		return NULL;
+
+	lower = xstrdup(name);
+	xstrtolower(lower);
+	name_inx = xhash_get_str(table, lower);
+	xfree(lower);
+
+	return name_inx ? name_inx->rec : NULL;
+}
+
+/* NOTE: USER_LOCK write lock needs to be set before calling this. */
+static void _rebuild_user_hash(void)
+{
+	slurmdb_user_rec_t *user;
+	ListIterator itr;
+
+	xhash_free(user_uid_hash);
+	xhash_free(user_name_hash);
+
+	if (!assoc_mgr_user_list)
+		return;
+
+	user_uid_hash = xhash_init(_user_uid_id, NULL);
+	user_name_hash = xhash_init(_name_inx_id, _name_inx_free);
+
+	itr = list_iterator_create(assoc_mgr_user_list);
+	while ((user = list_next(itr))) {
+		/*
+		 * Several user names can map to one uid; keep the first one
+		 * in list order, as a linear scan of the list would.
+		 */
+		if ((user->uid != NO_VAL) &&
+		    !xhash_get(user_uid_hash, (char *) &user->uid,
+			       sizeof(user->uid)))
+			xhash_add(user_uid_hash, user);
+		_add_name_inx(user_name_hash, user->name, user);
+	}
+	list_iterator_destroy(itr);
+}
+
+static slurmdb_user_rec_t *_find_user_rec_uid(uint32_t uid)
+{
+	if (!user_uid_hash || (uid == NO_VAL))
+		return NULL;
+
+	return xhash_get(user_uid_hash, (char *) &uid, sizeof(uid));
+}
+
+static slurmdb_user_rec_t *_find_user_rec_name(char *name)
+{
+	return _find_name_inx(user_name_hash, name);
+}
+
+/* NOTE: QOS_LOCK write lock needs to be set before calling this. */
+static void _rebuild_qos_hash(void)
+{
+	slurmdb_qos_rec_t *qos;
+	ListIterator itr;
+
+	xhash_free(qos_id_hash);
+	xhash_free(qos_name_hash);
+
+	if (!assoc_mgr_qos_list)
+		return;
+
+	qos_id_hash = xhash_init(_qos_id_id, NULL);
+	qos_name_hash = xhash_init(_name_inx_id, _name_inx_free);
+
+	itr = list_iterator_create(assoc_mgr_qos_list);
+	while ((qos = list_next(itr))) {
+		if (!xhash_get(qos_id_hash, (char *) &qos->id, sizeof(qos->id)))
+			xhash_add(qos_id_hash, qos);
+		_add_name_inx(qos_name_hash, qos->name, qos);
+	}
+	list_iterator_destroy(itr);
+}
+
+static slurmdb_qos_rec_t *_find_qos_rec_id(uint32_t id)
+{
+	if (!qos_id_hash)
+		return NULL;
+
+	return xhash_get(qos_id_hash, (char *) &id, sizeof(id));
+}
+
+static slurmdb_qos_rec_t *_find_qos_rec_name(char *name)
+{
+	return _find_name_inx(qos_name_hash, name);
 }
 
 
@@ -702,24 +912,19 @@ static void _set_user_default_acct(slurmdb_assoc_rec_t *assoc)
 
 	/* set up the default if this is it */
 	if ((assoc->is_def == 1) && (assoc->uid != NO_VAL)) {
-		slurmdb_user_rec_t *user = NULL;
-		ListIterator user_itr =
-			list_iterator_create(assoc_mgr_user_list);
-		while ((user = list_next(user_itr))) {
-			if (user->uid != assoc->uid)
-				continue;
-			if (!user->default_acct
-			    || xstrcmp(user->default_acct, assoc->acct)) {
-				xfree(user->default_acct);
-				user->default_acct = xstrdup(assoc->acct);
-				debug2("user %s default acct is %s",
-				       user->name, user->default_acct);
-			}
-			/* cache user rec reference for backfill*/
-			assoc->user_rec = user;
-			break;
+		slurmdb_user_rec_t *user = _find_user_rec_uid(assoc->uid);
+
+		if (!user)
+			return;
+		if (!user->default_acct
+		    || xstrcmp(user->default_acct, assoc->acct)) {
+			xfree(user->default_acct);
+			user->default_acct = xstrdup(assoc->acct);
+			debug2("user %s default acct is %s",
+			       user->name, user->default_acct);
 		}
-		list_iterator_destroy(user_itr);
+		/* cache user rec reference for backfill*/
+		assoc->user_rec = user;
 	}
 }
 
@@ -732,22 +937,17 @@ static void _set_user_default_wckey(slurmdb_wckey_rec_t *wckey)
 
 	/* set up the default if this is it */
 	if ((wckey->is_def == 1) && (wckey->uid != NO_VAL)) {
-		slurmdb_user_rec_t *user = NULL;
-		ListIterator user_itr =
-			list_iterator_create(assoc_mgr_user_list);
-		while ((user = list_next(user_itr))) {
-			if (user->uid != wckey->uid)
-				continue;
-			if (!user->default_wckey
-			    || xstrcmp(user->default_wckey, wckey->name)) {
-				xfree(user->default_wckey);
-				user->default_wckey = xstrdup(wckey->name);
-				debug2("user %s default wckey is %s",
-				       user->name, user->default_wckey);
-			}
-			break;
+		slurmdb_user_rec_t *user = _find_user_rec_uid(wckey->uid);
+
+		if (!user)
+			return;
+		if (!user->default_wckey
+		    || xstrcmp(user->default_wckey, wckey->name)) {
+			xfree(user->default_wckey);
+			user->default_wckey = xstrdup(wckey->name);
+			debug2("user %s default wckey is %s",
+			       user->name, user->default_wckey);
 		}
-		list_iterator_destroy(user_itr);
 	}
 }
 
@@ -1039,6 +1239,10 @@ static int _post_assoc_list(void)
 
 	xfree(assoc_hash_id);
 	xfree(assoc_hash);
+	assoc_hash_cnt = 0;
+	assoc_hash_size = ASSOC_HASH_SIZE;
+	while (assoc_hash_size < (list_count(assoc_mgr_assoc_list) * 2))
+		assoc_hash_size *= 2;
 
 	itr = list_iterator_create(assoc_mgr_assoc_list);
 
@@ -1668,6 +1872,7 @@ static int _get_assoc_mgr_qos_list(void *db_conn, int enforce)
 
 	FREE_NULL_LIST(assoc_mgr_qos_list);
 	assoc_mgr_qos_list = new_list;
+	_rebuild_qos_hash();
 	new_list = NULL;
 
 	_post_qos_list(assoc_mgr_qos_list);
@@ -1691,6 +1896,7 @@ static int _get_assoc_mgr_user_list(void *db_conn, int enforce)
 	assoc_mgr_user_list = acct_storage_g_get_users(db_conn, uid, &user_q);
 
 	if (!assoc_mgr_user_list) {
+		_rebuild_user_hash();
 		assoc_mgr_unlock(&locks);
 		if (enforce & ACCOUNTING_ENFORCE_ASSOCS) {
 			error("_get_assoc_mgr_user_list: "
@@ -1702,6 +1908,7 @@ static int _get_assoc_mgr_user_list(void *db_conn, int enforce)
 	}
 
 	_post_user_list(assoc_mgr_user_list);
+	_rebuild_user_hash();
 
 	assoc_mgr_unlock(&locks);
 	return SLURM_SUCCESS;
@@ -1916,9 +2123,7 @@ static int _refresh_assoc_mgr_qos_list(void *db_conn, int enforce)
 		ListIterator itr = list_iterator_create(current_qos);
 
 		while ((curr_qos = list_next(itr))) {
-			if (!(qos_rec = list_find_first(assoc_mgr_qos_list,
-							slurmdb_find_qos_in_list,
-							&curr_qos->id)))
+			if (!(qos_rec = _find_qos_rec_id(curr_qos->id)))
 				continue;
 			slurmdb_destroy_qos_usage(curr_qos->usage);
 			curr_qos->usage = qos_rec->usage;
@@ -1929,6 +2134,7 @@ static int _refresh_assoc_mgr_qos_list(void *db_conn, int enforce)
 	}
 
 	assoc_mgr_qos_list = current_qos;
+	_rebuild_qos_hash();
 
 	assoc_mgr_unlock(&locks);
 
@@ -1962,6 +2168,7 @@ static int _refresh_assoc_mgr_user_list(void *db_conn, int enforce)
 	FREE_NULL_LIST(assoc_mgr_user_list);
 
 	assoc_mgr_user_list = current_users;
+	_rebuild_user_hash();
 
 	assoc_mgr_unlock(&locks);
 
@@ -2137,6 +2344,12 @@ extern int assoc_mgr_fini(bool save_state)
 
 	xfree(assoc_hash_id);
 	xfree(assoc_hash);
+	assoc_hash_cnt = 0;
+	assoc_hash_size = ASSOC_HASH_SIZE;
+	xhash_free(user_uid_hash);
+	xhash_free(user_name_hash);
+	xhash_free(qos_id_hash);
+	xhash_free(qos_name_hash);
 
 	assoc_mgr_unlock(&locks);
 
@@ -2641,7 +2854,6 @@ extern int assoc_mgr_fill_in_user(void *db_conn, slurmdb_user_rec_t *user,
 				  slurmdb_user_rec_t **user_pptr,
 				  bool locked)
 {
-	ListIterator itr = NULL;
 	slurmdb_user_rec_t * found_user = NULL;
 	assoc_mgr_lock_t locks = { .user = READ_LOCK };
 
@@ -2663,16 +2875,10 @@ extern int assoc_mgr_fill_in_user(void *db_conn, slurmdb_user_rec_t *user,
 		return SLURM_SUCCESS;
 	}
 
-	itr = list_iterator_create(assoc_mgr_user_list);
-	while ((found_user = list_next(itr))) {
-		if (user->uid != NO_VAL) {
-			if (user->uid == found_user->uid)
-				break;
-		} else if (user->name
-			   && !xstrcasecmp(user->name, found_user->name))
-			break;
-	}
-	list_iterator_destroy(itr);
+	if (user->uid != NO_VAL)
+		found_user = _find_user_rec_uid(user->uid);
+	else
+		found_user = _find_user_rec_name(user->name);
 
 	if (!found_user) {
 		if (!locked)
@@ -2718,7 +2924,6 @@ extern int assoc_mgr_fill_in_qos(void *db_conn, slurmdb_qos_rec_t *qos,
 				 int enforce,
 				 slurmdb_qos_rec_t **qos_pptr, bool locked)
 {
-	ListIterator itr = NULL;
 	slurmdb_qos_rec_t * found_qos = NULL;
 	assoc_mgr_lock_t locks = { .qos = READ_LOCK };
 
@@ -2753,14 +2958,8 @@ extern int assoc_mgr_fill_in_qos(void *db_conn, slurmdb_qos_rec_t *qos,
 		return SLURM_SUCCESS;
 	}
 
-	itr = list_iterator_create(assoc_mgr_qos_list);
-	while ((found_qos = list_next(itr))) {
-		if (qos->id == found_qos->id)
-			break;
-		else if (qos->name && !xstrcasecmp(qos->name, found_qos->name))
-			break;
-	}
-	list_iterator_destroy(itr);
+	if (!(found_qos = _find_qos_rec_id(qos->id)))
+		found_qos = _find_qos_rec_name(qos->name);
 
 	if (!found_qos) {
 		if (!locked)
@@ -3034,7 +3233,6 @@ extern int assoc_mgr_fill_in_wckey(void *db_conn, slurmdb_wckey_rec_t *wckey,
 extern slurmdb_admin_level_t assoc_mgr_get_admin_level(void *db_conn,
 						       uint32_t uid)
 {
-	ListIterator itr = NULL;
 	slurmdb_user_rec_t * found_user = NULL;
 	assoc_mgr_lock_t locks = { .user = READ_LOCK };
 	slurmdb_admin_level_t level = SLURMDB_ADMIN_NOTSET;
@@ -3049,14 +3247,7 @@ extern slurmdb_admin_level_t assoc_mgr_get_admin_level(void *db_conn,
 		return SLURMDB_ADMIN_NOTSET;
 	}
 
-	itr = list_iterator_create(assoc_mgr_user_list);
-	while ((found_user = list_next(itr))) {
-		if (uid == found_user->uid)
-			break;
-	}
-	list_iterator_destroy(itr);
-
-	if (found_user)
+	if ((found_user = _find_user_rec_uid(uid)))
 		level = found_user->admin_level;
 
 	assoc_mgr_unlock(&locks);
@@ -3086,12 +3277,7 @@ extern bool assoc_mgr_is_user_acct_coord(void *db_conn,
 		return false;
 	}
 
-	itr = list_iterator_create(assoc_mgr_user_list);
-	while ((found_user = list_next(itr))) {
-		if (uid == found_user->uid)
-			break;
-	}
-	list_iterator_destroy(itr);
+	found_user = _find_user_rec_uid(uid);
 
 	if (!found_user || !found_user->coord_accts) {
 		assoc_mgr_unlock(&locks);
@@ -4305,6 +4491,7 @@ extern int assoc_mgr_update_users(slurmdb_update_object_t *update, bool locked)
 
 	ListIterator itr = NULL;
 	int rc = SLURM_SUCCESS;
+	bool rebuild_hash = false;
 	uid_t pw_uid;
 	assoc_mgr_lock_t locks = { .assoc = WRITE_LOCK, .user = WRITE_LOCK,
 				   .wckey = WRITE_LOCK };
@@ -4353,6 +4540,7 @@ extern int assoc_mgr_update_users(slurmdb_update_object_t *update, bool locked)
 				rec->name = object->name;
 				object->name = NULL;
 				rc = _change_user_name(rec);
+				rebuild_hash = true;
 			}
 
 			if (object->default_acct) {
@@ -4384,6 +4572,7 @@ extern int assoc_mgr_update_users(slurmdb_update_object_t *update, bool locked)
 				object->uid = pw_uid;
 			list_append(assoc_mgr_user_list, object);
 			object = NULL;
+			rebuild_hash = true;
 			break;
 		case SLURMDB_REMOVE_USER:
 			if (!rec) {
@@ -4391,6 +4580,7 @@ extern int assoc_mgr_update_users(slurmdb_update_object_t *update, bool locked)
 				break;
 			}
 			list_delete_item(itr);
+			rebuild_hash = true;
 			break;
 		case SLURMDB_ADD_COORD:
 			/* same as SLURMDB_REMOVE_COORD */
@@ -4416,6 +4606,8 @@ extern int assoc_mgr_update_users(slurmdb_update_object_t *update, bool locked)
 		slurmdb_destroy_user_rec(object);
 	}
 	list_iterator_destroy(itr);
+	if (rebuild_hash)
+		_rebuild_user_hash();
 	if (!locked)
 		assoc_mgr_unlock(&locks);
 
@@ -4432,6 +4624,7 @@ extern int assoc_mgr_update_qos(slurmdb_update_object_t *update, bool locked)
 	slurmdb_assoc_rec_t *assoc = NULL;
 	int rc = SLURM_SUCCESS;
 	bool resize_qos_bitstr = 0;
+	bool rebuild_hash = false;
 	int redo_priority = 0;
 	List remove_list = NULL;
 	List update_list = NULL;
@@ -4470,6 +4663,7 @@ extern int assoc_mgr_update_qos(slurmdb_update_object_t *update, bool locked)
 			assoc_mgr_set_qos_tres_cnt(object);
 
 			list_append(assoc_mgr_qos_list, object);
+			rebuild_hash = true;
 /* 			char *tmp = get_qos_complete_str_bitstr( */
 /* 				assoc_mgr_qos_list, */
 /* 				object->preempt_bitstr); */
@@ -4768,6 +4962,7 @@ extern int assoc_mgr_update_qos(slurmdb_update_object_t *update, bool locked)
 				list_append(remove_list, rec);
 			} else
 				list_delete_item(itr);
+			rebuild_hash = true;
 
 			if (!assoc_mgr_assoc_list)
 				break;
@@ -4839,6 +5034,8 @@ extern int assoc_mgr_update_qos(slurmdb_update_object_t *update, bool locked)
 		_post_qos_list(assoc_mgr_qos_list);
 
 	list_iterator_destroy(itr);
+	if (rebuild_hash)
+		_rebuild_qos_hash();
 
 	if (!locked)
 		assoc_mgr_unlock(&locks);
@@ -5341,14 +5538,14 @@ extern int dump_assoc_mgr_state(void)
 	buffer = init_buf(high_buffer_size);
 
 	/* write header: version, time */
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
 	pack_time(time(NULL), buffer);
 
 	assoc_mgr_lock(&locks);
 	if (assoc_mgr_tres_list) {
 		memset(&msg, 0, sizeof(dbd_list_msg_t));
 		msg.my_list = assoc_mgr_tres_list;
-		slurmdbd_pack_list_msg(&msg, SLURM_PROTOCOL_VERSION,
+		slurmdbd_pack_list_msg(&msg, SLURM_STATE_PROTOCOL_VERSION,
 				       DBD_ADD_TRES, buffer);
 	}
 
@@ -5402,7 +5599,7 @@ extern int dump_assoc_mgr_state(void)
 	buffer = init_buf(high_buffer_size);
 
 	/* write header: version, time */
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
 	pack_time(time(NULL), buffer);
 
 	if (assoc_mgr_user_list) {
@@ -5410,7 +5607,7 @@ extern int dump_assoc_mgr_state(void)
 		msg.my_list = assoc_mgr_user_list;
 		/* let us know what to unpack */
 		pack16(DBD_ADD_USERS, buffer);
-		slurmdbd_pack_list_msg(&msg, SLURM_PROTOCOL_VERSION,
+		slurmdbd_pack_list_msg(&msg, SLURM_STATE_PROTOCOL_VERSION,
 				       DBD_ADD_USERS, buffer);
 	}
 
@@ -5419,7 +5616,7 @@ extern int dump_assoc_mgr_state(void)
 		msg.my_list = assoc_mgr_res_list;
 		/* let us know what to unpack */
 		pack16(DBD_ADD_RES, buffer);
-		slurmdbd_pack_list_msg(&msg, SLURM_PROTOCOL_VERSION,
+		slurmdbd_pack_list_msg(&msg, SLURM_STATE_PROTOCOL_VERSION,
 				       DBD_ADD_RES, buffer);
 	}
 
@@ -5428,7 +5625,7 @@ extern int dump_assoc_mgr_state(void)
 		msg.my_list = assoc_mgr_qos_list;
 		/* let us know what to unpack */
 		pack16(DBD_ADD_QOS, buffer);
-		slurmdbd_pack_list_msg(&msg, SLURM_PROTOCOL_VERSION,
+		slurmdbd_pack_list_msg(&msg, SLURM_STATE_PROTOCOL_VERSION,
 				       DBD_ADD_QOS, buffer);
 	}
 
@@ -5437,7 +5634,7 @@ extern int dump_assoc_mgr_state(void)
 		msg.my_list = assoc_mgr_wckey_list;
 		/* let us know what to unpack */
 		pack16(DBD_ADD_WCKEYS, buffer);
-		slurmdbd_pack_list_msg(&msg, SLURM_PROTOCOL_VERSION,
+		slurmdbd_pack_list_msg(&msg, SLURM_STATE_PROTOCOL_VERSION,
 				       DBD_ADD_WCKEYS, buffer);
 	}
 	/* this needs to be done last so qos is set up
@@ -5447,7 +5644,7 @@ extern int dump_assoc_mgr_state(void)
 		msg.my_list = assoc_mgr_assoc_list;
 		/* let us know what to unpack */
 		pack16(DBD_ADD_ASSOCS, buffer);
-		slurmdbd_pack_list_msg(&msg, SLURM_PROTOCOL_VERSION,
+		slurmdbd_pack_list_msg(&msg, SLURM_STATE_PROTOCOL_VERSION,
 				       DBD_ADD_ASSOCS, buffer);
 	}
 
@@ -5501,7 +5698,7 @@ extern int dump_assoc_mgr_state(void)
 
 	buffer = init_buf(high_buffer_size);
 	/* write header: version, time */
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
 	pack_time(time(NULL), buffer);
 
 	if (assoc_mgr_assoc_list) {
@@ -5572,7 +5769,7 @@ extern int dump_assoc_mgr_state(void)
 
 	buffer = init_buf(high_buffer_size);
 	/* write header: version, time */
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
 	pack_time(time(NULL), buffer);
 
 	if (assoc_mgr_qos_list) {
@@ -5999,6 +6196,7 @@ extern int load_assoc_mgr_state(bool only_tres)
 			FREE_NULL_LIST(assoc_mgr_user_list);
 			assoc_mgr_user_list = msg->my_list;
 			_post_user_list(assoc_mgr_user_list);
+			_rebuild_user_hash();
 			debug("Recovered %u users",
 			      list_count(assoc_mgr_user_list));
 			msg->my_list = NULL;
@@ -6038,6 +6236,7 @@ extern int load_assoc_mgr_state(bool only_tres)
 			FREE_NULL_LIST(assoc_mgr_qos_list);
 			assoc_mgr_qos_list = msg->my_list;
 			_post_qos_list(assoc_mgr_qos_list);
+			_rebuild_qos_hash();
 			debug("Recovered %u qos",
 			      list_count(assoc_mgr_qos_list));
 			msg->my_list = NULL;
@@ -6203,6 +6402,7 @@ extern int assoc_mgr_set_missing_uids()
 			}
 		}
 		list_iterator_destroy(itr);
+		_rebuild_user_hash();
 	}
 	assoc_mgr_unlock(&locks);
 
@@ -49,10 +49,17 @@
 #include "src/common/bitstring.h"
 #include "src/common/log.h"
 #include "src/common/macros.h"
+#include "src/common/slab.h"
 #include "src/common/xassert.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
+#if defined(__x86_64__) && !defined(SLURM_BIGENDIAN) && \
+    (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ >= 8)))
+#  define BIT_SIMD 1
+#  include <immintrin.h>
+#endif
+
 /* word of the bitstring bit is in */
 #define	_bit_word(bit) 		(((bit) >> BITSTR_SHIFT) + BITSTR_OVERHEAD)
 
@@ -146,6 +153,8 @@ strong_alias(bit_fill_gaps,	slurm_bit_fill_gaps);
 strong_alias(bit_super_set,	slurm_bit_super_set);
 strong_alias(bit_overlap,	slurm_bit_overlap);
 strong_alias(bit_overlap_any,	slurm_bit_overlap_any);
+strong_alias(bit_and_not_count,	slurm_bit_and_not_count);
+strong_alias(bit_and_not_any,	slurm_bit_and_not_any);
 strong_alias(bit_equal,		slurm_bit_equal);
 strong_alias(bit_copy,		slurm_bit_copy);
 strong_alias(bit_pick_cnt,	slurm_bit_pick_cnt);
@@ -156,6 +165,516 @@ strong_alias(bit_copybits,	slurm_bit_copybits);
 strong_alias(bit_get_bit_num,	slurm_bit_get_bit_num);
 strong_alias(bit_get_pos_num,	slurm_bit_get_pos_num);
 
+#ifdef HAVE___BUILTIN_POPCOUNTLL
+#define hweight __builtin_popcountll
+#else
+/*
+ * Returns the hamming weight (i.e. the number of bits set) in a word.
+ * NOTE: This routine borrowed from Linux 4.9 <tools/lib/hweight.c>.
+ */
+static uint64_t
+hweight(uint64_t w)
+{
+        w -= (w >> 1) & 0x5555555555555555ul;
+        w =  (w & 0x3333333333333333ul) + ((w >> 2) & 0x3333333333333333ul);
+        w =  (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0ful;
+        return (w * 0x0101010101010101ul) >> 56;
+}
+#endif
+
+/*
+ * Word kernels used by the bulk operations below. Each works on "n" whole
+ * words following the bitstring header. The scalar versions are replaced by
+ * AVX2 or AVX-512 versions when the CPU supports them, see _bit_kernels().
+ */
+typedef struct {
+	const char *name;
+	void (*and_words)(bitstr_t *d, const bitstr_t *s, int64_t n);
+	void (*and_not_words)(bitstr_t *d, const bitstr_t *s, int64_t n);
+	void (*or_words)(bitstr_t *d, const bitstr_t *s, int64_t n);
+	void (*or_not_words)(bitstr_t *d, const bitstr_t *s, int64_t n);
+	int64_t (*count)(const bitstr_t *a, int64_t n);
+	int64_t (*and_count)(const bitstr_t *a, const bitstr_t *b, int64_t n);
+	int64_t (*and_not_count)(const bitstr_t *a, const bitstr_t *b,
+				 int64_t n);
+	bool (*and_any)(const bitstr_t *a, const bitstr_t *b, int64_t n);
+	bool (*and_not_any)(const bitstr_t *a, const bitstr_t *b, int64_t n);
+	int64_t (*first_nonzero)(const bitstr_t *a, int64_t n);
+} bit_kernels_t;
+
+static void _and_words(bitstr_t *d, const bitstr_t *s, int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; i < n; i++)
+		d[i] &= s[i];
+}
+
+static void _and_not_words(bitstr_t *d, const bitstr_t *s, int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; i < n; i++)
+		d[i] &= ~s[i];
+}
+
+static void _or_words(bitstr_t *d, const bitstr_t *s, int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; i < n; i++)
+		d[i] |= s[i];
+}
+
+static void _or_not_words(bitstr_t *d, const bitstr_t *s, int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; i < n; i++)
+		d[i] |= ~s[i];
+}
+
+static int64_t _count(const bitstr_t *a, int64_t n)
+{
+	int64_t i, count = 0;
+
+	for (i = 0; i < n; i++)
+		count += hweight(a[i]);
+	return count;
+}
+
+static int64_t _and_count(const bitstr_t *a, const bitstr_t *b, int64_t n)
+{
+	int64_t i, count = 0;
+
+	for (i = 0; i < n; i++)
+		count += hweight(a[i] & b[i]);
+	return count;
+}
+
+static int64_t _and_not_count(const bitstr_t *a, const bitstr_t *b, int64_t n)
+{
+	int64_t i, count = 0;
+
+	for (i = 0; i < n; i++)
+		count += hweight(a[i] & ~b[i]);
+	return count;
+}
+
+static bool _and_any(const bitstr_t *a, const bitstr_t *b, int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; i < n; i++) {
+		if (a[i] & b[i])
+			return true;
+	}
+	return false;
+}
+
+static bool _and_not_any(const bitstr_t *a, const bitstr_t *b, int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; i < n; i++) {
+		if (a[i] & ~b[i])
+			return true;
+	}
+	return false;
+}
+
+static int64_t _first_nonzero(const bitstr_t *a, int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; i < n; i++) {
+		if (a[i])
+			return i;
+	}
+	return n;
+}
+
+static const bit_kernels_t bit_kernels_scalar = {
+	.name = "scalar",
+	.and_words = _and_words,
+	.and_not_words = _and_not_words,
+	.or_words = _or_words,
+	.or_not_words = _or_not_words,
+	.count = _count,
+	.and_count = _and_count,
+	.and_not_count = _and_not_count,
+	.and_any = _and_any,
+	.and_not_any = _and_not_any,
+	.first_nonzero = _first_nonzero,
+};
+
+#ifdef BIT_SIMD
+
+#define AVX2 __attribute__((target("avx2")))
+
+/* Byte-wise popcount by nibble lookup, summed into four 64-bit lanes */
+AVX2 static inline __m256i _popcnt256(__m256i v)
+{
+	const __m256i lookup = _mm256_setr_epi8(
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i low_mask = _mm256_set1_epi8(0x0f);
+	__m256i lo, hi, cnt;
+
+	lo = _mm256_and_si256(v, low_mask);
+	hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+	cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+			      _mm256_shuffle_epi8(lookup, hi));
+	return _mm256_sad_epu8(cnt, _mm256_setzero_si256());
+}
+
+AVX2 static inline int64_t _sum256(__m256i acc)
+{
+	return _mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) +
+	       _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3);
+}
+
+#define LOAD256(p)	_mm256_loadu_si256((const __m256i *) (p))
+#define STORE256(p, v)	_mm256_storeu_si256((__m256i *) (p), (v))
+
+AVX2 static void _and_words_avx2(bitstr_t *d, const bitstr_t *s, int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; (i + 4) <= n; i += 4)
+		STORE256(d + i, _mm256_and_si256(LOAD256(d + i),
+						 LOAD256(s + i)));
+	_and_words(d + i, s + i, n - i);
+}
+
+AVX2 static void _and_not_words_avx2(bitstr_t *d, const bitstr_t *s,
+				     int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; (i + 4) <= n; i += 4)
+		STORE256(d + i, _mm256_andnot_si256(LOAD256(s + i),
+						    LOAD256(d + i)));
+	_and_not_words(d + i, s + i, n - i);
+}
+
+AVX2 static void _or_words_avx2(bitstr_t *d, const bitstr_t *s, int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; (i + 4) <= n; i += 4)
+		STORE256(d + i, _mm256_or_si256(LOAD256(d + i),
+						LOAD256(s + i)));
+	_or_words(d + i, s + i, n - i);
+}
+
+AVX2 static void _or_not_words_avx2(bitstr_t *d, const bitstr_t *s, int64_t n)
+{
+	const __m256i ones = _mm256_set1_epi64x(-1);
+	int64_t i;
+
+	for (i = 0; (i + 4) <= n; i += 4)
+		STORE256(d + i, _mm256_or_si256(LOAD256(d + i),
+			 _mm256_xor_si256(LOAD256(s + i), ones)));
+	_or_not_words(d + i, s + i, n - i);
+}
+
+AVX2 static int64_t _count_avx2(const bitstr_t *a, int64_t n)
+{
+	__m256i acc = _mm256_setzero_si256();
+	int64_t i;
+
+	for (i = 0; (i + 4) <= n; i += 4)
+		acc = _mm256_add_epi64(acc, _popcnt256(LOAD256(a + i)));
+	return _sum256(acc) + _count(a + i, n - i);
+}
+
+AVX2 static int64_t _and_count_avx2(const bitstr_t *a, const bitstr_t *b,
+				    int64_t n)
+{
+	__m256i acc = _mm256_setzero_si256();
+	int64_t i;
+
+	for (i = 0; (i + 4) <= n; i += 4)
+		acc = _mm256_add_epi64(acc, _popcnt256(
+			_mm256_and_si256(LOAD256(a + i), LOAD256(b + i))));
+	return _sum256(acc) + _and_count(a + i, b + i, n - i);
+}
+
+AVX2 static int64_t _and_not_count_avx2(const bitstr_t *a, const bitstr_t *b,
+					int64_t n)
+{
+	__m256i acc = _mm256_setzero_si256();
+	int64_t i;
+
+	for (i = 0; (i + 4) <= n; i += 4)
+		acc = _mm256_add_epi64(acc, _popcnt256(
+			_mm256_andnot_si256(LOAD256(b + i), LOAD256(a + i))));
+	return _sum256(acc) + _and_not_count(a + i, b + i, n - i);
+}
+
+AVX2 static bool _and_any_avx2(const bitstr_t *a, const bitstr_t *b,
+			       int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; (i + 4) <= n; i += 4) {
+		if (!_mm256_testz_si256(LOAD256(a + i), LOAD256(b + i)))
+			return true;
+	}
+	return _and_any(a + i, b + i, n - i);
+}
+
+AVX2 static bool _and_not_any_avx2(const bitstr_t *a, const bitstr_t *b,
+				   int64_t n)
+{
+	int64_t i;
+
+	/* testc sets CF if (~b & a) == 0 */
+	for (i = 0; (i + 4) <= n; i += 4) {
+		if (!_mm256_testc_si256(LOAD256(b + i), LOAD256(a + i)))
+			return true;
+	}
+	return _and_not_any(a + i, b + i, n - i);
+}
+
+AVX2 static int64_t _first_nonzero_avx2(const bitstr_t *a, int64_t n)
+{
+	__m256i v;
+	int64_t i;
+
+	for (i = 0; (i + 4) <= n; i += 4) {
+		v = LOAD256(a + i);
+		if (!_mm256_testz_si256(v, v))
+			break;
+	}
+	return i + _first_nonzero(a + i, n - i);
+}
+
+static const bit_kernels_t bit_kernels_avx2 = {
+	.name = "avx2",
+	.and_words = _and_words_avx2,
+	.and_not_words = _and_not_words_avx2,
+	.or_words = _or_words_avx2,
+	.or_not_words = _or_not_words_avx2,
+	.count = _count_avx2,
+	.and_count = _and_count_avx2,
+	.and_not_count = _and_not_count_avx2,
+	.and_any = _and_any_avx2,
+	.and_not_any = _and_not_any_avx2,
+	.first_nonzero = _first_nonzero_avx2,
+};
+
+#define AVX512 __attribute__((target("avx512f,avx512vpopcntdq")))
+
+#define LOAD512(p)	_mm512_loadu_si512((const void *) (p))
+#define STORE512(p, v)	_mm512_storeu_si512((void *) (p), (v))
+
+AVX512 static void _and_words_avx512(bitstr_t *d, const bitstr_t *s,
+				     int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; (i + 8) <= n; i += 8)
+		STORE512(d + i, _mm512_and_si512(LOAD512(d + i),
+						 LOAD512(s + i)));
+	_and_words(d + i, s + i, n - i);
+}
+
+AVX512 static void _and_not_words_avx512(bitstr_t *d, const bitstr_t *s,
+					 int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; (i + 8) <= n; i += 8)
+		STORE512(d + i, _mm512_andnot_si512(LOAD512(s + i),
+						    LOAD512(d + i)));
+	_and_not_words(d + i, s + i, n - i);
+}
+
+AVX512 static void _or_words_avx512(bitstr_t *d, const bitstr_t *s, int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; (i + 8) <= n; i += 8)
+		STORE512(d + i, _mm512_or_si512(LOAD512(d + i),
+						LOAD512(s + i)));
+	_or_words(d + i, s + i, n - i);
+}
+
+AVX512 static void _or_not_words_avx512(bitstr_t *d, const bitstr_t *s,
+					int64_t n)
+{
+	int64_t i;
+
+	/* 0xf3: d | ~s */
+	for (i = 0; (i + 8) <= n; i += 8)
+		STORE512(d + i, _mm512_ternarylogic_epi64(LOAD512(d + i),
+				LOAD512(s + i), LOAD512(s + i), 0xf3));
+	_or_not_words(d + i, s + i, n - i);
+}
+
+AVX512 static int64_t _count_avx512(const bitstr_t *a, int64_t n)
+{
+	__m512i acc = _mm512_setzero_si512();
+	int64_t i;
+
+	for (i = 0; (i + 8) <= n; i += 8)
+		acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(
+			LOAD512(a + i)));
+	return _mm512_reduce_add_epi64(acc) + _count(a + i, n - i);
+}
+
+AVX512 static int64_t _and_count_avx512(const bitstr_t *a, const bitstr_t *b,
+					int64_t n)
+{
+	__m512i acc = _mm512_setzero_si512();
+	int64_t i;
+
+	for (i = 0; (i + 8) <= n; i += 8)
+		acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(
+			_mm512_and_si512(LOAD512(a + i), LOAD512(b + i))));
+	return _mm512_reduce_add_epi64(acc) + _and_count(a + i, b + i, n - i);
+}
+
+AVX512 static int64_t _and_not_count_avx512(const bitstr_t *a,
+					    const bitstr_t *b, int64_t n)
+{
+	__m512i acc = _mm512_setzero_si512();
+	int64_t i;
+
+	for (i = 0; (i + 8) <= n; i += 8)
+		acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(
+			_mm512_andnot_si512(LOAD512(b + i), LOAD512(a + i))));
+	return _mm512_reduce_add_epi64(acc) +
+	       _and_not_count(a + i, b + i, n - i);
+}
+
+AVX512 static bool _and_any_avx512(const bitstr_t *a, const bitstr_t *b,
+				   int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; (i + 8) <= n; i += 8) {
+		if (_mm512_test_epi64_mask(LOAD512(a + i), LOAD512(b + i)))
+			return true;
+	}
+	return _and_any(a + i, b + i, n - i);
+}
+
+AVX512 static bool _and_not_any_avx512(const bitstr_t *a, const bitstr_t *b,
+				       int64_t n)
+{
+	int64_t i;
+
+	for (i = 0; (i + 8) <= n; i += 8) {
+		if (_mm512_test_epi64_mask(_mm512_andnot_si512(LOAD512(b + i),
+							       LOAD512(a + i)),
+					   _mm512_set1_epi64(-1)))
+			return true;
+	}
+	return _and_not_any(a + i, b + i, n - i);
+}
+
+AVX512 static int64_t _first_nonzero_avx512(const bitstr_t *a, int64_t n)
+{
+	__m512i v;
+	int64_t i;
+
+	for (i = 0; (i + 8) <= n; i += 8) {
+		v = LOAD512(a + i);
+		if (_mm512_test_epi64_mask(v, v))
+			break;
+	}
+	return i + _first_nonzero(a + i, n - i);
+}
+
+static const bit_kernels_t bit_kernels_avx512 = {
+	.name = "avx512",
+	.and_words = _and_words_avx512,
+	.and_not_words = _and_not_words_avx512,
+	.or_words = _or_words_avx512,
+	.or_not_words = _or_not_words_avx512,
+	.count = _count_avx512,
+	.and_count = _and_count_avx512,
+	.and_not_count = _and_not_count_avx512,
+	.and_any = _and_any_avx512,
+	.and_not_any = _and_not_any_avx512,
+	.first_nonzero = _first_nonzero_avx512,
+};
+
+#endif	/* BIT_SIMD */
+
+static const bit_kernels_t *bit_kernels = NULL;
+static slab_cache_t *bit_slab = NULL;	/* see bit_cache_size() */
+
+static const bit_kernels_t *_bit_kernels_find(const char *name)
+{
+#ifdef BIT_SIMD
+	__builtin_cpu_init();
+	if ((!name || !xstrcmp(name, "avx512")) &&
+	    __builtin_cpu_supports("avx512f") &&
+	    __builtin_cpu_supports("avx512vpopcntdq"))
+		return &bit_kernels_avx512;
+	if ((!name || !xstrcmp(name, "avx2")) &&
+	    __builtin_cpu_supports("avx2"))
+		return &bit_kernels_avx2;
+#endif
+	if (!name || !xstrcmp(name, "scalar"))
+		return &bit_kernels_scalar;
+	return NULL;
+}
+
+/*
+ * Pick the widest word kernels this CPU supports. Racing callers all store
+ * the same pointer, so no lock is needed.
+ */
+static inline const bit_kernels_t *_bit_kernels(void)
+{
+	if (!bit_kernels)
+		bit_kernels = _bit_kernels_find(NULL);
+	return bit_kernels;
+}
+
+/*
+ * Select the word kernels used by the bulk bitstring operations.
+ *   name (IN)		"scalar", "avx2", "avx512" or NULL for the best
+ *			supported by this CPU
+ *   RETURN		name of the kernels now in use, NULL if the
+ *			requested ones are not supported (no change made)
+ */
+const char *
+bit_kernels_select(const char *name)
+{
+	const bit_kernels_t *kernels = _bit_kernels_find(name);
+
+	if (!kernels)
+		return NULL;
+	bit_kernels = kernels;
+	return kernels->name;
+}
+
+/*
+ * Allocate bitstrings of the given size (e.g. the node count) from a slab
+ * cache, see slab.h. Bitstrings of other sizes are unaffected. The cache of
+ * a previous size is retired, it is released once its bitstrings are freed.
+ *   nbits (IN)		valid bits in bitstrings to cache
+ */
+void
+bit_cache_size(bitoff_t nbits)
+{
+	slab_cache_t *old_slab = bit_slab;
+	size_t size;
+
+	_assert_valid_size(nbits);
+	size = _bitstr_words(nbits) * sizeof(bitstr_t);
+	if (old_slab && (slab_cache_size(old_slab) == size))
+		return;
+
+	bit_slab = slab_cache_create("bitstr", size);
+	slab_cache_retire(old_slab);
+}
+
 /*
  * Allocate a bitstring.
  *   nbits (IN)		valid bits in new bitstring, initialized to all clear
@@ -164,9 +683,14 @@ strong_alias(bit_get_pos_num,	slurm_bit_get_pos_num);
 bitstr_t *bit_alloc(bitoff_t nbits)
 {
 	bitstr_t *new;
+	size_t size = _bitstr_words(nbits) * sizeof(bitstr_t);
+	slab_cache_t *slab = bit_slab;
 
 	_assert_valid_size(nbits);
-	new = xmalloc(_bitstr_words(nbits) * sizeof(bitstr_t));
+	if (slab && (slab_cache_size(slab) == size))
+		new = slab_alloc(slab);
+	else
+		new = xmalloc(size);
 
 	_bitstr_magic(new) = BITSTR_MAGIC;
 	_bitstr_bits(new) = nbits;
@@ -472,10 +996,15 @@ bit_nffs(bitstr_t *b, int32_t n)
 bitoff_t
 bit_ffs(bitstr_t *b)
 {
-	bitoff_t bit = 0, value = -1;
+	bitoff_t bit, value = -1;
 
 	_assert_bitstr_valid(b);
 
+	/* skip leading zero words */
+	bit = _bit_kernels()->first_nonzero(&b[BITSTR_OVERHEAD],
+			_bitstr_words(_bitstr_bits(b)) - BITSTR_OVERHEAD);
+	bit <<= BITSTR_SHIFT;
+
 	while (bit < _bitstr_bits(b) && value == -1) {
 		int32_t word = _bit_word(bit);
 
@@ -579,17 +1108,15 @@ bit_fill_gaps(bitstr_t *b)
 int
 bit_super_set(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
-
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8) {
-		if (b1[_bit_word(bit)] != (b1[_bit_word(bit)] &
-		                           b2[_bit_word(bit)]))
-			return 0;
-	}
+	if (_bit_kernels()->and_not_any(&b1[BITSTR_OVERHEAD],
+					&b2[BITSTR_OVERHEAD],
+					_bitstr_words(_bitstr_bits(b1)) -
+					BITSTR_OVERHEAD))
+		return 0;
 
 	return 1;
 }
@@ -626,14 +1153,12 @@ bit_equal(bitstr_t *b1, bitstr_t *b2)
 void
 bit_and(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
-
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] &= b2[_bit_word(bit)];
+	_bit_kernels()->and_words(&b1[BITSTR_OVERHEAD], &b2[BITSTR_OVERHEAD],
+			_bitstr_words(_bitstr_bits(b1)) - BITSTR_OVERHEAD);
 }
 
 /*
@@ -643,14 +1168,12 @@ bit_and(bitstr_t *b1, bitstr_t *b2)
  */
 void bit_and_not(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
-
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] &= ~b2[_bit_word(bit)];
+	_bit_kernels()->and_not_words(&b1[BITSTR_OVERHEAD], &b2[BITSTR_OVERHEAD],
+			_bitstr_words(_bitstr_bits(b1)) - BITSTR_OVERHEAD);
 }
 
 /*
@@ -676,14 +1199,12 @@ bit_not(bitstr_t *b)
 void
 bit_or(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
-
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] |= b2[_bit_word(bit)];
+	_bit_kernels()->or_words(&b1[BITSTR_OVERHEAD], &b2[BITSTR_OVERHEAD],
+			_bitstr_words(_bitstr_bits(b1)) - BITSTR_OVERHEAD);
 }
 
 /*
@@ -693,14 +1214,12 @@ bit_or(bitstr_t *b1, bitstr_t *b2)
  */
 void bit_or_not(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
-
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] |= ~b2[_bit_word(bit)];
+	_bit_kernels()->or_not_words(&b1[BITSTR_OVERHEAD], &b2[BITSTR_OVERHEAD],
+			_bitstr_words(_bitstr_bits(b1)) - BITSTR_OVERHEAD);
 }
 
 /*
@@ -737,23 +1256,6 @@ bit_copybits(bitstr_t *dest, bitstr_t *src)
 	memcpy(&dest[BITSTR_OVERHEAD], &src[BITSTR_OVERHEAD], len);
 }
 
-#ifdef HAVE___BUILTIN_POPCOUNTLL
-#define hweight __builtin_popcountll
-#else
-/*
- * Returns the hamming weight (i.e. the number of bits set) in a word.
- * NOTE: This routine borrowed from Linux 4.9 <tools/lib/hweight.c>.
- */
-static uint64_t
-hweight(uint64_t w)
-{
-        w -= (w >> 1) & 0x5555555555555555ul;
-        w =  (w & 0x3333333333333333ul) + ((w >> 2) & 0x3333333333333333ul);
-        w =  (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0ful;
-        return (w * 0x0101010101010101ul) >> 56;
-}
-#endif
-
 /*
  * Count the number of bits set in bitstring.
  *   b (IN)		bitstring to check
@@ -769,10 +1271,9 @@ bit_set_count(bitstr_t *b)
 	_assert_bitstr_valid(b);
 
 	bit_cnt = _bitstr_bits(b);
-	for (bit = 0; (bit + word_size) <= bit_cnt; bit += word_size) {
-		count += hweight(b[_bit_word(bit)]);
-	}
-	for ( ; bit < bit_cnt; bit++) {
+	count = _bit_kernels()->count(&b[BITSTR_OVERHEAD],
+				      bit_cnt / word_size);
+	for (bit = (bit_cnt / word_size) * word_size; bit < bit_cnt; bit++) {
 		if (bit_test(b, bit))
 			count++;
 	}
@@ -802,8 +1303,10 @@ bit_set_count_range(bitstr_t *b, int32_t start, int32_t end)
 		if (bit_test(b, bit))
 			count++;
 	}
-	for (; (bit + word_size) <= end ; bit += word_size) {
-		count += hweight(b[_bit_word(bit)]);
+	if ((bit + word_size) <= end) {
+		count += _bit_kernels()->count(&b[_bit_word(bit)],
+					       (end - bit) / word_size);
+		bit += ((end - bit) / word_size) * word_size;
 	}
 	for ( ; bit < end; bit++) {
 		if (bit_test(b, bit))
@@ -813,11 +1316,16 @@ bit_set_count_range(bitstr_t *b, int32_t start, int32_t end)
 	return count;
 }
 
-static int32_t _bit_overlap_internal(bitstr_t *b1, bitstr_t *b2, bool count_it)
+/*
+ * Count (count_it) or test for any bits set in b1 & b2, or in b1 & ~b2 if
+ * invert is set, without building the intermediate bitmap.
+ */
+static int32_t _bit_and_internal(bitstr_t *b1, bitstr_t *b2, bool invert,
+				 bool count_it)
 {
+	const bit_kernels_t *kernels = _bit_kernels();
 	int32_t count = 0;
-	int64_t anded;
-	bitoff_t bit, bit_cnt;
+	bitoff_t bit, bit_cnt, word_cnt;
 	int32_t word_size = sizeof(bitstr_t) * 8;
 
 	_assert_bitstr_valid(b1);
@@ -825,17 +1333,23 @@ static int32_t _bit_overlap_internal(bitstr_t *b1, bitstr_t *b2, bool count_it)
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
 	bit_cnt = _bitstr_bits(b1);
-	for (bit = 0; bit < bit_cnt; bit += word_size) {
-		if ((bit + word_size - 1) >= bit_cnt)
-			break;
-		anded = b1[_bit_word(bit)] & b2[_bit_word(bit)];
-		if (count_it)
-			count += hweight(anded);
-		else if (anded)
-			return 1;
-	}
-	for ( ; bit < bit_cnt; bit++) {
-		if (bit_test(b1, bit) && bit_test(b2, bit)) {
+	word_cnt = bit_cnt / word_size;
+	if (count_it && invert)
+		count = kernels->and_not_count(&b1[BITSTR_OVERHEAD],
+					       &b2[BITSTR_OVERHEAD], word_cnt);
+	else if (count_it)
+		count = kernels->and_count(&b1[BITSTR_OVERHEAD],
+					   &b2[BITSTR_OVERHEAD], word_cnt);
+	else if (invert && kernels->and_not_any(&b1[BITSTR_OVERHEAD],
+						&b2[BITSTR_OVERHEAD],
+						word_cnt))
+		return 1;
+	else if (!invert && kernels->and_any(&b1[BITSTR_OVERHEAD],
+					     &b2[BITSTR_OVERHEAD], word_cnt))
+		return 1;
+
+	for (bit = word_cnt * word_size; bit < bit_cnt; bit++) {
+		if (bit_test(b1, bit) && (bit_test(b2, bit) != invert)) {
 			if (count_it)
 				count++;
 			else
@@ -851,7 +1365,7 @@ static int32_t _bit_overlap_internal(bitstr_t *b1, bitstr_t *b2, bool count_it)
  */
 extern int32_t bit_overlap(bitstr_t *b1, bitstr_t *b2)
 {
-	return _bit_overlap_internal(b1, b2, 1);
+	return _bit_and_internal(b1, b2, false, true);
 }
 
 /*
@@ -860,7 +1374,25 @@ extern int32_t bit_overlap(bitstr_t *b1, bitstr_t *b2)
  */
 extern int32_t bit_overlap_any(bitstr_t *b1, bitstr_t *b2)
 {
-	return _bit_overlap_internal(b1, b2, 0);
+	return _bit_and_internal(b1, b2, false, false);
+}
+
+/*
+ * return number of bits set in b1 that are not set in b2, the same as
+ * bit_set_count() of b1 after bit_and_not(b1, b2) but leaving b1 unchanged
+ */
+extern int32_t bit_and_not_count(bitstr_t *b1, bitstr_t *b2)
+{
+	return _bit_and_internal(b1, b2, true, true);
+}
+
+/*
+ * return 1 if there is at least one bit set in b1 that is not set in b2, 0
+ * otherwise
+ */
+extern int32_t bit_and_not_any(bitstr_t *b1, bitstr_t *b2)
+{
+	return _bit_and_internal(b1, b2, true, false);
 }
 
 /*
@@ -141,12 +141,16 @@ void	bit_fill_gaps(bitstr_t *b);
 int	bit_super_set(bitstr_t *b1, bitstr_t *b2);
 int     bit_overlap(bitstr_t *b1, bitstr_t *b2);
 int     bit_overlap_any(bitstr_t *b1, bitstr_t *b2);
+int32_t	bit_and_not_count(bitstr_t *b1, bitstr_t *b2);
+int32_t	bit_and_not_any(bitstr_t *b1, bitstr_t *b2);
 int     bit_equal(bitstr_t *b1, bitstr_t *b2);
 void    bit_copybits(bitstr_t *dest, bitstr_t *src);
 bitstr_t *bit_copy(bitstr_t *b);
 bitstr_t *bit_pick_cnt(bitstr_t *b, bitoff_t nbits);
 bitoff_t bit_get_bit_num(bitstr_t *b, int32_t pos);
 int32_t	bit_get_pos_num(bitstr_t *b, bitoff_t pos);
+const char *bit_kernels_select(const char *name);
+void	bit_cache_size(bitoff_t nbits);
 
 #define FREE_NULL_BITMAP(_X)		\
 	do {				\
@@ -52,9 +52,16 @@
 #include "src/common/slurm_route.h"
 #include "src/common/read_config.h"
 #include "src/common/slurm_protocol_interface.h"
+#include "src/common/timers.h"
+#include "src/common/xhash.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
+/* Seconds a node which failed to reply is sent messages as a leaf */
+#define FWD_FAIL_TIME	300
+/* Nodes with the longest reply times reported by forward_pack_stats() */
+#define FWD_STATS_NODES	20
+
 typedef struct {
 	pthread_cond_t *notify;
 	int            *p_thr_count;
@@ -65,6 +72,27 @@ typedef struct {
 	pthread_mutex_t *tree_mutex;
 } fwd_tree_t;
 
+/*
+ * Reply times of the nodes messages were forwarded to, as measured by the
+ * node which sent each its message and returned with the replies, less the
+ * time each waited on the nodes it forwarded the message on to. Each
+ * daemon keeps those it sees, and sends nodes which recently failed or
+ * replied slowly the message directly rather than through a subtree.
+ */
+typedef struct {
+	char *node_name;
+	uint32_t hop_avg;	/* usec, decaying average */
+	uint32_t hop_max;	/* usec */
+	uint32_t resp_cnt;
+	uint32_t fail_cnt;
+	time_t fail_time;	/* last failure to reply */
+} fwd_node_t;
+
+static pthread_mutex_t fwd_node_mutex = PTHREAD_MUTEX_INITIALIZER;
+static xhash_t *fwd_nodes = NULL;
+static uint32_t fwd_slow_usec = 0;	/* reply time making a node a leaf */
+static uint64_t fwd_resp_cnt = 0, fwd_fail_cnt = 0, fwd_leaf_cnt = 0;
+
 static void _start_msg_tree_internal(hostlist_t hl, hostlist_t* sp_hl,
 				     fwd_tree_t *fwd_tree_in,
 				     int hl_count);
@@ -73,6 +101,194 @@ static void _forward_msg_internal(hostlist_t hl, hostlist_t* sp_hl,
 				  header_t *header, int timeout,
 				  int hl_count);
 
+static void _fwd_node_id(void *item, const char **key, uint32_t *key_len)
+{
+	fwd_node_t *node = (fwd_node_t *) item;
+
+	*key = node->node_name;
+	*key_len = strlen(node->node_name);
+}
+
+static void _fwd_node_free(void *item)
+{
+	fwd_node_t *node = (fwd_node_t *) item;
+
+	xfree(node->node_name);
+	xfree(node);
+}
+
+/*
+ * Set the hop time of the reply from node name, which is the one without a
+ * node name yet in lists returned by slurm_receive_msgs(). usec includes the
+ * time name waited on the nodes it forwarded the message to. The longest of
+ * their hop times is taken off to get the time of name itself.
+ */
+static void _set_hop_time(List ret_list, char *name, uint32_t usec)
+{
+	ListIterator itr;
+	ret_data_info_t *ret_data_info, *self = NULL;
+	uint32_t fwd_usec = 0;
+
+	itr = list_iterator_create(ret_list);
+	while ((ret_data_info = list_next(itr))) {
+		if (!self && (!ret_data_info->node_name ||
+			      !xstrcmp(ret_data_info->node_name, name)))
+			self = ret_data_info;
+		else
+			fwd_usec = MAX(fwd_usec, ret_data_info->hop_time);
+	}
+	list_iterator_destroy(itr);
+
+	if (!self)
+		return;
+	self->hop_time = MAX(usec, 1);
+	if (usec > fwd_usec)
+		self->hop_self = usec - fwd_usec;
+	else
+		self->hop_self = 1;
+}
+
+/* Record a reply or failure of a node, fwd_node_mutex held */
+static void _record_hop(char *node_name, bool failed, uint32_t hop_time)
+{
+	fwd_node_t *node;
+
+	if (!fwd_nodes) {
+		fwd_nodes = xhash_init(_fwd_node_id, _fwd_node_free);
+		/* A tenth of MessageTimeout, in usec */
+		fwd_slow_usec = slurm_get_msg_timeout() * 100000;
+	}
+	if (!(node = xhash_get_str(fwd_nodes, node_name))) {
+		node = xmalloc(sizeof(fwd_node_t));
+		node->node_name = xstrdup(node_name);
+		xhash_add(fwd_nodes, node);
+	}
+
+	if (failed) {
+		node->fail_cnt++;
+		node->fail_time = time(NULL);
+		fwd_fail_cnt++;
+		return;
+	}
+	if (node->hop_avg)
+		node->hop_avg = ((uint64_t) node->hop_avg * 3 + hop_time) / 4;
+	else
+		node->hop_avg = hop_time;
+	node->hop_max = MAX(node->hop_max, hop_time);
+	node->resp_cnt++;
+	fwd_resp_cnt++;
+}
+
+/*
+ * Record the replies and failures in ret_list, name is the node replying
+ * for the entry without a node name
+ */
+static void _record_hops(List ret_list, char *name)
+{
+	ListIterator itr;
+	ret_data_info_t *ret_data_info;
+	char *node_name;
+
+	slurm_mutex_lock(&fwd_node_mutex);
+	itr = list_iterator_create(ret_list);
+	while ((ret_data_info = list_next(itr))) {
+		if (!(node_name = ret_data_info->node_name))
+			node_name = name;
+		if (ret_data_info->type == RESPONSE_FORWARD_FAILED)
+			_record_hop(node_name, true, 0);
+		else if (ret_data_info->hop_self)
+			_record_hop(node_name, false, ret_data_info->hop_self);
+	}
+	list_iterator_destroy(itr);
+	slurm_mutex_unlock(&fwd_node_mutex);
+}
+
+static void _record_fail(char *name)
+{
+	slurm_mutex_lock(&fwd_node_mutex);
+	_record_hop(name, true, 0);
+	slurm_mutex_unlock(&fwd_node_mutex);
+}
+
+/* Check if a node recently failed or replied slowly, fwd_node_mutex held */
+static bool _fwd_node_leaf(char *name, time_t now)
+{
+	fwd_node_t *node = xhash_get_str(fwd_nodes, name);
+
+	if (!node)
+		return false;
+	if (node->fail_time && ((now - node->fail_time) < FWD_FAIL_TIME))
+		return true;
+	return (node->hop_avg >= fwd_slow_usec);
+}
+
+/*
+ * Split hl into the lists of nodes to forward to, as route_g_split_hostlist()
+ * does, except that up to tree_width nodes which recently failed or replied
+ * slowly are each put in a list of their own, so they are sent the message
+ * directly and don't stall the nodes which would have been under them.
+ */
+static int _split_hostlist(hostlist_t hl, hostlist_t **sp_hl, int *count,
+			   uint16_t tree_width)
+{
+	hostlist_t leaves = NULL;
+	hostlist_iterator_t itr;
+	hostlist_t *tree_hl = NULL;
+	int tree_cnt = 0, leaf_cnt = 0, rc = SLURM_SUCCESS;
+	time_t now = time(NULL);
+	char *name, *buf;
+
+	if (!tree_width)
+		tree_width = slurm_get_tree_width();
+
+	slurm_mutex_lock(&fwd_node_mutex);
+	if (fwd_nodes && xhash_count(fwd_nodes)) {
+		itr = hostlist_iterator_create(hl);
+		while ((leaf_cnt < tree_width) &&
+		       (name = hostlist_next(itr))) {
+			if (_fwd_node_leaf(name, now)) {
+				if (!leaves)
+					leaves = hostlist_create(NULL);
+				hostlist_push_host(leaves, name);
+				leaf_cnt++;
+			}
+			free(name);
+		}
+		hostlist_iterator_destroy(itr);
+		fwd_leaf_cnt += leaf_cnt;
+	}
+	slurm_mutex_unlock(&fwd_node_mutex);
+
+	if (!leaves)
+		return route_g_split_hostlist(hl, sp_hl, count, tree_width);
+
+	buf = hostlist_ranged_string_xmalloc(leaves);
+	debug2("%s: sending directly to %s", __func__, buf);
+	hostlist_delete(hl, buf);
+	xfree(buf);
+
+	if (hostlist_count(hl))
+		rc = route_g_split_hostlist(hl, &tree_hl, &tree_cnt,
+					    tree_width);
+	if (rc != SLURM_SUCCESS) {
+		hostlist_destroy(leaves);
+		return rc;
+	}
+
+	*sp_hl = xcalloc(tree_cnt + leaf_cnt, sizeof(hostlist_t));
+	if (tree_cnt)
+		memcpy(*sp_hl, tree_hl, tree_cnt * sizeof(hostlist_t));
+	xfree(tree_hl);
+	*count = tree_cnt;
+	while ((name = hostlist_shift(leaves))) {
+		(*sp_hl)[(*count)++] = hostlist_create(name);
+		free(name);
+	}
+	hostlist_destroy(leaves);
+
+	return SLURM_SUCCESS;
+}
+
 void _destroy_tree_fwd(fwd_tree_t *fwd_tree)
 {
 	if (fwd_tree) {
@@ -106,6 +322,7 @@ void *_forward_thread(void *arg)
 	char *buf = NULL;
 	int steps = 0;
 	int start_timeout = fwd_msg->timeout;
+	DEF_TIMERS;
 
 	/* repeat until we are sure the message was sent */
 	while ((name = hostlist_shift(hl))) {
@@ -130,6 +347,7 @@ void *_forward_thread(void *arg)
 			mark_as_failed_forward(
 				&fwd_struct->ret_list, name,
 				SLURM_COMMUNICATIONS_CONNECTION_ERROR);
+			_record_fail(name);
 			free(name);
 			if (hostlist_count(hl) > 0) {
 				slurm_mutex_unlock(&fwd_struct->forward_mutex);
@@ -179,6 +397,7 @@ void *_forward_thread(void *arg)
 		/*
 		 * forward message
 		 */
+		START_TIMER;
 		if (slurm_msg_sendto(fd,
 				     get_buf_data(buffer),
 				     get_buf_offset(buffer)) < 0) {
@@ -187,6 +406,7 @@ void *_forward_thread(void *arg)
 			slurm_mutex_lock(&fwd_struct->forward_mutex);
 			mark_as_failed_forward(&fwd_struct->ret_list, name,
 					       errno);
+			_record_fail(name);
 			free(name);
 			if (hostlist_count(hl) > 0) {
 				free_buf(buffer);
@@ -249,6 +469,9 @@ void *_forward_thread(void *arg)
 		}
 
 		ret_list = slurm_receive_msgs(fd, steps, fwd_msg->timeout);
+		END_TIMER;
+		if (ret_list)
+			_set_hop_time(ret_list, name, DELTA_TIMER);
 		/* info("sent %d forwards got %d back", */
 		/*      fwd_msg->header.forward.cnt, list_count(ret_list)); */
 
@@ -257,6 +480,7 @@ void *_forward_thread(void *arg)
 			slurm_mutex_lock(&fwd_struct->forward_mutex);
 			mark_as_failed_forward(&fwd_struct->ret_list, name,
 					       errno);
+			_record_fail(name);
 			free(name);
 			FREE_NULL_LIST(ret_list);
 			if (hostlist_count(hl) > 0) {
@@ -318,6 +542,8 @@ void *_forward_thread(void *arg)
 		}
 		break;
 	}
+	if (ret_list)
+		_record_hops(ret_list, name);
 	slurm_mutex_lock(&fwd_struct->forward_mutex);
 	if (ret_list) {
 		while ((ret_data_info = list_pop(ret_list)) != NULL) {
@@ -351,6 +577,7 @@ void *_fwd_tree_thread(void *arg)
 	char *name = NULL;
 	char *buf = NULL;
 	slurm_msg_t send_msg;
+	DEF_TIMERS;
 
 	slurm_msg_t_init(&send_msg);
 	send_msg.msg_type = fwd_tree->orig_msg->msg_type;
@@ -388,13 +615,18 @@ void *_fwd_tree_thread(void *arg)
 		} else
 			debug3("Tree sending to %s", name);
 
+		START_TIMER;
 		ret_list = slurm_send_addr_recv_msgs(&send_msg, name,
 						     fwd_tree->timeout);
+		END_TIMER;
 
 		xfree(send_msg.forward.nodelist);
 
 		if (ret_list) {
 			int ret_cnt = list_count(ret_list);
+
+			_set_hop_time(ret_list, name, DELTA_TIMER);
+			_record_hops(ret_list, name);
 			/* This is most common if a slurmd is running
 			   an older version of Slurm than the
 			   originator of the message.
@@ -605,8 +837,8 @@ extern int forward_msg(forward_struct_t *forward_struct, header_t *header)
 	hl = hostlist_create(header->forward.nodelist);
 	hostlist_uniq(hl);
 
-	if (route_g_split_hostlist(
-		    hl, &sp_hl, &hl_count, header->forward.tree_width)) {
+	if (_split_hostlist(hl, &sp_hl, &hl_count,
+			    header->forward.tree_width)) {
 		error("unable to split forward hostlist");
 		hostlist_destroy(hl);
 		return SLURM_ERROR;
@@ -650,8 +882,7 @@ extern List start_msg_tree(hostlist_t hl, slurm_msg_t *msg, int timeout)
 	hostlist_uniq(hl);
 	host_count = hostlist_count(hl);
 
-	if (route_g_split_hostlist(hl, &sp_hl, &hl_count,
-				   msg->forward.tree_width)) {
+	if (_split_hostlist(hl, &sp_hl, &hl_count, msg->forward.tree_width)) {
 		error("unable to split forward hostlist");
 		return NULL;
 	}
@@ -691,6 +922,122 @@ extern List start_msg_tree(hostlist_t hl, slurm_msg_t *msg, int timeout)
 	return ret_list;
 }
 
+typedef struct {
+	fwd_node_t **nodes;
+	int cnt;
+} fwd_node_array_t;
+
+static void _fwd_node_collect(void *item, void *arg)
+{
+	fwd_node_array_t *array = (fwd_node_array_t *) arg;
+
+	array->nodes[array->cnt++] = (fwd_node_t *) item;
+}
+
+/* Sort nodes by decreasing average reply time */
+static int _fwd_node_cmp(const void *a, const void *b)
+{
+	fwd_node_t *n1 = *(fwd_node_t **) a;
+	fwd_node_t *n2 = *(fwd_node_t **) b;
+
+	if (n1->hop_avg > n2->hop_avg)
+		return -1;
+	if (n1->hop_avg < n2->hop_avg)
+		return 1;
+	return 0;
+}
+
+/*
+ * forward_pack_stats - pack the reply times of the nodes messages were
+ *	forwarded to for sdiag: reply and failure counts, the number of nodes
+ *	sent messages directly as leaves, then the slowest nodes and those
+ *	which recently failed
+ */
+extern void forward_pack_stats(Buf buffer, uint16_t protocol_version)
+{
+	fwd_node_array_t array = { NULL, 0 };
+	char **names;
+	uint32_t *avg, *max, *resp, *fail, *leaf;
+	time_t now = time(NULL);
+	bool is_leaf;
+	int i, cnt = 0;
+
+	slurm_mutex_lock(&fwd_node_mutex);
+	if (fwd_nodes) {
+		array.nodes = xcalloc(xhash_count(fwd_nodes),
+				      sizeof(fwd_node_t *));
+		xhash_walk(fwd_nodes, _fwd_node_collect, &array);
+		qsort(array.nodes, array.cnt, sizeof(fwd_node_t *),
+		      _fwd_node_cmp);
+	}
+	names = xcalloc(array.cnt + 1, sizeof(char *));
+	avg = xcalloc(array.cnt + 1, sizeof(uint32_t));
+	max = xcalloc(array.cnt + 1, sizeof(uint32_t));
+	resp = xcalloc(array.cnt + 1, sizeof(uint32_t));
+	fail = xcalloc(array.cnt + 1, sizeof(uint32_t));
+	leaf = xcalloc(array.cnt + 1, sizeof(uint32_t));
+	for (i = 0; i < array.cnt; i++) {
+		fwd_node_t *node = array.nodes[i];
+
+		is_leaf = _fwd_node_leaf(node->node_name, now);
+		if ((cnt >= FWD_STATS_NODES) && !is_leaf)
+			continue;
+		names[cnt] = xstrdup(node->node_name);
+		avg[cnt] = node->hop_avg;
+		max[cnt] = node->hop_max;
+		resp[cnt] = node->resp_cnt;
+		fail[cnt] = node->fail_cnt;
+		leaf[cnt] = is_leaf;
+		cnt++;
+	}
+
+	pack64(fwd_resp_cnt, buffer);
+	pack64(fwd_fail_cnt, buffer);
+	pack64(fwd_leaf_cnt, buffer);
+	slurm_mutex_unlock(&fwd_node_mutex);
+
+	packstr_array(names, cnt, buffer);
+	pack32_array(avg, cnt, buffer);
+	pack32_array(max, cnt, buffer);
+	pack32_array(resp, cnt, buffer);
+	pack32_array(fail, cnt, buffer);
+	pack32_array(leaf, cnt, buffer);
+
+	for (i = 0; i < cnt; i++)
+		xfree(names[i]);
+	xfree(names);
+	xfree(avg);
+	xfree(max);
+	xfree(resp);
+	xfree(fail);
+	xfree(leaf);
+	xfree(array.nodes);
+}
+
+static void _fwd_node_reset(void *item, void *arg)
+{
+	fwd_node_t *node = (fwd_node_t *) item;
+
+	node->hop_max = 0;
+	node->resp_cnt = 0;
+	node->fail_cnt = 0;
+}
+
+/*
+ * forward_reset_stats - reset the counts packed by forward_pack_stats(),
+ *	the reply times and failure times used to build trees are kept
+ */
+extern void forward_reset_stats(void)
+{
+	slurm_mutex_lock(&fwd_node_mutex);
+	fwd_resp_cnt = 0;
+	fwd_fail_cnt = 0;
+	fwd_leaf_cnt = 0;
+	if (fwd_nodes)
+		xhash_walk(fwd_nodes, _fwd_node_reset, NULL);
+	slurm_mutex_unlock(&fwd_node_mutex);
+}
+
 /*
  * mark_as_failed_forward- mark a node as failed and add it to "ret_list"
  *
@@ -111,6 +111,15 @@ extern void mark_as_failed_forward(List *ret_list, char *node_name, int err);
 
 extern void forward_wait(slurm_msg_t *msg);
 
+/*
+ * forward_pack_stats - pack the reply times of the nodes messages were
+ *	forwarded to, and which of them are sent messages as leaves, for sdiag
+ */
+extern void forward_pack_stats(Buf buffer, uint16_t protocol_version);
+
+/* forward_reset_stats - reset the counts packed by forward_pack_stats() */
+extern void forward_reset_stats(void);
+
 /*
  * no_resp_forward - Used to respond for nodes not able to respond since
  *                   the parent had failed in some way
@@ -42,6 +42,7 @@
 #include <ctype.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -113,6 +114,13 @@ strong_alias(hostlist_shift_range,	slurm_hostlist_shift_range);
 strong_alias(hostlist_sort,		slurm_hostlist_sort);
 strong_alias(hostlist_cmp_first,	slurm_hostlist_cmp_first);
 strong_alias(hostlist_uniq,		slurm_hostlist_uniq);
+strong_alias(hostlist_union,		slurm_hostlist_union);
+strong_alias(hostlist_intersection,	slurm_hostlist_intersection);
+strong_alias(hostlist_difference,	slurm_hostlist_difference);
+strong_alias(hostlist_index_create,	slurm_hostlist_index_create);
+strong_alias(hostlist_index_destroy,	slurm_hostlist_index_destroy);
+strong_alias(hostlist_index_find,	slurm_hostlist_index_find);
+strong_alias(hostlist_index_bitmap,	slurm_hostlist_index_bitmap);
 strong_alias(hostset_copy,		slurm_hostset_copy);
 strong_alias(hostset_count,		slurm_hostset_count);
 strong_alias(hostset_create,		slurm_hostset_create);
@@ -238,6 +246,36 @@ struct _range {
 	int width;
 };
 
+/* hostseg type: A run of hosts in a canonical form in which two hosts
+ * have the same name iff they have the same prefix, pad and suffix.
+ * Used by the range-native set operations and by hostlist_index_t. */
+struct hostseg {
+	char *prefix;		/* never ends in a suffix character	*/
+	int pad;		/* zero padded width of the suffixes,	*/
+				/* 0 if unpadded, -1 if no suffix	*/
+	unsigned long lo, hi;	/* suffix range				*/
+	int inx;		/* position of host `lo', or -1		*/
+};
+
+/* An array based list of hostseg's */
+struct hostseg_list {
+	struct hostseg *seg;
+	int cnt;
+	int size;
+	int dims;
+};
+
+enum hostseg_op {
+	HOSTSEG_UNION,
+	HOSTSEG_INTERSECT,
+	HOSTSEG_DIFFERENCE
+};
+
+/* The hostlist index type: hostseg's sorted by name */
+struct hostlist_index {
+	struct hostseg_list sl;
+};
+
 /* ---- ---- */
 
 /* Multi-dimension system stuff here */
@@ -295,7 +333,6 @@ static int    _zero_padded(unsigned long, int);
 static int    _width_equiv(unsigned long, int *, unsigned long, int *);
 
 static int           host_prefix_end(const char *, int dims);
-static hostname_t    hostname_create(const char *);
 static void          hostname_destroy(hostname_t);
 static int           hostname_suffix_is_valid(hostname_t);
 static int           hostname_suffix_width(hostname_t);
@@ -343,7 +380,15 @@ static hostlist_iterator_t hostlist_iterator_new(void);
 static void               _iterator_advance(hostlist_iterator_t);
 static void               _iterator_advance_range(hostlist_iterator_t);
 
-static int hostset_find_host(hostset_t, const char *);
+
+static void _seg_list_init(struct hostseg_list *sl, int dims);
+static void _seg_list_free(struct hostseg_list *sl);
+static void _seg_add_hostlist(struct hostseg_list *sl, hostlist_t hl);
+static void _seg_list_normalize(struct hostseg_list *sl);
+static int  _hostlist_delete_segs(hostlist_t hl, int i,
+				  struct hostseg_list *del, int *n);
+static int  _hostlist_merge(hostlist_t hl1, hostlist_t hl2,
+			    enum hostseg_op op, hostlist_t *out);
 
 /* ------[ macros ]------ */
 
@@ -556,15 +601,6 @@ static hostname_t hostname_create_dims(const char *hostname, int dims)
 
 	return hn;
 }
-/*
- * create a hostname_t object from a string hostname
- */
-static hostname_t hostname_create(const char *hostname)
-{
-	int dims = slurmdb_setup_cluster_name_dims();
-
-	return hostname_create_dims(hostname, dims);
-}
 
 /* free a hostname object
  */
@@ -2201,23 +2237,32 @@ char *hostlist_shift_range(hostlist_t hl)
 	return buf;
 }
 
-/* XXX: Note: efficiency improvements needed */
 int hostlist_delete(hostlist_t hl, const char *hosts)
 {
-	int n = 0;
-	char *hostname = NULL;
+	int i, n = 0;
 	hostlist_t hltmp;
+	struct hostseg_list del;
+
 	if (!hl)
 		return -1;
 
 	if (!(hltmp = hostlist_create(hosts)))
 		seterrno_ret(EINVAL, 0);
 
-	while ((hostname = hostlist_pop(hltmp)) != NULL) {
-		n += hostlist_delete_host(hl, hostname);
-		free(hostname);
-	}
+	/*
+	 * Remove the first occurrence of each host a range at a time,
+	 * rather than searching hl for every host in turn.
+	 */
+	_seg_list_init(&del, 0);
+	_seg_add_hostlist(&del, hltmp);
 	hostlist_destroy(hltmp);
+	_seg_list_normalize(&del);
+
+	LOCK_HOSTLIST(hl);
+	for (i = 0; (i < hl->nranges) && del.cnt; )
+		i += _hostlist_delete_segs(hl, i, &del, &n);
+	UNLOCK_HOSTLIST(hl);
+	_seg_list_free(&del);
 
 	return n;
 }
@@ -2535,6 +2580,555 @@ void hostlist_uniq(hostlist_t hl)
 	UNLOCK_HOSTLIST(hl);
 }
 
+/* ----[ range-native set operations ]---- */
+
+static void _seg_list_init(struct hostseg_list *sl, int dims)
+{
+	memset(sl, 0, sizeof(*sl));
+	sl->dims = dims ? dims : slurmdb_setup_cluster_name_dims();
+}
+
+static void _seg_list_free(struct hostseg_list *sl)
+{
+	int i;
+
+	for (i = 0; i < sl->cnt; i++)
+		xfree(sl->seg[i].prefix);
+	xfree(sl->seg);
+	sl->cnt = sl->size = 0;
+}
+
+/* Append a run of hosts to sl, extending the last run where possible
+ */
+static void _seg_add(struct hostseg_list *sl, char *prefix, int pad,
+		     unsigned long lo, unsigned long hi, int inx)
+{
+	struct hostseg *s;
+
+	if (sl->cnt) {
+		s = &sl->seg[sl->cnt - 1];
+		if ((pad >= 0) && (s->pad == pad) && (s->hi + 1 == lo) &&
+		    ((inx < 0) ? (s->inx < 0) :
+		     (inx == s->inx + (int) (s->hi - s->lo + 1))) &&
+		    !strcmp(s->prefix, prefix)) {
+			s->hi = hi;
+			return;
+		}
+	}
+
+	if (sl->cnt == sl->size) {
+		sl->size = sl->size ? (sl->size * 2) : HOSTLIST_CHUNK;
+		xrealloc(sl->seg, sl->size * sizeof(struct hostseg));
+	}
+	s = &sl->seg[sl->cnt++];
+	s->prefix = xstrdup(prefix);
+	s->pad = pad;
+	s->lo = lo;
+	s->hi = hi;
+	s->inx = inx;
+}
+
+/* Return the pad of suffix "num" when printed "width" characters wide
+ */
+static int _seg_pad(unsigned long num, int width, int dims)
+{
+	if ((dims > 1) && (width == dims))
+		return width;
+	return _zero_padded(num, width) ? width : 0;
+}
+
+static void _seg_add_name(struct hostseg_list *sl, const char *name, int inx)
+{
+	hostname_t hn = hostname_create_dims(name, sl->dims);
+
+	if (hostname_suffix_is_valid(hn))
+		_seg_add(sl, hn->prefix,
+			 _seg_pad(hn->num, hostname_suffix_width(hn), sl->dims),
+			 hn->num, hn->num, inx);
+	else
+		_seg_add(sl, hn->hostname, -1, 0, 0, inx);
+	hostname_destroy(hn);
+}
+
+/* Append the hosts of hostrange hr to sl. If inx is not -1, it is the
+ * position of the first host of hr and is recorded for every run.
+ */
+static void _seg_add_range(struct hostseg_list *sl, hostrange_t hr, int inx)
+{
+	unsigned long lo = hr->lo, hi = hr->hi, mark = 1;
+	int w;
+
+	if (hr->singlehost) {
+		_seg_add_name(sl, hr->prefix, inx);
+		return;
+	}
+
+	/*
+	 * A prefix ending in digits (e.g. "nid0000[2-7]") or a suffix which
+	 * is ambiguous on multi-dimensional systems names the same hosts as
+	 * some other prefix and suffix; only the host names tell which.
+	 */
+	if ((host_prefix_end(hr->prefix, sl->dims) !=
+	     (int) strlen(hr->prefix) - 1) ||
+	    ((sl->dims > 1) && (hr->width != sl->dims))) {
+		unsigned long num;
+
+		for (num = lo; num <= hi; num++) {
+			char *name = _hostrange_string(hr, num - lo);
+			if (!name)
+				continue;
+			_seg_add_name(sl, name,
+				      (inx < 0) ? -1 : (inx + (num - lo)));
+			free(name);
+		}
+		return;
+	}
+
+	if ((sl->dims > 1) || (hr->width <= 1)) {
+		_seg_add(sl, hr->prefix, _seg_pad(lo, hr->width, sl->dims),
+			 lo, hi, inx);
+		return;
+	}
+
+	/* Suffixes below "mark" are zero padded, the others are not */
+	for (w = 1; (w < hr->width) && (mark <= (ULONG_MAX / 10)); w++)
+		mark *= 10;
+	if (lo < mark)
+		_seg_add(sl, hr->prefix, hr->width, lo, MIN(hi, mark - 1), inx);
+	if (hi >= mark) {
+		unsigned long first = MAX(lo, mark);
+		_seg_add(sl, hr->prefix, 0, first, hi,
+			 (inx < 0) ? -1 : (inx + (first - lo)));
+	}
+}
+
+static void _seg_add_hostlist(struct hostseg_list *sl, hostlist_t hl)
+{
+	int i;
+
+	LOCK_HOSTLIST(hl);
+	for (i = 0; i < hl->nranges; i++)
+		_seg_add_range(sl, hl->hr[i], -1);
+	UNLOCK_HOSTLIST(hl);
+}
+
+static int _seg_group_cmp(struct hostseg *s1, struct hostseg *s2)
+{
+	int rc;
+
+	if ((rc = strcmp(s1->prefix, s2->prefix)))
+		return rc;
+	return s1->pad - s2->pad;
+}
+
+static int _seg_cmp(const void *a, const void *b)
+{
+	struct hostseg *s1 = (struct hostseg *) a;
+	struct hostseg *s2 = (struct hostseg *) b;
+	int rc;
+
+	if ((rc = _seg_group_cmp(s1, s2)))
+		return rc;
+	if (s1->lo < s2->lo)
+		return -1;
+	return (s1->lo > s2->lo) ? 1 : 0;
+}
+
+/* Sort sl and merge overlapping runs, leaving the set of hosts in sl
+ */
+static void _seg_list_normalize(struct hostseg_list *sl)
+{
+	int i, j;
+
+	if (sl->cnt < 2)
+		return;
+
+	qsort(sl->seg, sl->cnt, sizeof(struct hostseg), _seg_cmp);
+	for (i = 1, j = 0; i < sl->cnt; i++) {
+		struct hostseg *s = &sl->seg[j];
+
+		if (!_seg_group_cmp(s, &sl->seg[i]) &&
+		    (sl->seg[i].lo <= s->hi + 1)) {
+			s->hi = MAX(s->hi, sl->seg[i].hi);
+			xfree(sl->seg[i].prefix);
+		} else
+			sl->seg[++j] = sl->seg[i];
+		sl->seg[j].inx = -1;
+	}
+	sl->seg[0].inx = -1;
+	sl->cnt = j + 1;
+}
+
+/* Binary search of sorted list sl for the first run which is not before
+ * the first host of key
+ */
+static int _seg_search(struct hostseg_list *sl, struct hostseg *key)
+{
+	int lo = 0, hi = sl->cnt, mid, rc;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		rc = _seg_group_cmp(&sl->seg[mid], key);
+		if ((rc < 0) || (!rc && (sl->seg[mid].hi < key->lo)))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/* Remove suffixes lo through hi from run k of sorted list sl
+ */
+static void _seg_consume(struct hostseg_list *sl, int k,
+			 unsigned long lo, unsigned long hi)
+{
+	struct hostseg *s = &sl->seg[k];
+
+	if ((lo == s->lo) && (hi == s->hi)) {
+		xfree(s->prefix);
+		memmove(s, s + 1, (sl->cnt - k - 1) * sizeof(struct hostseg));
+		sl->cnt--;
+	} else if (lo == s->lo) {
+		s->lo = hi + 1;
+	} else if (hi == s->hi) {
+		s->hi = lo - 1;
+	} else {
+		struct hostseg upper = *s;
+
+		upper.lo = hi + 1;
+		upper.prefix = xstrdup(s->prefix);
+		s->hi = lo - 1;
+		if (sl->cnt == sl->size) {
+			sl->size *= 2;
+			xrealloc(sl->seg, sl->size * sizeof(struct hostseg));
+		}
+		memmove(&sl->seg[k + 2], &sl->seg[k + 1],
+			(sl->cnt - k - 1) * sizeof(struct hostseg));
+		sl->seg[k + 1] = upper;
+		sl->cnt++;
+	}
+}
+
+static int _seg_emit(struct hostseg_list *out, struct hostseg *s,
+		     unsigned long lo, unsigned long hi)
+{
+	if (out)
+		_seg_add(out, s->prefix, s->pad, lo, hi, -1);
+	return hi - lo + 1;
+}
+
+/* Merge normalized lists sl1 and sl2 with set operation op.
+ * The result is appended to out, if not NULL.
+ * Returns the number of hosts in the result.
+ */
+static int _seg_merge(struct hostseg_list *sl1, struct hostseg_list *sl2,
+		      enum hostseg_op op, struct hostseg_list *out)
+{
+	struct hostseg a, b;	/* unmerged parts of sl1[i] and sl2[j] */
+	unsigned long end;
+	int i = 0, j = 0, count = 0, rc;
+
+	if (sl1->cnt)
+		a = sl1->seg[0];
+	if (sl2->cnt)
+		b = sl2->seg[0];
+
+	while ((i < sl1->cnt) || (j < sl2->cnt)) {
+		if (j >= sl2->cnt)
+			rc = -1;
+		else if (i >= sl1->cnt)
+			rc = 1;
+		else if (!(rc = _seg_group_cmp(&a, &b))) {
+			if (a.hi < b.lo)
+				rc = -1;
+			else if (b.hi < a.lo)
+				rc = 1;
+		}
+
+		if (rc < 0) {
+			if (op != HOSTSEG_INTERSECT)
+				count += _seg_emit(out, &a, a.lo, a.hi);
+			if (++i < sl1->cnt)
+				a = sl1->seg[i];
+			continue;
+		} else if (rc > 0) {
+			if (op == HOSTSEG_UNION)
+				count += _seg_emit(out, &b, b.lo, b.hi);
+			if (++j < sl2->cnt)
+				b = sl2->seg[j];
+			continue;
+		}
+
+		/* a and b overlap */
+		if (a.lo < b.lo) {
+			if (op != HOSTSEG_INTERSECT)
+				count += _seg_emit(out, &a, a.lo, b.lo - 1);
+			a.lo = b.lo;
+		} else if (b.lo < a.lo) {
+			if (op == HOSTSEG_UNION)
+				count += _seg_emit(out, &b, b.lo, a.lo - 1);
+			b.lo = a.lo;
+		}
+		end = MIN(a.hi, b.hi);
+		if (op != HOSTSEG_DIFFERENCE)
+			count += _seg_emit(out, &a, a.lo, end);
+		if (a.hi == end) {
+			if (++i < sl1->cnt)
+				a = sl1->seg[i];
+		} else
+			a.lo = end + 1;
+		if (b.hi == end) {
+			if (++j < sl2->cnt)
+				b = sl2->seg[j];
+		} else
+			b.lo = end + 1;
+	}
+
+	return count;
+}
+
+static void _hostlist_push_seg(hostlist_t hl, struct hostseg *s,
+			       unsigned long lo, unsigned long hi)
+{
+	if (s->pad < 0) {
+		hostrange_t hr = hostrange_create_single(s->prefix);
+		hostlist_push_range(hl, hr);
+		hostrange_destroy(hr);
+	} else
+		hostlist_push_hr(hl, s->prefix, lo, hi, s->pad);
+}
+
+/* Merge the hosts of hl1 and hl2 with set operation op. If out is not
+ * NULL, it is set to a new sorted hostlist holding the result.
+ * Returns the number of hosts in the result.
+ */
+static int _hostlist_merge(hostlist_t hl1, hostlist_t hl2,
+			   enum hostseg_op op, hostlist_t *out)
+{
+	struct hostseg_list sl1, sl2, res;
+	int i, count;
+
+	_seg_list_init(&sl1, 0);
+	_seg_list_init(&sl2, sl1.dims);
+	_seg_list_init(&res, sl1.dims);
+	if (hl1)
+		_seg_add_hostlist(&sl1, hl1);
+	if (hl2)
+		_seg_add_hostlist(&sl2, hl2);
+	_seg_list_normalize(&sl1);
+	_seg_list_normalize(&sl2);
+
+	count = _seg_merge(&sl1, &sl2, op, out ? &res : NULL);
+	if (out) {
+		*out = hostlist_new();
+		for (i = 0; i < res.cnt; i++)
+			_hostlist_push_seg(*out, &res.seg[i],
+					   res.seg[i].lo, res.seg[i].hi);
+		hostlist_uniq(*out);
+	}
+
+	_seg_list_free(&sl1);
+	_seg_list_free(&sl2);
+	_seg_list_free(&res);
+	return count;
+}
+
+hostlist_t hostlist_union(hostlist_t hl1, hostlist_t hl2)
+{
+	hostlist_t hl;
+
+	(void) _hostlist_merge(hl1, hl2, HOSTSEG_UNION, &hl);
+	return hl;
+}
+
+hostlist_t hostlist_intersection(hostlist_t hl1, hostlist_t hl2)
+{
+	hostlist_t hl;
+
+	(void) _hostlist_merge(hl1, hl2, HOSTSEG_INTERSECT, &hl);
+	return hl;
+}
+
+hostlist_t hostlist_difference(hostlist_t hl1, hostlist_t hl2)
+{
+	hostlist_t hl;
+
+	(void) _hostlist_merge(hl1, hl2, HOSTSEG_DIFFERENCE, &hl);
+	return hl;
+}
+
+/* Remove the hosts found in sorted list "del" from the range at position
+ * i of hostlist hl, consuming them from "del". Adds the number of hosts
+ * removed to *n. Returns the number of ranges left in place of range i.
+ * Assumes that the hostlist hl has been locked by caller.
+ */
+static int _hostlist_delete_segs(hostlist_t hl, int i,
+				 struct hostseg_list *del, int *n)
+{
+	hostrange_t hr = hl->hr[i], new;
+	struct hostseg_list segs;
+	struct _range *cut = NULL;
+	unsigned long base = hr->lo, count = hostrange_count(hr), next = 0;
+	int c, j, k, ncut = 0, nkept = 0, deleted = 0;
+
+	/* Runs of hr, with the offset of their first host within hr */
+	_seg_list_init(&segs, del->dims);
+	_seg_add_range(&segs, hr, 0);
+
+	for (j = 0; j < segs.cnt; j++) {
+		struct hostseg *s = &segs.seg[j];
+
+		k = _seg_search(del, s);
+		while ((k < del->cnt) && !_seg_group_cmp(&del->seg[k], s) &&
+		       (del->seg[k].lo <= s->hi)) {
+			struct hostseg *d = &del->seg[k];
+			unsigned long lo = MAX(s->lo, d->lo);
+			unsigned long hi = MIN(s->hi, d->hi);
+			bool whole = ((lo == d->lo) && (hi == d->hi));
+
+			xrealloc(cut, (ncut + 1) * sizeof(struct _range));
+			cut[ncut].lo = s->inx + (lo - s->lo);
+			cut[ncut].hi = s->inx + (hi - s->lo);
+			deleted += hi - lo + 1;
+			ncut++;
+
+			_seg_consume(del, k, lo, hi);
+			if (!whole)
+				k++;
+		}
+	}
+	_seg_list_free(&segs);
+
+	if (!ncut)
+		return 1;
+
+	*n += deleted;
+	hl->nhosts -= deleted;
+
+	/* Keep what lies between the cuts */
+	for (c = 0; (c <= ncut) && !hr->singlehost; c++) {
+		unsigned long end = (c < ncut) ? cut[c].lo : count;
+
+		if (next < end) {
+			if (!nkept) {
+				hr->lo = base + next;
+				hr->hi = base + end - 1;
+			} else {
+				new = hostrange_copy(hr);
+				new->lo = base + next;
+				new->hi = base + end - 1;
+				hostlist_insert_range(hl, new, i + nkept);
+				hostrange_destroy(new);
+			}
+			nkept++;
+		}
+		if (c < ncut)
+			next = cut[c].hi + 1;
+	}
+	xfree(cut);
+
+	if (!nkept)
+		hostlist_delete_range(hl, i);
+
+	return nkept;
+}
+
+/* ----[ hostlist_index functions ]---- */
+
+hostlist_index_t hostlist_index_create(char **names, int cnt)
+{
+	hostlist_index_t idx = xmalloc(sizeof(*idx));
+	int i;
+
+	_seg_list_init(&idx->sl, 0);
+	for (i = 0; i < cnt; i++) {
+		if (names[i] && names[i][0])
+			_seg_add_name(&idx->sl, names[i], i);
+	}
+	if (idx->sl.cnt > 1)
+		qsort(idx->sl.seg, idx->sl.cnt, sizeof(struct hostseg),
+		      _seg_cmp);
+
+	return idx;
+}
+
+void hostlist_index_destroy(hostlist_index_t idx)
+{
+	if (!idx)
+		return;
+	_seg_list_free(&idx->sl);
+	xfree(idx);
+}
+
+int hostlist_index_find(hostlist_index_t idx, const char *hostname)
+{
+	struct hostseg_list key;
+	struct hostseg *s;
+	int k, inx = -1;
+
+	if (!idx || !hostname)
+		return -1;
+
+	_seg_list_init(&key, idx->sl.dims);
+	_seg_add_name(&key, hostname, -1);
+	k = _seg_search(&idx->sl, key.seg);
+	if (k < idx->sl.cnt) {
+		s = &idx->sl.seg[k];
+		if (!_seg_group_cmp(s, key.seg) && (s->lo <= key.seg->lo))
+			inx = s->inx + (key.seg->lo - s->lo);
+	}
+	_seg_list_free(&key);
+
+	return inx;
+}
+
+int hostlist_index_bitmap(hostlist_index_t idx, hostlist_t hl,
+			  bitstr_t *bitmap, hostlist_t missing)
+{
+	struct hostseg_list sl;
+	int i, k, nmissing = 0;
+
+	if (!idx || !hl)
+		return -1;
+
+	_seg_list_init(&sl, idx->sl.dims);
+	_seg_add_hostlist(&sl, hl);
+
+	for (i = 0; i < sl.cnt; i++) {
+		struct hostseg *q = &sl.seg[i];
+		unsigned long next = q->lo;
+
+		for (k = _seg_search(&idx->sl, q);
+		     (k < idx->sl.cnt) && (next <= q->hi); k++) {
+			struct hostseg *s = &idx->sl.seg[k];
+			unsigned long hi;
+
+			if (_seg_group_cmp(s, q) || (s->lo > q->hi))
+				break;
+			if (s->lo > next) {
+				if (missing)
+					_hostlist_push_seg(missing, q, next,
+							   s->lo - 1);
+				nmissing += s->lo - next;
+				next = s->lo;
+			}
+			hi = MIN(s->hi, q->hi);
+			bit_nset(bitmap, s->inx + (next - s->lo),
+				 s->inx + (hi - s->lo));
+			next = hi + 1;
+		}
+		if (next <= q->hi) {
+			if (missing)
+				_hostlist_push_seg(missing, q, next, q->hi);
+			nmissing += q->hi - next + 1;
+		}
+	}
+	_seg_list_free(&sl);
+
+	return nmissing;
+}
+
 char *hostlist_deranged_string_malloc(hostlist_t hl)
 {
 	int buf_size = 8192;
@@ -3578,48 +4172,16 @@ int hostset_insert(hostset_t set, const char *hosts)
 }
 
 
-/* linear search through N ranges for hostname "host"
- * */
-static int hostset_find_host(hostset_t set, const char *host)
-{
-	int i;
-	int retval = 0;
-	hostname_t hn;
-	LOCK_HOSTLIST(set->hl);
-	hn = hostname_create(host);
-	for (i = 0; i < set->hl->nranges; i++) {
-		/*
-		 * FIXME: THIS WILL NOT ALWAYS WORK CORRECTLY IF CALLED FROM A
-		 * LOCATION THAT COULD HAVE DIFFERENT DIMENSIONS
-		 * (i.e. slurmdbd).
-		 */
-		if (hostrange_hn_within(set->hl->hr[i], hn, 0)) {
-			retval = 1;
-			goto done;
-		}
-	}
-done:
-	UNLOCK_HOSTLIST(set->hl);
-	hostname_destroy(hn);
-	return retval;
-}
-
 int hostset_intersects(hostset_t set, const char *hosts)
 {
-	int retval = 0;
+	int retval;
 	hostlist_t hl;
-	char *hostname;
 
 	assert(set->hl->magic == HOSTLIST_MAGIC);
 
-	hl = hostlist_create(hosts);
-	while ((hostname = hostlist_pop(hl)) != NULL) {
-		retval += hostset_find_host(set, hostname);
-		free(hostname);
-		if (retval)
-			break;
-	}
-
+	if (!(hl = hostlist_create(hosts)))
+		return (0);
+	retval = (_hostlist_merge(hl, set->hl, HOSTSEG_INTERSECT, NULL) > 0);
 	hostlist_destroy(hl);
 
 	return retval;
@@ -3627,25 +4189,17 @@ int hostset_intersects(hostset_t set, const char *hosts)
 
 int hostset_within(hostset_t set, const char *hosts)
 {
-	int nhosts, nfound;
+	int retval;
 	hostlist_t hl;
-	char *hostname;
 
 	assert(set->hl->magic == HOSTLIST_MAGIC);
 
 	if (!(hl = hostlist_create(hosts)))
 		return (0);
-	nhosts = hostlist_count(hl);
-	nfound = 0;
-
-	while ((hostname = hostlist_pop(hl)) != NULL) {
-		nfound += hostset_find_host(set, hostname);
-		free(hostname);
-	}
-
+	retval = (_hostlist_merge(hl, set->hl, HOSTSEG_DIFFERENCE, NULL) == 0);
 	hostlist_destroy(hl);
 
-	return (nhosts == nfound);
+	return retval;
 }
 
 int hostset_delete(hostset_t set, const char *hosts)
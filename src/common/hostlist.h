@@ -43,6 +43,8 @@
 
 #include <unistd.h>		/* load ssize_t definition */
 
+#include "src/common/bitstring.h"
+
 /* Since users can specify a numeric range in the prefix, we need to prevent
  * expressions that can consume all of the memory on a system and crash the
  * daemons (e.g. "a[0-999999999].b[0-9]", which generates 1 billion distinct
@@ -92,6 +94,11 @@ typedef struct hostset * hostset_t;
  */
 typedef struct hostlist_iterator * hostlist_iterator_t;
 
+/* The hostlist index type, mapping host names to positions in a table
+ * of names (e.g. the node table) by binary search over ranges of hosts.
+ */
+typedef struct hostlist_index * hostlist_index_t;
+
 /* ----[ hostlist_t functions: ]---- */
 
 /* ----[ hostlist creation and destruction ]---- */
@@ -322,6 +329,54 @@ void hostlist_sort(hostlist_t hl);
  */
 void hostlist_uniq(hostlist_t hl);
 
+/* ----[ hostlist set operations ]---- */
+
+/* hostlist_union(), hostlist_intersection(), hostlist_difference():
+ *
+ * Return a new sorted hostlist without duplicates holding the hosts found
+ * in either hl1 or hl2, in both hl1 and hl2, or in hl1 but not in hl2.
+ * Hosts are compared by name, a range at a time, without expanding ranges
+ * into individual host names. Either hostlist may be NULL.
+ *
+ * The returned hostlist must be freed with hostlist_destroy().
+ */
+hostlist_t hostlist_union(hostlist_t hl1, hostlist_t hl2);
+hostlist_t hostlist_intersection(hostlist_t hl1, hostlist_t hl2);
+hostlist_t hostlist_difference(hostlist_t hl1, hostlist_t hl2);
+
+/* ----[ hostlist index operations ]---- */
+
+/* hostlist_index_create():
+ *
+ * Create an index of the cnt host names in array names, mapping every
+ * name to its position in the array. NULL or empty names are skipped and
+ * names are expected to be unique. The index does not reference names.
+ *
+ * The returned index must be freed with hostlist_index_destroy().
+ */
+hostlist_index_t hostlist_index_create(char **names, int cnt);
+
+/* hostlist_index_destroy():
+ */
+void hostlist_index_destroy(hostlist_index_t idx);
+
+/* hostlist_index_find():
+ *
+ * Returns the position of hostname in the index, or -1 if not found.
+ */
+int hostlist_index_find(hostlist_index_t idx, const char *hostname);
+
+/* hostlist_index_bitmap():
+ *
+ * Set the bits of bitmap at the positions of the hosts of hl, matching
+ * each range of hl against the index as a whole. The hosts of hl not in
+ * the index are pushed onto hostlist missing, if not NULL.
+ *
+ * Returns the number of hosts not in the index, or -1 on error.
+ */
+int hostlist_index_bitmap(hostlist_index_t idx, hostlist_t hl,
+			  bitstr_t *bitmap, hostlist_t missing);
+
 /* Return the base used for encoding numeric hostlist suffixes */
 #define hostlist_get_base(_dimensions) ((_dimensions) > 1 ? 36 : 10)
 
@@ -45,6 +45,7 @@
 #include "list.h"
 #include "log.h"
 #include "macros.h"
+#include "slab.h"
 #include "xassert.h"
 #include "xmalloc.h"
 
@@ -87,11 +88,11 @@ strong_alias(list_delete_item,	slurm_list_delete_item);
  ***************/
 #define LIST_MAGIC 0xDEADBEEF
 
-#define list_alloc() xmalloc(sizeof(struct xlist))
+#define list_alloc() _list_slab_alloc(&list_slab)
 #define list_free(_l) xfree(l)
-#define list_node_alloc() xmalloc(sizeof(struct listNode))
+#define list_node_alloc() _list_slab_alloc(&list_node_slab)
 #define list_node_free(_p) xfree(_p)
-#define list_iterator_alloc() xmalloc(sizeof(struct listIterator))
+#define list_iterator_alloc() _list_slab_alloc(&list_iterator_slab)
 #define list_iterator_free(_i) xfree(_i)
 
 /****************
@@ -127,6 +128,12 @@ struct xlist {
 
 typedef struct listNode * ListNode;
 
+/* Lists, nodes and iterators come from slab caches, see slab.h */
+static slab_cache_t *list_slab = NULL;
+static slab_cache_t *list_node_slab = NULL;
+static slab_cache_t *list_iterator_slab = NULL;
+static pthread_once_t list_slab_once = PTHREAD_ONCE_INIT;
+
 
 /****************
  *  Prototypes  *
@@ -145,6 +152,21 @@ static int _list_mutex_is_locked (pthread_mutex_t *mutex);
  *  Functions  *
  ***************/
 
+static void _list_slab_init(void)
+{
+	list_slab = slab_cache_create("list", sizeof(struct xlist));
+	list_node_slab = slab_cache_create("list_node",
+					   sizeof(struct listNode));
+	list_iterator_slab = slab_cache_create("list_iterator",
+					       sizeof(struct listIterator));
+}
+
+static void *_list_slab_alloc(slab_cache_t **cache)
+{
+	pthread_once(&list_slab_once, _list_slab_init);
+	return slab_alloc(*cache);
+}
+
 /* list_create()
  */
 List
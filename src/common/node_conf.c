@@ -89,6 +89,11 @@ int node_record_count = 0;		/* count in node_record_table_ptr */
 uint16_t *cr_node_num_cores = NULL;
 uint32_t *cr_node_cores_offset = NULL;
 
+static hostlist_index_t node_name_index = NULL;
+static node_record_t *node_name_index_table = NULL;
+static int node_name_index_cnt = 0;
+static pthread_mutex_t node_name_index_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /* Local function definitions */
 static int	_delete_config_record (void);
 #if _DEBUG
@@ -97,6 +102,8 @@ static void	_dump_hash (void);
 static node_record_t *_find_node_record(char *name, bool test_alias,
 					bool log_missing);
 static void	_list_delete_config (void *config_entry);
+static hostlist_index_t _node_name_index(void);
+static void	_node_name_index_free(void);
 static void _node_record_hash_identity (void* item, const char** key,
 					uint32_t* key_len);
 
@@ -669,6 +676,7 @@ extern node_record_t *create_node_record(config_record_t *config_ptr,
 	if (!node_hash_table)
 		node_hash_table = xhash_init(_node_record_hash_identity, NULL);
 	xhash_add(node_hash_table, node_ptr);
+	_node_name_index_free();
 
 	node_ptr->config_ptr = config_ptr;
 	/* these values will be overwritten when the node actually registers */
@@ -802,6 +810,7 @@ extern int init_node_conf (void)
 	node_record_count = 0;
 	xfree(node_record_table_ptr);
 	xhash_free(node_hash_table);
+	_node_name_index_free();
 
 	if (config_list)	/* delete defunct configuration entries */
 		(void) _delete_config_record ();
@@ -826,6 +835,7 @@ extern void node_fini2 (void)
 	}
 
 	xhash_free(node_hash_table);
+	_node_name_index_free();
 	node_ptr = node_record_table_ptr;
 	for (i = 0; i < node_record_count; i++, node_ptr++)
 		purge_node_rec(node_ptr);
@@ -850,7 +860,8 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 	int rc = SLURM_SUCCESS;
 	char *this_node_name;
 	bitstr_t *my_bitmap;
-	hostlist_t host_list;
+	hostlist_t host_list, missing;
+	hostlist_index_t name_index;
 
 	my_bitmap = (bitstr_t *) bit_alloc (node_record_count);
 	*bitmap = my_bitmap;
@@ -868,6 +879,18 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 		return rc;
 	}
 
+	/*
+	 * Set the bits of whole ranges of node names at once, leaving only
+	 * the names not found (e.g. aliases) to look up one at a time.
+	 */
+	if ((name_index = _node_name_index())) {
+		missing = hostlist_create(NULL);
+		hostlist_index_bitmap(name_index, host_list, my_bitmap,
+				      missing);
+		hostlist_destroy(host_list);
+		host_list = missing;
+	}
+
 	while ( (this_node_name = hostlist_shift (host_list)) ) {
 		node_record_t *node_ptr;
 		node_ptr = _find_node_record(this_node_name, best_effort, true);
@@ -900,11 +923,19 @@ extern int hostlist2bitmap (hostlist_t hl, bool best_effort, bitstr_t **bitmap)
 	bitstr_t *my_bitmap;
 	char *name;
 	hostlist_iterator_t hi;
+	hostlist_t missing = NULL;
+	hostlist_index_t name_index;
 
 	FREE_NULL_BITMAP(*bitmap);
 	my_bitmap = (bitstr_t *) bit_alloc (node_record_count);
 	*bitmap = my_bitmap;
 
+	if ((name_index = _node_name_index())) {
+		missing = hostlist_create(NULL);
+		hostlist_index_bitmap(name_index, hl, my_bitmap, missing);
+		hl = missing;
+	}
+
 	hi = hostlist_iterator_create(hl);
 	while ((name = hostlist_next(hi))) {
 		node_record_t *node_ptr;
@@ -922,10 +953,54 @@ extern int hostlist2bitmap (hostlist_t hl, bool best_effort, bitstr_t **bitmap)
 	}
 
 	hostlist_iterator_destroy(hi);
+	FREE_NULL_HOSTLIST(missing);
 	return rc;
 
 }
 
+/*
+ * _node_name_index - return an index of node names to node table positions,
+ *	built on first use after the node table changes
+ * RET index or NULL if there are no nodes
+ */
+static hostlist_index_t _node_name_index(void)
+{
+	hostlist_index_t name_index;
+	char **names;
+	int i;
+
+	slurm_mutex_lock(&node_name_index_lock);
+	if (node_name_index &&
+	    ((node_name_index_table != node_record_table_ptr) ||
+	     (node_name_index_cnt != node_record_count))) {
+		hostlist_index_destroy(node_name_index);
+		node_name_index = NULL;
+	}
+	if (!node_name_index && node_record_count) {
+		names = xcalloc(node_record_count, sizeof(char *));
+		for (i = 0; i < node_record_count; i++)
+			names[i] = node_record_table_ptr[i].name;
+		node_name_index = hostlist_index_create(names,
+							node_record_count);
+		node_name_index_table = node_record_table_ptr;
+		node_name_index_cnt = node_record_count;
+		xfree(names);
+	}
+	name_index = node_name_index;
+	slurm_mutex_unlock(&node_name_index_lock);
+
+	return name_index;
+}
+
+/* _node_name_index_free - discard the node name index */
+static void _node_name_index_free(void)
+{
+	slurm_mutex_lock(&node_name_index_lock);
+	hostlist_index_destroy(node_name_index);
+	node_name_index = NULL;
+	slurm_mutex_unlock(&node_name_index_lock);
+}
+
 /* Purge the contents of a node record */
 extern void purge_node_rec(node_record_t *node_ptr)
 {
@@ -969,6 +1044,7 @@ extern void rehash_node (void)
 			continue;	/* vestigial record */
 		xhash_add(node_hash_table, node_ptr);
 	}
+	_node_name_index_free();
 
 #if _DEBUG
 	_dump_hash();
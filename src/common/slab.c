@@ -0,0 +1,632 @@
+/*****************************************************************************\
+ *  slab.c - per-thread slab caches for fixed-size objects and arenas for
+ *	memory released in one shot
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "config.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/slab.h"
+#include "src/common/xassert.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#define SLAB_CACHE_MAX	32		/* must fit the SLAB_MAGIC low byte */
+#define SLAB_SIZE	(64 * 1024)	/* minimum bytes carved per slab */
+#define SLAB_BATCH	32		/* objects moved to/from the depot */
+#define SLAB_HDR	(2 * sizeof(size_t))	/* xmalloc() header */
+
+#define ARENA_SIZE	(64 * 1024)	/* arena block size */
+#define ARENA_LARGE	(16 * 1024)	/* larger requests use xmalloc() */
+
+/* Round up to the xmalloc() header size, which keeps malloc() alignment */
+#define SLAB_ROUND(_s)	(((_s) + SLAB_HDR - 1) & ~(SLAB_HDR - 1))
+
+struct slab_cache {
+	char *name;
+	size_t size;		/* object size requested */
+	size_t stride;		/* header plus size, rounded */
+	int inx;		/* in slab_caches, -1 if not slab backed */
+	int batch;		/* objects moved to/from the depot at once */
+	pthread_mutex_t mutex;	/* protects the fields below */
+	size_t *depot;		/* free objects shared by all threads */
+	int depot_cnt;
+	void *slabs;		/* slabs allocated, linked by first word */
+	uint32_t slab_cnt;
+	size_t slab_size;
+	uint64_t alloc_cnt;	/* folded in from the threads' counts */
+	uint64_t free_cnt;
+	uint64_t depot_trips;	/* refills from and flushes to the depot */
+	bool retired;		/* see slab_cache_retire() */
+};
+
+/* Free objects of one cache kept by one thread, linked through the word
+ * following the header */
+typedef struct {
+	size_t *head;
+	int cnt;
+	uint64_t alloc_cnt;
+	uint64_t free_cnt;
+} slab_local_t;
+
+typedef struct arena_block {
+	struct arena_block *next;
+	char *pos;		/* next allocation */
+	char *start;		/* first allocation */
+	char *end;
+} arena_block_t;
+
+struct arena {
+	arena_block_t *block;	/* allocating from, then older blocks */
+	arena_block_t first;	/* the rest of this slab object */
+	uint64_t alloc_cnt;
+	uint64_t alloc_bytes;
+	uint32_t block_cnt;	/* blocks added beyond the first */
+};
+
+static bool slab_enabled = false;
+static pthread_mutex_t slab_mutex = PTHREAD_MUTEX_INITIALIZER;
+static slab_cache_t *slab_caches[SLAB_CACHE_MAX];
+static int slab_cache_cnt = 0;
+static pthread_key_t slab_key;
+static uint32_t slab_retire_cnt = 0;	/* slab_cache_retire() calls */
+
+static __thread slab_local_t slab_local[SLAB_CACHE_MAX];
+static __thread bool slab_thread_init = false;
+static __thread uint32_t slab_local_retire_cnt = 0;
+static __thread arena_t *arena_current = NULL;
+
+static slab_cache_t *arena_slab = NULL;
+static uint64_t arena_cnt = 0, arena_alloc_cnt = 0, arena_alloc_bytes = 0;
+static uint64_t arena_block_cnt = 0;
+static uint32_t arena_max_bytes = 0;
+
+/*
+ * Release the slabs of a retired cache once all of its objects are back in
+ * the depot.
+ * NOTE: cache->mutex must be locked
+ */
+static void _slab_drain(slab_cache_t *cache)
+{
+	void *slab;
+
+	if (!cache->retired || !cache->slab_cnt ||
+	    (cache->depot_cnt != (cache->slab_cnt *
+				  ((cache->slab_size - SLAB_HDR) /
+				   cache->stride))))
+		return;
+
+	while ((slab = cache->slabs)) {
+		cache->slabs = *(void **) slab;
+		free(slab);
+	}
+	cache->slab_cnt = 0;
+	cache->depot = NULL;
+	cache->depot_cnt = 0;
+}
+
+/* Move up to cnt objects from the thread's free list to the depot */
+static void _slab_flush(slab_cache_t *cache, slab_local_t *local, int cnt)
+{
+	size_t *head = local->head, *tail = head;
+	int i;
+
+	if (!head)
+		return;
+	for (i = 1; (i < cnt) && tail[2]; i++)
+		tail = (size_t *) tail[2];
+	local->head = (size_t *) tail[2];
+	local->cnt -= i;
+
+	slurm_mutex_lock(&cache->mutex);
+	tail[2] = (size_t) cache->depot;
+	cache->depot = head;
+	cache->depot_cnt += i;
+	cache->alloc_cnt += local->alloc_cnt;
+	cache->free_cnt += local->free_cnt;
+	cache->depot_trips++;
+	_slab_drain(cache);
+	slurm_mutex_unlock(&cache->mutex);
+	local->alloc_cnt = local->free_cnt = 0;
+}
+
+/* Give this thread's free objects of retired caches to their depot */
+static void _slab_local_retire(void)
+{
+	int i, cnt;
+
+	slab_local_retire_cnt = __atomic_load_n(&slab_retire_cnt,
+						__ATOMIC_ACQUIRE);
+
+	slurm_mutex_lock(&slab_mutex);
+	cnt = slab_cache_cnt;
+	slurm_mutex_unlock(&slab_mutex);
+
+	for (i = 0; i < cnt; i++) {
+		if (slab_local[i].head &&
+		    __atomic_load_n(&slab_caches[i]->retired, __ATOMIC_RELAXED))
+			_slab_flush(slab_caches[i], &slab_local[i],
+				    slab_local[i].cnt);
+	}
+}
+
+/* pthread key destructor, give this thread's free objects to the depot */
+static void _slab_thread_fini(void *arg)
+{
+	int i, cnt;
+
+	/* Register again should a later key destructor free objects */
+	slab_thread_init = false;
+
+	slurm_mutex_lock(&slab_mutex);
+	cnt = slab_cache_cnt;
+	slurm_mutex_unlock(&slab_mutex);
+
+	for (i = 0; i < cnt; i++) {
+		slab_local_t *local = &slab_local[i];
+
+		while (local->head)
+			_slab_flush(slab_caches[i], local, local->cnt);
+		if (local->alloc_cnt || local->free_cnt) {
+			slurm_mutex_lock(&slab_caches[i]->mutex);
+			slab_caches[i]->alloc_cnt += local->alloc_cnt;
+			slab_caches[i]->free_cnt += local->free_cnt;
+			slurm_mutex_unlock(&slab_caches[i]->mutex);
+			local->alloc_cnt = local->free_cnt = 0;
+		}
+	}
+}
+
+static void _slab_thread_init(void)
+{
+	slab_thread_init = true;
+	if ((errno = pthread_setspecific(slab_key, (void *) 1)))
+		error("%s: pthread_setspecific: %m", __func__);
+}
+
+/* Move up to cache->batch objects from the depot or a new slab to the
+ * thread's free list */
+static void _slab_refill(slab_cache_t *cache, slab_local_t *local)
+{
+	size_t *p;
+	char *slab;
+	int i, cnt;
+
+	if (!slab_thread_init)
+		_slab_thread_init();
+
+	slurm_mutex_lock(&cache->mutex);
+	if (!cache->depot) {
+		slab = malloc(cache->slab_size);
+		if (!slab) {
+			log_oom(__FILE__, __LINE__, __func__);
+			abort();
+		}
+		*(void **) slab = cache->slabs;
+		cache->slabs = slab;
+		cache->slab_cnt++;
+		cnt = (cache->slab_size - SLAB_HDR) / cache->stride;
+		for (i = cnt - 1; i >= 0; i--) {
+			p = (size_t *) (slab + SLAB_HDR + (i * cache->stride));
+			p[2] = (size_t) cache->depot;
+			cache->depot = p;
+		}
+		cache->depot_cnt += cnt;
+	}
+	for (i = 0; (i < cache->batch) && cache->depot; i++) {
+		p = cache->depot;
+		cache->depot = (size_t *) p[2];
+		p[2] = (size_t) local->head;
+		local->head = p;
+	}
+	cache->depot_cnt -= i;
+	local->cnt += i;
+	cache->alloc_cnt += local->alloc_cnt;
+	cache->free_cnt += local->free_cnt;
+	cache->depot_trips++;
+	slurm_mutex_unlock(&cache->mutex);
+	local->alloc_cnt = local->free_cnt = 0;
+}
+
+static void _slab_atfork_prepare(void)
+{
+	int i;
+
+	slurm_mutex_lock(&slab_mutex);
+	for (i = 0; i < slab_cache_cnt; i++)
+		slurm_mutex_lock(&slab_caches[i]->mutex);
+}
+
+static void _slab_atfork_release(void)
+{
+	int i;
+
+	for (i = 0; i < slab_cache_cnt; i++)
+		slurm_mutex_unlock(&slab_caches[i]->mutex);
+	slurm_mutex_unlock(&slab_mutex);
+}
+
+extern void slab_enable(void)
+{
+	if (slab_enabled)
+		return;
+	if ((errno = pthread_key_create(&slab_key, _slab_thread_fini)))
+		fatal("%s: pthread_key_create: %m", __func__);
+	if ((errno = pthread_atfork(_slab_atfork_prepare,
+				    _slab_atfork_release,
+				    _slab_atfork_release)))
+		fatal("%s: pthread_atfork: %m", __func__);
+	slab_enabled = true;
+}
+
+extern slab_cache_t *slab_cache_create(const char *name, size_t size)
+{
+	slab_cache_t *cache;
+	int i;
+
+	xassert(size);
+
+	slurm_mutex_lock(&slab_mutex);
+	for (i = 0; i < slab_cache_cnt; i++) {
+		cache = slab_caches[i];
+		if ((cache->size == size) && !xstrcmp(cache->name, name)) {
+			slurm_mutex_lock(&cache->mutex);
+			__atomic_store_n(&cache->retired, false,
+					 __ATOMIC_RELAXED);
+			slurm_mutex_unlock(&cache->mutex);
+			slurm_mutex_unlock(&slab_mutex);
+			return cache;
+		}
+	}
+
+	cache = xmalloc(sizeof(slab_cache_t));
+	cache->name = xstrdup(name);
+	cache->size = size;
+	/* The free list link is kept in the object */
+	cache->stride = SLAB_HDR + SLAB_ROUND(MAX(size, sizeof(size_t)));
+	cache->slab_size = MAX(SLAB_SIZE, SLAB_HDR + (cache->stride * 4));
+	cache->batch = MAX(1, MIN(SLAB_BATCH, ((cache->slab_size - SLAB_HDR) /
+					       cache->stride) / 2));
+	slurm_mutex_init(&cache->mutex);
+	if (slab_cache_cnt < SLAB_CACHE_MAX) {
+		cache->inx = slab_cache_cnt;
+		slab_caches[slab_cache_cnt++] = cache;
+	} else {
+		cache->inx = -1;
+		error("%s: slab cache table full, %s objects use xmalloc",
+		      __func__, name);
+	}
+	slurm_mutex_unlock(&slab_mutex);
+
+	return cache;
+}
+
+extern void slab_cache_retire(slab_cache_t *cache)
+{
+	if (!cache || (cache->inx < 0))
+		return;
+
+	slurm_mutex_lock(&cache->mutex);
+	__atomic_store_n(&cache->retired, true, __ATOMIC_RELAXED);
+	_slab_drain(cache);
+	slurm_mutex_unlock(&cache->mutex);
+
+	/* Have every thread hand over the free objects it holds */
+	__atomic_fetch_add(&slab_retire_cnt, 1, __ATOMIC_RELEASE);
+	if (slab_enabled)
+		_slab_local_retire();
+}
+
+extern size_t slab_cache_size(slab_cache_t *cache)
+{
+	return cache->size;
+}
+
+static void *_slab_alloc(slab_cache_t *cache, bool clear)
+{
+	slab_local_t *local;
+	size_t *p;
+
+	if (!slab_enabled || (cache->inx < 0)) {
+		if (clear)
+			return xmalloc(cache->size);
+		return xmalloc_nz(cache->size);
+	}
+
+	if (slab_local_retire_cnt !=
+	    __atomic_load_n(&slab_retire_cnt, __ATOMIC_RELAXED))
+		_slab_local_retire();
+
+	local = &slab_local[cache->inx];
+	if (!local->head)
+		_slab_refill(cache, local);
+	p = local->head;
+	local->head = (size_t *) p[2];
+	local->cnt--;
+	local->alloc_cnt++;
+	/* Keep nothing for a retired cache so it can drain */
+	if (__atomic_load_n(&cache->retired, __ATOMIC_RELAXED))
+		_slab_flush(cache, local, local->cnt);
+
+	p[0] = SLAB_MAGIC | cache->inx;
+	p[1] = cache->size;
+	if (clear)
+		memset(&p[2], 0, cache->size);
+	return &p[2];
+}
+
+extern void *slab_alloc(slab_cache_t *cache)
+{
+	return _slab_alloc(cache, true);
+}
+
+/*
+ * Return true if the arena object with header p is the last allocation
+ * made from the arena's current block
+ */
+static bool _arena_last(arena_t *arena, size_t *p)
+{
+	arena_block_t *block;
+
+	if (!arena)
+		return false;
+	block = arena->block;
+	return (((char *) p >= block->start) &&
+		(((char *) p + SLAB_HDR + SLAB_ROUND(p[1])) == block->pos));
+}
+
+static void _arena_free(size_t *p)
+{
+	if (_arena_last(arena_current, p))
+		arena_current->block->pos = (char *) p;
+	p[0] = 0;
+}
+
+extern void slab_free(void *ptr)
+{
+	size_t *p = (size_t *) ptr - 2;
+	slab_local_t *local;
+	int inx;
+
+	if (p[0] == ARENA_MAGIC) {
+		_arena_free(p);
+		return;
+	}
+
+	xassert(IS_SLAB_MAGIC(p[0]));
+	inx = p[0] & 0xff;
+	p[0] = 0;	/* make sure xfree isn't called twice */
+
+	if (!slab_thread_init)
+		_slab_thread_init();
+	if (slab_local_retire_cnt !=
+	    __atomic_load_n(&slab_retire_cnt, __ATOMIC_RELAXED))
+		_slab_local_retire();
+	local = &slab_local[inx];
+	p[2] = (size_t) local->head;
+	local->head = p;
+	local->cnt++;
+	local->free_cnt++;
+	if (__atomic_load_n(&slab_caches[inx]->retired, __ATOMIC_RELAXED))
+		_slab_flush(slab_caches[inx], local, local->cnt);
+	else if (local->cnt >= (2 * slab_caches[inx]->batch))
+		_slab_flush(slab_caches[inx], local, slab_caches[inx]->batch);
+}
+
+extern void *slab_realloc(void *ptr, size_t size, bool clear)
+{
+	size_t *p = (size_t *) ptr - 2;
+	size_t old_size = p[1];
+	char *new;
+
+	if ((p[0] == ARENA_MAGIC) && _arena_last(arena_current, p) &&
+	    ((char *) ptr + SLAB_ROUND(size) <= arena_current->block->end)) {
+		/* Grow or shrink in place */
+		arena_current->block->pos = (char *) ptr + SLAB_ROUND(size);
+		arena_current->alloc_bytes += SLAB_ROUND(size) -
+					      MIN(SLAB_ROUND(old_size),
+						  SLAB_ROUND(size));
+		p[1] = size;
+		if (clear && (size > old_size))
+			memset((char *) ptr + old_size, 0, size - old_size);
+		return ptr;
+	}
+
+	if (p[0] == ARENA_MAGIC)
+		new = arena_alloc(size);
+	else
+		new = xmalloc_nz(size);
+	memcpy(new, ptr, MIN(old_size, size));
+	if (clear && (size > old_size))
+		memset(new + old_size, 0, size - old_size);
+	slab_free(ptr);
+
+	return new;
+}
+
+static void _arena_init(void)
+{
+	arena_slab = slab_cache_create("arena", ARENA_SIZE);
+}
+
+extern arena_t *arena_create(void)
+{
+	static pthread_once_t arena_once = PTHREAD_ONCE_INIT;
+	arena_t *arena;
+
+	pthread_once(&arena_once, _arena_init);
+	arena = _slab_alloc(arena_slab, false);
+	arena->block = &arena->first;
+	arena->first.next = NULL;
+	arena->first.start = (char *) arena + SLAB_ROUND(sizeof(arena_t));
+	arena->first.pos = arena->first.start;
+	arena->first.end = (char *) arena + ARENA_SIZE;
+	arena->alloc_cnt = 0;
+	arena->alloc_bytes = 0;
+	arena->block_cnt = 0;
+
+	return arena;
+}
+
+extern arena_t *arena_swap(arena_t *arena)
+{
+	arena_t *prev = arena_current;
+
+	arena_current = arena;
+	return prev;
+}
+
+extern void arena_destroy(arena_t *arena)
+{
+	arena_block_t *block;
+	uint32_t max;
+
+	if (!arena)
+		return;
+	xassert(arena != arena_current);
+
+	while ((block = arena->block) != &arena->first) {
+		arena->block = block->next;
+		free(block);
+	}
+
+	__atomic_fetch_add(&arena_cnt, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&arena_alloc_cnt, arena->alloc_cnt,
+			   __ATOMIC_RELAXED);
+	__atomic_fetch_add(&arena_alloc_bytes, arena->alloc_bytes,
+			   __ATOMIC_RELAXED);
+	__atomic_fetch_add(&arena_block_cnt, arena->block_cnt,
+			   __ATOMIC_RELAXED);
+	max = __atomic_load_n(&arena_max_bytes, __ATOMIC_RELAXED);
+	while ((arena->alloc_bytes > max) &&
+	       !__atomic_compare_exchange_n(&arena_max_bytes, &max,
+					    (uint32_t) arena->alloc_bytes,
+					    false, __ATOMIC_RELAXED,
+					    __ATOMIC_RELAXED))
+		;
+
+	xfree(arena);
+}
+
+extern void *arena_alloc(size_t size)
+{
+	arena_t *arena = arena_current;
+	arena_block_t *block;
+	size_t need = SLAB_HDR + SLAB_ROUND(size);
+	size_t *p;
+
+	if (!arena || !size || (size > ARENA_LARGE))
+		return xmalloc_nz(size);
+
+	block = arena->block;
+	if ((block->pos + need) > block->end) {
+		block = malloc(ARENA_SIZE);
+		if (!block) {
+			log_oom(__FILE__, __LINE__, __func__);
+			abort();
+		}
+		block->next = arena->block;
+		block->start = (char *) block + SLAB_ROUND(sizeof(*block));
+		block->pos = block->start;
+		block->end = (char *) block + ARENA_SIZE;
+		arena->block = block;
+		arena->block_cnt++;
+	}
+
+	p = (size_t *) block->pos;
+	block->pos += need;
+	arena->alloc_cnt++;
+	arena->alloc_bytes += need;
+	p[0] = ARENA_MAGIC;
+	p[1] = size;
+	return &p[2];
+}
+
+extern void pack_slab_stats(Buf buffer, uint16_t protocol_version)
+{
+	char **names;
+	uint32_t *sizes, *kbytes, *in_depot;
+	uint64_t *allocs, *frees, *trips;
+	int i, cnt;
+
+	slurm_mutex_lock(&slab_mutex);
+	cnt = slab_enabled ? slab_cache_cnt : 0;
+	names = xcalloc(cnt + 1, sizeof(char *));
+	sizes = xcalloc(cnt + 1, sizeof(uint32_t));
+	kbytes = xcalloc(cnt + 1, sizeof(uint32_t));
+	in_depot = xcalloc(cnt + 1, sizeof(uint32_t));
+	allocs = xcalloc(cnt + 1, sizeof(uint64_t));
+	frees = xcalloc(cnt + 1, sizeof(uint64_t));
+	trips = xcalloc(cnt + 1, sizeof(uint64_t));
+	for (i = 0; i < cnt; i++) {
+		slab_cache_t *cache = slab_caches[i];
+
+		slurm_mutex_lock(&cache->mutex);
+		names[i] = cache->name;
+		sizes[i] = cache->size;
+		kbytes[i] = cache->slab_cnt * (cache->slab_size / 1024);
+		in_depot[i] = cache->depot_cnt;
+		allocs[i] = cache->alloc_cnt;
+		frees[i] = cache->free_cnt;
+		trips[i] = cache->depot_trips;
+		slurm_mutex_unlock(&cache->mutex);
+	}
+	slurm_mutex_unlock(&slab_mutex);
+
+	packstr_array(names, cnt, buffer);
+	pack32_array(sizes, cnt, buffer);
+	pack32_array(kbytes, cnt, buffer);
+	pack32_array(in_depot, cnt, buffer);
+	pack64_array(allocs, cnt, buffer);
+	pack64_array(frees, cnt, buffer);
+	pack64_array(trips, cnt, buffer);
+
+	pack64(__atomic_load_n(&arena_cnt, __ATOMIC_RELAXED), buffer);
+	pack64(__atomic_load_n(&arena_alloc_cnt, __ATOMIC_RELAXED), buffer);
+	pack64(__atomic_load_n(&arena_alloc_bytes, __ATOMIC_RELAXED), buffer);
+	pack64(__atomic_load_n(&arena_block_cnt, __ATOMIC_RELAXED), buffer);
+	pack32(__atomic_load_n(&arena_max_bytes, __ATOMIC_RELAXED), buffer);
+
+	xfree(names);
+	xfree(sizes);
+	xfree(kbytes);
+	xfree(in_depot);
+	xfree(allocs);
+	xfree(frees);
+	xfree(trips);
+}
@@ -0,0 +1,128 @@
+/*****************************************************************************\
+ *  slab.h - per-thread slab caches for fixed-size objects and arenas for
+ *	memory released in one shot
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+/*
+ * Memory from slab_alloc() and arena_alloc() carries the same two word
+ * header as xmalloc() memory, with a different magic value, so it is
+ * released with xfree() and may be passed to xrealloc() and xsize() like
+ * any other xmalloc() memory.
+ *
+ * Slab caches keep freed objects on a free list of the thread which freed
+ * them, and move them in batches to and from a list shared by all threads.
+ * Slab memory is only returned to the system by a retired cache, see
+ * slab_cache_retire(). Until slab_enable() is called slab_alloc() is simply
+ * xmalloc().
+ *
+ * An arena hands out memory from large blocks which are released together
+ * by arena_destroy(). Memory from arena_alloc() must not be used after the
+ * arena it came from is destroyed, xfree() of it only reclaims the space
+ * when it was the last allocation made.
+ */
+
+#ifndef _SLAB_H
+#define _SLAB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "src/common/pack.h"
+
+/* xmalloc() header magic values, a slab object has its cache index in the
+ * low byte */
+#define SLAB_MAGIC	0x51ab00
+#define ARENA_MAGIC	0xa4e4a
+#define IS_SLAB_MAGIC(_m)	(((_m) & ~((size_t) 0xff)) == SLAB_MAGIC)
+
+typedef struct slab_cache slab_cache_t;
+typedef struct arena arena_t;
+
+/*
+ * Enable slab caches in this process. Call once from the main thread
+ * before other threads are created.
+ */
+extern void slab_enable(void);
+
+/*
+ * Return the slab cache for objects of the given name and size, creating
+ * it if needed, or taking it back if it was retired. Caches are never
+ * destroyed. Once the cache table is full, the cache returned allocates
+ * with xmalloc().
+ */
+extern slab_cache_t *slab_cache_create(const char *name, size_t size);
+
+/*
+ * Stop keeping free objects of a cache no longer used. Its slabs are
+ * returned to the system once every object allocated from it is freed.
+ * Objects may still be allocated from it, they are just not kept once
+ * freed.
+ */
+extern void slab_cache_retire(slab_cache_t *cache);
+
+/* Return the size of objects allocated from a slab cache */
+extern size_t slab_cache_size(slab_cache_t *cache);
+
+/* Allocate a zeroed object from a slab cache, release it with xfree() */
+extern void *slab_alloc(slab_cache_t *cache);
+
+/*
+ * Create an arena. It is used by arena_alloc() in a thread once made
+ * current there by arena_swap(), and may move between threads.
+ */
+extern arena_t *arena_create(void);
+
+/*
+ * Make arena (or none if NULL) the calling thread's current arena
+ * RET the previous current arena
+ */
+extern arena_t *arena_swap(arena_t *arena);
+
+/* Release an arena and all memory allocated from it */
+extern void arena_destroy(arena_t *arena);
+
+/*
+ * Allocate uninitialized memory from the calling thread's current arena.
+ * Large requests and threads without an arena use xmalloc_nz().
+ */
+extern void *arena_alloc(size_t size);
+
+/* Used by xfree() and xrealloc() for memory with a SLAB_MAGIC or
+ * ARENA_MAGIC header */
+extern void slab_free(void *ptr);
+extern void *slab_realloc(void *ptr, size_t size, bool clear);
+
+/* Pack slab cache and arena statistics for sdiag */
+extern void pack_slab_stats(Buf buffer, uint16_t protocol_version);
+
+#endif /* !_SLAB_H */
@@ -104,6 +104,8 @@ static slurm_errtab_t slurm_errtab[] = {
 	  "Unable to contact slurm controller (receive failure)" },
 	{ SLURMCTLD_COMMUNICATIONS_SHUTDOWN_ERROR,
 	  "Unable to contact slurm controller (shutdown failure)"},
+	{ SLURMCTLD_COMMUNICATIONS_BACKOFF,
+	  "Slurm controller busy, retry later"			},
 
 	/* _info.c/communication layer RESPONSE_SLURM_RC message codes */
 
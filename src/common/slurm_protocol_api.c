@@ -64,6 +64,7 @@
 #include "src/common/msg_aggr.h"
 #include "src/common/pack.h"
 #include "src/common/read_config.h"
+#include "src/common/slab.h"
 #include "src/common/slurm_accounting_storage.h"
 #include "src/common/slurm_auth.h"
 #include "src/common/slurm_protocol_interface.h"
@@ -4125,9 +4126,10 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 	init_header(&header, msg, msg->flags);
 
 	/*
-	 * Pack header into buffer for transmission
+	 * Pack header into buffer for transmission, the buffer is
+	 * from the thread's arena if any
 	 */
-	buffer = init_buf(BUF_SIZE);
+	buffer = create_buf(arena_alloc(BUF_SIZE), BUF_SIZE);
 	pack_header(&header, buffer);
 
 	/*
@@ -4546,6 +4548,32 @@ _send_and_recv_msg(int fd, slurm_msg_t *req,
 	return rc;
 }
 
+/*
+ * A 20.02 daemon rejects the header of the extended protocol. Switch a
+ * request sent at SLURM_PROTOCOL_VERSION to the 20.02 format so the caller
+ * can resend it.
+ * RET true if the request should be resent
+ */
+static bool _downgrade_version(slurm_msg_t *req, slurm_msg_t *resp)
+{
+	/* RPCs 20.02 does not know are left for the caller to replace */
+	if ((req->protocol_version != SLURM_PROTOCOL_VERSION) ||
+	    (req->msg_type == REQUEST_JOB_INFO_DELTA) ||
+	    (resp->msg_type != RESPONSE_SLURM_RC) ||
+	    (((return_code_msg_t *) resp->data)->return_code !=
+	     SLURM_PROTOCOL_VERSION_ERROR))
+		return false;
+
+	debug("%s: %s rejected by peer, resending with protocol version %u",
+	      __func__, rpc_num2string(req->msg_type),
+	      SLURM_20_02_PROTOCOL_VERSION);
+	slurm_free_return_code_msg(resp->data);
+	resp->data = NULL;
+	req->protocol_version = SLURM_20_02_PROTOCOL_VERSION;
+
+	return true;
+}
+
 /*
  * Send and recv a slurm request and response on the open slurm descriptor
  * with a list containing the responses of the children (if any) we
@@ -4616,9 +4644,10 @@ extern int slurm_send_recv_controller_msg(slurm_msg_t * request_msg,
 	int retry = 1;
 	slurm_ctl_conf_t *conf;
 	bool have_backup;
-	uint16_t slurmctld_timeout;
+	uint16_t msg_timeout, slurmctld_timeout;
 	slurm_addr_t ctrl_addr;
 	static bool use_backup = false;
+	int backoff = 1;
 	slurmdb_cluster_rec_t *save_comm_cluster_rec = comm_cluster_rec;
 
 	/*
@@ -4643,6 +4672,7 @@ tryagain:
 
 	conf = slurm_conf_lock();
 	have_backup = conf->control_cnt > 1;
+	msg_timeout = conf->msg_timeout;
 	slurmctld_timeout = conf->slurmctld_timeout;
 	slurm_conf_unlock();
 
@@ -4681,6 +4711,43 @@ tryagain:
 			}
 		}
 
+		/*
+		 * slurmctld is deferring this class of RPC (see
+		 * rpc_limit_low), sleep and retry with an increasing delay
+		 */
+		if ((rc == 0) && !retry
+		    && (response_msg->msg_type == RESPONSE_SLURM_RC)
+		    && ((((return_code_msg_t *)response_msg->data)->return_code)
+			== SLURMCTLD_COMMUNICATIONS_BACKOFF)
+		    && ((difftime(time(NULL), start_time) + backoff)
+			<= msg_timeout)) {
+			debug("Slurm controller busy, sleep %d and retry",
+			      backoff);
+			slurm_free_return_code_msg(response_msg->data);
+			sleep(backoff);
+			backoff *= 2;
+			if ((fd = slurm_open_controller_conn(&ctrl_addr,
+							     &use_backup,
+							     comm_cluster_rec))
+			    < 0) {
+				rc = -1;
+			} else {
+				retry = 1;
+			}
+		}
+
+		if ((rc == 0) && !retry
+		    && _downgrade_version(request_msg, response_msg)) {
+			if ((fd = slurm_open_controller_conn(&ctrl_addr,
+							     &use_backup,
+							     comm_cluster_rec))
+			    < 0) {
+				rc = -1;
+			} else {
+				retry = 1;
+			}
+		}
+
 		if (rc == -1)
 			break;
 	}
@@ -4722,14 +4789,24 @@ cleanup:
  */
 int slurm_send_recv_node_msg(slurm_msg_t *req, slurm_msg_t *resp, int timeout)
 {
-	int fd = -1;
+	int fd = -1, rc;
 
 	resp->auth_cred = NULL;
 	if ((fd = slurm_open_msg_conn(&req->address)) < 0)
 		return -1;
 
-	return _send_and_recv_msg(fd, req, resp, timeout);
+	rc = _send_and_recv_msg(fd, req, resp, timeout);
+	if ((rc == 0) && _downgrade_version(req, resp)) {
+		if (resp->auth_cred) {
+			g_slurm_auth_destroy(resp->auth_cred);
+			resp->auth_cred = NULL;
+		}
+		if ((fd = slurm_open_msg_conn(&req->address)) < 0)
+			return -1;
+		rc = _send_and_recv_msg(fd, req, resp, timeout);
+	}
 
+	return rc;
 }
 
 /* slurm_send_only_controller_msg
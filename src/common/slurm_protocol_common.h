@@ -69,14 +69,26 @@
  * done here with them since we have to support old version of archive
  * files since they don't update once they are created.
  */
+/*
+ * 20.02 plus the appended statistics and message fields added on top of it.
+ * 20.02 daemons and clients are still accepted (see check_header_version)
+ * and the extended fields are only packed for peers at this version.
+ */
+#define SLURM_20_02_EXT_PROTOCOL_VERSION ((35 << 8) | 1)
 #define SLURM_20_02_PROTOCOL_VERSION ((35 << 8) | 0)
 #define SLURM_19_05_PROTOCOL_VERSION ((34 << 8) | 0)
 #define SLURM_18_08_PROTOCOL_VERSION ((33 << 8) | 0)
 
-#define SLURM_PROTOCOL_VERSION SLURM_20_02_PROTOCOL_VERSION
+#define SLURM_PROTOCOL_VERSION SLURM_20_02_EXT_PROTOCOL_VERSION
 #define SLURM_ONE_BACK_PROTOCOL_VERSION SLURM_19_05_PROTOCOL_VERSION
 #define SLURM_MIN_PROTOCOL_VERSION SLURM_18_08_PROTOCOL_VERSION
 
+/*
+ * State save files carry no extended fields, keep writing them as 20.02 so
+ * a 20.02 slurmctld can still read them after a downgrade.
+ */
+#define SLURM_STATE_PROTOCOL_VERSION SLURM_20_02_PROTOCOL_VERSION
+
 #if 0
 /* Old Slurm versions kept for reference only.  Slurm only actively keeps track
  * of 2 previous versions. */
@@ -1670,6 +1670,41 @@ extern void slurm_free_stats_response_msg(stats_info_response_msg_t *msg)
 {
 	int i;
 	if (msg) {
+		for (i = 0; i < msg->lock_stats_count; i++)
+			xfree(msg->lock_stats_name[i]);
+		xfree(msg->lock_stats_name);
+		xfree(msg->lock_cnt);
+		xfree(msg->lock_wait_time);
+		xfree(msg->lock_hold_time);
+		xfree(msg->lock_hold_max);
+		xfree(msg->lock_hist_bound);
+		xfree(msg->lock_hist);
+		for (i = 0; i < msg->rpc_class_count; i++)
+			xfree(msg->rpc_class_name[i]);
+		xfree(msg->rpc_class_name);
+		xfree(msg->rpc_class_cnt);
+		xfree(msg->rpc_class_time);
+		xfree(msg->rpc_class_active);
+		xfree(msg->rpc_class_active_max);
+		xfree(msg->rpc_class_busy);
+		xfree(msg->rpc_class_rate);
+		for (i = 0; i < msg->slab_cache_count; i++)
+			xfree(msg->slab_cache_name[i]);
+		xfree(msg->slab_cache_name);
+		xfree(msg->slab_cache_size);
+		xfree(msg->slab_cache_kbytes);
+		xfree(msg->slab_cache_depot);
+		xfree(msg->slab_cache_alloc);
+		xfree(msg->slab_cache_free);
+		xfree(msg->slab_cache_trips);
+		for (i = 0; i < msg->fwd_node_count; i++)
+			xfree(msg->fwd_node_name[i]);
+		xfree(msg->fwd_node_name);
+		xfree(msg->fwd_node_hop_avg);
+		xfree(msg->fwd_node_hop_max);
+		xfree(msg->fwd_node_resp);
+		xfree(msg->fwd_node_fail);
+		xfree(msg->fwd_node_leaf);
 		xfree(msg->rpc_type_id);
 		xfree(msg->rpc_type_cnt);
 		xfree(msg->rpc_type_time);
@@ -4116,6 +4151,8 @@ extern void slurm_free_slurmd_status(slurmd_status_t* slurmd_status_ptr)
 		xfree(slurmd_status_ptr->slurmd_logfile);
 		xfree(slurmd_status_ptr->step_list);
 		xfree(slurmd_status_ptr->version);
+		xfree(slurmd_status_ptr->launch_hist_new);
+		xfree(slurmd_status_ptr->launch_hist_pooled);
 		xfree(slurmd_status_ptr);
 	}
 }
@@ -4132,6 +4169,7 @@ extern void slurm_free_job_info_msg(job_info_msg_t * job_buffer_ptr)
 			_free_all_job_info(job_buffer_ptr);
 			xfree(job_buffer_ptr->job_array);
 		}
+		xfree(job_buffer_ptr->removed_job_ids);
 		xfree(job_buffer_ptr);
 	}
 }
@@ -4769,6 +4807,7 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 		slurm_free_last_update_msg(data);
 		break;
 	case REQUEST_JOB_INFO:
+	case REQUEST_JOB_INFO_DELTA:
 		slurm_free_job_info_request_msg(data);
 		break;
 	case REQUEST_NODE_INFO:
@@ -5122,6 +5161,9 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 	case RESPONSE_JOB_INFO:
 		slurm_free_job_info(data);
 		break;
+	case RESPONSE_JOB_INFO_DELTA:
+		slurm_free_job_info_msg(data);
+		break;
 	case REQUEST_HET_JOB_ALLOCATION:
 	case REQUEST_SUBMIT_BATCH_HET_JOB:
 	case RESPONSE_HET_JOB_ALLOCATION:
@@ -5411,6 +5453,10 @@ rpc_num2string(uint16_t opcode)
 		return "REQUEST_BURST_BUFFER_STATUS";
 	case RESPONSE_BURST_BUFFER_STATUS:
 		return "RESPONSE_BURST_BUFFER_STATUS";
+	case REQUEST_JOB_INFO_DELTA:
+		return "REQUEST_JOB_INFO_DELTA";
+	case RESPONSE_JOB_INFO_DELTA:
+		return "RESPONSE_JOB_INFO_DELTA";
 
 	case REQUEST_UPDATE_JOB:				/* 3001 */
 		return "REQUEST_UPDATE_JOB";
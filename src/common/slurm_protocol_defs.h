@@ -286,6 +286,8 @@ typedef enum {
 	RESPONSE_CONTROL_STATUS,
 	REQUEST_BURST_BUFFER_STATUS,
 	RESPONSE_BURST_BUFFER_STATUS,
+	REQUEST_JOB_INFO_DELTA,
+	RESPONSE_JOB_INFO_DELTA,
 
 	REQUEST_UPDATE_JOB = 3001,
 	REQUEST_UPDATE_NODE,
@@ -528,6 +530,11 @@ typedef struct ret_data_info {
 	char *node_name;
 	void *data; /* used to hold the return message data (i.e.
 		       return_code_msg_t */
+	uint32_t hop_time; /* usec from the node being sent the message to
+			    * its reply, as measured by the node sending
+			    * it, zero if not measured */
+	uint32_t hop_self; /* usec of hop_time not spent waiting on the
+			    * nodes the message was forwarded on to */
 } ret_data_info_t;
 
 /*****************************************************************************\
@@ -1510,6 +1510,9 @@ _pack_job_sbcast_cred_msg(job_sbcast_cred_msg_t * msg, Buf buffer,
 		_pack_slurm_addr_array(msg->node_addr, msg->node_cnt, buffer,
 				       protocol_version);
 	pack_sbcast_cred(msg->sbcast_cred, buffer, protocol_version);
+
+	if (protocol_version >= SLURM_20_02_EXT_PROTOCOL_VERSION)
+		pack16(msg->protocol_version, buffer);
 }
 
 static int
@@ -1543,6 +1546,9 @@ _unpack_job_sbcast_cred_msg(job_sbcast_cred_msg_t ** msg, Buf buffer,
 	if (tmp_ptr->sbcast_cred == NULL)
 		goto unpack_error;
 
+	if (protocol_version >= SLURM_20_02_EXT_PROTOCOL_VERSION)
+		safe_unpack16(&tmp_ptr->protocol_version, buffer);
+
 	return SLURM_SUCCESS;
 
 unpack_error:
@@ -3337,6 +3343,24 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+/* Unpack RESPONSE_JOB_INFO_DELTA, see pack_job_delta() in slurmctld */
+static int _unpack_job_info_delta_msg(job_info_msg_t **msg, Buf buffer,
+				      uint16_t protocol_version)
+{
+	if (_unpack_job_info_msg(msg, buffer, protocol_version))
+		return SLURM_ERROR;
+
+	(*msg)->delta = 1;
+	safe_unpack32_array(&(*msg)->removed_job_ids,
+			    &(*msg)->removed_job_count, buffer);
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_job_info_msg(*msg);
+	*msg = NULL;
+	return SLURM_ERROR;
+}
+
 /* Translate bitmap representation from hex to decimal format, replacing
  * array_task_str and store the bitmap in job->array_bitmap. */
 static void _xlate_task_str(job_info_t *job_ptr)
@@ -9605,6 +9629,10 @@ _pack_ret_list(List ret_list,
 		pack32((uint32_t)ret_data_info->err, buffer);
 		pack16((uint16_t)ret_data_info->type, buffer);
 		packstr(ret_data_info->node_name, buffer);
+		if (protocol_version >= SLURM_20_02_EXT_PROTOCOL_VERSION) {
+			pack32(ret_data_info->hop_time, buffer);
+			pack32(ret_data_info->hop_self, buffer);
+		}
 
 		msg.msg_type = ret_data_info->type;
 		msg.data = ret_data_info->data;
@@ -9636,6 +9664,10 @@ _unpack_ret_list(List *ret_list,
 		safe_unpack16(&ret_data_info->type, buffer);
 		safe_unpackstr_xmalloc(&ret_data_info->node_name,
 				       &uint32_tmp, buffer);
+		if (protocol_version >= SLURM_20_02_EXT_PROTOCOL_VERSION) {
+			safe_unpack32(&ret_data_info->hop_time, buffer);
+			safe_unpack32(&ret_data_info->hop_self, buffer);
+		}
 		msg.msg_type = ret_data_info->type;
 		if (unpack_msg(&msg, buffer) != SLURM_SUCCESS)
 			goto unpack_error;
@@ -10981,6 +11013,15 @@ static void _pack_slurmd_status(slurmd_status_t *msg, Buf buffer,
 		packstr(msg->slurmd_logfile, buffer);
 		packstr(msg->step_list, buffer);
 		packstr(msg->version, buffer);
+
+		if (protocol_version >= SLURM_20_02_EXT_PROTOCOL_VERSION) {
+			pack32(msg->stepd_pool_size, buffer);
+			pack32(msg->stepd_pool_idle, buffer);
+			pack32_array(msg->launch_hist_new,
+				     msg->launch_hist_cnt, buffer);
+			pack32_array(msg->launch_hist_pooled,
+				     msg->launch_hist_cnt, buffer);
+		}
 	} else {
 		error("_pack_slurmd_status: protocol_version "
 		      "%hu not supported", protocol_version);
@@ -11020,6 +11061,17 @@ static int _unpack_slurmd_status(slurmd_status_t **msg_ptr, Buf buffer,
 					&uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&msg->version,
 					&uint32_tmp, buffer);
+
+		if (protocol_version >= SLURM_20_02_EXT_PROTOCOL_VERSION) {
+			safe_unpack32(&msg->stepd_pool_size, buffer);
+			safe_unpack32(&msg->stepd_pool_idle, buffer);
+			safe_unpack32_array(&msg->launch_hist_new,
+					    &msg->launch_hist_cnt, buffer);
+			safe_unpack32_array(&msg->launch_hist_pooled,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->launch_hist_cnt)
+				goto unpack_error;
+		}
 	} else {
 		error("_unpack_slurmd_status: protocol_version "
 		      "%hu not supported", protocol_version);
@@ -11471,6 +11523,129 @@ static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 				     buffer);
 		if (uint32_tmp != msg->rpc_dump_count)
 			goto unpack_error;
+
+		/* Appended by pack_ext_stat() */
+		if ((protocol_version >= SLURM_20_02_EXT_PROTOCOL_VERSION) &&
+		    msg->parts_packed) {
+			safe_unpackstr_array(&msg->lock_stats_name,
+					     &msg->lock_stats_count, buffer);
+			safe_unpack32_array(&msg->lock_cnt, &uint32_tmp,
+					    buffer);
+			if (uint32_tmp != msg->lock_stats_count)
+				goto unpack_error;
+			safe_unpack64_array(&msg->lock_wait_time, &uint32_tmp,
+					    buffer);
+			if (uint32_tmp != msg->lock_stats_count)
+				goto unpack_error;
+			safe_unpack64_array(&msg->lock_hold_time, &uint32_tmp,
+					    buffer);
+			if (uint32_tmp != msg->lock_stats_count)
+				goto unpack_error;
+			safe_unpack32_array(&msg->lock_hold_max, &uint32_tmp,
+					    buffer);
+			if (uint32_tmp != msg->lock_stats_count)
+				goto unpack_error;
+			safe_unpack32_array(&msg->lock_hist_bound,
+					    &msg->lock_hist_size, buffer);
+			safe_unpack32_array(&msg->lock_hist, &uint32_tmp,
+					    buffer);
+			if (uint32_tmp != (msg->lock_stats_count *
+					   msg->lock_hist_size))
+				goto unpack_error;
+
+			safe_unpackstr_array(&msg->rpc_class_name,
+					     &msg->rpc_class_count, buffer);
+			safe_unpack32_array(&msg->rpc_class_cnt, &uint32_tmp,
+					    buffer);
+			if (uint32_tmp != msg->rpc_class_count)
+				goto unpack_error;
+			safe_unpack64_array(&msg->rpc_class_time, &uint32_tmp,
+					    buffer);
+			if (uint32_tmp != msg->rpc_class_count)
+				goto unpack_error;
+			safe_unpack32_array(&msg->rpc_class_active,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->rpc_class_count)
+				goto unpack_error;
+			safe_unpack32_array(&msg->rpc_class_active_max,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->rpc_class_count)
+				goto unpack_error;
+			safe_unpack32_array(&msg->rpc_class_busy, &uint32_tmp,
+					    buffer);
+			if (uint32_tmp != msg->rpc_class_count)
+				goto unpack_error;
+			safe_unpack32_array(&msg->rpc_class_rate, &uint32_tmp,
+					    buffer);
+			if (uint32_tmp != msg->rpc_class_count)
+				goto unpack_error;
+
+			safe_unpack32(&msg->decay_cycle_counter, buffer);
+			safe_unpack64(&msg->decay_cycle_sum, buffer);
+			safe_unpack32(&msg->decay_cycle_last, buffer);
+			safe_unpack32(&msg->decay_cycle_max, buffer);
+			safe_unpack32(&msg->decay_jobs_last, buffer);
+			safe_unpack32(&msg->decay_threads, buffer);
+			safe_unpack_time(&msg->decay_when_last_cycle, buffer);
+
+			safe_unpackstr_array(&msg->slab_cache_name,
+					     &msg->slab_cache_count, buffer);
+			safe_unpack32_array(&msg->slab_cache_size, &uint32_tmp,
+					    buffer);
+			if (uint32_tmp != msg->slab_cache_count)
+				goto unpack_error;
+			safe_unpack32_array(&msg->slab_cache_kbytes,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->slab_cache_count)
+				goto unpack_error;
+			safe_unpack32_array(&msg->slab_cache_depot,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->slab_cache_count)
+				goto unpack_error;
+			safe_unpack64_array(&msg->slab_cache_alloc,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->slab_cache_count)
+				goto unpack_error;
+			safe_unpack64_array(&msg->slab_cache_free, &uint32_tmp,
+					    buffer);
+			if (uint32_tmp != msg->slab_cache_count)
+				goto unpack_error;
+			safe_unpack64_array(&msg->slab_cache_trips,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->slab_cache_count)
+				goto unpack_error;
+			safe_unpack64(&msg->arena_count, buffer);
+			safe_unpack64(&msg->arena_alloc_count, buffer);
+			safe_unpack64(&msg->arena_alloc_bytes, buffer);
+			safe_unpack64(&msg->arena_block_count, buffer);
+			safe_unpack32(&msg->arena_max_bytes, buffer);
+
+			safe_unpack64(&msg->fwd_resp_count, buffer);
+			safe_unpack64(&msg->fwd_fail_count, buffer);
+			safe_unpack64(&msg->fwd_leaf_count, buffer);
+			safe_unpackstr_array(&msg->fwd_node_name,
+					     &msg->fwd_node_count, buffer);
+			safe_unpack32_array(&msg->fwd_node_hop_avg,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->fwd_node_count)
+				goto unpack_error;
+			safe_unpack32_array(&msg->fwd_node_hop_max,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->fwd_node_count)
+				goto unpack_error;
+			safe_unpack32_array(&msg->fwd_node_resp, &uint32_tmp,
+					    buffer);
+			if (uint32_tmp != msg->fwd_node_count)
+				goto unpack_error;
+			safe_unpack32_array(&msg->fwd_node_fail, &uint32_tmp,
+					    buffer);
+			if (uint32_tmp != msg->fwd_node_count)
+				goto unpack_error;
+			safe_unpack32_array(&msg->fwd_node_leaf, &uint32_tmp,
+					    buffer);
+			if (uint32_tmp != msg->fwd_node_count)
+				goto unpack_error;
+		}
 	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpack32(&msg->parts_packed,	buffer);
 		if (msg->parts_packed) {
@@ -12088,6 +12263,7 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 					 msg->protocol_version);
 		break;
 	case RESPONSE_JOB_INFO:
+	case RESPONSE_JOB_INFO_DELTA:
 		_pack_job_info_msg((slurm_msg_t *) msg, buffer);
 		break;
 	case RESPONSE_BATCH_SCRIPT:
@@ -12302,6 +12478,7 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 					    msg->protocol_version);
 		break;
 	case REQUEST_JOB_INFO:
+	case REQUEST_JOB_INFO_DELTA:
 		_pack_job_info_request_msg((job_info_request_msg_t *)
 					   msg->data, buffer,
 					   msg->protocol_version);
@@ -12753,6 +12930,11 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 					  buffer,
 					  msg->protocol_version);
 		break;
+	case RESPONSE_JOB_INFO_DELTA:
+		rc = _unpack_job_info_delta_msg((job_info_msg_t **)
+						&(msg->data), buffer,
+						msg->protocol_version);
+		break;
 	case RESPONSE_BATCH_SCRIPT:
 		rc = _unpack_job_script_msg((char **) &(msg->data),
 					    buffer,
@@ -12984,6 +13166,7 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 		break;
 		/********  job_step_id_t Messages  ********/
 	case REQUEST_JOB_INFO:
+	case REQUEST_JOB_INFO_DELTA:
 		rc = _unpack_job_info_request_msg((job_info_request_msg_t**)
 						  & (msg->data), buffer,
 						  msg->protocol_version);
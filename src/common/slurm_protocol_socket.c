@@ -59,6 +59,7 @@
 #include "src/common/slurm_protocol_defs.h"
 #include "src/common/log.h"
 #include "src/common/fd.h"
+#include "src/common/slab.h"
 #include "src/common/strlcpy.h"
 #include "src/common/xsignal.h"
 #include "src/common/xstring.h"
@@ -146,9 +147,9 @@ extern ssize_t slurm_msg_recvfrom_timeout(int fd, char **pbuf, size_t *lenp,
 		slurm_seterrno_ret(SLURM_PROTOCOL_INSANE_MSG_LENGTH);
 
 	/*
-	 *  Allocate memory on heap for message
+	 *  Allocate memory for message, from the thread's arena if any
 	 */
-	*pbuf = xmalloc_nz(msglen);
+	*pbuf = arena_alloc(msglen);
 
 	if (slurm_recv_timeout(fd, *pbuf, msglen, 0, tmout) != msglen) {
 		xfree(*pbuf);
@@ -103,6 +103,8 @@
 #define	bit_fls			slurm_bit_fls
 #define	bit_fill_gaps		slurm_bit_fill_gaps
 #define	bit_super_set		slurm_bit_super_set
+#define	bit_and_not_count	slurm_bit_and_not_count
+#define	bit_and_not_any		slurm_bit_and_not_any
 #define	bit_copy		slurm_bit_copy
 #define	bit_pick_cnt		slurm_bit_pick_cnt
 #define bit_nffc		slurm_bit_nffc
@@ -151,6 +153,13 @@
 #define	hostlist_shift_range	slurm_hostlist_shift_range
 #define	hostlist_sort		slurm_hostlist_sort
 #define	hostlist_uniq		slurm_hostlist_uniq
+#define	hostlist_union		slurm_hostlist_union
+#define	hostlist_intersection	slurm_hostlist_intersection
+#define	hostlist_difference	slurm_hostlist_difference
+#define	hostlist_index_create	slurm_hostlist_index_create
+#define	hostlist_index_destroy	slurm_hostlist_index_destroy
+#define	hostlist_index_find	slurm_hostlist_index_find
+#define	hostlist_index_bitmap	slurm_hostlist_index_bitmap
 #define	hostset_copy		slurm_hostset_copy
 #define	hostset_count		slurm_hostset_count
 #define	hostset_create		slurm_hostset_create
@@ -43,6 +43,8 @@
 #include <dirent.h>
 #include <grp.h>
 #include <inttypes.h>
+#include <poll.h>
+#include <pthread.h>
 #include <regex.h>
 #include <signal.h>
 #include <stdlib.h>
@@ -81,6 +83,222 @@ strong_alias(xfree_struct_passwd, slurm_xfree_struct_passwd);
 strong_alias(stepd_getgr, slurm_stepd_getgr);
 strong_alias(xfree_struct_group_array, slurm_xfree_struct_group_array);
 
+/*
+ * Registry of running steps kept by slurmd in place of scanning its spool
+ * directory, with up to STEPD_IDLE_MAX idle connections to each step kept
+ * open for reuse by stepd_connect(). The directory is still scanned every
+ * STEPD_RESCAN_TIME seconds in case a step was missed.
+ */
+#define STEPD_IDLE_MAX		2
+#define STEPD_RESCAN_TIME	300
+
+typedef struct {
+	uint32_t jobid;
+	uint32_t stepid;
+	uint16_t protocol_version;
+	int idle_cnt;
+	int idle_fd[STEPD_IDLE_MAX];
+} stepd_reg_t;
+
+/* Step of a connection handed out by stepd_connect(), indexed by fd */
+typedef struct {
+	uint32_t jobid;
+	uint32_t stepid;
+	bool busy;
+} stepd_conn_t;
+
+static pthread_mutex_t reg_mutex = PTHREAD_MUTEX_INITIALIZER;
+static List reg_list = NULL;
+static char *reg_directory = NULL;
+static char *reg_nodename = NULL;
+static time_t reg_scan_time = 0;
+static stepd_conn_t *reg_conn = NULL;
+static int reg_conn_size = 0;
+
+static void _free_step_loc_t(step_loc_t *loc);
+static List _stepd_scan(const char *directory, const char *nodename);
+
+static int _reg_find(void *x, void *key)
+{
+	stepd_reg_t *reg = x;
+	uint32_t *id = key;
+
+	return ((reg->jobid == id[0]) && (reg->stepid == id[1]));
+}
+
+static void _reg_free(void *x)
+{
+	stepd_reg_t *reg = x;
+	int i;
+
+	for (i = 0; i < reg->idle_cnt; i++)
+		close(reg->idle_fd[i]);
+	xfree(reg);
+}
+
+/* Return true if the registry holds the steps of directory and nodename.
+ * Must hold reg_mutex. */
+static bool _reg_match(const char *directory, const char *nodename)
+{
+	return (reg_list && !xstrcmp(directory, reg_directory) &&
+		!xstrcmp(nodename, reg_nodename));
+}
+
+/* Must hold reg_mutex */
+static stepd_reg_t *_reg_lookup(uint32_t jobid, uint32_t stepid, bool add)
+{
+	uint32_t id[2] = { jobid, stepid };
+	stepd_reg_t *reg;
+
+	if (!(reg = list_find_first(reg_list, _reg_find, id)) && add) {
+		reg = xmalloc(sizeof(stepd_reg_t));
+		reg->jobid = jobid;
+		reg->stepid = stepid;
+		list_append(reg_list, reg);
+	}
+	return reg;
+}
+
+/* No request is outstanding on an idle connection, so it only becomes
+ * readable once the stepd has closed it */
+static bool _idle_fd_closed(int fd)
+{
+	struct pollfd pfd = { .fd = fd, .events = POLLIN };
+
+	return (poll(&pfd, 1, 0) != 0);
+}
+
+/*
+ * Close the idle connections which the stepd has closed.
+ * RET true if the step is gone. Must hold reg_mutex.
+ */
+static bool _reg_prune(stepd_reg_t *reg)
+{
+	struct stat stat_buf;
+	bool closed = false, gone;
+	char *name;
+	int i = 0;
+
+	while (i < reg->idle_cnt) {
+		if (_idle_fd_closed(reg->idle_fd[i])) {
+			close(reg->idle_fd[i]);
+			reg->idle_fd[i] = reg->idle_fd[--reg->idle_cnt];
+			closed = true;
+		} else
+			i++;
+	}
+	if (!closed)
+		return false;
+
+	/* The stepd removes its socket before closing connections */
+	name = xstrdup_printf("%s/%s_%u.%u", reg_directory, reg_nodename,
+			      reg->jobid, reg->stepid);
+	gone = (stat(name, &stat_buf) < 0);
+	xfree(name);
+	return gone;
+}
+
+/* Add the steps found in the spool directory. Must hold reg_mutex. */
+static void _reg_scan(void)
+{
+	List steps = _stepd_scan(reg_directory, reg_nodename);
+	step_loc_t *loc;
+
+	while ((loc = list_pop(steps))) {
+		(void) _reg_lookup(loc->jobid, loc->stepid, true);
+		_free_step_loc_t(loc);
+	}
+	FREE_NULL_LIST(steps);
+	reg_scan_time = time(NULL);
+}
+
+/* Return a List of step_loc_t for the registered steps.
+ * Must hold reg_mutex. */
+static List _reg_available(void)
+{
+	List l = list_create((ListDelF) _free_step_loc_t);
+	ListIterator itr;
+	stepd_reg_t *reg;
+	step_loc_t *loc;
+
+	if (time(NULL) >= (reg_scan_time + STEPD_RESCAN_TIME))
+		_reg_scan();
+
+	itr = list_iterator_create(reg_list);
+	while ((reg = list_next(itr))) {
+		if (_reg_prune(reg)) {
+			debug4("%s: step %u.%u is gone",
+			       __func__, reg->jobid, reg->stepid);
+			list_delete_item(itr);
+			continue;
+		}
+		loc = xmalloc(sizeof(step_loc_t));
+		loc->directory = xstrdup(reg_directory);
+		loc->nodename = xstrdup(reg_nodename);
+		loc->jobid = reg->jobid;
+		loc->stepid = reg->stepid;
+		loc->protocol_version = reg->protocol_version;
+		list_append(l, loc);
+	}
+	list_iterator_destroy(itr);
+
+	return l;
+}
+
+/* Must hold reg_mutex */
+static void _reg_conn_set(int fd, uint32_t jobid, uint32_t stepid)
+{
+	if (fd >= reg_conn_size) {
+		reg_conn_size = MAX(fd + 1, reg_conn_size * 2);
+		xrecalloc(reg_conn, reg_conn_size, sizeof(stepd_conn_t));
+	}
+	reg_conn[fd].jobid = jobid;
+	reg_conn[fd].stepid = stepid;
+	reg_conn[fd].busy = true;
+}
+
+/* Return an idle connection to a step, or -1. Must hold reg_mutex. */
+static int _reg_checkout(uint32_t jobid, uint32_t stepid,
+			 uint16_t *protocol_version)
+{
+	stepd_reg_t *reg = _reg_lookup(jobid, stepid, false);
+	int fd;
+
+	while (reg && reg->idle_cnt) {
+		fd = reg->idle_fd[--reg->idle_cnt];
+		if (_idle_fd_closed(fd)) {
+			close(fd);
+			continue;
+		}
+		*protocol_version = reg->protocol_version;
+		_reg_conn_set(fd, jobid, stepid);
+		return fd;
+	}
+
+	return -1;
+}
+
+/*
+ * Record the result of a new connection to a step, a step which can not be
+ * connected to is gone. Must hold reg_mutex.
+ */
+static void _reg_connected(uint32_t jobid, uint32_t stepid, int fd,
+			   uint16_t protocol_version)
+{
+	uint32_t id[2] = { jobid, stepid };
+	stepd_reg_t *reg;
+
+	if (fd == -1) {
+		list_delete_all(reg_list, _reg_find, id);
+		return;
+	}
+
+	reg = _reg_lookup(jobid, stepid, true);
+	reg->protocol_version = protocol_version;
+	fd_set_close_on_exec(fd);
+	_reg_conn_set(fd, jobid, stepid);
+}
+
 static bool
 _slurm_authorized_user()
 {
@@ -296,20 +514,10 @@ fail1:
 	return -1;
 }
 
-/*
- * Connect to a slurmstepd proccess by way of its unix domain socket.
- *
- * Both "directory" and "nodename" may be null, in which case stepd_connect
- * will attempt to determine them on its own.  If you are using multiple
- * slurmd on one node (unusual outside of development environments), you
- * will get one of the local NodeNames more-or-less at random.
- *
- * Returns a file descriptor for the opened socket on success alongside the
- * protocol_version for the stepd, or -1 on error.
- */
-extern int stepd_connect(const char *directory, const char *nodename,
-			 uint32_t jobid, uint32_t stepid,
-			 uint16_t *protocol_version)
+/* Open a new connection to a step and exchange protocol versions */
+static int _stepd_connect(const char *directory, const char *nodename,
+			  uint32_t jobid, uint32_t stepid,
+			  uint16_t *protocol_version)
 {
 	int req = SLURM_PROTOCOL_VERSION;
 	int fd = -1;
@@ -361,6 +569,116 @@ fail1:
 	return fd;
 }
 
+/*
+ * Connect to a slurmstepd proccess by way of its unix domain socket.
+ *
+ * Both "directory" and "nodename" may be null, in which case stepd_connect
+ * will attempt to determine them on its own.  If you are using multiple
+ * slurmd on one node (unusual outside of development environments), you
+ * will get one of the local NodeNames more-or-less at random.
+ *
+ * Returns a file descriptor for the opened socket on success alongside the
+ * protocol_version for the stepd, or -1 on error.
+ */
+extern int stepd_connect(const char *directory, const char *nodename,
+			 uint32_t jobid, uint32_t stepid,
+			 uint16_t *protocol_version)
+{
+	bool registered;
+	int fd = -1;
+
+	/* slurmd reuses idle connections to the steps it has registered */
+	slurm_mutex_lock(&reg_mutex);
+	if ((registered = _reg_match(directory, nodename)))
+		fd = _reg_checkout(jobid, stepid, protocol_version);
+	slurm_mutex_unlock(&reg_mutex);
+	if (fd != -1)
+		return fd;
+
+	fd = _stepd_connect(directory, nodename, jobid, stepid,
+			    protocol_version);
+	if (!registered)
+		return fd;
+
+	slurm_mutex_lock(&reg_mutex);
+	if (_reg_match(directory, nodename))
+		_reg_connected(jobid, stepid, fd, *protocol_version);
+	slurm_mutex_unlock(&reg_mutex);
+
+	return fd;
+}
+
+/*
+ * Release a connection from stepd_connect(). In slurmd an idle connection
+ * to a running step is kept open for reuse if "reuse" is set, otherwise it
+ * is closed. Pass false after any error, the stream may be out of sync.
+ */
+extern void stepd_disconnect(int fd, bool reuse)
+{
+	stepd_reg_t *reg;
+
+	if (fd < 0)
+		return;
+
+	slurm_mutex_lock(&reg_mutex);
+	if (reg_list && (fd < reg_conn_size) && reg_conn[fd].busy) {
+		reg_conn[fd].busy = false;
+		reg = _reg_lookup(reg_conn[fd].jobid, reg_conn[fd].stepid,
+				  false);
+		/*
+		 * Older stepds do not close idle connections when the step
+		 * ends and would wait for them before exiting
+		 */
+		if (reuse && reg &&
+		    (reg->protocol_version == SLURM_PROTOCOL_VERSION) &&
+		    (reg->idle_cnt < STEPD_IDLE_MAX) && !_idle_fd_closed(fd)) {
+			reg->idle_fd[reg->idle_cnt++] = fd;
+			fd = -1;
+		}
+	}
+	slurm_mutex_unlock(&reg_mutex);
+
+	if (fd >= 0)
+		close(fd);
+}
+
+/*
+ * Keep a registry of the steps in "directory" of "nodename", seeded from
+ * the sockets found there, for stepd_available() and stepd_connect().
+ */
+extern void stepd_registry_init(const char *directory, const char *nodename)
+{
+	slurm_mutex_lock(&reg_mutex);
+	if (!reg_list) {
+		reg_list = list_create(_reg_free);
+		reg_directory = xstrdup(directory);
+		reg_nodename = xstrdup(nodename);
+		_reg_scan();
+	}
+	slurm_mutex_unlock(&reg_mutex);
+}
+
+/* Register a step once its stepd is listening on its socket */
+extern void stepd_registry_add(uint32_t jobid, uint32_t stepid)
+{
+	slurm_mutex_lock(&reg_mutex);
+	if (reg_list)
+		(void) _reg_lookup(jobid, stepid, true);
+	slurm_mutex_unlock(&reg_mutex);
+}
+
+/* Close all idle connections and free the registry */
+extern void stepd_registry_fini(void)
+{
+	slurm_mutex_lock(&reg_mutex);
+	FREE_NULL_LIST(reg_list);
+	xfree(reg_directory);
+	xfree(reg_nodename);
+	xfree(reg_conn);
+	reg_conn_size = 0;
+	slurm_mutex_unlock(&reg_mutex);
+}
+
 /*
  * Connect to a slurmstepd proccess by way of its unix domain socket.
  *
@@ -638,10 +956,6 @@ extern List
 stepd_available(const char *directory, const char *nodename)
 {
 	List l;
-	DIR *dp;
-	struct dirent *ent;
-	regex_t re;
-	struct stat stat_buf;
 
 	if (nodename == NULL) {
 		if (!(nodename = _guess_nodename())) {
@@ -658,6 +972,27 @@ stepd_available(const char *directory, const char *nodename)
 		slurm_conf_unlock();
 	}
 
+	slurm_mutex_lock(&reg_mutex);
+	if (_reg_match(directory, nodename))
+		l = _reg_available();
+	else
+		l = NULL;
+	slurm_mutex_unlock(&reg_mutex);
+	if (l)
+		return l;
+
+	return _stepd_scan(directory, nodename);
+}
+
+/* Scan "directory" for the sockets of steps of "nodename" */
+static List _stepd_scan(const char *directory, const char *nodename)
+{
+	List l;
+	DIR *dp;
+	struct dirent *ent;
+	regex_t re;
+	struct stat stat_buf;
+
 	l = list_create((ListDelF) _free_step_loc_t);
 	if (_sockname_regex_init(&re, nodename) == -1)
 		goto done;
@@ -1224,6 +1559,7 @@ stepd_stat_jobacct(int fd, uint16_t protocol_version,
 
 	return rc;
 rwfail:
+	rc = SLURM_ERROR;
 	error("gathering job accounting: %d", rc);
 	jobacctinfo_destroy(resp->jobacct);
 	resp->jobacct = NULL;
@@ -150,6 +150,27 @@ int stepd_terminate(int fd, uint16_t protocol_version);
 extern int stepd_connect(const char *directory, const char *nodename,
 		  uint32_t jobid, uint32_t stepid, uint16_t *protocol_version);
 
+/*
+ * Release a connection from stepd_connect(). In slurmd an idle connection
+ * to a running step is kept open for reuse if "reuse" is set, otherwise it
+ * is closed. Pass false after any error, the stream may be out of sync.
+ */
+extern void stepd_disconnect(int fd, bool reuse);
+
+/*
+ * Keep a registry of the steps in "directory" of "nodename", seeded from
+ * the sockets found there, for stepd_available() and stepd_connect() to use
+ * in place of scanning the directory and opening a new connection for every
+ * request. Used by slurmd.
+ */
+extern void stepd_registry_init(const char *directory, const char *nodename);
+
+/* Register a step once its stepd is listening on its socket */
+extern void stepd_registry_add(uint32_t jobid, uint32_t stepid);
+
+/* Close all idle connections and free the registry */
+extern void stepd_registry_fini(void);
+
 
 /*
  * Connect to a slurmstepd proccess by way of its unix domain socket.
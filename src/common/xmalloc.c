@@ -50,6 +50,7 @@
 
 #include "src/common/log.h"
 #include "src/common/macros.h"
+#include "src/common/slab.h"
 #include "src/common/xmalloc.h"
 
 strong_alias(xfree_ptr, slurm_xfree_ptr);
@@ -160,6 +161,12 @@ extern void * slurm_xrecalloc(void **item, size_t count, size_t size,
 		size_t old_size;
 		p = (size_t *)*item - 2;
 
+		/* slab or arena memory is copied or grown in its arena */
+		if ((p[0] == ARENA_MAGIC) || IS_SLAB_MAGIC(p[0])) {
+			*item = slab_realloc(*item, count_size, clear);
+			return *item;
+		}
+
 		/* magic cookie still there? */
 		xmalloc_assert(p[0] == XMALLOC_MAGIC);
 		old_size = p[1];
@@ -204,7 +211,9 @@ size_t slurm_xsize(void *item, const char *file, int line, const char *func)
 {
 	size_t *p = (size_t *)item - 2;
 	xmalloc_assert(item != NULL);
-	xmalloc_assert(p[0] == XMALLOC_MAGIC); /* CLANG false positive here */
+	/* CLANG false positive here */
+	xmalloc_assert((p[0] == XMALLOC_MAGIC) || (p[0] == ARENA_MAGIC) ||
+		       IS_SLAB_MAGIC(p[0]));
 	return p[1];
 }
 
@@ -217,6 +226,11 @@ void slurm_xfree(void **item, const char *file, int line, const char *func)
 {
 	if (*item != NULL) {
 		size_t *p = (size_t *)*item - 2;
+		if ((p[0] == ARENA_MAGIC) || IS_SLAB_MAGIC(p[0])) {
+			slab_free(*item);
+			*item = NULL;
+			return;
+		}
 		/* magic cookie still there? */
 		xmalloc_assert(p[0] == XMALLOC_MAGIC);
 		p[0] = 0;	/* make sure xfree isn't called twice */
@@ -202,6 +202,62 @@ end_it:
 	return rc;
 }
 
+/* NOTE: Ensure that mysql_conn->lock is set on function entry */
+static void _batch_clear(mysql_conn_t *mysql_conn)
+{
+	xfree(mysql_conn->batch_head);
+	xfree(mysql_conn->batch_query);
+	FREE_NULL_LIST(mysql_conn->batch_rows);
+	mysql_conn->batch_size = 0;
+	xfree(mysql_conn->batch_tail);
+}
+
+/*
+ * Send the rows and statements queued on mysql_conn in one round trip.
+ * NOTE: Ensure that mysql_conn->lock is set on function entry
+ */
+static int _batch_flush(mysql_conn_t *mysql_conn)
+{
+	char *query = NULL, *pos = NULL, *row, *sep = "";
+	ListIterator itr;
+	int rc = SLURM_SUCCESS, row_cnt = 0;
+
+	if (!mysql_conn->batch_size)
+		return SLURM_SUCCESS;
+
+	if (mysql_conn->batch_rows) {
+		row_cnt = list_count(mysql_conn->batch_rows);
+		xstrfmtcatat(query, &pos, "%s", mysql_conn->batch_head);
+		itr = list_iterator_create(mysql_conn->batch_rows);
+		while ((row = list_next(itr))) {
+			xstrfmtcatat(query, &pos, "%s%s", sep, row);
+			sep = ", ";
+		}
+		list_iterator_destroy(itr);
+		xstrfmtcatat(query, &pos, "%s;", mysql_conn->batch_tail);
+	}
+	if (mysql_conn->batch_query)
+		xstrfmtcatat(query, &pos, "%s", mysql_conn->batch_query);
+
+	rc = _mysql_query_internal(mysql_conn->db_conn, query);
+	xfree(query);
+	if (rc == SLURM_SUCCESS)
+		rc = _clear_results(mysql_conn->db_conn);
+
+	if (rc != SLURM_SUCCESS) {
+		/*
+		 * The batch may hold rows of requests already answered, so
+		 * the transaction must not be committed without them
+		 */
+		error("%s: unable to send %d queued rows and the statements queued with them",
+		      __func__, row_cnt);
+		if (mysql_conn->rollback)
+			mysql_conn->batch_failed = true;
+	}
+	_batch_clear(mysql_conn);
+	return rc;
+}
+
 /* NOTE: Ensure that mysql_conn->lock is NOT set on function entry */
 static int _mysql_make_table_current(mysql_conn_t *mysql_conn, char *table_name,
 				     storage_field_t *fields, char *ending)
@@ -663,6 +719,8 @@ extern int destroy_mysql_conn(mysql_conn_t *mysql_conn)
 {
 	if (mysql_conn) {
 		mysql_db_close_db_connection(mysql_conn);
+		/* never committed, drop it like the rest of the transaction */
+		_batch_clear(mysql_conn);
 		xfree(mysql_conn->pre_commit_query);
 		xfree(mysql_conn->cluster_name);
 		slurm_mutex_destroy(&mysql_conn->lock);
@@ -831,7 +889,8 @@ extern int mysql_db_query(mysql_conn_t *mysql_conn, char *query)
 		return 0;	/* For CLANG false positive */
 	}
 	slurm_mutex_lock(&mysql_conn->lock);
-	rc = _mysql_query_internal(mysql_conn->db_conn, query);
+	if ((rc = _batch_flush(mysql_conn)) == SLURM_SUCCESS)
+		rc = _mysql_query_internal(mysql_conn->db_conn, query);
 	slurm_mutex_unlock(&mysql_conn->lock);
 	return rc;
 }
@@ -849,7 +908,9 @@ extern int mysql_db_delete_affected_rows(mysql_conn_t *mysql_conn, char *query)
 		return 0;	/* For CLANG false positive */
 	}
 	slurm_mutex_lock(&mysql_conn->lock);
-	if (!(rc = _mysql_query_internal(mysql_conn->db_conn, query)))
+	if ((rc = _batch_flush(mysql_conn)) != SLURM_SUCCESS)
+		rc = -1;
+	else if (!(rc = _mysql_query_internal(mysql_conn->db_conn, query)))
 		rc = mysql_affected_rows(mysql_conn->db_conn);
 	slurm_mutex_unlock(&mysql_conn->lock);
 	return rc;
@@ -884,6 +945,14 @@ extern int mysql_db_commit(mysql_conn_t *mysql_conn)
 		return SLURM_ERROR;
 
 	slurm_mutex_lock(&mysql_conn->lock);
+	if (((rc = _batch_flush(mysql_conn)) != SLURM_SUCCESS) ||
+	    mysql_conn->batch_failed) {
+		/* don't commit a transaction missing part of a batch */
+		error("%s: queued statements were lost, not committing",
+		      __func__);
+		slurm_mutex_unlock(&mysql_conn->lock);
+		return SLURM_ERROR;
+	}
 	/* clear out the old results so we don't get a 2014 error */
 	_clear_results(mysql_conn->db_conn);
 	if (mysql_commit(mysql_conn->db_conn)) {
@@ -905,6 +974,8 @@ extern int mysql_db_rollback(mysql_conn_t *mysql_conn)
 		return SLURM_ERROR;
 
 	slurm_mutex_lock(&mysql_conn->lock);
+	_batch_clear(mysql_conn);
+	mysql_conn->batch_failed = false;
 	/* clear out the old results so we don't get a 2014 error */
 	_clear_results(mysql_conn->db_conn);
 	if (mysql_rollback(mysql_conn->db_conn)) {
@@ -931,6 +1002,8 @@ extern MYSQL_RES *mysql_db_query_ret(mysql_conn_t *mysql_conn,
 	MYSQL_RES *result = NULL;
 
 	slurm_mutex_lock(&mysql_conn->lock);
+	if (_batch_flush(mysql_conn) != SLURM_SUCCESS)
+		goto fini;
 	if (_mysql_query_internal(mysql_conn->db_conn, query) != SLURM_ERROR)  {
 		if (mysql_errno(mysql_conn->db_conn) == ER_NO_SUCH_TABLE)
 			goto fini;
@@ -960,8 +1033,9 @@ extern int mysql_db_query_check_after(mysql_conn_t *mysql_conn, char *query)
 	int rc = SLURM_SUCCESS;
 
 	slurm_mutex_lock(&mysql_conn->lock);
-	if ((rc = _mysql_query_internal(
-		     mysql_conn->db_conn, query)) != SLURM_ERROR)
+	if (((rc = _batch_flush(mysql_conn)) == SLURM_SUCCESS) &&
+	    ((rc = _mysql_query_internal(
+		      mysql_conn->db_conn, query)) != SLURM_ERROR))
 		rc = _clear_results(mysql_conn->db_conn);
 	slurm_mutex_unlock(&mysql_conn->lock);
 	return rc;
@@ -972,7 +1046,8 @@ extern uint64_t mysql_db_insert_ret_id(mysql_conn_t *mysql_conn, char *query)
 	uint64_t new_id = 0;
 
 	slurm_mutex_lock(&mysql_conn->lock);
-	if (_mysql_query_internal(mysql_conn->db_conn, query) != SLURM_ERROR)  {
+	if ((_batch_flush(mysql_conn) == SLURM_SUCCESS) &&
+	    (_mysql_query_internal(mysql_conn->db_conn, query) != SLURM_ERROR)) {
 		new_id = mysql_insert_id(mysql_conn->db_conn);
 		if (!new_id) {
 			/* should have new id */
@@ -985,6 +1060,72 @@ extern uint64_t mysql_db_insert_ret_id(mysql_conn_t *mysql_conn, char *query)
 
 }
 
+extern int mysql_db_batch_insert(mysql_conn_t *mysql_conn, char *head,
+				 char *row, char *tail)
+{
+	int rc = SLURM_SUCCESS;
+
+	if (!mysql_conn->rollback) {
+		/* autocommit, nothing would come along to send the batch */
+		char *query = xstrdup_printf("%s%s%s;", head, row, tail);
+		rc = mysql_db_query(mysql_conn, query);
+		xfree(query);
+		return rc;
+	}
+
+	slurm_mutex_lock(&mysql_conn->lock);
+	/*
+	 * The insert is sent ahead of the queued statements, so send those
+	 * first if there are any to keep everything in the order it was
+	 * queued.
+	 */
+	if (mysql_conn->batch_query ||
+	    (mysql_conn->batch_rows &&
+	     (xstrcmp(head, mysql_conn->batch_head) ||
+	      xstrcmp(tail, mysql_conn->batch_tail))))
+		rc = _batch_flush(mysql_conn);
+	if (rc != SLURM_SUCCESS) {
+		slurm_mutex_unlock(&mysql_conn->lock);
+		return rc;
+	}
+	if (!mysql_conn->batch_rows) {
+		mysql_conn->batch_rows = list_create(xfree_ptr);
+		mysql_conn->batch_head = xstrdup(head);
+		mysql_conn->batch_tail = xstrdup(tail);
+	}
+	list_append(mysql_conn->batch_rows, xstrdup(row));
+	mysql_conn->batch_size += strlen(row);
+	if ((list_count(mysql_conn->batch_rows) >= MYSQL_BATCH_MAX_ROWS) ||
+	    (mysql_conn->batch_size >= MYSQL_BATCH_MAX_SIZE))
+		rc = _batch_flush(mysql_conn);
+	slurm_mutex_unlock(&mysql_conn->lock);
+
+	return rc;
+}
+
+extern int mysql_db_batch_query(mysql_conn_t *mysql_conn, char *query)
+{
+	int rc = SLURM_SUCCESS;
+	int len = strlen(query);
+
+	if (!mysql_conn->rollback)
+		return mysql_db_query(mysql_conn, query);
+
+	slurm_mutex_lock(&mysql_conn->lock);
+	xstrcat(mysql_conn->batch_query, query);
+	/* statements are sent together, make sure this one is terminated */
+	if (len && (query[len - 1] != ';')) {
+		xstrcat(mysql_conn->batch_query, ";");
+		len++;
+	}
+	mysql_conn->batch_size += len;
+	if (mysql_conn->batch_size >= MYSQL_BATCH_MAX_SIZE)
+		rc = _batch_flush(mysql_conn);
+	slurm_mutex_unlock(&mysql_conn->lock);
+
+	return rc;
+}
+
 extern int mysql_db_create_table(mysql_conn_t *mysql_conn, char *table_name,
 				 storage_field_t *fields, char *ending)
 {
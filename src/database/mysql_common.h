@@ -58,7 +58,19 @@ typedef enum {
 	SLURM_MYSQL_PLUGIN_JC, /* jobcomp */
 } slurm_mysql_plugin_type_t;
 
+/* Limits on the statements queued with mysql_db_batch_insert() and
+ * mysql_db_batch_query() before they are sent */
+#define MYSQL_BATCH_MAX_ROWS 1000
+#define MYSQL_BATCH_MAX_SIZE (1024 * 1024)
+
 typedef struct {
+	char *batch_head;	/* insert statement batch_rows belong to */
+	char *batch_query;	/* statements queued after batch_rows */
+	List batch_rows;	/* rows of a pending multi-row insert */
+	uint32_t batch_size;	/* bytes in batch_rows and batch_query */
+	char *batch_tail;	/* "on duplicate key" clause of batch_head */
+	bool batch_failed;	/* a batch was lost, refuse to commit until
+				 * mysql_db_rollback() */
 	bool cluster_deleted;
 	char *cluster_name;
 	MYSQL *db_conn;
@@ -104,6 +116,26 @@ extern int mysql_db_query_check_after(mysql_conn_t *mysql_conn, char *query);
 
 extern uint64_t mysql_db_insert_ret_id(mysql_conn_t *mysql_conn, char *query);
 
+/*
+ * Queue a row for a multi-row insert of the form "<head><row>, ...<tail>".
+ * Queued rows and statements are sent in one round trip before the next
+ * query or commit on mysql_conn, or once the MYSQL_BATCH_* limits are
+ * reached. Rows and statements queued with mysql_db_batch_query() are sent
+ * in the order they were queued. An error sending the batch is returned by
+ * the call that sent it. The batch is then lost, and mysql_db_commit() fails
+ * without committing until the transaction is rolled back, even if the
+ * error was returned while processing a later request.
+ * Without rollback (autocommit) the row is inserted right away.
+ */
+extern int mysql_db_batch_insert(mysql_conn_t *mysql_conn, char *head,
+				 char *row, char *tail);
+
+/*
+ * Queue a statement that returns no result to be sent with the batch,
+ * see mysql_db_batch_insert().
+ */
+extern int mysql_db_batch_query(mysql_conn_t *mysql_conn, char *query);
+
 extern int mysql_db_create_table(mysql_conn_t *mysql_conn, char *table_name,
 				 storage_field_t *fields, char *ending);
 
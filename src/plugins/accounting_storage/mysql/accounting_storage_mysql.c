@@ -2780,6 +2780,7 @@ extern int acct_storage_p_close_connection(mysql_conn_t **mysql_conn)
 extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 {
 	int rc = check_connection(mysql_conn);
+	int commit_rc = SLURM_SUCCESS;
 	List update_list = NULL;
 
 	/* always reset this here */
@@ -2804,7 +2805,6 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 			if (mysql_db_rollback(mysql_conn))
 				error("rollback failed");
 		} else {
-			int rc = SLURM_SUCCESS;
 			/*
 			 * Handle anything here we were unable to do
 			 * because of rollback issues.
@@ -2813,22 +2813,26 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 				if (debug_flags & DEBUG_FLAG_DB_ASSOC)
 					DB_DEBUG(mysql_conn->conn, "query\n%s",
 						 mysql_conn->pre_commit_query);
-				rc = mysql_db_query(
+				commit_rc = mysql_db_query(
 					mysql_conn,
 					mysql_conn->pre_commit_query);
 			}
 
-			if (rc != SLURM_SUCCESS) {
-				if (mysql_db_rollback(mysql_conn))
-					error("rollback failed");
-			} else {
-				if (mysql_db_commit(mysql_conn))
-					error("commit failed");
-			}
+			if ((commit_rc == SLURM_SUCCESS) &&
+			    (commit_rc = mysql_db_commit(mysql_conn)))
+				error("commit failed");
+			/*
+			 * Nothing was committed, roll back so the caller can
+			 * send the failed requests again.
+			 */
+			if ((commit_rc != SLURM_SUCCESS) &&
+			    mysql_db_rollback(mysql_conn))
+				error("rollback failed");
 		}
 	}
 
-	if (commit && list_count(update_list)) {
+	if (commit && (commit_rc == SLURM_SUCCESS) &&
+	    list_count(update_list)) {
 		char *query = NULL;
 		MYSQL_RES *result = NULL;
 		MYSQL_ROW row;
@@ -2888,7 +2892,7 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 	xfree(mysql_conn->pre_commit_query);
 	FREE_NULL_LIST(update_list);
 
-	return SLURM_SUCCESS;
+	return commit_rc;
 }
 
 extern int acct_storage_p_add_users(mysql_conn_t *mysql_conn, uint32_t uid,
@@ -2742,7 +2742,7 @@ static Buf _pack_archive_events(MYSQL_RES *result, char *cluster_name,
 	local_event_t event;
 
 	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
 	pack_time(time(NULL), buffer);
 	pack16(DBD_GOT_EVENTS, buffer);
 	packstr(cluster_name, buffer);
@@ -2763,7 +2763,7 @@ static Buf _pack_archive_events(MYSQL_RES *result, char *cluster_name,
 		event.state = row[EVENT_REQ_STATE];
 		event.tres_str = row[EVENT_REQ_TRES];
 
-		_pack_local_event(&event, SLURM_PROTOCOL_VERSION, buffer);
+		_pack_local_event(&event, SLURM_STATE_PROTOCOL_VERSION, buffer);
 	}
 
 	return buffer;
@@ -2830,7 +2830,7 @@ static Buf _pack_archive_jobs(MYSQL_RES *result, char *cluster_name,
 	local_job_t job;
 
 	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
 	pack_time(time(NULL), buffer);
 	pack16(DBD_GOT_JOBS, buffer);
 	packstr(cluster_name, buffer);
@@ -2895,7 +2895,7 @@ static Buf _pack_archive_jobs(MYSQL_RES *result, char *cluster_name,
 		job.wckey_id = row[JOB_REQ_WCKEYID];
 		job.work_dir = row[JOB_REQ_WORK_DIR];
 
-		_pack_local_job(&job, SLURM_PROTOCOL_VERSION, buffer);
+		_pack_local_job(&job, SLURM_STATE_PROTOCOL_VERSION, buffer);
 	}
 
 	return buffer;
@@ -3120,7 +3120,7 @@ static Buf _pack_archive_resvs(MYSQL_RES *result, char *cluster_name,
 	local_resv_t resv;
 
 	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
 	pack_time(time(NULL), buffer);
 	pack16(DBD_GOT_RESVS, buffer);
 	packstr(cluster_name, buffer);
@@ -3144,7 +3144,7 @@ static Buf _pack_archive_resvs(MYSQL_RES *result, char *cluster_name,
 		resv.tres_str = row[RESV_REQ_TRES];
 		resv.unused_wall = row[RESV_REQ_UNUSED];
 
-		_pack_local_resv(&resv, SLURM_PROTOCOL_VERSION, buffer);
+		_pack_local_resv(&resv, SLURM_STATE_PROTOCOL_VERSION, buffer);
 	}
 
 	return buffer;
@@ -3211,7 +3211,7 @@ static Buf _pack_archive_steps(MYSQL_RES *result, char *cluster_name,
 	local_step_t step;
 
 	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
 	pack_time(time(NULL), buffer);
 	pack16(DBD_STEP_START, buffer);
 	packstr(cluster_name, buffer);
@@ -3273,7 +3273,7 @@ static Buf _pack_archive_steps(MYSQL_RES *result, char *cluster_name,
 		step.user_sec = row[STEP_REQ_USER_SEC];
 		step.user_usec = row[STEP_REQ_USER_USEC];
 
-		_pack_local_step(&step, SLURM_PROTOCOL_VERSION, buffer);
+		_pack_local_step(&step, SLURM_STATE_PROTOCOL_VERSION, buffer);
 	}
 
 	return buffer;
@@ -3370,7 +3370,7 @@ static Buf _pack_archive_suspends(MYSQL_RES *result, char *cluster_name,
 	local_suspend_t suspend;
 
 	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
 	pack_time(time(NULL), buffer);
 	pack16(DBD_JOB_SUSPEND, buffer);
 	packstr(cluster_name, buffer);
@@ -3387,7 +3387,7 @@ static Buf _pack_archive_suspends(MYSQL_RES *result, char *cluster_name,
 		suspend.period_start = row[SUSPEND_REQ_START];
 		suspend.period_end = row[SUSPEND_REQ_END];
 
-		_pack_local_suspend(&suspend, SLURM_PROTOCOL_VERSION, buffer);
+		_pack_local_suspend(&suspend, SLURM_STATE_PROTOCOL_VERSION, buffer);
 	}
 
 	return buffer;
@@ -3448,7 +3448,7 @@ static Buf _pack_archive_txns(MYSQL_RES *result, char *cluster_name,
 	local_txn_t txn;
 
 	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
 	pack_time(time(NULL), buffer);
 	pack16(DBD_GOT_TXN, buffer);
 	packstr(cluster_name, buffer);
@@ -3468,7 +3468,7 @@ static Buf _pack_archive_txns(MYSQL_RES *result, char *cluster_name,
 		txn.info = row[TXN_REQ_INFO];
 		txn.cluster = row[TXN_REQ_CLUSTER];
 
-		_pack_local_txn(&txn, SLURM_PROTOCOL_VERSION, buffer);
+		_pack_local_txn(&txn, SLURM_STATE_PROTOCOL_VERSION, buffer);
 	}
 
 	return buffer;
@@ -3534,7 +3534,7 @@ static Buf _pack_archive_usage(MYSQL_RES *result, char *cluster_name,
 	uint16_t period = usage_info >> 16;
 
 	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
 	pack_time(time(NULL), buffer);
 	pack16(type, buffer);
 	packstr(cluster_name, buffer);
@@ -3555,7 +3555,7 @@ static Buf _pack_archive_usage(MYSQL_RES *result, char *cluster_name,
 		usage.mod_time = row[USAGE_MOD_TIME];
 		usage.deleted = row[USAGE_DELETED];
 
-		_pack_local_usage(&usage, SLURM_PROTOCOL_VERSION, buffer);
+		_pack_local_usage(&usage, SLURM_STATE_PROTOCOL_VERSION, buffer);
 	}
 
 	return buffer;
@@ -3661,7 +3661,7 @@ static Buf _pack_archive_cluster_usage(MYSQL_RES *result, char *cluster_name,
 	uint16_t period = usage_info >> 16;
 
 	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
 	pack_time(time(NULL), buffer);
 	pack16(DBD_GOT_CLUSTER_USAGE, buffer);
 	packstr(cluster_name, buffer);
@@ -3688,7 +3688,7 @@ static Buf _pack_archive_cluster_usage(MYSQL_RES *result, char *cluster_name,
 		usage.deleted = row[CLUSTER_DELETED];
 
 		_pack_local_cluster_usage(
-			&usage, SLURM_PROTOCOL_VERSION, buffer);
+			&usage, SLURM_STATE_PROTOCOL_VERSION, buffer);
 	}
 
 	return buffer;
@@ -42,6 +42,9 @@
 #include "as_mysql_archive.h"
 #include "src/common/parse_time.h"
 #include "src/common/slurm_time.h"
+#include "src/common/xhash.h"
+
+#define MAX_ROLLUP_THREADS 64
 
 enum {
 	TIME_ALLOC,
@@ -88,10 +91,54 @@ typedef struct {
 			      over of type local_id_usage_t */
 	List loc_tres;
 	time_t orig_start;
+	int prev_unused; /* unused_wall from before this hour */
 	time_t start;
 	double unused_wall;
+	double used_wall; /* unused_wall used by jobs this hour */
 } local_resv_usage_t;
 
+/* Unused wall time of a reservation in an hour rolled up in parallel */
+typedef struct {
+	time_t hour_start;
+	int id;
+	time_t orig_start;
+	int prev_unused;
+	int resv_seconds;
+	double used_wall;
+} local_resv_unused_t;
+
+enum {
+	ROLLUP_PHASE_RESV,
+	ROLLUP_PHASE_CLUSTER,
+	ROLLUP_PHASE_JOBS,
+	ROLLUP_PHASE_RESV_UNUSED,
+	ROLLUP_PHASE_INSERT,
+	ROLLUP_PHASE_CNT
+};
+
+static char *rollup_phase_str[] = {
+	"resv",
+	"cluster",
+	"jobs",
+	"resv_unused",
+	"insert"
+};
+
+/* State shared by the threads of an hourly rollup */
+typedef struct {
+	char *cluster_name;
+	int conn;
+	int dims;
+	time_t end;
+	pthread_mutex_t lock;
+	time_t next_start; /* start of the next hour to roll up */
+	time_t now;
+	uint64_t phase_usec[ROLLUP_PHASE_CNT];
+	int rc;
+	List resv_unused_list; /* local_resv_unused_t of every hour */
+	uint16_t track_wckey;
+} local_hour_rollup_t;
+
 static void _destroy_local_tres_usage(void *object)
 {
 	local_tres_usage_t *a_usage = (local_tres_usage_t *)object;
@@ -279,6 +326,7 @@ static int _update_unused_wall(local_resv_usage_t *r_usage, List job_tres,
 	 * to determine how much time is actually idle in the reservation.
 	 */
 	r_usage->unused_wall -=	(double)job_seconds * tres_ratio;
+	r_usage->used_wall += (double)job_seconds * tres_ratio;
 
 	if (r_usage->unused_wall < 0) {
 		/*
@@ -1163,6 +1211,7 @@ extern int _setup_resv_usage(mysql_conn_t *mysql_conn,
 		 * reservation's unused_wall later on.
 		 */
 		r_usage->orig_start = orig_start;
+		r_usage->prev_unused = unused;
 		r_usage->start = row_start;
 		r_usage->end = row_end;
 		r_usage->unused_wall = unused + resv_seconds;
@@ -1174,17 +1223,43 @@ extern int _setup_resv_usage(mysql_conn_t *mysql_conn,
 	return SLURM_SUCCESS;
 }
 
-extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
-				  char *cluster_name,
-				  time_t start, time_t end,
-				  uint16_t archive_data)
+static void _id_usage_key(void *item, const char **key, uint32_t *key_len)
+{
+	local_id_usage_t *usage = (local_id_usage_t *)item;
+
+	*key = (char *)&usage->id;
+	*key_len = sizeof(int);
+}
+
+static int _sort_resv_unused(void *x, void *y)
+{
+	local_resv_unused_t *a = *(local_resv_unused_t **)x;
+	local_resv_unused_t *b = *(local_resv_unused_t **)y;
+
+	if (a->id != b->id)
+		return (a->id < b->id) ? -1 : 1;
+	if (a->orig_start != b->orig_start)
+		return (a->orig_start < b->orig_start) ? -1 : 1;
+	if (a->hour_start != b->hour_start)
+		return (a->hour_start < b->hour_start) ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Roll up the hour starting at curr_start. Without resv_unused_list the
+ * unused wall time of the reservations is updated here, which needs the
+ * hours to be rolled up in order. With it a local_resv_unused_t is added to
+ * resv_unused_list for each reservation instead, so the hours can be rolled
+ * up in any order and the unused wall time computed afterwards.
+ */
+static int _hourly_rollup_hour(mysql_conn_t *mysql_conn,
+			       local_hour_rollup_t *hour_rollup,
+			       time_t curr_start, List resv_unused_list)
 {
 	int rc = SLURM_SUCCESS;
-	int add_sec = 3600;
-	int i=0, dims;
-	time_t now = time(NULL);
-	time_t curr_start = start;
-	time_t curr_end = curr_start + add_sec;
+	int i;
+	time_t curr_end = curr_start + 3600;
+	char *cluster_name = hour_rollup->cluster_name;
 	char *query = NULL;
 	MYSQL_RES *result = NULL;
 	MYSQL_ROW row;
@@ -1196,13 +1271,17 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 	List cluster_down_list = list_create(_destroy_local_cluster_usage);
 	List wckey_usage_list = list_create(_destroy_local_id_usage);
 	List resv_usage_list = list_create(_destroy_local_resv_usage);
-	uint16_t track_wckey = slurm_get_track_wckey();
+	xhash_t *assoc_usage_hash = xhash_init(_id_usage_key, NULL);
+	xhash_t *wckey_usage_hash = xhash_init(_id_usage_key, NULL);
 	local_cluster_usage_t *loc_c_usage = NULL;
 	local_cluster_usage_t *c_usage = NULL;
 	local_resv_usage_t *r_usage = NULL;
 	local_id_usage_t *a_usage = NULL;
 	local_id_usage_t *w_usage = NULL;
-	/* char start_char[20], end_char[20]; */
+	uint64_t phase_usec[ROLLUP_PHASE_CNT] = { 0 };
+	int last_id = -1;
+	int last_wckeyid = -1;
+	DEF_TIMERS;
 
 	char *job_req_inx[] = {
 		"job.job_db_inx",
@@ -1258,563 +1337,773 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 		xstrfmtcat(suspend_str, ", %s", suspend_req_inx[i]);
 	}
 
-	/* We need to figure out the dimensions of this cluster */
-	query = xstrdup_printf("select dimensions from %s where name='%s'",
-			       cluster_table, cluster_name);
-	if (debug_flags & DEBUG_FLAG_DB_USAGE)
-		DB_DEBUG(mysql_conn->conn, "query\n%s", query);
-	result = mysql_db_query_ret(mysql_conn, query, 0);
-	xfree(query);
+	a_itr = list_iterator_create(assoc_usage_list);
+	c_itr = list_iterator_create(cluster_down_list);
+	w_itr = list_iterator_create(wckey_usage_list);
+	r_itr = list_iterator_create(resv_usage_list);
 
-	if (!result) {
-		error("%s: error querying cluster_table", __func__);
-		rc = SLURM_ERROR;
+	if (debug_flags & DEBUG_FLAG_DB_USAGE)
+		DB_DEBUG(mysql_conn->conn,
+			 "%s curr hour is now %ld-%ld",
+			 cluster_name, curr_start, curr_end);
+/* 	info("start %s", slurm_ctime2(&curr_start)); */
+/* 	info("end %s", slurm_ctime2(&curr_end)); */
+
+	START_TIMER;
+	if ((rc = _setup_resv_usage(mysql_conn, cluster_name,
+				    curr_start, curr_end,
+				    resv_usage_list, hour_rollup->dims))
+	    != SLURM_SUCCESS)
 		goto end_it;
-	}
-	row = mysql_fetch_row(result);
+	END_TIMER;
+	phase_usec[ROLLUP_PHASE_RESV] += DELTA_TIMER;
 
-	if (!row) {
-		error("%s: no cluster by name %s known",
-		      __func__, cluster_name);
+	START_TIMER;
+	c_usage = _setup_cluster_usage(mysql_conn, cluster_name,
+				       curr_start, curr_end,
+				       resv_usage_list,
+				       cluster_down_list);
+
+	if (c_usage)
+		xassert(c_usage->loc_tres);
+	END_TIMER;
+	phase_usec[ROLLUP_PHASE_CLUSTER] += DELTA_TIMER;
+
+	START_TIMER;
+	/* now get the jobs during this time only  */
+	query = xstrdup_printf("select %s from \"%s_%s\" as job "
+			       "where (job.time_eligible && "
+			       "job.time_eligible < %ld && "
+			       "(job.time_end >= %ld || "
+			       "job.time_end = 0)) "
+			       "group by job.job_db_inx "
+			       "order by job.id_assoc, "
+			       "job.time_eligible",
+			       job_str, cluster_name, job_table,
+			       curr_end, curr_start);
+
+	if (debug_flags & DEBUG_FLAG_DB_USAGE)
+		DB_DEBUG(mysql_conn->conn, "query\n%s", query);
+	if (!(result = mysql_db_query_ret(
+		      mysql_conn, query, 0))) {
 		rc = SLURM_ERROR;
 		goto end_it;
 	}
+	xfree(query);
 
-	dims = atoi(row[0]);
-	mysql_free_result(result);
-
-/* 	info("begin start %s", slurm_ctime2(&curr_start)); */
-/* 	info("begin end %s", slurm_ctime2(&curr_end)); */
-	a_itr = list_iterator_create(assoc_usage_list);
-	c_itr = list_iterator_create(cluster_down_list);
-	w_itr = list_iterator_create(wckey_usage_list);
-	r_itr = list_iterator_create(resv_usage_list);
-	while (curr_start < end) {
-		int last_id = -1;
-		int last_wckeyid = -1;
-
-		if (debug_flags & DEBUG_FLAG_DB_USAGE)
-			DB_DEBUG(mysql_conn->conn,
-				 "%s curr hour is now %ld-%ld",
-				 cluster_name, curr_start, curr_end);
-/* 		info("start %s", slurm_ctime2(&curr_start)); */
-/* 		info("end %s", slurm_ctime2(&curr_end)); */
-
-		if ((rc = _setup_resv_usage(mysql_conn, cluster_name,
-					    curr_start, curr_end,
-					    resv_usage_list, dims))
-		    != SLURM_SUCCESS)
-			goto end_it;
+	while ((row = mysql_fetch_row(result))) {
+		//uint32_t job_id = slurm_atoul(row[JOB_REQ_JOBID]);
+		uint32_t assoc_id = slurm_atoul(row[JOB_REQ_ASSOCID]);
+		uint32_t wckey_id = slurm_atoul(row[JOB_REQ_WCKEYID]);
+		uint32_t array_pending =
+			slurm_atoul(row[JOB_REQ_ARRAY_PENDING]);
+		uint32_t resv_id = slurm_atoul(row[JOB_REQ_RESVID]);
+		time_t row_eligible = slurm_atoul(row[JOB_REQ_ELG]);
+		time_t row_start = slurm_atoul(row[JOB_REQ_START]);
+		time_t row_end = slurm_atoul(row[JOB_REQ_END]);
+		uint32_t row_rcpu = slurm_atoul(row[JOB_REQ_RCPU]);
+		List loc_tres = NULL;
+		int loc_seconds = 0;
+		int seconds = 0, suspend_seconds = 0;
+
+		if (row_start && (row_start < curr_start))
+			row_start = curr_start;
 
-		c_usage = _setup_cluster_usage(mysql_conn, cluster_name,
-					       curr_start, curr_end,
-					       resv_usage_list,
-					       cluster_down_list);
-
-		if (c_usage)
-			xassert(c_usage->loc_tres);
-
-		/* now get the jobs during this time only  */
-		query = xstrdup_printf("select %s from \"%s_%s\" as job "
-				       "where (job.time_eligible && "
-				       "job.time_eligible < %ld && "
-				       "(job.time_end >= %ld || "
-				       "job.time_end = 0)) "
-				       "group by job.job_db_inx "
-				       "order by job.id_assoc, "
-				       "job.time_eligible",
-				       job_str, cluster_name, job_table,
-				       curr_end, curr_start);
+		if (!row_start && row_end)
+			row_start = row_end;
 
-		if (debug_flags & DEBUG_FLAG_DB_USAGE)
-			DB_DEBUG(mysql_conn->conn, "query\n%s", query);
-		if (!(result = mysql_db_query_ret(
-			      mysql_conn, query, 0))) {
-			rc = SLURM_ERROR;
-			goto end_it;
-		}
-		xfree(query);
+		if (!row_end || row_end > curr_end)
+			row_end = curr_end;
 
-		while ((row = mysql_fetch_row(result))) {
-			//uint32_t job_id = slurm_atoul(row[JOB_REQ_JOBID]);
-			uint32_t assoc_id = slurm_atoul(row[JOB_REQ_ASSOCID]);
-			uint32_t wckey_id = slurm_atoul(row[JOB_REQ_WCKEYID]);
-			uint32_t array_pending =
-				slurm_atoul(row[JOB_REQ_ARRAY_PENDING]);
-			uint32_t resv_id = slurm_atoul(row[JOB_REQ_RESVID]);
-			time_t row_eligible = slurm_atoul(row[JOB_REQ_ELG]);
-			time_t row_start = slurm_atoul(row[JOB_REQ_START]);
-			time_t row_end = slurm_atoul(row[JOB_REQ_END]);
-			uint32_t row_rcpu = slurm_atoul(row[JOB_REQ_RCPU]);
-			List loc_tres = NULL;
-			int loc_seconds = 0;
-			int seconds = 0, suspend_seconds = 0;
-
-			if (row_start && (row_start < curr_start))
-				row_start = curr_start;
-
-			if (!row_start && row_end)
-				row_start = row_end;
-
-			if (!row_end || row_end > curr_end)
-				row_end = curr_end;
-
-			if (!row_start || ((row_end - row_start) < 1))
-				goto calc_cluster;
-
-			seconds = (row_end - row_start);
-
-			if (slurm_atoul(row[JOB_REQ_SUSPENDED])) {
-				MYSQL_RES *result2 = NULL;
-				MYSQL_ROW row2;
-				/* get the suspended time for this job */
-				query = xstrdup_printf(
-					"select %s from \"%s_%s\" where "
-					"(time_start < %ld && (time_end >= %ld "
-					"|| time_end = 0)) && job_db_inx=%s "
-					"order by time_start",
-					suspend_str, cluster_name,
-					suspend_table,
-					curr_end, curr_start,
-					row[JOB_REQ_DB_INX]);
-
-				debug4("%d(%s:%d) query\n%s",
-				       mysql_conn->conn, THIS_FILE,
-				       __LINE__, query);
-				if (!(result2 = mysql_db_query_ret(
-					      mysql_conn,
-					      query, 0))) {
-					rc = SLURM_ERROR;
-					mysql_free_result(result);
-					goto end_it;
-				}
-				xfree(query);
-				while ((row2 = mysql_fetch_row(result2))) {
-					int tot_time = 0;
-					time_t local_start = slurm_atoul(
-						row2[SUSPEND_REQ_START]);
-					time_t local_end = slurm_atoul(
-						row2[SUSPEND_REQ_END]);
-
-					if (!local_start)
-						continue;
-
-					if (row_start > local_start)
-						local_start = row_start;
-					if (!local_end || row_end < local_end)
-						local_end = row_end;
-					tot_time = (local_end - local_start);
-
-					if (tot_time > 0)
-						suspend_seconds += tot_time;
-				}
-				mysql_free_result(result2);
+		if (!row_start || ((row_end - row_start) < 1))
+			goto calc_cluster;
+
+		seconds = (row_end - row_start);
+
+		if (slurm_atoul(row[JOB_REQ_SUSPENDED])) {
+			MYSQL_RES *result2 = NULL;
+			MYSQL_ROW row2;
+			/* get the suspended time for this job */
+			query = xstrdup_printf(
+				"select %s from \"%s_%s\" where "
+				"(time_start < %ld && (time_end >= %ld "
+				"|| time_end = 0)) && job_db_inx=%s "
+				"order by time_start",
+				suspend_str, cluster_name,
+				suspend_table,
+				curr_end, curr_start,
+				row[JOB_REQ_DB_INX]);
+
+			debug4("%d(%s:%d) query\n%s",
+			       mysql_conn->conn, THIS_FILE,
+			       __LINE__, query);
+			if (!(result2 = mysql_db_query_ret(
+				      mysql_conn,
+				      query, 0))) {
+				rc = SLURM_ERROR;
+				mysql_free_result(result);
+				goto end_it;
 			}
+			xfree(query);
+			while ((row2 = mysql_fetch_row(result2))) {
+				int tot_time = 0;
+				time_t local_start = slurm_atoul(
+					row2[SUSPEND_REQ_START]);
+				time_t local_end = slurm_atoul(
+					row2[SUSPEND_REQ_END]);
+
+				if (!local_start)
+					continue;
 
-			if (last_id != assoc_id) {
-				a_usage = xmalloc(sizeof(local_id_usage_t));
-				a_usage->id = assoc_id;
-				list_append(assoc_usage_list, a_usage);
-				last_id = assoc_id;
-				/* a_usage->loc_tres is made later,
-				   don't do it here.
-				*/
-			}
+				if (row_start > local_start)
+					local_start = row_start;
+				if (!local_end || row_end < local_end)
+					local_end = row_end;
+				tot_time = (local_end - local_start);
 
-			/* Short circuit this so so we don't get a pointer. */
-			if (!track_wckey)
-				last_wckeyid = wckey_id;
+				if (tot_time > 0)
+					suspend_seconds += tot_time;
+			}
+			mysql_free_result(result2);
+		}
 
-			/* do the wckey calculation */
-			if (last_wckeyid != wckey_id) {
-				list_iterator_reset(w_itr);
-				while ((w_usage = list_next(w_itr)))
-					if (w_usage->id == wckey_id)
-						break;
+		if (last_id != assoc_id) {
+			a_usage = xmalloc(sizeof(local_id_usage_t));
+			a_usage->id = assoc_id;
+			list_append(assoc_usage_list, a_usage);
+			xhash_add(assoc_usage_hash, a_usage);
+			last_id = assoc_id;
+			/* a_usage->loc_tres is made later,
+			   don't do it here.
+			*/
+		}
 
-				if (!w_usage) {
-					w_usage = xmalloc(
-						sizeof(local_id_usage_t));
-					w_usage->id = wckey_id;
-					list_append(wckey_usage_list,
-						    w_usage);
-					w_usage->loc_tres = list_create(
-						_destroy_local_tres_usage);
-				}
-				last_wckeyid = wckey_id;
+		/* Short circuit this so so we don't get a pointer. */
+		if (!hour_rollup->track_wckey)
+			last_wckeyid = wckey_id;
+
+		/* do the wckey calculation */
+		if (last_wckeyid != wckey_id) {
+			if (!(w_usage = xhash_get(wckey_usage_hash,
+						  (char *)&wckey_id,
+						  sizeof(int)))) {
+				w_usage = xmalloc(
+					sizeof(local_id_usage_t));
+				w_usage->id = wckey_id;
+				list_append(wckey_usage_list,
+					    w_usage);
+				xhash_add(wckey_usage_hash, w_usage);
+				w_usage->loc_tres = list_create(
+					_destroy_local_tres_usage);
 			}
+			last_wckeyid = wckey_id;
+		}
 
-			/* do the cluster allocated calculation */
-		calc_cluster:
-
-			/*
-			 * We need to have this clean for each job
-			 * since we add the time to the cluster individually.
-			 */
-			loc_tres = list_create(_destroy_local_tres_usage);
+		/* do the cluster allocated calculation */
+	calc_cluster:
 
-			_add_tres_time_2_list(loc_tres, row[JOB_REQ_TRES],
+		/*
+		 * We need to have this clean for each job
+		 * since we add the time to the cluster individually.
+		 */
+		loc_tres = list_create(_destroy_local_tres_usage);
+
+		_add_tres_time_2_list(loc_tres, row[JOB_REQ_TRES],
+				      TIME_ALLOC, seconds,
+				      suspend_seconds, 0);
+		if (w_usage)
+			_add_tres_time_2_list(w_usage->loc_tres,
+					      row[JOB_REQ_TRES],
 					      TIME_ALLOC, seconds,
 					      suspend_seconds, 0);
-			if (w_usage)
-				_add_tres_time_2_list(w_usage->loc_tres,
-						      row[JOB_REQ_TRES],
-						      TIME_ALLOC, seconds,
-						      suspend_seconds, 0);
-
-			/*
-			 * Now figure out there was a disconnected
-			 * slurmctld during this job.
-			 */
-			list_iterator_reset(c_itr);
-			while ((loc_c_usage = list_next(c_itr))) {
-				int temp_end = row_end;
-				int temp_start = row_start;
-				if (loc_c_usage->start > temp_start)
-					temp_start = loc_c_usage->start;
-				if (loc_c_usage->end < temp_end)
-					temp_end = loc_c_usage->end;
-				loc_seconds = (temp_end - temp_start);
-				if (loc_seconds < 1)
-					continue;
 
-				_remove_job_tres_time_from_cluster(
-					loc_c_usage->loc_tres,
-					loc_tres,
-					loc_seconds);
-				/* info("Job %u was running for " */
-				/*      "%d seconds while " */
-				/*      "cluster %s's slurmctld " */
-				/*      "wasn't responding", */
-				/*      job_id, loc_seconds, cluster_name); */
-			}
+		/*
+		 * Now figure out there was a disconnected
+		 * slurmctld during this job.
+		 */
+		list_iterator_reset(c_itr);
+		while ((loc_c_usage = list_next(c_itr))) {
+			int temp_end = row_end;
+			int temp_start = row_start;
+			if (loc_c_usage->start > temp_start)
+				temp_start = loc_c_usage->start;
+			if (loc_c_usage->end < temp_end)
+				temp_end = loc_c_usage->end;
+			loc_seconds = (temp_end - temp_start);
+			if (loc_seconds < 1)
+				continue;
 
-			/* first figure out the reservation */
-			if (resv_id) {
-				if (seconds <= 0) {
-					_transfer_loc_tres(&loc_tres, a_usage);
-					continue;
-				}
-				/*
-				 * Since we have already added the entire
-				 * reservation as used time on the cluster we
-				 * only need to calculate the used time for the
-				 * reservation and then divy up the unused time
-				 * over the associations able to run in the
-				 * reservation. Since the job was to run, or ran
-				 * a reservation we don't care about eligible
-				 * time since that could totally skew the
-				 * clusters reserved time since the job may be
-				 * able to run outside of the reservation.
-				 */
-				list_iterator_reset(r_itr);
-				while ((r_usage = list_next(r_itr))) {
-					int temp_end, temp_start;
-					/*
-					 * since the reservation could have
-					 * changed in some way, thus making a
-					 * new reservation record in the
-					 * database, we have to make sure all
-					 * of the reservations are checked to
-					 * see if such a thing has happened
-					 */
-					if (r_usage->id != resv_id)
-						continue;
-					temp_end = row_end;
-					temp_start = row_start;
-					if (r_usage->start > temp_start)
-						temp_start =
-							r_usage->start;
-					if (r_usage->end < temp_end)
-						temp_end = r_usage->end;
-
-					loc_seconds = (temp_end - temp_start);
-
-					if (loc_seconds <= 0)
-						continue;
-
-					if (c_usage &&
-					    (r_usage->flags &
-					     RESERVE_FLAG_IGN_JOBS))
-						/*
-						 * job usage was not
-						 * bundled with resv
-						 * usage so need to
-						 * account for it
-						 * individually here
-						 */
-						_add_tres_time_2_list(
-							c_usage->loc_tres,
-							row[JOB_REQ_TRES],
-							TIME_ALLOC,
-							loc_seconds,
-							0, 0);
-
-					_add_time_tres_list(
-						r_usage->loc_tres,
-						loc_tres, TIME_ALLOC,
-						loc_seconds, 1);
-					if ((rc = _update_unused_wall(
-						     r_usage,
-						     loc_tres,
-						     loc_seconds))
-					    != SLURM_SUCCESS)
-						goto end_it;
-				}
+			_remove_job_tres_time_from_cluster(
+				loc_c_usage->loc_tres,
+				loc_tres,
+				loc_seconds);
+			/* info("Job %u was running for " */
+			/*      "%d seconds while " */
+			/*      "cluster %s's slurmctld " */
+			/*      "wasn't responding", */
+			/*      job_id, loc_seconds, cluster_name); */
+		}
 
+		/* first figure out the reservation */
+		if (resv_id) {
+			if (seconds <= 0) {
 				_transfer_loc_tres(&loc_tres, a_usage);
 				continue;
 			}
-
 			/*
-			 * only record time for the clusters that have
-			 * registered.  This continue should rarely if
-			 * ever happen.
+			 * Since we have already added the entire
+			 * reservation as used time on the cluster we
+			 * only need to calculate the used time for the
+			 * reservation and then divy up the unused time
+			 * over the associations able to run in the
+			 * reservation. Since the job was to run, or ran
+			 * a reservation we don't care about eligible
+			 * time since that could totally skew the
+			 * clusters reserved time since the job may be
+			 * able to run outside of the reservation.
 			 */
-			if (!c_usage) {
-				_transfer_loc_tres(&loc_tres, a_usage);
-				continue;
-			}
+			list_iterator_reset(r_itr);
+			while ((r_usage = list_next(r_itr))) {
+				int temp_end, temp_start;
+				/*
+				 * since the reservation could have
+				 * changed in some way, thus making a
+				 * new reservation record in the
+				 * database, we have to make sure all
+				 * of the reservations are checked to
+				 * see if such a thing has happened
+				 */
+				if (r_usage->id != resv_id)
+					continue;
+				temp_end = row_end;
+				temp_start = row_start;
+				if (r_usage->start > temp_start)
+					temp_start =
+						r_usage->start;
+				if (r_usage->end < temp_end)
+					temp_end = r_usage->end;
 
-			if (row_start && (seconds > 0)) {
-				/* info("%d assoc %d adds " */
-				/*      "(%d)(%d-%d) * %d = %d " */
-				/*      "to %d", */
-				/*      job_id, */
-				/*      a_usage->id, */
-				/*      seconds, */
-				/*      row_end, row_start, */
-				/*      row_acpu, */
-				/*      seconds * row_acpu, */
-				/*      row_acpu); */
-
-				_add_job_alloc_time_to_cluster(
-					c_usage->loc_tres,
-					loc_tres);
-			}
+				loc_seconds = (temp_end - temp_start);
 
-			/*
-			 * The loc_tres isn't needed after this so transfer to
-			 * the association and go on our merry way.
-			 */
-			_transfer_loc_tres(&loc_tres, a_usage);
+				if (loc_seconds <= 0)
+					continue;
 
-			/* now reserved time */
-			if (!row_start || (row_start >= c_usage->start)) {
-				int temp_end = row_start;
-				int temp_start = row_eligible;
-				if (c_usage->start > temp_start)
-					temp_start = c_usage->start;
-				if (c_usage->end < temp_end)
-					temp_end = c_usage->end;
-				loc_seconds = (temp_end - temp_start);
-				if (loc_seconds > 0) {
+				if (c_usage &&
+				    (r_usage->flags &
+				     RESERVE_FLAG_IGN_JOBS))
 					/*
-					 * If we have pending jobs in an array
-					 * they haven't been inserted into the
-					 * database yet as proper job records,
-					 * so handle them here.
+					 * job usage was not
+					 * bundled with resv
+					 * usage so need to
+					 * account for it
+					 * individually here
 					 */
-					if (array_pending)
-						loc_seconds *= array_pending;
-
-					/* info("%d assoc %d reserved " */
-					/*      "(%d)(%d-%d) * %d * %d = %d " */
-					/*      "to %d", */
-					/*      job_id, */
-					/*      assoc_id, */
-					/*      temp_end - temp_start, */
-					/*      temp_end, temp_start, */
-					/*      row_rcpu, */
-					/*      array_pending, */
-					/*      loc_seconds, */
-					/*      row_rcpu); */
-
-					_add_time_tres(c_usage->loc_tres,
-						       TIME_RESV, TRES_CPU,
-						       loc_seconds *
-						       (uint64_t) row_rcpu,
-						       0);
-				}
+					_add_tres_time_2_list(
+						c_usage->loc_tres,
+						row[JOB_REQ_TRES],
+						TIME_ALLOC,
+						loc_seconds,
+						0, 0);
+
+				_add_time_tres_list(
+					r_usage->loc_tres,
+					loc_tres, TIME_ALLOC,
+					loc_seconds, 1);
+				if ((rc = _update_unused_wall(
+					     r_usage,
+					     loc_tres,
+					     loc_seconds))
+				    != SLURM_SUCCESS)
+					goto end_it;
 			}
+
+			_transfer_loc_tres(&loc_tres, a_usage);
+			continue;
 		}
-		mysql_free_result(result);
 
-		/* now figure out how much more to add to the
-		   associations that could had run in the reservation
-		*/
-		query = NULL;
-		list_iterator_reset(r_itr);
-		while ((r_usage = list_next(r_itr))) {
-			ListIterator t_itr;
-			local_tres_usage_t *loc_tres;
+		/*
+		 * only record time for the clusters that have
+		 * registered.  This continue should rarely if
+		 * ever happen.
+		 */
+		if (!c_usage) {
+			_transfer_loc_tres(&loc_tres, a_usage);
+			continue;
+		}
+
+		if (row_start && (seconds > 0)) {
+			/* info("%d assoc %d adds " */
+			/*      "(%d)(%d-%d) * %d = %d " */
+			/*      "to %d", */
+			/*      job_id, */
+			/*      a_usage->id, */
+			/*      seconds, */
+			/*      row_end, row_start, */
+			/*      row_acpu, */
+			/*      seconds * row_acpu, */
+			/*      row_acpu); */
+
+			_add_job_alloc_time_to_cluster(
+				c_usage->loc_tres,
+				loc_tres);
+		}
+
+		/*
+		 * The loc_tres isn't needed after this so transfer to
+		 * the association and go on our merry way.
+		 */
+		_transfer_loc_tres(&loc_tres, a_usage);
+
+		/* now reserved time */
+		if (!row_start || (row_start >= c_usage->start)) {
+			int temp_end = row_start;
+			int temp_start = row_eligible;
+			if (c_usage->start > temp_start)
+				temp_start = c_usage->start;
+			if (c_usage->end < temp_end)
+				temp_end = c_usage->end;
+			loc_seconds = (temp_end - temp_start);
+			if (loc_seconds > 0) {
+				/*
+				 * If we have pending jobs in an array
+				 * they haven't been inserted into the
+				 * database yet as proper job records,
+				 * so handle them here.
+				 */
+				if (array_pending)
+					loc_seconds *= array_pending;
+
+				/* info("%d assoc %d reserved " */
+				/*      "(%d)(%d-%d) * %d * %d = %d " */
+				/*      "to %d", */
+				/*      job_id, */
+				/*      assoc_id, */
+				/*      temp_end - temp_start, */
+				/*      temp_end, temp_start, */
+				/*      row_rcpu, */
+				/*      array_pending, */
+				/*      loc_seconds, */
+				/*      row_rcpu); */
+
+				_add_time_tres(c_usage->loc_tres,
+					       TIME_RESV, TRES_CPU,
+					       loc_seconds *
+					       (uint64_t) row_rcpu,
+					       0);
+			}
+		}
+	}
+	mysql_free_result(result);
+	END_TIMER;
+	phase_usec[ROLLUP_PHASE_JOBS] += DELTA_TIMER;
 
+	START_TIMER;
+	/* now figure out how much more to add to the
+	   associations that could had run in the reservation
+	*/
+	query = NULL;
+	list_iterator_reset(r_itr);
+	while ((r_usage = list_next(r_itr))) {
+		ListIterator t_itr;
+		local_tres_usage_t *loc_tres;
+
+		if (resv_unused_list) {
+			local_resv_unused_t *resv_unused =
+				xmalloc(sizeof(local_resv_unused_t));
+
+			resv_unused->hour_start = curr_start;
+			resv_unused->id = r_usage->id;
+			resv_unused->orig_start = r_usage->orig_start;
+			resv_unused->prev_unused = r_usage->prev_unused;
+			resv_unused->resv_seconds =
+				r_usage->end - r_usage->start;
+			resv_unused->used_wall = r_usage->used_wall;
+			list_append(resv_unused_list, resv_unused);
+		} else
 			xstrfmtcat(query, "update \"%s_%s\" set unused_wall=%f where id_resv=%u and time_start=%ld;",
 				   cluster_name, resv_table,
 				   r_usage->unused_wall, r_usage->id,
 				   r_usage->orig_start);
 
-			if (!r_usage->loc_tres ||
-			    !list_count(r_usage->loc_tres))
-				continue;
+		if (!r_usage->loc_tres ||
+		    !list_count(r_usage->loc_tres))
+			continue;
 
-			t_itr = list_iterator_create(r_usage->loc_tres);
-			while ((loc_tres = list_next(t_itr))) {
-				int64_t idle = loc_tres->total_time -
-					loc_tres->time_alloc;
-				char *assoc = NULL;
-				ListIterator tmp_itr = NULL;
-				int assoc_cnt, resv_unused_secs;
-
-				if (idle <= 0)
-					break; /* since this will be
-						* the same for all TRES	*/
-
-				/* now divide that time by the number of
-				   associations in the reservation and add
-				   them to each association */
-				resv_unused_secs = idle;
-				assoc_cnt = list_count(r_usage->local_assocs);
-				if (assoc_cnt)
-					resv_unused_secs /= assoc_cnt;
-				/* info("resv %d got %d seconds for TRES %u " */
-				/*      "for %d assocs", */
-				/*      r_usage->id, resv_unused_secs, */
-				/*      loc_tres->id, */
-				/*      list_count(r_usage->local_assocs)); */
-				tmp_itr = list_iterator_create(
-					r_usage->local_assocs);
-				while ((assoc = list_next(tmp_itr))) {
-					uint32_t associd = slurm_atoul(assoc);
-					if ((last_id != associd) &&
-					    !(a_usage = list_find_first(
-						      assoc_usage_list,
-						      _find_id_usage,
-						      &associd))) {
-						a_usage = xmalloc(
-							sizeof(local_id_usage_t));
-						a_usage->id = associd;
-						list_append(assoc_usage_list,
-							    a_usage);
-						last_id = associd;
-						a_usage->loc_tres = list_create(
-							_destroy_local_tres_usage);
-					}
-
-					_add_time_tres(a_usage->loc_tres,
-						       TIME_ALLOC, loc_tres->id,
-						       resv_unused_secs, 0);
+		t_itr = list_iterator_create(r_usage->loc_tres);
+		while ((loc_tres = list_next(t_itr))) {
+			int64_t idle = loc_tres->total_time -
+				loc_tres->time_alloc;
+			char *assoc = NULL;
+			ListIterator tmp_itr = NULL;
+			int assoc_cnt, resv_unused_secs;
+
+			if (idle <= 0)
+				break; /* since this will be
+					* the same for all TRES	*/
+
+			/* now divide that time by the number of
+			   associations in the reservation and add
+			   them to each association */
+			resv_unused_secs = idle;
+			assoc_cnt = list_count(r_usage->local_assocs);
+			if (assoc_cnt)
+				resv_unused_secs /= assoc_cnt;
+			/* info("resv %d got %d seconds for TRES %u " */
+			/*      "for %d assocs", */
+			/*      r_usage->id, resv_unused_secs, */
+			/*      loc_tres->id, */
+			/*      list_count(r_usage->local_assocs)); */
+			tmp_itr = list_iterator_create(
+				r_usage->local_assocs);
+			while ((assoc = list_next(tmp_itr))) {
+				uint32_t associd = slurm_atoul(assoc);
+				if ((last_id != associd) &&
+				    !(a_usage = xhash_get(
+					      assoc_usage_hash,
+					      (char *)&associd,
+					      sizeof(int)))) {
+					a_usage = xmalloc(
+						sizeof(local_id_usage_t));
+					a_usage->id = associd;
+					list_append(assoc_usage_list,
+						    a_usage);
+					xhash_add(assoc_usage_hash,
+						  a_usage);
+					last_id = associd;
+					a_usage->loc_tres = list_create(
+						_destroy_local_tres_usage);
 				}
-				list_iterator_destroy(tmp_itr);
-			}
-			list_iterator_destroy(t_itr);
-		}
 
-		if (query) {
-			if (debug_flags & DEBUG_FLAG_DB_USAGE)
-				DB_DEBUG(mysql_conn->conn, "query\n%s", query);
-			rc = mysql_db_query(mysql_conn, query);
-			xfree(query);
-			if (rc != SLURM_SUCCESS) {
-				error("couldn't update reservations with unused time");
-				goto end_it;
+				_add_time_tres(a_usage->loc_tres,
+					       TIME_ALLOC, loc_tres->id,
+					       resv_unused_secs, 0);
 			}
+			list_iterator_destroy(tmp_itr);
 		}
+		list_iterator_destroy(t_itr);
+	}
 
-		/* now apply the down time from the slurmctld disconnects */
-		if (c_usage) {
-			list_iterator_reset(c_itr);
-			while ((loc_c_usage = list_next(c_itr))) {
-				local_tres_usage_t *loc_tres;
-				ListIterator tmp_itr = list_iterator_create(
-					loc_c_usage->loc_tres);
-				while ((loc_tres = list_next(tmp_itr)))
-					_add_time_tres(c_usage->loc_tres,
-						       TIME_DOWN,
-						       loc_tres->id,
-						       loc_tres->total_time,
-						       0);
-				list_iterator_destroy(tmp_itr);
-			}
-
-			if ((rc = _process_cluster_usage(
-				     mysql_conn, cluster_name, curr_start,
-				     curr_end, now, c_usage))
-			    != SLURM_SUCCESS) {
-				goto end_it;
-			}
+	if (query) {
+		if (debug_flags & DEBUG_FLAG_DB_USAGE)
+			DB_DEBUG(mysql_conn->conn, "query\n%s", query);
+		rc = mysql_db_query(mysql_conn, query);
+		xfree(query);
+		if (rc != SLURM_SUCCESS) {
+			error("couldn't update reservations with unused time");
+			goto end_it;
 		}
+	}
+	END_TIMER;
+	phase_usec[ROLLUP_PHASE_RESV_UNUSED] += DELTA_TIMER;
 
-		list_iterator_reset(a_itr);
-		while ((a_usage = list_next(a_itr)))
-			_create_id_usage_insert(cluster_name, ASSOC_TABLES,
-						curr_start, now,
-						a_usage, &query);
-		if (query) {
-			if (debug_flags & DEBUG_FLAG_DB_USAGE)
-				DB_DEBUG(mysql_conn->conn, "query\n%s", query);
-			rc = mysql_db_query(mysql_conn, query);
-			xfree(query);
-			if (rc != SLURM_SUCCESS) {
-				error("Couldn't add assoc hour rollup");
-				goto end_it;
-			}
+	START_TIMER;
+	/* now apply the down time from the slurmctld disconnects */
+	if (c_usage) {
+		list_iterator_reset(c_itr);
+		while ((loc_c_usage = list_next(c_itr))) {
+			local_tres_usage_t *loc_tres;
+			ListIterator tmp_itr = list_iterator_create(
+				loc_c_usage->loc_tres);
+			while ((loc_tres = list_next(tmp_itr)))
+				_add_time_tres(c_usage->loc_tres,
+					       TIME_DOWN,
+					       loc_tres->id,
+					       loc_tres->total_time,
+					       0);
+			list_iterator_destroy(tmp_itr);
 		}
 
-		if (!track_wckey)
-			goto end_loop;
-
-		list_iterator_reset(w_itr);
-		while ((w_usage = list_next(w_itr)))
-			_create_id_usage_insert(cluster_name, WCKEY_TABLES,
-						curr_start, now,
-						w_usage, &query);
-		if (query) {
-			if (debug_flags & DEBUG_FLAG_DB_USAGE)
-				DB_DEBUG(mysql_conn->conn, "query\n%s", query);
-			rc = mysql_db_query(mysql_conn, query);
-			xfree(query);
-			if (rc != SLURM_SUCCESS) {
-				error("Couldn't add wckey hour rollup");
-				goto end_it;
-			}
+		if ((rc = _process_cluster_usage(
+			     mysql_conn, cluster_name, curr_start,
+			     curr_end, hour_rollup->now, c_usage))
+		    != SLURM_SUCCESS) {
+			goto end_it;
 		}
+	}
 
-	end_loop:
-		_destroy_local_cluster_usage(c_usage);
+	list_iterator_reset(a_itr);
+	while ((a_usage = list_next(a_itr)))
+		_create_id_usage_insert(cluster_name, ASSOC_TABLES,
+					curr_start, hour_rollup->now,
+					a_usage, &query);
+	if (query) {
+		if (debug_flags & DEBUG_FLAG_DB_USAGE)
+			DB_DEBUG(mysql_conn->conn, "query\n%s", query);
+		rc = mysql_db_query(mysql_conn, query);
+		xfree(query);
+		if (rc != SLURM_SUCCESS) {
+			error("Couldn't add assoc hour rollup");
+			goto end_it;
+		}
+	}
 
-		c_usage     = NULL;
-		r_usage     = NULL;
-		a_usage     = NULL;
-		w_usage     = NULL;
+	if (!hour_rollup->track_wckey)
+		goto end_insert;
 
-		list_flush(assoc_usage_list);
-		list_flush(cluster_down_list);
-		list_flush(wckey_usage_list);
-		list_flush(resv_usage_list);
-		curr_start = curr_end;
-		curr_end = curr_start + add_sec;
+	list_iterator_reset(w_itr);
+	while ((w_usage = list_next(w_itr)))
+		_create_id_usage_insert(cluster_name, WCKEY_TABLES,
+					curr_start, hour_rollup->now,
+					w_usage, &query);
+	if (query) {
+		if (debug_flags & DEBUG_FLAG_DB_USAGE)
+			DB_DEBUG(mysql_conn->conn, "query\n%s", query);
+		rc = mysql_db_query(mysql_conn, query);
+		xfree(query);
+		if (rc != SLURM_SUCCESS) {
+			error("Couldn't add wckey hour rollup");
+			goto end_it;
+		}
 	}
+end_insert:
+	END_TIMER;
+	phase_usec[ROLLUP_PHASE_INSERT] += DELTA_TIMER;
+
+	slurm_mutex_lock(&hour_rollup->lock);
+	for (i = 0; i < ROLLUP_PHASE_CNT; i++)
+		hour_rollup->phase_usec[i] += phase_usec[i];
+	slurm_mutex_unlock(&hour_rollup->lock);
+
 end_it:
 	xfree(query);
 	xfree(suspend_str);
 	xfree(job_str);
 	_destroy_local_cluster_usage(c_usage);
 
-	if (a_itr)
-		list_iterator_destroy(a_itr);
-	if (c_itr)
-		list_iterator_destroy(c_itr);
-	if (w_itr)
-		list_iterator_destroy(w_itr);
-	if (r_itr)
-		list_iterator_destroy(r_itr);
+	list_iterator_destroy(a_itr);
+	list_iterator_destroy(c_itr);
+	list_iterator_destroy(w_itr);
+	list_iterator_destroy(r_itr);
 
+	xhash_free(assoc_usage_hash);
+	xhash_free(wckey_usage_hash);
 	FREE_NULL_LIST(assoc_usage_list);
 	FREE_NULL_LIST(cluster_down_list);
 	FREE_NULL_LIST(wckey_usage_list);
 	FREE_NULL_LIST(resv_usage_list);
 
+	return rc;
+}
+
+/*
+ * Set the unused wall time of the reservations rolled up in parallel. Replay
+ * the hours of each reservation in order the same way _hourly_rollup_hour()
+ * would have done it rolling them up one after the other.
+ */
+static int _update_resv_unused(mysql_conn_t *mysql_conn, char *cluster_name,
+			       List resv_unused_list)
+{
+	local_resv_unused_t *resv_unused, *prev = NULL;
+	ListIterator itr;
+	char *query = NULL;
+	double unused_wall = 0;
+	int rc = SLURM_SUCCESS;
+
+	list_sort(resv_unused_list, _sort_resv_unused);
+	itr = list_iterator_create(resv_unused_list);
+	while ((resv_unused = list_next(itr))) {
+		if (!prev || (prev->id != resv_unused->id) ||
+		    (prev->orig_start != resv_unused->orig_start)) {
+			if (prev)
+				xstrfmtcat(query, "update \"%s_%s\" set unused_wall=%f where id_resv=%u and time_start=%ld;",
+					   cluster_name, resv_table,
+					   unused_wall, prev->id,
+					   prev->orig_start);
+			unused_wall = resv_unused->prev_unused;
+		}
+		unused_wall += resv_unused->resv_seconds;
+		unused_wall -= resv_unused->used_wall;
+		if (unused_wall < 0)
+			unused_wall = 0;
+		prev = resv_unused;
+	}
+	if (prev)
+		xstrfmtcat(query, "update \"%s_%s\" set unused_wall=%f where id_resv=%u and time_start=%ld;",
+			   cluster_name, resv_table,
+			   unused_wall, prev->id, prev->orig_start);
+	list_iterator_destroy(itr);
+
+	if (query) {
+		if (debug_flags & DEBUG_FLAG_DB_USAGE)
+			DB_DEBUG(mysql_conn->conn, "query\n%s", query);
+		rc = mysql_db_query(mysql_conn, query);
+		xfree(query);
+		if (rc != SLURM_SUCCESS)
+			error("couldn't update reservations with unused time");
+	}
+
+	return rc;
+}
+
+static void *_hourly_rollup_thread(void *arg)
+{
+	local_hour_rollup_t *hour_rollup = (local_hour_rollup_t *)arg;
+	mysql_conn_t mysql_conn;
+	List resv_unused_list = list_create(xfree_ptr);
+	time_t curr_start;
+	int rc;
+
+	memset(&mysql_conn, 0, sizeof(mysql_conn_t));
+	mysql_conn.rollback = 1;
+	mysql_conn.conn = hour_rollup->conn;
+	slurm_mutex_init(&mysql_conn.lock);
+
+	/* Each thread needs it's own connection */
+	rc = check_connection(&mysql_conn);
+
+	while (rc == SLURM_SUCCESS) {
+		slurm_mutex_lock(&hour_rollup->lock);
+		if ((hour_rollup->rc != SLURM_SUCCESS) ||
+		    (hour_rollup->next_start >= hour_rollup->end)) {
+			slurm_mutex_unlock(&hour_rollup->lock);
+			break;
+		}
+		curr_start = hour_rollup->next_start;
+		hour_rollup->next_start += 3600;
+		slurm_mutex_unlock(&hour_rollup->lock);
+
+		/* Commit each hour so threads don't hold locks for long */
+		if (((rc = _hourly_rollup_hour(&mysql_conn, hour_rollup,
+					       curr_start, resv_unused_list))
+		     == SLURM_SUCCESS) && mysql_db_commit(&mysql_conn)) {
+			char start[25];
+			error("Couldn't commit cluster (%s) hour rollup for %s",
+			      hour_rollup->cluster_name,
+			      slurm_ctime2_r(&curr_start, start));
+			rc = SLURM_ERROR;
+		}
+	}
+
+	if ((rc != SLURM_SUCCESS) && mysql_conn.db_conn &&
+	    mysql_db_rollback(&mysql_conn))
+		error("rollback failed");
+	mysql_db_close_db_connection(&mysql_conn);
+	slurm_mutex_destroy(&mysql_conn.lock);
+
+	slurm_mutex_lock(&hour_rollup->lock);
+	if ((rc != SLURM_SUCCESS) && (hour_rollup->rc == SLURM_SUCCESS))
+		hour_rollup->rc = rc;
+	list_transfer(hour_rollup->resv_unused_list, resv_unused_list);
+	slurm_mutex_unlock(&hour_rollup->lock);
+	FREE_NULL_LIST(resv_unused_list);
+
+	return NULL;
+}
+
+/* Number of connections to roll up hours on, from rollup_threads= */
+static int _rollup_threads(void)
+{
+	char *tmp_ptr;
+	int threads = 1;
+
+	if (slurmdbd_conf &&
+	    (tmp_ptr = xstrcasestr(slurmdbd_conf->parameters,
+				   "rollup_threads="))) {
+		threads = atoi(tmp_ptr + 15);
+		if (threads < 1) {
+			error("Invalid Parameters rollup_threads: %s",
+			      tmp_ptr);
+			threads = 1;
+		} else if (threads > MAX_ROLLUP_THREADS)
+			threads = MAX_ROLLUP_THREADS;
+	}
+
+	return threads;
+}
+
+extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
+				  char *cluster_name,
+				  time_t start, time_t end,
+				  uint16_t archive_data)
+{
+	int rc = SLURM_SUCCESS;
+	int i, hours, threads = 0;
+	time_t curr_start = start;
+	char *query = NULL;
+	MYSQL_RES *result = NULL;
+	MYSQL_ROW row;
+	local_hour_rollup_t hour_rollup;
+	pthread_t thread_id[MAX_ROLLUP_THREADS];
+	char *phase_str = NULL;
+	DEF_TIMERS;
+	/* char start_char[20], end_char[20]; */
+
+	START_TIMER;
+	memset(&hour_rollup, 0, sizeof(local_hour_rollup_t));
+	hour_rollup.cluster_name = cluster_name;
+	hour_rollup.conn = mysql_conn->conn;
+	hour_rollup.end = end;
+	hour_rollup.next_start = start;
+	hour_rollup.now = time(NULL);
+	hour_rollup.track_wckey = slurm_get_track_wckey();
+	slurm_mutex_init(&hour_rollup.lock);
+
+	/* We need to figure out the dimensions of this cluster */
+	query = xstrdup_printf("select dimensions from %s where name='%s'",
+			       cluster_table, cluster_name);
+	if (debug_flags & DEBUG_FLAG_DB_USAGE)
+		DB_DEBUG(mysql_conn->conn, "query\n%s", query);
+	result = mysql_db_query_ret(mysql_conn, query, 0);
+	xfree(query);
+
+	if (!result) {
+		error("%s: error querying cluster_table", __func__);
+		rc = SLURM_ERROR;
+		goto end_it;
+	}
+	row = mysql_fetch_row(result);
+
+	if (!row) {
+		error("%s: no cluster by name %s known",
+		      __func__, cluster_name);
+		rc = SLURM_ERROR;
+		goto end_it;
+	}
+
+	hour_rollup.dims = atoi(row[0]);
+	mysql_free_result(result);
+
+	hours = (end - start + 3599) / 3600;
+	threads = MIN(_rollup_threads(), hours);
+
+/* 	info("begin start %s", slurm_ctime2(&curr_start)); */
+/* 	info("begin end %s", slurm_ctime2(&curr_end)); */
+	if (threads <= 1) {
+		while (curr_start < end) {
+			if ((rc = _hourly_rollup_hour(mysql_conn, &hour_rollup,
+						      curr_start, NULL))
+			    != SLURM_SUCCESS)
+				goto end_it;
+			curr_start += 3600;
+		}
+	} else {
+		/*
+		 * Each thread commits the hours it rolls up on its own
+		 * connection, so don't leave anything from this connection
+		 * behind or we would get in their way.
+		 */
+		if (mysql_db_commit(mysql_conn)) {
+			rc = SLURM_ERROR;
+			goto end_it;
+		}
+		hour_rollup.resv_unused_list = list_create(xfree_ptr);
+		for (i = 0; i < threads; i++)
+			slurm_thread_create(&thread_id[i],
+					    _hourly_rollup_thread,
+					    &hour_rollup);
+		for (i = 0; i < threads; i++)
+			pthread_join(thread_id[i], NULL);
+		curr_start = hour_rollup.next_start;
+
+		if ((rc = hour_rollup.rc) == SLURM_SUCCESS)
+			rc = _update_resv_unused(
+				mysql_conn, cluster_name,
+				hour_rollup.resv_unused_list);
+	}
+end_it:
+	FREE_NULL_LIST(hour_rollup.resv_unused_list);
+	slurm_mutex_destroy(&hour_rollup.lock);
+
 /* 	info("stop start %s", slurm_ctime2(&curr_start)); */
 /* 	info("stop end %s", slurm_ctime2(&curr_end)); */
 
@@ -1823,6 +2112,7 @@ end_it:
 	if (rc == SLURM_SUCCESS) {
 		if (mysql_db_commit(mysql_conn)) {
 			char start[25], end[25];
+			time_t curr_end = curr_start + 3600;
 			error("Couldn't commit cluster (%s) "
 			      "hour rollup for %s - %s",
 			      cluster_name, slurm_ctime2_r(&curr_start, start),
@@ -1833,8 +2123,18 @@ end_it:
 					    archive_data, SLURMDB_PURGE_HOURS);
 	}
 
+	END_TIMER;
+	for (i = 0; i < ROLLUP_PHASE_CNT; i++)
+		xstrfmtcat(phase_str, " %s=%"PRIu64"ms", rollup_phase_str[i],
+			   hour_rollup.phase_usec[i] / 1000);
+	debug("%s: %s %ld-%ld with %d thread(s) took %s, hour phases:%s",
+	      __func__, cluster_name, start, end, MAX(threads, 1), TIME_STR,
+	      phase_str);
+	xfree(phase_str);
+
 	return rc;
 }
+
 extern int as_mysql_nonhour_rollup(mysql_conn_t *mysql_conn,
 				   bool run_month,
 				   char *cluster_name,
@@ -317,6 +317,7 @@ static void *_set_db_inx_thread(void *no_data)
 				 * it accordingly.
 				 */
 				job_ptr->db_index = NO_VAL64;
+				job_record_changed(job_ptr);
 			}
 
 			req = xmalloc(sizeof(dbd_job_start_msg_t));
@@ -401,8 +402,10 @@ static void *_set_db_inx_thread(void *no_data)
 						 * again. */
 						job_ptr->db_index =
 							id_ptr->db_index;
-						job_ptr->job_state &=
-							(~JOB_UPDATE_DB);
+						job_record_changed(job_ptr);
+						job_state_unset_flag(
+							job_ptr,
+							JOB_UPDATE_DB);
 					}
 				}
 				list_iterator_destroy(itr);
@@ -423,8 +426,10 @@ static void *_set_db_inx_thread(void *no_data)
 					goto end_it;
 				}
 				while ((job_ptr = list_next(itr))) {
-					if (job_ptr->db_index == NO_VAL64)
+					if (job_ptr->db_index == NO_VAL64) {
 						job_ptr->db_index = 0;
+						job_record_changed(job_ptr);
+					}
 				}
 				list_iterator_destroy(itr);
 				unlock_slurmctld(job_read_lock);
@@ -2589,8 +2594,10 @@ extern int jobacct_storage_p_job_start(void *db_conn, job_record_t *job_ptr)
 		 * same job.  This can happen when an account is being
 		 * deleted and hense the associations dealing with it.
 		 */
-		if (!req.db_index)
+		if (!req.db_index) {
 			job_ptr->db_index = NO_VAL64;
+			job_record_changed(job_ptr);
+		}
 
 		if (send_slurmdbd_msg(SLURM_PROTOCOL_VERSION, &msg) < 0) {
 			_partial_free_dbd_job_start(&req);
@@ -2614,6 +2621,7 @@ extern int jobacct_storage_p_job_start(void *db_conn, job_record_t *job_ptr)
 	} else {
 		resp = (dbd_id_rc_msg_t *) msg_rc.data;
 		job_ptr->db_index = resp->db_index;
+		job_record_changed(job_ptr);
 		rc = resp->return_code;
 		//info("here got %d for return code", resp->rc);
 		slurmdbd_free_id_rc_msg(resp);
@@ -0,0 +1,490 @@
+/*****************************************************************************\
+ *  dbd_spool.c - disk backed queue of messages pending for the SlurmDBD
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "src/common/slurm_xlator.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "src/common/slurmdbd_defs.h"
+#include "src/common/slurmdbd_pack.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "dbd_spool.h"
+
+/*
+ * File layout: a dbd_spool_hdr_t in the first page, then a ring of records.
+ * Each record is a dbd_spool_rec_t followed by the message, padded to
+ * DBD_SPOOL_ALIGN. A record that does not fit before the end of the file is
+ * written at the start of the ring instead, after a wrap marker if there is
+ * room for one.
+ *
+ * Records are appended without touching the header, the newest record is
+ * found on open by following the sequence numbers from the oldest one.
+ * Sequence numbers only grow, so stale records left in the ring never
+ * continue the chain.
+ */
+#define DBD_SPOOL_MAGIC		0xDB5B0001
+#define DBD_SPOOL_REC_MAGIC	0xDB5B0002
+#define DBD_SPOOL_WRAP_MAGIC	0xDB5B0003
+#define DBD_SPOOL_VERSION	1
+#define DBD_SPOOL_ALIGN		8
+#define DBD_SPOOL_MIN_SIZE	(1024 * 1024)
+
+#define DBD_SPOOL_REC_LEN(_size) \
+	((sizeof(dbd_spool_rec_t) + (_size) + DBD_SPOOL_ALIGN - 1) & \
+	 ~((uint64_t) DBD_SPOOL_ALIGN - 1))
+
+typedef struct {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t reserved;
+	uint64_t size;		/* of the file */
+	uint64_t head;		/* offset of the oldest record */
+	uint64_t head_seq;	/* sequence number of the oldest record */
+} dbd_spool_hdr_t;
+
+typedef struct {
+	uint32_t magic;
+	uint32_t size;		/* of the message */
+	uint64_t seq;
+	uint16_t rpc_version;	/* the message was packed with */
+	uint16_t reserved;
+	uint32_t hash;		/* of the message */
+} dbd_spool_rec_t;
+
+struct dbd_spool {
+	char *file;
+	int fd;
+	char *map;
+	dbd_spool_hdr_t *hdr;	/* start of map */
+	uint64_t size;
+	uint64_t data_start;	/* offset of the ring */
+	uint64_t head;		/* offset of the oldest record */
+	uint64_t head_seq;
+	uint64_t tail;		/* offset after the newest record */
+	uint64_t tail_seq;	/* sequence number of the next record */
+	uint32_t count;
+	bool dirty;
+	time_t sync_time;
+};
+
+/* FNV-1a */
+static uint32_t _spool_hash(const char *data, uint32_t size)
+{
+	uint32_t hash = 2166136261U;
+	uint32_t i;
+
+	for (i = 0; i < size; i++) {
+		hash ^= (unsigned char) data[i];
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+/*
+ * Return the record with sequence number seq at *pos, following a wrap to the
+ * start of the ring. *pos is set to the offset of the record.
+ * RET record or NULL if there is none
+ */
+static dbd_spool_rec_t *_spool_rec(dbd_spool_t *spool, uint64_t *pos,
+				   uint64_t seq)
+{
+	dbd_spool_rec_t *rec;
+
+	if ((spool->size - *pos) < sizeof(dbd_spool_rec_t))
+		*pos = spool->data_start;
+	rec = (dbd_spool_rec_t *) (spool->map + *pos);
+	if ((rec->magic == DBD_SPOOL_WRAP_MAGIC) && (rec->seq == seq)) {
+		*pos = spool->data_start;
+		rec = (dbd_spool_rec_t *) (spool->map + *pos);
+	}
+	if ((rec->magic != DBD_SPOOL_REC_MAGIC) || (rec->seq != seq) ||
+	    (rec->size > (spool->size - *pos - sizeof(dbd_spool_rec_t))))
+		return NULL;
+
+	return rec;
+}
+
+static void _spool_set_head(dbd_spool_t *spool)
+{
+	/* head_seq first, _spool_recover() skips records older than it */
+	spool->hdr->head_seq = spool->head_seq;
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	spool->hdr->head = spool->head;
+	spool->dirty = true;
+}
+
+static void _spool_init(dbd_spool_t *spool)
+{
+	memset(spool->map, 0, sizeof(dbd_spool_hdr_t));
+	spool->hdr->magic = DBD_SPOOL_MAGIC;
+	spool->hdr->version = DBD_SPOOL_VERSION;
+	spool->hdr->size = spool->size;
+	spool->head = spool->tail = spool->data_start;
+	spool->head_seq = spool->tail_seq = 1;
+	spool->count = 0;
+	_spool_set_head(spool);
+}
+
+/* Find the records of an existing spool, see the file layout above */
+static void _spool_recover(dbd_spool_t *spool)
+{
+	dbd_spool_rec_t *rec;
+	uint64_t pos, seq;
+
+	spool->head_seq = spool->hdr->head_seq;
+	pos = spool->hdr->head;
+	if ((pos < spool->data_start) || (pos > spool->size))
+		pos = spool->data_start;
+
+	/* Skip records released just before the header's head was updated */
+	if ((spool->size - pos) < sizeof(dbd_spool_rec_t))
+		pos = spool->data_start;
+	rec = (dbd_spool_rec_t *) (spool->map + pos);
+	if (((rec->magic == DBD_SPOOL_REC_MAGIC) ||
+	     (rec->magic == DBD_SPOOL_WRAP_MAGIC)) &&
+	    (rec->seq < spool->head_seq)) {
+		for (seq = rec->seq; seq < spool->head_seq; seq++) {
+			if (!(rec = _spool_rec(spool, &pos, seq)))
+				break;
+			pos += DBD_SPOOL_REC_LEN(rec->size);
+		}
+	}
+
+	spool->head = pos;
+	spool->count = 0;
+	seq = spool->head_seq;
+	while (1) {
+		if (!(rec = _spool_rec(spool, &pos, seq)) ||
+		    (rec->hash != _spool_hash((char *) (rec + 1), rec->size)))
+			break;
+		if (!spool->count)
+			spool->head = pos;
+		pos += DBD_SPOOL_REC_LEN(rec->size);
+		spool->count++;
+		seq++;
+		/* A chain longer than the ring can only be corruption */
+		if (((uint64_t) spool->count * DBD_SPOOL_REC_LEN(0)) >
+		    spool->size)
+			break;
+	}
+	spool->tail = pos;
+	spool->tail_seq = seq;
+
+	if (!spool->count)
+		spool->head = spool->tail = spool->data_start;
+	_spool_set_head(spool);
+}
+
+static int _spool_map(dbd_spool_t *spool)
+{
+	spool->map = mmap(NULL, spool->size, PROT_READ | PROT_WRITE,
+			  MAP_SHARED, spool->fd, 0);
+	if (spool->map == MAP_FAILED) {
+		error("%s: mmap(%s): %m", __func__, spool->file);
+		spool->map = NULL;
+		return SLURM_ERROR;
+	}
+	spool->hdr = (dbd_spool_hdr_t *) spool->map;
+	return SLURM_SUCCESS;
+}
+
+static void _spool_unmap(dbd_spool_t *spool)
+{
+	if (spool->map)
+		(void) munmap(spool->map, spool->size);
+	spool->map = NULL;
+	spool->hdr = NULL;
+}
+
+static int _spool_create(dbd_spool_t *spool, uint64_t size)
+{
+	_spool_unmap(spool);
+	spool->size = size;
+	if (ftruncate(spool->fd, 0) || ftruncate(spool->fd, spool->size)) {
+		error("%s: ftruncate(%s): %m", __func__, spool->file);
+		return SLURM_ERROR;
+	}
+	if (_spool_map(spool))
+		return SLURM_ERROR;
+	_spool_init(spool);
+	return SLURM_SUCCESS;
+}
+
+extern dbd_spool_t *dbd_spool_open(const char *file, uint64_t size)
+{
+	dbd_spool_t *spool = xmalloc(sizeof(dbd_spool_t));
+	struct stat st;
+	long page_size = sysconf(_SC_PAGESIZE);
+	bool valid = false;
+
+	spool->file = xstrdup(file);
+	spool->data_start = MAX(page_size, sizeof(dbd_spool_hdr_t));
+	size = MAX(size, DBD_SPOOL_MIN_SIZE);
+
+	if ((spool->fd = open(file, O_RDWR | O_CREAT | O_CLOEXEC, 0600)) < 0) {
+		error("%s: open(%s): %m", __func__, file);
+		goto fail;
+	}
+	if (flock(spool->fd, LOCK_EX | LOCK_NB)) {
+		error("%s: %s is in use by another process: %m",
+		      __func__, file);
+		goto fail;
+	}
+	if (fstat(spool->fd, &st)) {
+		error("%s: fstat(%s): %m", __func__, file);
+		goto fail;
+	}
+
+	if (st.st_size > spool->data_start) {
+		spool->size = st.st_size;
+		if (_spool_map(spool))
+			goto fail;
+		valid = ((spool->hdr->magic == DBD_SPOOL_MAGIC) &&
+			 (spool->hdr->version == DBD_SPOOL_VERSION) &&
+			 (spool->hdr->size == spool->size));
+		if (!valid)
+			error("%s: %s has an invalid header, discarding it",
+			      __func__, file);
+	}
+
+	if (valid) {
+		_spool_recover(spool);
+		if (spool->count && (spool->size != size)) {
+			info("%s: %s keeps size %"PRIu64" until its %u messages are sent",
+			     __func__, file, spool->size, spool->count);
+		} else if (spool->size != size) {
+			if (_spool_create(spool, size))
+				goto fail;
+		}
+	} else if (_spool_create(spool, size))
+		goto fail;
+
+	verbose("slurmdbd: recovered %u pending RPCs from %s",
+		spool->count, file);
+	return spool;
+
+fail:
+	_spool_unmap(spool);
+	if (spool->fd >= 0)
+		(void) close(spool->fd);
+	xfree(spool->file);
+	xfree(spool);
+	return NULL;
+}
+
+extern void dbd_spool_close(dbd_spool_t *spool)
+{
+	if (!spool)
+		return;
+
+	dbd_spool_sync(spool, true);
+	_spool_unmap(spool);
+	(void) close(spool->fd);
+	xfree(spool->file);
+	xfree(spool);
+}
+
+extern int dbd_spool_append(dbd_spool_t *spool, Buf buffer)
+{
+	uint32_t size = get_buf_offset(buffer);
+	uint64_t len = DBD_SPOOL_REC_LEN(size), pos;
+	dbd_spool_rec_t *rec;
+
+	if (!spool->count) {
+		spool->head = spool->tail = spool->data_start;
+		spool->head_seq = spool->tail_seq;
+		_spool_set_head(spool);
+	}
+
+	/* Never let tail reach head while there are records */
+	pos = spool->tail;
+	if (spool->tail >= spool->head) {
+		if ((spool->size - spool->tail) < len) {
+			if (spool->count &&
+			    ((spool->head - spool->data_start) <= len))
+				return ENOSPC;
+			if (!spool->count &&
+			    ((spool->size - spool->data_start) < len))
+				return ENOSPC;
+			if ((spool->size - spool->tail) >=
+			    sizeof(dbd_spool_rec_t)) {
+				rec = (dbd_spool_rec_t *)
+					(spool->map + spool->tail);
+				rec->seq = spool->tail_seq;
+				rec->size = 0;
+				rec->magic = DBD_SPOOL_WRAP_MAGIC;
+			}
+			pos = spool->data_start;
+		}
+	} else if ((spool->head - spool->tail) <= len)
+		return ENOSPC;
+
+	rec = (dbd_spool_rec_t *) (spool->map + pos);
+	rec->magic = 0;
+	rec->size = size;
+	rec->seq = spool->tail_seq;
+	rec->rpc_version = SLURM_STATE_PROTOCOL_VERSION;
+	rec->reserved = 0;
+	memcpy(rec + 1, get_buf_data(buffer), size);
+	rec->hash = _spool_hash((char *) (rec + 1), size);
+	/* Make the record valid only once it is complete */
+	__atomic_store_n(&rec->magic, DBD_SPOOL_REC_MAGIC, __ATOMIC_RELEASE);
+
+	spool->tail = pos + len;
+	spool->tail_seq++;
+	spool->count++;
+	spool->dirty = true;
+
+	return SLURM_SUCCESS;
+}
+
+extern uint32_t dbd_spool_count(dbd_spool_t *spool)
+{
+	if (!spool)
+		return 0;
+	return spool->count;
+}
+
+extern int dbd_spool_peek(dbd_spool_t *spool, List batch, int max_cnt)
+{
+	dbd_spool_rec_t *rec;
+	persist_msg_t msg;
+	Buf buffer;
+	uint64_t pos = spool->head, seq = spool->head_seq;
+	int cnt = 0, rc;
+
+	while ((cnt < max_cnt) && (cnt < spool->count)) {
+		if (!(rec = _spool_rec(spool, &pos, seq))) {
+			error("%s: lost record %"PRIu64" of %s",
+			      __func__, seq, spool->file);
+			break;
+		}
+		buffer = create_buf((char *) (rec + 1), rec->size);
+		if (rec->rpc_version != SLURM_STATE_PROTOCOL_VERSION) {
+			/* Queued before an upgrade, repack like dbd.messages */
+			memset(&msg, 0, sizeof(msg));
+			rc = unpack_slurmdbd_msg(&msg, rec->rpc_version,
+						 buffer);
+			(void) xfer_buf_data(buffer);
+			buffer = NULL;
+			if (rc == SLURM_SUCCESS)
+				buffer = pack_slurmdbd_msg(
+					&msg, SLURM_PROTOCOL_VERSION);
+			slurmdbd_free_msg(&msg);
+			if (!buffer) {
+				if (cnt)	/* discard it once at the head */
+					break;
+				error("%s: discarding invalid record %"PRIu64" of %s",
+				      __func__, seq, spool->file);
+				dbd_spool_release(spool, 1);
+				pos = spool->head;
+				seq = spool->head_seq;
+				continue;
+			}
+		} else
+			set_buf_offset(buffer, rec->size);
+		list_append(batch, buffer);
+		pos += DBD_SPOOL_REC_LEN(rec->size);
+		seq++;
+		cnt++;
+	}
+
+	return cnt;
+}
+
+extern void dbd_spool_batch_free(dbd_spool_t *spool, List batch)
+{
+	Buf buffer;
+	char *data;
+
+	while ((buffer = list_pop(batch))) {
+		data = get_buf_data(buffer);
+		if ((data >= spool->map) && (data < (spool->map + spool->size)))
+			(void) xfer_buf_data(buffer);	/* data is the map */
+		else
+			free_buf(buffer);
+	}
+}
+
+extern void dbd_spool_release(dbd_spool_t *spool, uint32_t cnt)
+{
+	dbd_spool_rec_t *rec;
+	uint64_t old_head = spool->head;
+	long page_size = sysconf(_SC_PAGESIZE);
+	uint64_t start, end;
+
+	while (cnt-- && spool->count) {
+		if (!(rec = _spool_rec(spool, &spool->head, spool->head_seq))) {
+			error("%s: lost records from %"PRIu64" of %s",
+			      __func__, spool->head_seq, spool->file);
+			spool->head_seq = spool->tail_seq;
+			spool->count = 0;
+			break;
+		}
+		spool->head += DBD_SPOOL_REC_LEN(rec->size);
+		spool->head_seq++;
+		spool->count--;
+	}
+	if (!spool->count)
+		spool->head = spool->tail = spool->data_start;
+	_spool_set_head(spool);
+
+	/* Drop delivered pages from memory, the file keeps the data */
+	start = (old_head / page_size) * page_size;
+	end = (spool->head > old_head) ? spool->head : spool->size;
+	end = (end / page_size) * page_size;
+	if (end > start)
+		(void) madvise(spool->map + start, end - start, MADV_DONTNEED);
+}
+
+extern void dbd_spool_sync(dbd_spool_t *spool, bool force)
+{
+	time_t now;
+
+	if (!spool || !spool->dirty)
+		return;
+
+	now = time(NULL);
+	if (!force && (now == spool->sync_time))
+		return;
+	if (msync(spool->map, spool->size, MS_SYNC))
+		error("%s: msync(%s): %m", __func__, spool->file);
+	spool->dirty = false;
+	spool->sync_time = now;
+}
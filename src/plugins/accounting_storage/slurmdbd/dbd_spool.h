@@ -0,0 +1,89 @@
+/*****************************************************************************\
+ *  dbd_spool.h - disk backed queue of messages pending for the SlurmDBD
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _DBD_SPOOL_H
+#define _DBD_SPOOL_H
+
+#include "src/common/list.h"
+#include "src/common/pack.h"
+
+/*
+ * A dbd_spool_t is a fixed size ring of packed messages in a file mapped into
+ * memory. Each record carries a sequence number and a hash of the message so
+ * the newest complete record can be found again after a crash, only the
+ * position of the oldest record is kept in the file header.
+ * The caller serializes all calls.
+ */
+typedef struct dbd_spool dbd_spool_t;
+
+/*
+ * Open the spool in file, creating it with the given size if needed.
+ * An existing spool holding records keeps its size until it is empty.
+ * RET spool or NULL on error
+ */
+extern dbd_spool_t *dbd_spool_open(const char *file, uint64_t size);
+
+/* Write pending changes to disk and close the spool */
+extern void dbd_spool_close(dbd_spool_t *spool);
+
+/*
+ * Append the packed message in buffer (up to its offset) to the spool
+ * RET SLURM_SUCCESS or ENOSPC if the spool is full
+ */
+extern int dbd_spool_append(dbd_spool_t *spool, Buf buffer);
+
+/* Return the number of messages in the spool */
+extern uint32_t dbd_spool_count(dbd_spool_t *spool);
+
+/*
+ * Append up to max_cnt of the oldest messages to batch as buffers ready to be
+ * packed in a DBD_SEND_MULT_MSG. The messages stay in the spool until
+ * released with dbd_spool_release(), the buffers must be freed with
+ * dbd_spool_batch_free() before then.
+ * RET number of messages added to batch
+ */
+extern int dbd_spool_peek(dbd_spool_t *spool, List batch, int max_cnt);
+
+/* Free the buffers added to batch by dbd_spool_peek() */
+extern void dbd_spool_batch_free(dbd_spool_t *spool, List batch);
+
+/* Remove the cnt oldest messages from the spool once they are delivered */
+extern void dbd_spool_release(dbd_spool_t *spool, uint32_t cnt);
+
+/*
+ * Write the spool to disk if changed, at most once per second unless force
+ * is set
+ */
+extern void dbd_spool_sync(dbd_spool_t *spool, bool force);
+
+#endif
@@ -44,6 +44,7 @@
 #include "src/common/xsignal.h"
 #include "src/common/xstring.h"
 
+#include "dbd_spool.h"
 #include "slurmdbd_agent.h"
 
 enum {
@@ -55,6 +56,7 @@ enum {
 #define SLURMDBD_TIMEOUT	900	/* Seconds SlurmDBD for response */
 #define DEBUG_PRINT_MAX_MSG_TYPES 10
 #define MAX_DBD_DEFAULT_ACTION MAX_DBD_ACTION_DISCARD
+#define DBD_SPOOL_BATCH		5000	/* spooled messages sent at once */
 
 static pthread_mutex_t agent_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t  agent_cond = PTHREAD_COND_INITIALIZER;
@@ -71,6 +73,16 @@ static pthread_cond_t  slurmdbd_cond = PTHREAD_COND_INITIALIZER;
 
 static int max_dbd_msg_action = MAX_DBD_DEFAULT_ACTION;
 
+/*
+ * With SlurmctldParameters=dbd_spool_size messages are queued in
+ * agent_spool. agent_list only holds registration messages, messages that
+ * did not fit in the spool and every message queued after them until the
+ * list is drained, so the spool always holds the older messages. Both are
+ * protected by agent_lock.
+ */
+static dbd_spool_t *agent_spool = NULL;
+static uint64_t dbd_spool_size = 0;
+
 static int _send_fini_msg(void)
 {
 	int rc;
@@ -177,13 +189,19 @@ static int _get_return_code(void)
 	return rc;
 }
 
-static int _handle_mult_rc_ret(void)
+/*
+ * Receive the return codes of a DBD_SEND_MULT_MSG and remove the messages
+ * delivered from the agent queue
+ * IN spooled - the messages were sent from agent_spool instead of agent_list
+ */
+static int _handle_mult_rc_ret(bool spooled)
 {
 	Buf buffer;
 	uint16_t msg_type;
 	persist_rc_msg_t *msg = NULL;
 	dbd_list_msg_t *list_msg = NULL;
 	int rc = SLURM_ERROR;
+	uint32_t delivered = 0;
 	Buf out_buf = NULL;
 
 	buffer = slurm_persist_recv_msg(slurmdbd_conn);
@@ -212,7 +230,9 @@ static int _handle_mult_rc_ret(void)
 				    != SLURM_SUCCESS)
 					break;
 
-				if ((b = list_dequeue(agent_list))) {
+				if (spooled) {
+					delivered++;
+				} else if ((b = list_dequeue(agent_list))) {
 					free_buf(b);
 				} else {
 					error("slurmdbd: DBD_GOT_MULT_MSG "
@@ -220,6 +240,8 @@ static int _handle_mult_rc_ret(void)
 				}
 			}
 			list_iterator_destroy(itr);
+			if (delivered && agent_spool)
+				dbd_spool_release(agent_spool, delivered);
 		}
 		slurm_mutex_unlock(&agent_lock);
 		slurmdbd_free_list_msg(list_msg);
@@ -365,7 +387,7 @@ static void _load_dbd_state(void)
 				buffer = _load_dbd_rec(fd);
 			if (buffer == NULL)
 				break;
-			if (rpc_version != SLURM_PROTOCOL_VERSION) {
+			if (rpc_version != SLURM_STATE_PROTOCOL_VERSION) {
 				/* unpack and repack with new
 				 * PROTOCOL_VERSION just so we keep
 				 * things up to date.
@@ -454,7 +476,7 @@ static void _save_dbd_state(void)
 	} else if (list_count(agent_list)) {
 		char curr_ver_str[10];
 		snprintf(curr_ver_str, sizeof(curr_ver_str),
-			 "VER%d", SLURM_PROTOCOL_VERSION);
+			 "VER%d", SLURM_STATE_PROTOCOL_VERSION);
 		buffer = init_buf(strlen(curr_ver_str));
 		packstr(curr_ver_str, buffer);
 		rc = _save_dbd_rec(fd, buffer);
@@ -564,6 +586,7 @@ static void _max_dbd_msg_action(uint32_t *msg_cnt)
 			return;
 
 		_save_dbd_state();
+		dbd_spool_sync(agent_spool, true);
 		fatal("slurmdbd: agent queue is full (%u), not continuing until slurmdbd is able to process messages.",
 		      *msg_cnt);
 	}
@@ -733,7 +756,8 @@ static void _print_agent_list_msg_types(void)
 static void *_agent(void *x)
 {
 	int rc;
-	uint32_t cnt;
+	uint32_t cnt, spool_cnt;
+	bool spooled;
 	Buf buffer;
 	struct timespec abs_time;
 	static time_t fail_time = 0;
@@ -781,26 +805,47 @@ static void *_agent(void *x)
 		}
 
 		slurm_mutex_lock(&agent_lock);
+		dbd_spool_sync(agent_spool, false);
 		cnt = list_count(agent_list);
-		if ((cnt == 0) || (slurmdbd_conn->fd < 0) ||
+		spool_cnt = dbd_spool_count(agent_spool);
+		spooled = false;
+		if (((cnt + spool_cnt) == 0) || (slurmdbd_conn->fd < 0) ||
 		    (fail_time && (difftime(time(NULL), fail_time) < 10))) {
 			slurm_mutex_unlock(&slurmdbd_lock);
 			_max_dbd_msg_action(&cnt);
 			END_TIMER2("slurmdbd agent: sleep");
 			if (slurmctld_conf.debug_flags & DEBUG_FLAG_AGENT)
 				info("%s: slurmdbd agent sleeping with agent_count=%d",
-				     __func__, list_count(agent_list));
+				     __func__, list_count(agent_list) +
+				     dbd_spool_count(agent_spool));
 			abs_time.tv_sec  = time(NULL) + 10;
 			abs_time.tv_nsec = 0;
 			slurm_cond_timedwait(&agent_cond, &agent_lock,
 					     &abs_time);
 			slurm_mutex_unlock(&agent_lock);
 			continue;
-		} else if (((cnt > 0) && ((cnt % 100) == 0)) ||
+		} else if ((((cnt + spool_cnt) > 0) &&
+			    (((cnt + spool_cnt) % 100) == 0)) ||
 			   (slurmctld_conf.debug_flags & DEBUG_FLAG_AGENT))
-			info("slurmdbd: agent_count:%d", cnt);
+			info("slurmdbd: agent_count:%d", cnt + spool_cnt);
 		/* Leave item on the queue until processing complete */
-		if (agent_list) {
+		if (spool_cnt) {
+			/*
+			 * agent_spool holds the older messages, send those in
+			 * agent_list once it is empty. The mult msg is packed
+			 * from the spool's memory map without copying.
+			 */
+			list_msg.my_list = list_create(NULL);
+			if (dbd_spool_peek(agent_spool, list_msg.my_list,
+					   DBD_SPOOL_BATCH)) {
+				buffer = pack_slurmdbd_msg(
+					&list_req, SLURM_PROTOCOL_VERSION);
+				spooled = true;
+			} else
+				buffer = NULL;
+			dbd_spool_batch_free(agent_spool, list_msg.my_list);
+			FREE_NULL_LIST(list_msg.my_list);
+		} else if (agent_list) {
 			int handle_agent_count = 1000;
 			if (cnt > handle_agent_count) {
 				int agent_count = 0;
@@ -848,8 +893,8 @@ static void *_agent(void *x)
 				break;
 			}
 			error("slurmdbd: Failure sending message: %d: %m", rc);
-		} else if (list_msg.my_list) {
-			rc = _handle_mult_rc_ret();
+		} else if (list_msg.my_list || spooled) {
+			rc = _handle_mult_rc_ret(spooled);
 		} else {
 			rc = _get_return_code();
 			if (rc == EAGAIN) {
@@ -869,7 +914,14 @@ static void *_agent(void *x)
 		slurm_mutex_unlock(&assoc_cache_mutex);
 
 		slurm_mutex_lock(&agent_lock);
-		if (agent_list && (rc == SLURM_SUCCESS)) {
+		if (spooled) {
+			/* _handle_mult_rc_ret() released what was delivered */
+			free_buf(buffer);
+			if (rc == SLURM_SUCCESS)
+				fail_time = 0;
+			else
+				fail_time = time(NULL);
+		} else if (agent_list && (rc == SLURM_SUCCESS)) {
 			/*
 			 * If we sent a mult_msg we just need to free buffer,
 			 * we don't need to requeue, just mark list_msg.my_list
@@ -910,22 +962,53 @@ static void *_agent(void *x)
 
 	if (slurmctld_conf.debug_flags & DEBUG_FLAG_AGENT)
 		info("%s: slurmdbd agent ending with agent_count=%d",
-		     __func__, list_count(agent_list));
+		     __func__, list_count(agent_list) +
+		     dbd_spool_count(agent_spool));
 
 	FREE_NULL_LIST(agent_list);
+	dbd_spool_close(agent_spool);
+	agent_spool = NULL;
 	slurm_mutex_unlock(&agent_lock);
 	return NULL;
 }
 
+/*
+ * Move the messages recovered from dbd.messages to the end of agent_spool,
+ * while they fit, so they are sent in order with the spooled messages
+ */
+static void _spool_agent_list(void)
+{
+	Buf buffer;
+
+	if (!agent_spool)
+		return;
+	while ((buffer = list_peek(agent_list))) {
+		if (dbd_spool_append(agent_spool, buffer) != SLURM_SUCCESS)
+			break;
+		buffer = list_dequeue(agent_list);
+		free_buf(buffer);
+	}
+}
+
 static void _create_agent(void)
 {
 	/* this needs to be set because the agent thread will do
 	   nothing if the connection was closed and then opened again */
 	slurmdbd_shutdown = 0;
 
+	if (dbd_spool_size && !agent_spool) {
+		char *spool_fname = slurm_get_state_save_location();
+		xstrcat(spool_fname, "/dbd.spool");
+		agent_spool = dbd_spool_open(spool_fname, dbd_spool_size);
+		if (!agent_spool)
+			error("slurmdbd: queueing messages in memory only");
+		xfree(spool_fname);
+	}
+
 	if (agent_list == NULL) {
 		agent_list = list_create(slurmdbd_free_buffer);
 		_load_dbd_state();
+		_spool_agent_list();
 	}
 
 	if (agent_tid == 0) {
@@ -1180,7 +1263,7 @@ extern int send_slurmdbd_msg(uint16_t rpc_version, persist_msg_t *req)
 {
 	Buf buffer;
 	uint32_t cnt, rc = SLURM_SUCCESS;
-	static time_t syslog_time = 0;
+	static time_t syslog_time = 0, spool_full_time = 0;
 
 	xassert(slurmctld_conf.max_dbd_msgs);
 
@@ -1204,6 +1287,27 @@ extern int send_slurmdbd_msg(uint16_t rpc_version, persist_msg_t *req)
 			return SLURM_ERROR;
 		}
 	}
+
+	/*
+	 * Registration messages are not kept across restarts, see
+	 * _save_dbd_state(). Once a message is queued in agent_list, later
+	 * ones follow it there so that they are sent in order.
+	 */
+	if (agent_spool && (req->msg_type != DBD_REGISTER_CTLD) &&
+	    !list_count(agent_list)) {
+		if (dbd_spool_append(agent_spool, buffer) == SLURM_SUCCESS) {
+			free_buf(buffer);
+			slurm_cond_broadcast(&agent_cond);
+			slurm_mutex_unlock(&agent_lock);
+			return rc;
+		}
+		if (difftime(time(NULL), spool_full_time) > 120) {
+			spool_full_time = time(NULL);
+			error("slurmdbd: agent spool is full (%u), queueing in memory, RESTART SLURMDBD NOW",
+			      dbd_spool_count(agent_spool));
+		}
+	}
+
 	cnt = list_count(agent_list);
 	if ((cnt >= (slurmctld_conf.max_dbd_msgs / 2)) &&
 	    (difftime(time(NULL), syslog_time) > 120)) {
@@ -1249,7 +1353,7 @@ extern bool slurmdbd_conn_active(void)
 
 extern int slurmdbd_agent_queue_count(void)
 {
-	return list_count(agent_list);
+	return list_count(agent_list) + dbd_spool_count(agent_spool);
 }
 
 extern void slurmdbd_agent_config_setup(void)
@@ -1281,4 +1385,11 @@ extern void slurmdbd_agent_config_setup(void)
 		xfree(type);
 	} else
 		max_dbd_msg_action = MAX_DBD_DEFAULT_ACTION;
+
+	if ((tmp_ptr = xstrcasestr(slurmctld_conf.slurmctld_params,
+				   "dbd_spool_size=")))
+		dbd_spool_size = (uint64_t) strtoull(tmp_ptr + 15, NULL, 10) *
+				 1024 * 1024;
+	else
+		dbd_spool_size = 0;
 }
@@ -774,7 +774,7 @@ static void _save_bb_state(void)
 	char *old_file = NULL, *new_file = NULL, *reg_file = NULL;
 	int i, count_offset, offset, state_fd;
 	int error_code = 0;
-	uint16_t protocol_version = SLURM_PROTOCOL_VERSION;
+	uint16_t protocol_version = SLURM_STATE_PROTOCOL_VERSION;
 
 	if ((bb_state.last_update_time <= last_save_time) &&
 	    !bb_state.term_flag)
@@ -2061,9 +2061,10 @@ static void *_start_stage_out(void *x)
 			xstrfmtcat(job_ptr->state_desc, "%s: %s: %s",
 				   plugin_type, op, resp_msg);
 		} else {
-			job_ptr->job_state &= (~JOB_STAGE_OUT);
+			job_state_unset_flag(job_ptr, JOB_STAGE_OUT);
 			xfree(job_ptr->state_desc);
 			last_job_update = time(NULL);
+			job_record_changed(job_ptr);
 		}
 		slurm_mutex_lock(&bb_state.bb_mutex);
 		bb_job = _get_bb_job(job_ptr);
@@ -2272,7 +2273,7 @@ static void *_start_teardown(void *x)
 			}
 			if ((bb_job = _get_bb_job(job_ptr)))
 				bb_job->state = BB_STATE_COMPLETE;
-			job_ptr->job_state &= (~JOB_STAGE_OUT);
+			job_state_unset_flag(job_ptr, JOB_STAGE_OUT);
 			if (!IS_JOB_PENDING(job_ptr) &&	/* No email if requeue */
 			    (job_ptr->mail_type & MAIL_JOB_STAGE_OUT)) {
 				/*
@@ -4178,7 +4179,7 @@ extern int bb_p_job_begin(job_record_t *job_ptr)
 		pre_run_args->user_id = job_ptr->user_id;
 		if (job_ptr->details) {	/* Defer launch until completion */
 			job_ptr->details->prolog_running++;
-			job_ptr->job_state |= JOB_CONFIGURING;
+			job_state_set_flag(job_ptr, JOB_CONFIGURING);
 		}
 
 		slurm_thread_create(&tid, _start_pre_run, pre_run_args);
@@ -4195,6 +4196,7 @@ fini:
 static void _kill_job(job_record_t *job_ptr, bool hold_job)
 {
 	last_job_update = time(NULL);
+	job_record_changed(job_ptr);
 	job_ptr->end_time = last_job_update;
 	if (hold_job)
 		job_ptr->priority = 0;
@@ -4204,9 +4206,9 @@ static void _kill_job(job_record_t *job_ptr, bool hold_job)
 	xfree(job_ptr->state_desc);
 	job_ptr->state_desc = xstrdup("Burst buffer pre_run error");
 
-	job_ptr->job_state  = JOB_REQUEUE;
+	job_state_set(job_ptr, JOB_REQUEUE);
 	job_completion_logger(job_ptr, true);
-	job_ptr->job_state = JOB_PENDING | JOB_COMPLETING;
+	job_state_set(job_ptr, JOB_PENDING | JOB_COMPLETING);
 
 	deallocate_nodes(job_ptr, false, false, false);
 }
@@ -4304,7 +4306,7 @@ static void *_start_pre_run(void *x)
 	}
 	if (job_ptr) {
 		if (run_kill_job)
-			job_ptr->job_state &= ~JOB_CONFIGURING;
+			job_state_unset_flag(job_ptr, JOB_CONFIGURING);
 		prolog_running_decr(job_ptr);
 	}
 	slurm_mutex_unlock(&bb_state.bb_mutex);
@@ -4384,7 +4386,7 @@ extern int bb_p_job_start_stage_out(job_record_t *job_ptr)
 		_queue_teardown(job_ptr->job_id, job_ptr->user_id, true);
 	} else if (bb_job->state < BB_STATE_POST_RUN) {
 		bb_job->state = BB_STATE_POST_RUN;
-		job_ptr->job_state |= JOB_STAGE_OUT;
+		job_state_set_flag(job_ptr, JOB_STAGE_OUT);
 		xfree(job_ptr->state_desc);
 		xstrfmtcat(job_ptr->state_desc, "%s: Stage-out in progress",
 			   plugin_type);
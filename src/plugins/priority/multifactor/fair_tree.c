@@ -48,7 +48,7 @@ static int  _ft_decay_apply_new_usage(job_record_t *job, time_t *start);
 static void _apply_priority_fs(void);
 
 /* Fair Tree code called from the decay thread loop */
-extern void fair_tree_decay(List jobs, time_t start)
+extern int fair_tree_decay(List jobs, time_t start)
 {
 	slurmctld_lock_t job_write_lock =
 		{ NO_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK, NO_LOCK };
@@ -66,10 +66,8 @@ extern void fair_tree_decay(List jobs, time_t start)
 	_apply_priority_fs();
 	assoc_mgr_unlock(&locks);
 
-	/* assign job priorities */
-	lock_slurmctld(job_write_lock);
-	list_for_each(jobs, (ListForF) decay_apply_weighted_factors, &start);
-	unlock_slurmctld(job_write_lock);
+	/* assign job priorities, this takes the job locks itself */
+	return decay_apply_jobs(jobs, start);
 }
 
 
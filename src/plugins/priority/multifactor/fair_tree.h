@@ -40,7 +40,10 @@
 
 #include "priority_multifactor.h"
 
-/* Fair Tree code called from the decay thread loop */
-extern void fair_tree_decay(List jobs, time_t start);
+/*
+ * Fair Tree code called from the decay thread loop
+ * RET number of jobs whose priority was recalculated
+ */
+extern int fair_tree_decay(List jobs, time_t start);
 
 #endif
@@ -64,6 +64,7 @@
 #include "src/common/slurm_mcs.h"
 #include "src/common/slurm_priority.h"
 #include "src/common/slurm_time.h"
+#include "src/common/xhash.h"
 #include "src/common/xstring.h"
 #include "src/common/gres.h"
 
@@ -75,6 +76,12 @@
 #define SECS_PER_DAY	(24 * 60 * 60)
 #define SECS_PER_WEEK	(7 * SECS_PER_DAY)
 
+#define MAX_DECAY_THREADS	64
+/* Fewest jobs worth handing to another priority factor thread */
+#define DECAY_JOBS_PER_THREAD	64
+/* Jobs whose weighted priority factors are summed together */
+#define PRIO_BATCH_SIZE		256
+
 /* These are defined here so when we link with something other than
  * the slurmctld we will have these symbols defined.  They will get
  * overwritten when linking with the slurmctld.
@@ -87,6 +94,7 @@ extern time_t last_job_update __attribute__((weak_import));
 extern slurm_ctl_conf_t slurmctld_conf __attribute__((weak_import));
 extern int slurmctld_tres_cnt __attribute__((weak_import));
 extern uint16_t accounting_enforce __attribute__((weak_import));
+extern diag_stats_t slurmctld_diag_stats __attribute__((weak_import));
 #else
 void *acct_db_conn = NULL;
 uint32_t cluster_cpus = NO_VAL;
@@ -95,6 +103,7 @@ time_t last_job_update = (time_t) 0;
 slurm_ctl_conf_t slurmctld_conf;
 int slurmctld_tres_cnt = 0;
 uint16_t accounting_enforce = 0;
+diag_stats_t slurmctld_diag_stats;
 #endif
 
 /*
@@ -150,12 +159,68 @@ static uint32_t prevflags;    /* Priority Flags before _internal_setup() resets
 			       * flags after a reconfigure */
 static time_t g_last_ran = 0; /* when the last poll ran */
 static double decay_factor = 1; /* The decay factor when decaying time. */
+static int decay_threads = 1; /* PriorityParameters=decay_threads= */
+
+/*
+ * New priority of a job computed under the job read lock, published by
+ * _decay_publish() under the job write lock
+ */
+typedef struct {
+	job_record_t *job_ptr;
+	uint32_t job_id;	/* to check job_ptr still exists */
+	priority_factors_object_t *prio_factors; /* NULL if not computed */
+	uint32_t *priority_array; /* in the order of part_order */
+	part_record_t **part_order; /* job_ptr->part_ptr_list when computed */
+	int part_cnt;
+	uint32_t new_prio;
+} decay_prio_t;
+
+typedef struct {
+	decay_prio_t *prios;	/* jobs to compute a new priority for */
+	int job_cnt;
+	time_t start_time;
+} decay_factors_args_t;
+
+/*
+ * Priority factors of up to PRIO_BATCH_SIZE jobs, one array per factor so
+ * the weighted sum of every job is computed in a single vectorizable loop.
+ */
+typedef struct {
+	double age[PRIO_BATCH_SIZE];
+	double assoc[PRIO_BATCH_SIZE];
+	double fs[PRIO_BATCH_SIZE];
+	double js[PRIO_BATCH_SIZE];
+	double part[PRIO_BATCH_SIZE];
+	double qos[PRIO_BATCH_SIZE];
+	double tres[PRIO_BATCH_SIZE];	/* already weighted */
+	double site[PRIO_BATCH_SIZE];	/* less NICE_OFFSET */
+	double nice[PRIO_BATCH_SIZE];	/* less NICE_OFFSET */
+	double prio[PRIO_BATCH_SIZE];
+	bool scalar[PRIO_BATCH_SIZE];	/* use _decay_calc_prio() */
+} prio_batch_t;
+
+/* Fairshare factor of an association, cached for a batch of jobs */
+typedef struct {
+	slurmdb_assoc_rec_t *assoc;
+	double fs;
+} prio_batch_fs_t;
+
+/* Job and user ID filters of a priority factors request, sorted */
+typedef struct {
+	uint32_t *job_ids;
+	int job_id_cnt;
+	uint32_t *user_ids;
+	int user_id_cnt;
+} prio_id_filter_t;
 
 /* variables defined in priority_multifactor.h */
 bool priority_debug = 0;
 
 static void _priority_p_set_assoc_usage_debug(slurmdb_assoc_rec_t *assoc);
 static void _set_assoc_usage_efctv(slurmdb_assoc_rec_t *assoc);
+static void _set_priority_factors(time_t start_time, job_record_t *job_ptr,
+				  priority_factors_object_t *prio_factors,
+				  double *fs_ptr);
 
 /*
  * apply decay factor to all associations usage_raw
@@ -411,23 +476,16 @@ static int _set_children_usage_efctv(List children_list)
 /* job_ptr should already have the partition priority and such added here
  * before had we will be adding to it
  */
-static double _get_fairshare_priority(job_record_t *job_ptr)
+/* NOTE: acct_mgr_assoc_lock must be locked before this is called. */
+static double _get_fairshare_priority_locked(job_record_t *job_ptr)
 {
 	slurmdb_assoc_rec_t *job_assoc;
 	slurmdb_assoc_rec_t *fs_assoc = NULL;
 	double priority_fs = 0.0;
-	assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
-				   NO_LOCK, NO_LOCK, NO_LOCK };
-
-	if (!calc_fairshare)
-		return 0;
-
-	assoc_mgr_lock(&locks);
 
 	job_assoc = job_ptr->assoc_ptr;
 
 	if (!job_assoc) {
-		assoc_mgr_unlock(&locks);
 		error("Job %u has no association.  Unable to "
 		      "compute fairshare.", job_ptr->job_id);
 		return 0;
@@ -462,6 +520,21 @@ static double _get_fairshare_priority(job_record_t *job_ptr)
 			     fs_assoc->usage->shares_norm, priority_fs);
 		}
 	}
+
+	return priority_fs;
+}
+
+static double _get_fairshare_priority(job_record_t *job_ptr)
+{
+	double priority_fs;
+	assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
+				   NO_LOCK, NO_LOCK, NO_LOCK };
+
+	if (!calc_fairshare)
+		return 0;
+
+	assoc_mgr_lock(&locks);
+	priority_fs = _get_fairshare_priority_locked(job_ptr);
 	assoc_mgr_unlock(&locks);
 
 	return priority_fs;
@@ -513,9 +586,27 @@ static double _get_tres_prio_weighted(double *tres_factors)
 	return tmp_tres;
 }
 
-/* Returns the priority after applying the weight factors */
-static uint32_t _get_priority_internal(time_t start_time,
-				       job_record_t *job_ptr)
+/* Return true if the priority of job_ptr is computed from its factors */
+static bool _prio_from_factors(job_record_t *job_ptr)
+{
+	if (job_ptr->direct_set_prio && (job_ptr->priority > 0))
+		return false;
+	if (!job_ptr->details)
+		return false;
+	return true;
+}
+
+/*
+ * Compute the priority of job_ptr after applying the weight factors.
+ * The factors are set in prio_factors and the priority in each partition of
+ * job_ptr->part_ptr_list, in the order of that list, in priority_array.
+ * If the priority does not come from the factors, prio_factors is cleared
+ * and priority_array is left alone, both may then be NULL.
+ * Nothing in job_ptr is changed so this can run under the job read lock.
+ */
+static uint32_t _calc_priority(time_t start_time, job_record_t *job_ptr,
+			       priority_factors_object_t *prio_factors,
+			       uint32_t *priority_array)
 {
 	double priority	= 0.0;
 	priority_factors_object_t pre_factors;
@@ -524,10 +615,10 @@ static uint32_t _get_priority_internal(time_t start_time,
 	char *multi_part_str = NULL;
 
 	if (job_ptr->direct_set_prio && (job_ptr->priority > 0)) {
-		if (job_ptr->prio_factors) {
-			xfree(job_ptr->prio_factors->tres_weights);
-			xfree(job_ptr->prio_factors->priority_tres);
-			memset(job_ptr->prio_factors, 0,
+		if (prio_factors) {
+			xfree(prio_factors->tres_weights);
+			xfree(prio_factors->priority_tres);
+			memset(prio_factors, 0,
 			       sizeof(priority_factors_object_t));
 		}
 		return job_ptr->priority;
@@ -537,53 +628,53 @@ static uint32_t _get_priority_internal(time_t start_time,
 		error("_get_priority_internal: job %u does not have a "
 		      "details symbol set, can't set priority",
 		      job_ptr->job_id);
-		if (job_ptr->prio_factors) {
-			xfree(job_ptr->prio_factors->tres_weights);
-			xfree(job_ptr->prio_factors->priority_tres);
-			memset(job_ptr->prio_factors, 0,
+		if (prio_factors) {
+			xfree(prio_factors->tres_weights);
+			xfree(prio_factors->priority_tres);
+			memset(prio_factors, 0,
 			       sizeof(priority_factors_object_t));
 		}
 		return 0;
 	}
 
-	set_priority_factors(start_time, job_ptr);
+	_set_priority_factors(start_time, job_ptr, prio_factors, NULL);
 
 	if (priority_debug) {
-		memcpy(&pre_factors, job_ptr->prio_factors,
+		memcpy(&pre_factors, prio_factors,
 		       sizeof(priority_factors_object_t));
-		if (job_ptr->prio_factors->priority_tres) {
+		if (prio_factors->priority_tres) {
 			pre_factors.priority_tres = xcalloc(slurmctld_tres_cnt,
 							    sizeof(double));
 			memcpy(pre_factors.priority_tres,
-			       job_ptr->prio_factors->priority_tres,
+			       prio_factors->priority_tres,
 			       sizeof(double) * slurmctld_tres_cnt);
 		}
 	} else	/* clang needs this memset to avoid a warning */
 		memset(&pre_factors, 0, sizeof(priority_factors_object_t));
 
-	job_ptr->prio_factors->priority_age  *= (double)weight_age;
-	job_ptr->prio_factors->priority_assoc *= (double)weight_assoc;
-	job_ptr->prio_factors->priority_fs   *= (double)weight_fs;
-	job_ptr->prio_factors->priority_js   *= (double)weight_js;
-	job_ptr->prio_factors->priority_part *= (double)weight_part;
-	job_ptr->prio_factors->priority_qos  *= (double)weight_qos;
+	prio_factors->priority_age  *= (double)weight_age;
+	prio_factors->priority_assoc *= (double)weight_assoc;
+	prio_factors->priority_fs   *= (double)weight_fs;
+	prio_factors->priority_js   *= (double)weight_js;
+	prio_factors->priority_part *= (double)weight_part;
+	prio_factors->priority_qos  *= (double)weight_qos;
 
-	if (weight_tres && job_ptr->prio_factors->priority_tres) {
+	if (weight_tres && prio_factors->priority_tres) {
 		double *tres_factors = NULL;
-		tres_factors = job_ptr->prio_factors->priority_tres;
+		tres_factors = prio_factors->priority_tres;
 		tmp_tres = _get_tres_prio_weighted(tres_factors);
 	}
 
-	priority = job_ptr->prio_factors->priority_age
-		+ job_ptr->prio_factors->priority_assoc
-		+ job_ptr->prio_factors->priority_fs
-		+ job_ptr->prio_factors->priority_js
-		+ job_ptr->prio_factors->priority_part
-		+ job_ptr->prio_factors->priority_qos
+	priority = prio_factors->priority_age
+		+ prio_factors->priority_assoc
+		+ prio_factors->priority_fs
+		+ prio_factors->priority_js
+		+ prio_factors->priority_part
+		+ prio_factors->priority_qos
 		+ tmp_tres
-		+ (double)(((int64_t)job_ptr->prio_factors->priority_site)
+		+ (double)(((int64_t)prio_factors->priority_site)
 			   - NICE_OFFSET)
-		- (double)(((int64_t)job_ptr->prio_factors->nice)
+		- (double)(((int64_t)prio_factors->nice)
 			   - NICE_OFFSET);
 
 	/* Priority 0 is reserved for held jobs */
@@ -597,19 +688,12 @@ static uint32_t _get_priority_internal(time_t start_time,
 		priority = (double) tmp_64;
 	}
 
-	if (job_ptr->part_ptr_list) {
+	if (job_ptr->part_ptr_list && priority_array) {
 		part_record_t *part_ptr;
 		double priority_part;
 		ListIterator part_iterator;
 		int i = 0;
 
-		if (!job_ptr->priority_array) {
-			i = list_count(job_ptr->part_ptr_list) + 1;
-			job_ptr->priority_array = xcalloc(i, sizeof(uint32_t));
-		}
-
-		i = 0;
-		list_sort(job_ptr->part_ptr_list, priority_sort_part_tier);
 		part_iterator = list_iterator_create(job_ptr->part_ptr_list);
 		while ((part_ptr = list_next(part_iterator))) {
 			double part_tres = 0.0;
@@ -630,17 +714,17 @@ static uint32_t _get_priority_internal(time_t start_time,
 				 part_ptr->norm_priority) *
 				(double)weight_part;
 			priority_part +=
-				 (job_ptr->prio_factors->priority_age
-				 + job_ptr->prio_factors->priority_assoc
-				 + job_ptr->prio_factors->priority_fs
-				 + job_ptr->prio_factors->priority_js
-				 + job_ptr->prio_factors->priority_qos
+				 (prio_factors->priority_age
+				 + prio_factors->priority_assoc
+				 + prio_factors->priority_fs
+				 + prio_factors->priority_js
+				 + prio_factors->priority_qos
 				 + part_tres
 				 + (double)
-				   (((int64_t)job_ptr->prio_factors->priority_site)
+				   (((int64_t)prio_factors->priority_site)
 				    - NICE_OFFSET)
 				 - (double)
-				   (((int64_t)job_ptr->prio_factors->nice)
+				   (((int64_t)prio_factors->nice)
 				    - NICE_OFFSET));
 
 			/* Priority 0 is reserved for held jobs */
@@ -655,15 +739,15 @@ static uint32_t _get_priority_internal(time_t start_time,
 				priority_part = (double) tmp_64;
 			}
 			if (((flags & PRIORITY_FLAGS_INCR_ONLY) == 0) ||
-			    (job_ptr->priority_array[i] <
+			    (priority_array[i] <
 			     (uint32_t) priority_part)) {
-				job_ptr->priority_array[i] =
+				priority_array[i] =
 					(uint32_t) priority_part;
 			}
 			if (priority_debug) {
 				xstrfmtcat(multi_part_str, multi_part_str ?
 					   ", %s=%u" : "%s=%u", part_ptr->name,
-					   job_ptr->priority_array[i]);
+					   priority_array[i]);
 			}
 			i++;
 		}
@@ -677,32 +761,32 @@ static uint32_t _get_priority_internal(time_t start_time,
 	if (priority_debug) {
 		int i;
 		double *post_tres_factors =
-			job_ptr->prio_factors->priority_tres;
+			prio_factors->priority_tres;
 		double *pre_tres_factors = pre_factors.priority_tres;
 		assoc_mgr_lock_t locks = { NO_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
 					   READ_LOCK, NO_LOCK, NO_LOCK };
 		int64_t priority_site =
-			(((int64_t)job_ptr->prio_factors->priority_site) -
+			(((int64_t)prio_factors->priority_site) -
 			 NICE_OFFSET);
 
 		info("Weighted Age priority is %f * %u = %.2f",
 		     pre_factors.priority_age, weight_age,
-		     job_ptr->prio_factors->priority_age);
+		     prio_factors->priority_age);
 		info("Weighted Assoc priority is %f * %u = %.2f",
 		     pre_factors.priority_assoc, weight_assoc,
-		     job_ptr->prio_factors->priority_assoc);
+		     prio_factors->priority_assoc);
 		info("Weighted Fairshare priority is %f * %u = %.2f",
 		     pre_factors.priority_fs, weight_fs,
-		     job_ptr->prio_factors->priority_fs);
+		     prio_factors->priority_fs);
 		info("Weighted JobSize priority is %f * %u = %.2f",
 		     pre_factors.priority_js, weight_js,
-		     job_ptr->prio_factors->priority_js);
+		     prio_factors->priority_js);
 		info("Weighted Partition priority is %f * %u = %.2f",
 		     pre_factors.priority_part, weight_part,
-		     job_ptr->prio_factors->priority_part);
+		     prio_factors->priority_part);
 		info("Weighted QOS priority is %f * %u = %.2f",
 		     pre_factors.priority_qos, weight_qos,
-		     job_ptr->prio_factors->priority_qos);
+		     prio_factors->priority_qos);
 		info("Site priority is %"PRId64, priority_site);
 
 		if (weight_tres && pre_tres_factors && post_tres_factors) {
@@ -721,14 +805,14 @@ static uint32_t _get_priority_internal(time_t start_time,
 		info("Job %u priority: %"PRId64" + %2.f + %.2f + %.2f + %.2f + %.2f + %.2f + %2.f - %"PRId64" = %.2f",
 		     job_ptr->job_id,
 		     priority_site,
-		     job_ptr->prio_factors->priority_age,
-		     job_ptr->prio_factors->priority_assoc,
-		     job_ptr->prio_factors->priority_fs,
-		     job_ptr->prio_factors->priority_js,
-		     job_ptr->prio_factors->priority_part,
-		     job_ptr->prio_factors->priority_qos,
+		     prio_factors->priority_age,
+		     prio_factors->priority_assoc,
+		     prio_factors->priority_fs,
+		     prio_factors->priority_js,
+		     prio_factors->priority_part,
+		     prio_factors->priority_qos,
 		     tmp_tres,
-		     (((int64_t)job_ptr->prio_factors->nice) - NICE_OFFSET),
+		     (((int64_t)prio_factors->nice) - NICE_OFFSET),
 		     priority);
 
 		xfree(pre_factors.priority_tres);
@@ -736,6 +820,32 @@ static uint32_t _get_priority_internal(time_t start_time,
 	return (uint32_t)priority;
 }
 
+/*
+ * Returns the priority after applying the weight factors, setting the
+ * priority factors and priority_array of job_ptr.
+ * NOTE: The job write lock must be held.
+ */
+static uint32_t _get_priority_internal(time_t start_time,
+				       job_record_t *job_ptr)
+{
+	if (_prio_from_factors(job_ptr)) {
+		if (!job_ptr->prio_factors)
+			job_ptr->prio_factors =
+				xmalloc(sizeof(priority_factors_object_t));
+		if (job_ptr->part_ptr_list) {
+			if (!job_ptr->priority_array)
+				job_ptr->priority_array = xcalloc(
+					list_count(job_ptr->part_ptr_list) + 1,
+					sizeof(uint32_t));
+			list_sort(job_ptr->part_ptr_list,
+				  priority_sort_part_tier);
+		}
+	}
+
+	return _calc_priority(start_time, job_ptr, job_ptr->prio_factors,
+			      job_ptr->priority_array);
+}
+
 
 /* based upon the last reset time, compute when the next reset should be */
 static time_t _next_reset(uint16_t reset_period, time_t last_reset)
@@ -1194,18 +1304,437 @@ static int _apply_new_usage(job_record_t *job_ptr, time_t start_period,
 }
 
 
-static int _decay_apply_new_usage_and_weighted_factors(job_record_t *job_ptr,
-						       time_t *start_time_ptr)
+/* Return true if the decay thread recalculates the priority of job_ptr */
+static bool _decay_needs_prio(job_record_t *job_ptr)
 {
-	/* Always return SUCCESS so that list_for_each will
-	 * continue processing list of jobs. */
+	/*
+	 * Priority 0 is reserved for held jobs. Also skip priority
+	 * re_calculation for non-pending jobs.
+	 */
+	if ((job_ptr->priority == 0) ||
+	    IS_JOB_POWER_UP_NODE(job_ptr) ||
+	    (!IS_JOB_PENDING(job_ptr) &&
+	     !(flags & PRIORITY_FLAGS_CALCULATE_RUNNING)))
+		return false;
 
-	if (!decay_apply_new_usage(job_ptr, start_time_ptr))
-		return SLURM_SUCCESS;
+	return true;
+}
 
-	decay_apply_weighted_factors(job_ptr, start_time_ptr);
+/* Set the priority of job_ptr to new_prio, return true if it changed */
+static bool _decay_set_prio(job_record_t *job_ptr, uint32_t new_prio)
+{
+	bool changed = false;
 
-	return SLURM_SUCCESS;
+	if (((flags & PRIORITY_FLAGS_INCR_ONLY) == 0) ||
+	    (job_ptr->priority < new_prio)) {
+		job_ptr->priority = new_prio;
+		job_record_changed(job_ptr);
+		changed = true;
+	}
+
+	debug2("priority for job %u is now %u",
+	       job_ptr->job_id, job_ptr->priority);
+
+	return changed;
+}
+
+/*
+ * _get_fairshare_priority() sets the effective usage of a user association
+ * the first time it is needed while holding only a read lock. Set it here
+ * for all the jobs up front so the priority factor threads only read the
+ * association tree.
+ */
+static void _decay_set_fs_usage(decay_prio_t *prios, int job_cnt)
+{
+	slurmdb_assoc_rec_t *fs_assoc;
+	assoc_mgr_lock_t locks = { WRITE_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
+				   NO_LOCK, NO_LOCK, NO_LOCK };
+	int i;
+
+	if (!calc_fairshare || !weight_fs)
+		return;
+
+	assoc_mgr_lock(&locks);
+	for (i = 0; i < job_cnt; i++) {
+		if (!(fs_assoc = prios[i].job_ptr->assoc_ptr))
+			continue;
+		if (fs_assoc->shares_raw == SLURMDB_FS_USE_PARENT)
+			fs_assoc = fs_assoc->usage->fs_assoc_ptr;
+		if (fs_assoc &&
+		    fuzzy_equal(fs_assoc->usage->usage_efctv, NO_VAL))
+			priority_p_set_assoc_usage(fs_assoc);
+	}
+	assoc_mgr_unlock(&locks);
+}
+
+static void _batch_fs_key(void *item, const char **key, uint32_t *key_len)
+{
+	prio_batch_fs_t *batch_fs = item;
+
+	*key = (const char *) &batch_fs->assoc;
+	*key_len = sizeof(batch_fs->assoc);
+}
+
+/*
+ * Return the fairshare factor of job_ptr, computing it once per association
+ * for all the jobs of a batch.
+ * NOTE: acct_mgr_assoc_lock must be locked before this is called.
+ */
+static double _batch_fairshare(xhash_t *fs_cache, job_record_t *job_ptr)
+{
+	prio_batch_fs_t *batch_fs;
+
+	if (!calc_fairshare)
+		return 0;
+
+	if (!job_ptr->assoc_ptr)
+		return _get_fairshare_priority_locked(job_ptr);
+
+	if ((batch_fs = xhash_get(fs_cache, (char *) &job_ptr->assoc_ptr,
+				  sizeof(job_ptr->assoc_ptr))))
+		return batch_fs->fs;
+
+	batch_fs = xmalloc(sizeof(prio_batch_fs_t));
+	batch_fs->assoc = job_ptr->assoc_ptr;
+	batch_fs->fs = _get_fairshare_priority_locked(job_ptr);
+	xhash_add(fs_cache, batch_fs);
+
+	return batch_fs->fs;
+}
+
+/* Weigh and sum the priority factors of the first cnt jobs of batch */
+static void _batch_weigh(prio_batch_t *batch, int cnt)
+{
+	double w_age = weight_age, w_assoc = weight_assoc, w_fs = weight_fs;
+	double w_js = weight_js, w_part = weight_part, w_qos = weight_qos;
+	int i;
+
+	for (i = 0; i < cnt; i++) {
+		batch->age[i] *= w_age;
+		batch->assoc[i] *= w_assoc;
+		batch->fs[i] *= w_fs;
+		batch->js[i] *= w_js;
+		batch->part[i] *= w_part;
+		batch->qos[i] *= w_qos;
+		batch->prio[i] = batch->age[i] + batch->assoc[i] +
+				 batch->fs[i] + batch->js[i] +
+				 batch->part[i] + batch->qos[i] +
+				 batch->tres[i] + batch->site[i] -
+				 batch->nice[i];
+	}
+}
+
+/*
+ * Compute the new priority of one job into prio as _calc_priority() does.
+ * NOTE: The job read lock must be held.
+ */
+static void _decay_calc_prio(time_t start_time, decay_prio_t *prio)
+{
+	job_record_t *job_ptr = prio->job_ptr;
+	part_record_t *part_ptr;
+	ListIterator itr;
+	int i = 0;
+
+	if (_prio_from_factors(job_ptr) && job_ptr->part_ptr_list) {
+		prio->part_cnt = list_count(job_ptr->part_ptr_list);
+		prio->part_order = xcalloc(prio->part_cnt + 1,
+					   sizeof(part_record_t *));
+		itr = list_iterator_create(job_ptr->part_ptr_list);
+		while ((part_ptr = list_next(itr)) && (i < prio->part_cnt))
+			prio->part_order[i++] = part_ptr;
+		list_iterator_destroy(itr);
+
+		prio->priority_array = xcalloc(prio->part_cnt + 1,
+					       sizeof(uint32_t));
+		/* PRIORITY_FLAGS_INCR_ONLY compares with the old values */
+		if ((flags & PRIORITY_FLAGS_INCR_ONLY) &&
+		    job_ptr->priority_array)
+			memcpy(prio->priority_array, job_ptr->priority_array,
+			       sizeof(uint32_t) * prio->part_cnt);
+	}
+	if (_prio_from_factors(job_ptr) || job_ptr->prio_factors)
+		prio->prio_factors = xmalloc(sizeof(priority_factors_object_t));
+
+	prio->new_prio = _calc_priority(start_time, job_ptr,
+					prio->prio_factors,
+					prio->priority_array);
+}
+
+/*
+ * Compute the priority of job_cnt jobs into prios as _decay_calc_prio()
+ * does. The fairshare factor is computed once per association under a
+ * single association read lock and the weighted factors are summed
+ * PRIO_BATCH_SIZE jobs at a time.
+ * Jobs in several partitions, with a priority set by an administrator or
+ * without details, and all jobs when DebugFlags=Priority is set, go
+ * through _decay_calc_prio().
+ * NOTE: The job read lock must be held and the effective usage of the jobs'
+ * associations must already be set, see _decay_set_fs_usage().
+ */
+static void _get_priority_batch(decay_prio_t *prios, int job_cnt,
+				time_t start_time)
+{
+	prio_batch_t *batch = xmalloc(sizeof(prio_batch_t));
+	priority_factors_object_t *prio_factors;
+	job_record_t *job_ptr;
+	xhash_t *fs_cache = xhash_init(_batch_fs_key, NULL);
+	assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
+				   NO_LOCK, NO_LOCK, NO_LOCK };
+	uint64_t tmp_64;
+	double fs;
+	int base, cnt, i;
+
+	for (base = 0; base < job_cnt; base += PRIO_BATCH_SIZE) {
+		cnt = MIN(PRIO_BATCH_SIZE, job_cnt - base);
+
+		assoc_mgr_lock(&locks);
+		for (i = 0; i < cnt; i++) {
+			job_ptr = prios[base + i].job_ptr;
+			batch->scalar[i] = priority_debug ||
+				!_prio_from_factors(job_ptr) ||
+				job_ptr->part_ptr_list;
+			if (batch->scalar[i]) {
+				batch->age[i] = batch->assoc[i] = 0.0;
+				batch->fs[i] = batch->js[i] = 0.0;
+				batch->part[i] = batch->qos[i] = 0.0;
+				batch->tres[i] = 0.0;
+				batch->site[i] = batch->nice[i] = 0.0;
+				continue;
+			}
+
+			fs = 0.0;
+			if (job_ptr->assoc_ptr && weight_fs)
+				fs = _batch_fairshare(fs_cache, job_ptr);
+			prio_factors = xmalloc(
+				sizeof(priority_factors_object_t));
+			prios[base + i].prio_factors = prio_factors;
+			_set_priority_factors(start_time, job_ptr,
+					      prio_factors, &fs);
+
+			batch->age[i] = prio_factors->priority_age;
+			batch->assoc[i] = prio_factors->priority_assoc;
+			batch->fs[i] = prio_factors->priority_fs;
+			batch->js[i] = prio_factors->priority_js;
+			batch->part[i] = prio_factors->priority_part;
+			batch->qos[i] = prio_factors->priority_qos;
+			batch->tres[i] = 0.0;
+			if (weight_tres && prio_factors->priority_tres)
+				batch->tres[i] = _get_tres_prio_weighted(
+					prio_factors->priority_tres);
+			batch->site[i] =
+				(double)(((int64_t)prio_factors->priority_site)
+					 - NICE_OFFSET);
+			batch->nice[i] =
+				(double)(((int64_t)prio_factors->nice)
+					 - NICE_OFFSET);
+		}
+		assoc_mgr_unlock(&locks);
+
+		_batch_weigh(batch, cnt);
+
+		for (i = 0; i < cnt; i++) {
+			job_ptr = prios[base + i].job_ptr;
+			if (batch->scalar[i]) {
+				_decay_calc_prio(start_time, &prios[base + i]);
+				continue;
+			}
+
+			prio_factors = prios[base + i].prio_factors;
+			prio_factors->priority_age = batch->age[i];
+			prio_factors->priority_assoc = batch->assoc[i];
+			prio_factors->priority_fs = batch->fs[i];
+			prio_factors->priority_js = batch->js[i];
+			prio_factors->priority_part = batch->part[i];
+			prio_factors->priority_qos = batch->qos[i];
+
+			/* Priority 0 is reserved for held jobs */
+			if (batch->prio[i] < 1)
+				batch->prio[i] = 1;
+
+			tmp_64 = (uint64_t) batch->prio[i];
+			if (tmp_64 > 0xffffffff) {
+				error("Job %u priority exceeds 32 bits",
+				      job_ptr->job_id);
+				tmp_64 = 0xffffffff;
+			}
+			prios[base + i].new_prio = (uint32_t) tmp_64;
+		}
+	}
+
+	xhash_free(fs_cache);
+	xfree(batch);
+}
+
+/*
+ * Compute the priority of a slice of the jobs. Each thread only writes to
+ * its own entries of prios, nothing in the jobs is changed.
+ */
+static void *_decay_factors_thread(void *arg)
+{
+	decay_factors_args_t *args = arg;
+
+	_get_priority_batch(args->prios, args->job_cnt, args->start_time);
+
+	return NULL;
+}
+
+/*
+ * Set the priority, priority factors and priority_array computed in prio
+ * for its job, if the job still exists and still needs a new priority.
+ * NOTE: The job write lock must be held.
+ * RET true if the job priority changed
+ */
+static bool _decay_publish(time_t start_time, decay_prio_t *prio)
+{
+	job_record_t *job_ptr = find_job_record(prio->job_id);
+	part_record_t *part_ptr;
+	ListIterator itr;
+	bool same_order = true;
+	int i = 0;
+
+	if ((job_ptr != prio->job_ptr) || !_decay_needs_prio(job_ptr))
+		return false;
+
+	if (prio->priority_array) {
+		/*
+		 * The priority_array follows the partitions sorted by tier.
+		 * If that order or the partitions changed since the priority
+		 * was computed start over with this job.
+		 */
+		list_sort(job_ptr->part_ptr_list, priority_sort_part_tier);
+		if (list_count(job_ptr->part_ptr_list) != prio->part_cnt)
+			same_order = false;
+		itr = list_iterator_create(job_ptr->part_ptr_list);
+		while (same_order && (part_ptr = list_next(itr))) {
+			if (part_ptr != prio->part_order[i++])
+				same_order = false;
+		}
+		list_iterator_destroy(itr);
+		if (!same_order)
+			return _decay_set_prio(job_ptr, _get_priority_internal(
+						       start_time, job_ptr));
+
+		xfree(job_ptr->priority_array);
+		job_ptr->priority_array = prio->priority_array;
+		prio->priority_array = NULL;
+	}
+
+	if (prio->prio_factors) {
+		if (job_ptr->prio_factors)
+			slurm_destroy_priority_factors_object(
+				job_ptr->prio_factors);
+		job_ptr->prio_factors = prio->prio_factors;
+		prio->prio_factors = NULL;
+	}
+
+	return _decay_set_prio(job_ptr, prio->new_prio);
+}
+
+/*
+ * Apply the new usage of the jobs in job_list. With set_prio also
+ * recalculate their priority one job at a time.
+ * NOTE: The job write lock must be held.
+ * RET number of jobs whose priority was recalculated
+ */
+static int _decay_apply_usage(List job_list, time_t *start_time_ptr,
+			      bool set_prio)
+{
+	job_record_t *job_ptr;
+	ListIterator itr;
+	int job_cnt = 0;
+
+	itr = list_iterator_create(job_list);
+	while ((job_ptr = list_next(itr))) {
+		if (!decay_apply_new_usage(job_ptr, start_time_ptr) ||
+		    !set_prio || !_decay_needs_prio(job_ptr))
+			continue;
+		decay_apply_weighted_factors(job_ptr, start_time_ptr);
+		job_cnt++;
+	}
+	list_iterator_destroy(itr);
+
+	return job_cnt;
+}
+
+/*
+ * Recalculate the priority of the jobs in job_list needing one.
+ * The jobs and their factors are read under the job read lock, split in
+ * slices over up to decay_threads threads. Each thread computes the
+ * priority, priority factors and priority_array of its jobs into private
+ * copies. These are then set in the jobs one after the other under the job
+ * write lock, so readers of the jobs never see them half written.
+ * NOTE: No slurmctld locks may be held.
+ * RET number of jobs whose priority was recalculated
+ */
+extern int decay_apply_jobs(List job_list, time_t start_time)
+{
+	slurmctld_lock_t job_read_lock =
+		{ NO_LOCK, READ_LOCK, READ_LOCK, READ_LOCK, NO_LOCK };
+	slurmctld_lock_t job_write_lock =
+		{ NO_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK, NO_LOCK };
+	decay_factors_args_t *args;
+	decay_prio_t *prios;
+	job_record_t *job_ptr;
+	ListIterator itr;
+	pthread_t *threads;
+	bool changed = false;
+	int i, job_cnt = 0, slice, thread_cnt;
+
+	lock_slurmctld(job_read_lock);
+	prios = xcalloc(list_count(job_list) + 1, sizeof(decay_prio_t));
+	itr = list_iterator_create(job_list);
+	while ((job_ptr = list_next(itr))) {
+		if (!_decay_needs_prio(job_ptr))
+			continue;
+		prios[job_cnt].job_ptr = job_ptr;
+		prios[job_cnt].job_id = job_ptr->job_id;
+		job_cnt++;
+	}
+	list_iterator_destroy(itr);
+
+	_decay_set_fs_usage(prios, job_cnt);
+
+	thread_cnt = MIN(decay_threads, ((job_cnt + DECAY_JOBS_PER_THREAD - 1) /
+					 DECAY_JOBS_PER_THREAD));
+	if (thread_cnt <= 1) {
+		_get_priority_batch(prios, job_cnt, start_time);
+	} else {
+		args = xcalloc(thread_cnt, sizeof(decay_factors_args_t));
+		threads = xcalloc(thread_cnt, sizeof(pthread_t));
+		slice = (job_cnt + thread_cnt - 1) / thread_cnt;
+		for (i = 0; i < thread_cnt; i++) {
+			args[i].prios = prios + (i * slice);
+			args[i].job_cnt = MIN(slice, job_cnt - (i * slice));
+			args[i].start_time = start_time;
+			slurm_thread_create(&threads[i], _decay_factors_thread,
+					    &args[i]);
+		}
+		for (i = 0; i < thread_cnt; i++)
+			pthread_join(threads[i], NULL);
+		xfree(threads);
+		xfree(args);
+	}
+	unlock_slurmctld(job_read_lock);
+
+	lock_slurmctld(job_write_lock);
+	for (i = 0; i < job_cnt; i++) {
+		if (_decay_publish(start_time, &prios[i]))
+			changed = true;
+	}
+	if (changed)
+		last_job_update = time(NULL);
+	unlock_slurmctld(job_write_lock);
+
+	for (i = 0; i < job_cnt; i++) {
+		if (prios[i].prio_factors)
+			slurm_destroy_priority_factors_object(
+				prios[i].prio_factors);
+		xfree(prios[i].priority_array);
+		xfree(prios[i].part_order);
+	}
+	xfree(prios);
+
+	return job_cnt;
 }
 
 
@@ -1221,6 +1750,8 @@ static void *_decay_thread(void *no_data)
 	double run_delta = 0.0, real_decay = 0.0;
 	struct timeval tvnow;
 	struct timespec abs;
+	int job_cnt;
+	DEF_TIMERS;
 
 	/* Write lock on jobs, read lock on nodes and partitions */
 	slurmctld_lock_t job_write_lock =
@@ -1291,6 +1822,8 @@ static void *_decay_thread(void *no_data)
 
 		slurm_mutex_lock(&decay_lock);
 		running_decay = 1;
+		job_cnt = 0;
+		START_TIMER;
 
 		/* If reconfig is called handle all that happens
 		   outside of the loop here */
@@ -1382,19 +1915,32 @@ static void *_decay_thread(void *no_data)
 		 */
 		site_factor_g_update();
 
-		if (!(flags & PRIORITY_FLAGS_FAIR_TREE)) {
-			list_for_each(
-				job_list,
-				(ListForF) _decay_apply_new_usage_and_weighted_factors,
-				&start_time
-				);
-		}
+		if (!(flags & PRIORITY_FLAGS_FAIR_TREE))
+			job_cnt = _decay_apply_usage(job_list, &start_time,
+						     (decay_threads <= 1));
 
 		unlock_slurmctld(job_write_lock);
 
+		if (!(flags & PRIORITY_FLAGS_FAIR_TREE) && (decay_threads > 1))
+			job_cnt = decay_apply_jobs(job_list, start_time);
+
 	get_usage:
 		if (flags & PRIORITY_FLAGS_FAIR_TREE)
-			fair_tree_decay(job_list, start_time);
+			job_cnt = fair_tree_decay(job_list, start_time);
+
+		END_TIMER;
+		slurmctld_diag_stats.decay_cycle_counter++;
+		slurmctld_diag_stats.decay_cycle_last = DELTA_TIMER;
+		slurmctld_diag_stats.decay_cycle_sum += DELTA_TIMER;
+		if (slurmctld_diag_stats.decay_cycle_last >
+		    slurmctld_diag_stats.decay_cycle_max)
+			slurmctld_diag_stats.decay_cycle_max =
+				slurmctld_diag_stats.decay_cycle_last;
+		slurmctld_diag_stats.decay_jobs_last = job_cnt;
+		slurmctld_diag_stats.decay_threads = decay_threads;
+		slurmctld_diag_stats.decay_when_last_cycle = time(NULL);
+		debug2("%s: recalculated the priority of %d jobs %s",
+		       __func__, job_cnt, TIME_STR);
 
 		g_last_ran = start_time;
 
@@ -1413,52 +1959,66 @@ static void *_decay_thread(void *no_data)
 	return NULL;
 }
 
-/* If the specified job record satisfies the filter specifications in req_msg
+static int _cmp_uint32(const void *x, const void *y)
+{
+	uint32_t a = *(uint32_t *) x, b = *(uint32_t *) y;
+
+	if (a < b)
+		return -1;
+	return (a > b) ? 1 : 0;
+}
+
+/*
+ * Copy the IDs of a request filter list into a sorted array
+ * RET the array, to be xfreed, or NULL if there is no filter
+ */
+static uint32_t *_id_filter_create(List id_list, int *id_cnt)
+{
+	uint32_t *ids, *id;
+	ListIterator itr;
+
+	*id_cnt = 0;
+	if (!id_list)
+		return NULL;
+
+	ids = xcalloc(list_count(id_list) + 1, sizeof(uint32_t));
+	itr = list_iterator_create(id_list);
+	while ((id = list_next(itr)))
+		ids[(*id_cnt)++] = *id;
+	list_iterator_destroy(itr);
+	qsort(ids, *id_cnt, sizeof(uint32_t), _cmp_uint32);
+
+	return ids;
+}
+
+static bool _id_filter_match(uint32_t *ids, int id_cnt, uint32_t id)
+{
+	if (!ids)
+		return true;
+
+	return bsearch(&id, ids, id_cnt, sizeof(uint32_t), _cmp_uint32);
+}
+
+/* If the specified job record satisfies the filter specifications in filter
  * and part_ptr_list (partition name filters), then add its priority specs
  * to ret_list */
-static void _filter_job(job_record_t *job_ptr,
-			priority_factors_request_msg_t *req_msg,
+static void _filter_job(job_record_t *job_ptr, prio_id_filter_t *id_filter,
 			List part_ptr_list, List ret_list)
 {
 	priority_factors_object_t *obj = NULL;
 	part_record_t *job_part_ptr = NULL, *filter_part_ptr = NULL;
-	List req_job_list, req_user_list;
 	int filter = 0, inx;
-	ListIterator iterator, job_iter, filter_iter;
-	uint32_t *job_id;
-	uint32_t *user_id;
+	ListIterator job_iter, filter_iter;
 
 	/* Filter by job ID */
-	req_job_list = req_msg->job_id_list;
-	if (req_job_list) {
-		filter = 1;
-		iterator = list_iterator_create(req_job_list);
-		while ((job_id = list_next(iterator))) {
-			if (*job_id == job_ptr->job_id) {
-				filter = 0;
-				break;
-			}
-		}
-		list_iterator_destroy(iterator);
-		if (filter == 1)
-			return;
-	}
+	if (!_id_filter_match(id_filter->job_ids, id_filter->job_id_cnt,
+			      job_ptr->job_id))
+		return;
 
 	/* Filter by user/UID */
-	req_user_list = req_msg->uid_list;
-	if (req_user_list) {
-		filter = 1;
-		iterator = list_iterator_create(req_user_list);
-		while ((user_id = list_next(iterator))) {
-			if (*user_id == job_ptr->user_id) {
-				filter = 0;
-				break;
-			}
-		}
-		list_iterator_destroy(iterator);
-		if (filter == 1)
-			return;
-	}
+	if (!_id_filter_match(id_filter->user_ids, id_filter->user_id_cnt,
+			      job_ptr->user_id))
+		return;
 
 	/*
 	 * Job is not in any partition, so there is nothing to return.
@@ -1546,7 +2106,7 @@ static void _filter_job(job_record_t *job_ptr,
 
 static void _internal_setup(void)
 {
-	char *tres_weights_str;
+	char *tres_weights_str, *prio_params, *tmp_ptr;
 	if (slurm_get_debug_flags() & DEBUG_FLAG_PRIO)
 		priority_debug = 1;
 	else
@@ -1571,6 +2131,18 @@ static void _internal_setup(void)
 	xfree(tres_weights_str);
 	flags = slurm_get_priority_flags();
 
+	decay_threads = 1;
+	prio_params = slurm_get_priority_params();
+	if ((tmp_ptr = xstrcasestr(prio_params, "decay_threads="))) {
+		int i = atoi(tmp_ptr + 14);
+		if ((i < 1) || (i > MAX_DECAY_THREADS)) {
+			error("Invalid PriorityParameters decay_threads=%d, must be between 1 and %d",
+			      i, MAX_DECAY_THREADS);
+		} else
+			decay_threads = i;
+	}
+	xfree(prio_params);
+
 	if (priority_debug) {
 		info("priority: Damp Factor is %u", damp_factor);
 		info("priority: AccountingStorageEnforce is %u", enforce);
@@ -1582,6 +2154,7 @@ static void _internal_setup(void)
 		info("priority: Weight Part is %u", weight_part);
 		info("priority: Weight QOS is %u", weight_qos);
 		info("priority: Flags is %u", flags);
+		info("priority: Decay threads is %d", decay_threads);
 	}
 }
 
@@ -1772,10 +2345,7 @@ int init ( void )
 
 		/* Initialize job priority factors for valid sprio output */
 		lock_slurmctld(job_write_lock);
-		list_for_each(
-			job_list,
-			(ListForF) _decay_apply_new_usage_and_weighted_factors,
-			&start_time);
+		(void) _decay_apply_usage(job_list, &start_time, true);
 		unlock_slurmctld(job_write_lock);
 	} else if (assoc_mgr_root_assoc) {
 		if (!cluster_cpus)
@@ -1956,14 +2526,28 @@ extern List priority_p_get_priority_factors_list(
 	ListIterator itr;
 	job_record_t *job_ptr = NULL;
 	part_record_t *part_ptr;
+	prio_id_filter_t id_filter;
 	time_t start_time = time(NULL);
 	char *part_str, *tok, *last = NULL;
+	bool private_jobs = false;
+	int mcs_private = 0;
 	/* Read lock on jobs, nodes, and partitions */
 	slurmctld_lock_t job_read_lock =
 		{ NO_LOCK, READ_LOCK, READ_LOCK, READ_LOCK, NO_LOCK };
 
 	xassert(req_msg);
 
+	/* These do not depend on the job, so only check them once */
+	id_filter.job_ids = _id_filter_create(req_msg->job_id_list,
+					      &id_filter.job_id_cnt);
+	id_filter.user_ids = _id_filter_create(req_msg->uid_list,
+					       &id_filter.user_id_cnt);
+	if ((slurmctld_conf.private_data & PRIVATE_DATA_JOBS) &&
+	    !validate_operator(uid)) {
+		private_jobs = true;
+		mcs_private = slurm_mcs_get_privatedata();
+	}
+
 	lock_slurmctld(job_read_lock);
 	if (req_msg->partitions) {
 		part_filter_list = list_create(NULL);
@@ -2008,18 +2592,16 @@ extern List priority_p_get_priority_factors_list(
 			if (job_ptr->priority == 0)
 				continue;
 
-			if ((slurmctld_conf.private_data & PRIVATE_DATA_JOBS) &&
-			    (job_ptr->user_id != uid) &&
-			    !validate_operator(uid) &&
-			    (((slurm_mcs_get_privatedata() == 0) &&
+			if (private_jobs && (job_ptr->user_id != uid) &&
+			    (((mcs_private == 0) &&
 			      !assoc_mgr_is_user_acct_coord(acct_db_conn, uid,
 							    job_ptr->account))||
-			     ((slurm_mcs_get_privatedata() == 1) &&
+			     ((mcs_private == 1) &&
 			      (mcs_g_check_mcs_label(uid, job_ptr->mcs_label)
 			       != 0))))
 				continue;
 
-			_filter_job(job_ptr, req_msg, part_filter_list,
+			_filter_job(job_ptr, &id_filter, part_filter_list,
 				    ret_list);
 		}
 		list_iterator_destroy(itr);
@@ -2028,6 +2610,8 @@ extern List priority_p_get_priority_factors_list(
 	}
 	unlock_slurmctld(job_read_lock);
 	FREE_NULL_LIST(part_filter_list);
+	xfree(id_filter.job_ids);
+	xfree(id_filter.user_ids);
 
 	return ret_list;
 }
@@ -2070,45 +2654,42 @@ extern int decay_apply_weighted_factors(job_record_t *job_ptr,
 	/* Always return SUCCESS so that list_for_each will
 	 * continue processing list of jobs. */
 
-	/*
-	 * Priority 0 is reserved for held jobs. Also skip priority
-	 * re_calculation for non-pending jobs.
-	 */
-	if ((job_ptr->priority == 0) ||
-	    IS_JOB_POWER_UP_NODE(job_ptr) ||
-	    (!IS_JOB_PENDING(job_ptr) &&
-	     !(flags & PRIORITY_FLAGS_CALCULATE_RUNNING)))
+	if (!_decay_needs_prio(job_ptr))
 		return SLURM_SUCCESS;
 
 	new_prio = _get_priority_internal(*start_time_ptr, job_ptr);
-	if (((flags & PRIORITY_FLAGS_INCR_ONLY) == 0) ||
-	    (job_ptr->priority < new_prio)) {
-		job_ptr->priority = new_prio;
+	if (_decay_set_prio(job_ptr, new_prio))
 		last_job_update = time(NULL);
-	}
-
-	debug2("priority for job %u is now %u",
-	       job_ptr->job_id, job_ptr->priority);
 
 	return SLURM_SUCCESS;
 }
 
 
 extern void set_priority_factors(time_t start_time, job_record_t *job_ptr)
+{
+	if (!job_ptr->prio_factors)
+		job_ptr->prio_factors =
+			xmalloc(sizeof(priority_factors_object_t));
+	_set_priority_factors(start_time, job_ptr, job_ptr->prio_factors,
+			      NULL);
+}
+
+/*
+ * Set the unweighted priority factors of job_ptr in prio_factors.
+ * IN fs_ptr - fairshare factor of the job if already known, else NULL
+ */
+static void _set_priority_factors(time_t start_time, job_record_t *job_ptr,
+				  priority_factors_object_t *prio_factors,
+				  double *fs_ptr)
 {
 	slurmdb_qos_rec_t *qos_ptr = NULL;
 
 	xassert(job_ptr);
+	xassert(prio_factors);
 
-	if (!job_ptr->prio_factors) {
-		job_ptr->prio_factors =
-			xmalloc(sizeof(priority_factors_object_t));
-	} else {
-		xfree(job_ptr->prio_factors->tres_weights);
-		xfree(job_ptr->prio_factors->priority_tres);
-		memset(job_ptr->prio_factors, 0,
-		       sizeof(priority_factors_object_t));
-	}
+	xfree(prio_factors->tres_weights);
+	xfree(prio_factors->priority_tres);
+	memset(prio_factors, 0, sizeof(priority_factors_object_t));
 
 	qos_ptr = job_ptr->qos_ptr;
 
@@ -2123,14 +2704,14 @@ extern void set_priority_factors(time_t start_time, job_record_t *job_ptr)
 			diff = start_time - job_ptr->details->accrue_time;
 
 		if (diff < max_age)
-			job_ptr->prio_factors->priority_age =
+			prio_factors->priority_age =
 				(double)diff / (double)max_age;
 		else
-			job_ptr->prio_factors->priority_age = 1.0;
+			prio_factors->priority_age = 1.0;
 	}
 
 	if (job_ptr->assoc_ptr && weight_fs) {
-		job_ptr->prio_factors->priority_fs =
+		prio_factors->priority_fs = fs_ptr ? *fs_ptr :
 			_get_fairshare_priority(job_ptr);
 	}
 
@@ -2154,12 +2735,12 @@ extern void set_priority_factors(time_t start_time, job_record_t *job_ptr)
 		if (flags & PRIORITY_FLAGS_SIZE_RELATIVE) {
 			uint32_t time_limit = 1;
 			/* Job size in CPUs (based upon average CPUs/Node */
-			job_ptr->prio_factors->priority_js =
+			prio_factors->priority_js =
 				(double)min_nodes *
 				(double)cluster_cpus /
 				(double)node_record_count;
-			if (cpu_cnt > job_ptr->prio_factors->priority_js) {
-				job_ptr->prio_factors->priority_js =
+			if (cpu_cnt > prio_factors->priority_js) {
+				prio_factors->priority_js =
 					(double)cpu_cnt;
 			}
 			/* Divide by job time limit */
@@ -2167,80 +2748,80 @@ extern void set_priority_factors(time_t start_time, job_record_t *job_ptr)
 				time_limit = job_ptr->time_limit;
 			else if (job_ptr->part_ptr)
 				time_limit = job_ptr->part_ptr->max_time;
-			job_ptr->prio_factors->priority_js /= time_limit;
+			prio_factors->priority_js /= time_limit;
 			/* Normalize to max value of 1.0 */
-			job_ptr->prio_factors->priority_js /= cluster_cpus;
+			prio_factors->priority_js /= cluster_cpus;
 			if (favor_small) {
-				job_ptr->prio_factors->priority_js =
+				prio_factors->priority_js =
 					(double) 1.0 -
-					job_ptr->prio_factors->priority_js;
+					prio_factors->priority_js;
 			}
 		} else if (favor_small) {
-			job_ptr->prio_factors->priority_js =
+			prio_factors->priority_js =
 				(double)(node_record_count - min_nodes)
 				/ (double)node_record_count;
 			if (cpu_cnt) {
-				job_ptr->prio_factors->priority_js +=
+				prio_factors->priority_js +=
 					(double)(cluster_cpus - cpu_cnt)
 					/ (double)cluster_cpus;
-				job_ptr->prio_factors->priority_js /= 2;
+				prio_factors->priority_js /= 2;
 			}
 		} else {	/* favor large */
-			job_ptr->prio_factors->priority_js =
+			prio_factors->priority_js =
 				(double)min_nodes / (double)node_record_count;
 			if (cpu_cnt) {
-				job_ptr->prio_factors->priority_js +=
+				prio_factors->priority_js +=
 					(double)cpu_cnt / (double)cluster_cpus;
-				job_ptr->prio_factors->priority_js /= 2;
+				prio_factors->priority_js /= 2;
 			}
 		}
-		if (job_ptr->prio_factors->priority_js < .0)
-			job_ptr->prio_factors->priority_js = 0.0;
-		else if (job_ptr->prio_factors->priority_js > 1.0)
-			job_ptr->prio_factors->priority_js = 1.0;
+		if (prio_factors->priority_js < .0)
+			prio_factors->priority_js = 0.0;
+		else if (prio_factors->priority_js > 1.0)
+			prio_factors->priority_js = 1.0;
 	}
 
 	if (job_ptr->part_ptr && job_ptr->part_ptr->priority_job_factor &&
 	    weight_part) {
-		job_ptr->prio_factors->priority_part =
+		prio_factors->priority_part =
 			(flags & PRIORITY_FLAGS_NO_NORMAL_PART) ?
 			job_ptr->part_ptr->priority_job_factor :
 			job_ptr->part_ptr->norm_priority;
 	}
 
-	job_ptr->prio_factors->priority_site = job_ptr->site_factor;
+	prio_factors->priority_site = job_ptr->site_factor;
 
 	if (job_ptr->assoc_ptr && weight_assoc)
-		job_ptr->prio_factors->priority_assoc =
+		prio_factors->priority_assoc =
 			(flags & PRIORITY_FLAGS_NO_NORMAL_ASSOC) ?
 			job_ptr->assoc_ptr->priority :
 			job_ptr->assoc_ptr->usage->priority_norm;
 
 	if (qos_ptr && qos_ptr->priority && weight_qos) {
-		job_ptr->prio_factors->priority_qos =
+		prio_factors->priority_qos =
 			(flags & PRIORITY_FLAGS_NO_NORMAL_QOS) ?
 			qos_ptr->priority :
 			qos_ptr->usage->norm_priority;
 	}
 
 	if (job_ptr->details)
-		job_ptr->prio_factors->nice = job_ptr->details->nice;
+		prio_factors->nice = job_ptr->details->nice;
 	else
-		job_ptr->prio_factors->nice = NICE_OFFSET;
+		prio_factors->nice = NICE_OFFSET;
 
 	if (weight_tres) {
-		if (!job_ptr->prio_factors->priority_tres) {
-			job_ptr->prio_factors->priority_tres =
+		if (!prio_factors->priority_tres) {
+			prio_factors->priority_tres =
 				xcalloc(slurmctld_tres_cnt, sizeof(double));
-			job_ptr->prio_factors->tres_weights =
+			prio_factors->tres_weights =
 				xcalloc(slurmctld_tres_cnt, sizeof(double));
-			memcpy(job_ptr->prio_factors->tres_weights, weight_tres,
+			memcpy(prio_factors->tres_weights, weight_tres,
 			       sizeof(double) * slurmctld_tres_cnt);
-			job_ptr->prio_factors->tres_cnt = slurmctld_tres_cnt;
+			prio_factors->tres_cnt = slurmctld_tres_cnt;
 		}
 
 		_get_tres_factors(job_ptr, job_ptr->part_ptr,
-				  job_ptr->prio_factors->priority_tres);
+				  prio_factors->priority_tres);
 	}
 }
 
@@ -145,6 +145,25 @@ typedef struct node_space_handler {
 	int *node_space_recs;
 } node_space_handler_t;
 
+/*
+ * Running job reservation kept between backfill cycles when bf_incremental
+ * is configured. Only jobs which would be handled by _bf_reserve_running()
+ * are recorded.
+ */
+typedef struct bf_running_rec {
+	uint32_t cycle;		/* last backfill cycle the job was seen */
+	time_t end_time;	/* rounded down to backfill_resolution */
+	uint32_t job_id;
+	bitstr_t *node_bitmap;
+	uint32_t node_cnt;
+	time_t start_time;
+} bf_running_rec_t;
+
+typedef struct bf_node_busy {
+	int node_inx;
+	time_t busy_until;
+} bf_node_busy_t;
+
 typedef struct bb_space_map
 {
 	time_t begin_time;
@@ -256,6 +275,12 @@ static int yield_interval = YIELD_INTERVAL;
 static int yield_sleep   = YIELD_SLEEP;
 static List het_job_list = NULL;
 static xhash_t *user_usage_map = NULL; /* look up user usage when no assoc */
+static bool bf_incremental = false;
+static xhash_t *running_job_map = NULL;	/* bf_running_rec_t by job_id */
+static time_t *node_busy_until = NULL;	/* end of last running job on node */
+static uint32_t *node_busy_cnt = NULL;	/* running jobs on node */
+static int running_map_node_cnt = 0;
+static uint32_t running_map_cycle = 0;
 
 /*********************** local functions *********************/
 static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
@@ -285,6 +310,10 @@ static bool _job_part_valid(job_record_t *job_ptr, part_record_t *part_ptr);
 static void _load_config(void);
 static bool _many_pending_rpcs(void);
 static bool _more_work(time_t last_backfill_time);
+static void _running_map_clear(void);
+static int  _running_map_node_space(node_space_map_t *node_space,
+				    int *node_space_recs, time_t now);
+static void _running_map_update(void);
 static uint32_t _my_sleep(int64_t usec);
 static int  _num_feature_count(job_record_t *job_ptr, bool *has_xand,
 			       bool *has_xor);
@@ -1019,6 +1048,17 @@ static void _load_config(void)
 	else
 		bf_running_job_reserve = false;
 
+	if (xstrcasestr(sched_params, "bf_incremental"))
+		bf_incremental = true;
+	else
+		bf_incremental = false;
+	if (bf_incremental && !bf_running_job_reserve) {
+		info("bf_incremental has no effect without bf_running_job_reserve");
+		bf_incremental = false;
+	}
+	/* Node indexes and time resolution may have changed */
+	_running_map_clear();
+
 	if ((tmp_ptr = xstrcasestr(sched_params, "max_rpc_cnt=")))
 		max_rpc_cnt = atoi(tmp_ptr + 12);
 	else if ((tmp_ptr = xstrcasestr(sched_params, "max_rpc_count=")))
@@ -1145,6 +1185,7 @@ extern void *backfill_agent(void *args)
 	}
 	FREE_NULL_LIST(het_job_list);
 	xhash_free(user_usage_map); /* May have been init'ed if used */
+	_running_map_clear();
 
 	return NULL;
 }
@@ -1446,6 +1487,312 @@ static int _bf_reserve_running(void *x, void *arg)
 	return SLURM_SUCCESS;
 }
 
+/* Fetch key from running_job_map item. Called from function ptr */
+static void _running_rec_key_id(void *item, const char **key,
+				uint32_t *key_len)
+{
+	bf_running_rec_t *rec = (bf_running_rec_t *) item;
+
+	xassert(rec);
+
+	*key = (char *) &rec->job_id;
+	*key_len = sizeof(uint32_t);
+}
+
+/* Free item from running_job_map. Called from function ptr */
+static void _running_rec_free(void *item)
+{
+	bf_running_rec_t *rec = (bf_running_rec_t *) item;
+
+	if (!rec)
+		return;
+
+	FREE_NULL_BITMAP(rec->node_bitmap);
+	xfree(rec);
+}
+
+/* Purge all running job reservations kept between backfill cycles */
+static void _running_map_clear(void)
+{
+	xhash_free(running_job_map);
+	xfree(node_busy_until);
+	xfree(node_busy_cnt);
+	running_map_node_cnt = 0;
+}
+
+/* Mark a job's nodes as busy until the job's expected end time */
+static void _running_rec_add(bf_running_rec_t *rec)
+{
+	int i, i_first, i_last;
+
+	i_first = bit_ffs(rec->node_bitmap);
+	if (i_first < 0)
+		return;
+	i_last = bit_fls(rec->node_bitmap);
+	for (i = i_first; i <= i_last; i++) {
+		if (!bit_test(rec->node_bitmap, i))
+			continue;
+		node_busy_cnt[i]++;
+		if (node_busy_until[i] < rec->end_time)
+			node_busy_until[i] = rec->end_time;
+	}
+}
+
+/*
+ * Release a job's nodes. Nodes still used by other jobs which might have
+ * determined the busy time are flagged in dirty_bitmap for recalculation.
+ */
+static void _running_rec_remove(bf_running_rec_t *rec, bitstr_t *dirty_bitmap)
+{
+	int i, i_first, i_last;
+
+	i_first = bit_ffs(rec->node_bitmap);
+	if (i_first < 0)
+		return;
+	i_last = bit_fls(rec->node_bitmap);
+	for (i = i_first; i <= i_last; i++) {
+		if (!bit_test(rec->node_bitmap, i))
+			continue;
+		if (node_busy_cnt[i] > 0)
+			node_busy_cnt[i]--;
+		if (node_busy_cnt[i] == 0)
+			node_busy_until[i] = 0;
+		else if (node_busy_until[i] <= rec->end_time)
+			bit_set(dirty_bitmap, i);
+	}
+}
+
+static bool _running_job_reserve_test(job_record_t *job_ptr)
+{
+	if (!IS_JOB_RUNNING(job_ptr))
+		return false;
+	if (!job_ptr->node_bitmap)
+		return false;
+	if (!job_ptr->job_resrcs || !(job_ptr->job_resrcs->whole_node ==
+				      WHOLE_NODE_REQUIRED))
+		return false;
+	if (slurm_job_preempt_mode(job_ptr) != PREEMPT_MODE_OFF)
+		return false;
+	return true;
+}
+
+typedef struct {
+	bitstr_t *dirty_bitmap;
+	uint32_t add_cnt;
+	uint32_t del_cnt;
+	List stale_list;
+} running_map_args_t;
+
+/* Record changes in a running job's reservation since the last cycle */
+static int _running_map_update_job(void *x, void *arg)
+{
+	job_record_t *job_ptr = (job_record_t *) x;
+	running_map_args_t *args = (running_map_args_t *) arg;
+	bf_running_rec_t *rec;
+	time_t end_time;
+
+	if (!_running_job_reserve_test(job_ptr))
+		return SLURM_SUCCESS;
+
+	end_time = (job_ptr->end_time / backfill_resolution) *
+		   backfill_resolution;
+	rec = xhash_get(running_job_map, (char *) &job_ptr->job_id,
+			sizeof(uint32_t));
+	if (rec && (rec->end_time == end_time) &&
+	    (rec->start_time == job_ptr->start_time) &&
+	    (rec->node_cnt == job_ptr->node_cnt)) {
+		rec->cycle = running_map_cycle;
+		return SLURM_SUCCESS;
+	}
+
+	if (rec) {
+		/* Time limit or allocation changed, replace the record */
+		_running_rec_remove(rec, args->dirty_bitmap);
+		FREE_NULL_BITMAP(rec->node_bitmap);
+		args->del_cnt++;
+	} else {
+		rec = xmalloc(sizeof(bf_running_rec_t));
+		rec->job_id = job_ptr->job_id;
+		xhash_add(running_job_map, rec);
+	}
+	rec->cycle = running_map_cycle;
+	rec->end_time = end_time;
+	rec->node_bitmap = bit_copy(job_ptr->node_bitmap);
+	rec->node_cnt = job_ptr->node_cnt;
+	rec->start_time = job_ptr->start_time;
+	_running_rec_add(rec);
+	args->add_cnt++;
+
+	return SLURM_SUCCESS;
+}
+
+/* Collect records of jobs which are no longer running */
+static void _running_map_find_stale(void *item, void *arg)
+{
+	bf_running_rec_t *rec = (bf_running_rec_t *) item;
+	running_map_args_t *args = (running_map_args_t *) arg;
+
+	if (rec->cycle != running_map_cycle)
+		list_append(args->stale_list, rec);
+}
+
+/* Recalculate busy time of nodes shared by more than one running job */
+static void _running_map_refresh_dirty(void *item, void *arg)
+{
+	bf_running_rec_t *rec = (bf_running_rec_t *) item;
+	bitstr_t *dirty_bitmap = (bitstr_t *) arg;
+	int i, i_first, i_last;
+
+	if (!bit_overlap_any(rec->node_bitmap, dirty_bitmap))
+		return;
+	i_first = bit_ffs(rec->node_bitmap);
+	i_last = bit_fls(rec->node_bitmap);
+	for (i = i_first; i <= i_last; i++) {
+		if (!bit_test(rec->node_bitmap, i) || !bit_test(dirty_bitmap, i))
+			continue;
+		if (node_busy_until[i] < rec->end_time)
+			node_busy_until[i] = rec->end_time;
+	}
+}
+
+/*
+ * Apply job start/end/resize/time limit changes since the previous backfill
+ * cycle to the running job reservations. Bitmap work is proportional to the
+ * number of changed jobs rather than the number of running jobs.
+ */
+static void _running_map_update(void)
+{
+	running_map_args_t args;
+	bf_running_rec_t *rec;
+	int i;
+
+	if (running_map_node_cnt != node_record_count)
+		_running_map_clear();
+	if (!running_job_map) {
+		running_job_map = xhash_init(_running_rec_key_id,
+					     _running_rec_free);
+		node_busy_until = xcalloc(node_record_count, sizeof(time_t));
+		node_busy_cnt = xcalloc(node_record_count, sizeof(uint32_t));
+		running_map_node_cnt = node_record_count;
+	}
+	running_map_cycle++;
+
+	memset(&args, 0, sizeof(args));
+	args.dirty_bitmap = bit_alloc(node_record_count);
+	args.stale_list = list_create(NULL);
+	list_for_each(job_list, _running_map_update_job, &args);
+
+	xhash_walk(running_job_map, _running_map_find_stale, &args);
+	while ((rec = list_pop(args.stale_list))) {
+		_running_rec_remove(rec, args.dirty_bitmap);
+		xhash_delete(running_job_map, (char *) &rec->job_id,
+			     sizeof(uint32_t));
+		args.del_cnt++;
+	}
+	FREE_NULL_LIST(args.stale_list);
+
+	if (bit_ffs(args.dirty_bitmap) >= 0) {
+		for (i = 0; i < node_record_count; i++) {
+			if (bit_test(args.dirty_bitmap, i))
+				node_busy_until[i] = 0;
+		}
+		xhash_walk(running_job_map, _running_map_refresh_dirty,
+			   args.dirty_bitmap);
+	}
+	FREE_NULL_BITMAP(args.dirty_bitmap);
+
+	if (debug_flags & DEBUG_FLAG_BACKFILL) {
+		info("backfill: running job map updated, added:%u removed:%u total:%u",
+		     args.add_cnt, args.del_cnt,
+		     xhash_count(running_job_map));
+	}
+}
+
+static int _node_busy_cmp(const void *x, const void *y)
+{
+	const bf_node_busy_t *b1 = (const bf_node_busy_t *) x;
+	const bf_node_busy_t *b2 = (const bf_node_busy_t *) y;
+
+	if (b1->busy_until < b2->busy_until)
+		return -1;
+	if (b1->busy_until > b2->busy_until)
+		return 1;
+	return 0;
+}
+
+/*
+ * Build the running job part of the resources/time table from the per-node
+ * busy times maintained by _running_map_update(). This is equivalent to
+ * calling _bf_reserve_running() for every running job, but costs one pass
+ * over the nodes instead of one table walk per job.
+ * IN/OUT node_space - table holding the single initial record
+ * IN/OUT node_space_recs - count of records in node_space
+ * IN now - begin time of the table
+ * RET count of records added
+ */
+static int _running_map_node_space(node_space_map_t *node_space,
+				   int *node_space_recs, time_t now)
+{
+	bf_node_busy_t *busy;
+	bitstr_t *base_bitmap;
+	int busy_cnt = 0, i, j, k, prev = 0, add_cnt = 0;
+	time_t window_end = node_space[0].end_time;
+
+	busy = xcalloc(node_record_count, sizeof(bf_node_busy_t));
+	for (i = 0; i < node_record_count; i++) {
+		if (node_busy_until[i] <= now)
+			continue;
+		busy[busy_cnt].node_inx = i;
+		busy[busy_cnt].busy_until = node_busy_until[i];
+		busy_cnt++;
+	}
+	if (busy_cnt == 0) {
+		xfree(busy);
+		return 0;
+	}
+	qsort(busy, busy_cnt, sizeof(bf_node_busy_t), _node_busy_cmp);
+
+	base_bitmap = bit_copy(node_space[0].avail_bitmap);
+	for (i = 0; i < busy_cnt; i++)
+		bit_clear(node_space[0].avail_bitmap, busy[i].node_inx);
+
+	for (i = 0; i < busy_cnt; i = j) {
+		time_t busy_until = busy[i].busy_until;
+		bool changed = false;
+
+		if (busy_until >= window_end)
+			break;
+		for (j = i; (j < busy_cnt) &&
+			    (busy[j].busy_until == busy_until); j++) {
+			if (bit_test(base_bitmap, busy[j].node_inx))
+				changed = true;
+		}
+		if (!changed)
+			continue;
+
+		k = *node_space_recs;
+		node_space[k].begin_time = busy_until;
+		node_space[k].end_time = node_space[prev].end_time;
+		node_space[k].avail_bitmap =
+			bit_copy(node_space[prev].avail_bitmap);
+		for ( ; i < j; i++) {
+			if (bit_test(base_bitmap, busy[i].node_inx))
+				bit_set(node_space[k].avail_bitmap,
+					busy[i].node_inx);
+		}
+		node_space[k].next = 0;
+		node_space[prev].end_time = busy_until;
+		node_space[prev].next = k;
+		prev = k;
+		(*node_space_recs)++;
+		add_cnt++;
+	}
+	FREE_NULL_BITMAP(base_bitmap);
+	xfree(busy);
+
+	return add_cnt;
+}
+
 // Make bb reservation for jobs that already allocated their bb (began stage-in process).
 static int _bf_reserve_bb_allocated(void *x, void *arg)
 {
@@ -1736,6 +2083,7 @@ static int _attempt_backfill(void)
 	List job_queue;
 	job_queue_rec_t *job_queue_rec;
 	int bb, i, j, node_space_recs, bb_space_recs, mcs_select = 0;
+	int ns_size;
 	slurmdb_qos_rec_t *qos_ptr = NULL;
 	job_record_t *job_ptr = NULL;
 	part_record_t *part_ptr;
@@ -1830,8 +2178,13 @@ static int _attempt_backfill(void)
 	slurmctld_diag_stats.bf_last_depth_try = 0;
 	slurmctld_diag_stats.bf_when_last_cycle = now;
 
-	node_space = xmalloc(sizeof(node_space_map_t) *
-			     (max_backfill_job_cnt * 2 + 1));
+	ns_size = max_backfill_job_cnt * 2 + 1;
+	if (bf_incremental) {
+		_running_map_update();
+		/* One record per distinct running job end time at most */
+		ns_size += xhash_count(running_job_map);
+	}
+	node_space = xmalloc(sizeof(node_space_map_t) * ns_size);
 	node_space[0].begin_time = sched_start;
 	window_end = sched_start + backfill_window;
 	node_space[0].end_time = window_end;
@@ -1850,7 +2203,10 @@ static int _attempt_backfill(void)
 	bb_space[0].next = 0;
 	bb_space_recs = 1;
 
-	if (bf_running_job_reserve) {
+	if (bf_incremental) {
+		_running_map_node_space(node_space, &node_space_recs,
+					sched_start);
+	} else if (bf_running_job_reserve) {
 		node_space_handler_t node_space_handler;
 		node_space_handler.node_space = node_space;
 		node_space_handler.node_space_recs = &node_space_recs;
@@ -2016,6 +2372,7 @@ static int _attempt_backfill(void)
 				xfree(job_ptr->state_desc);
 				job_ptr->assoc_id = assoc_rec.id;
 				last_job_update = now;
+				job_record_changed(job_ptr);
 			} else {
 				debug("backfill: %pJ has invalid association",
 				      job_ptr);
@@ -2045,11 +2402,13 @@ static int _attempt_backfill(void)
 				assoc_mgr_unlock(&locks);
 				job_fail_qos(job_ptr, __func__);
 				last_job_update = now;
+				job_record_changed(job_ptr);
 				continue;
 			} else if (job_ptr->state_reason == FAIL_QOS) {
 				xfree(job_ptr->state_desc);
 				job_ptr->state_reason = WAIT_NO_REASON;
 				last_job_update = now;
+				job_record_changed(job_ptr);
 			}
 			assoc_mgr_unlock(&locks);
 		}
@@ -2618,6 +2977,7 @@ next_task:
 		if (start_res > job_ptr->start_time) {
 			job_ptr->start_time = start_res;
 			last_job_update = now;
+			job_record_changed(job_ptr);
 		}
 		/*
 		 * avail_bitmap at this point contains a bitmap of nodes
@@ -2673,6 +3033,7 @@ next_task:
 				     job_reason_string(job_ptr->state_reason),
 				     job_ptr->priority);
 			last_job_update = now;
+			job_record_changed(job_ptr);
 			_set_job_time_limit(job_ptr, orig_time_limit);
 			later_start = 0;
 			if (bb == -1)
@@ -3176,6 +3537,7 @@ static int _start_job(job_record_t *job_ptr, bitstr_t *resv_bitmap)
 	if (rc == SLURM_SUCCESS) {
 		/* job initiated */
 		last_job_update = time(NULL);
+		job_record_changed(job_ptr);
 		info("backfill: Started %pJ in %s on %s",
 		     job_ptr, job_ptr->part_ptr->name, job_ptr->nodes);
 		power_g_job_start(job_ptr);
@@ -3696,10 +4058,12 @@ static time_t _het_job_start_find(job_record_t *job_ptr, time_t now)
 			if (job_ptr->state_reason == WAIT_TIME) {
 				job_ptr->state_reason = WAIT_NO_REASON;
 				last_job_update = now;
+				job_record_changed(job_ptr);
 			}
 			if (job_ptr->state_reason_prev == WAIT_TIME) {
 				job_ptr->state_reason_prev = WAIT_NO_REASON;
 				last_job_update = now;
+				job_record_changed(job_ptr);
 			}
 		}
 
@@ -3902,11 +4266,11 @@ static bool _het_job_limit_check(het_job_map_t *map, time_t now)
 			/* Simulate normal job completion */
 			job_ptr->end_time_exp = now;
 			job_ptr->end_time = job_ptr->start_time;
-			job_ptr->job_state = JOB_COMPLETE | JOB_COMPLETING;
+			job_state_set(job_ptr, JOB_COMPLETE | JOB_COMPLETING);
 			acct_policy_job_fini(job_ptr);
 			job_ptr->end_time_exp = end_time_exp;
 			job_ptr->end_time = end_time;
-			job_ptr->job_state = job_state;
+			job_state_set(job_ptr, job_state);
 			xfree(job_ptr->tres_alloc_cnt);
 			job_ptr->tres_alloc_cnt = tres_alloc_save[fini_jobs++];
 		}
@@ -4046,8 +4410,9 @@ static void _het_job_kill_now(het_job_map_t *map)
 		     job_ptr);
 		job_ptr->details->begin_time = now + cred_lifetime + 1;
 		job_ptr->end_time   = now;
-		job_ptr->job_state  = JOB_PENDING | JOB_COMPLETING;
+		job_state_set(job_ptr, JOB_PENDING | JOB_COMPLETING);
 		last_job_update     = now;
+		job_record_changed(job_ptr);
 		build_cg_bitmap(job_ptr);
 		job_completion_logger(job_ptr, false);
 		deallocate_nodes(job_ptr, false, false, false);
@@ -614,3 +614,257 @@ extern int job_res_rm_job(part_res_record_t *part_record_ptr,
 
 	return SLURM_SUCCESS;
 }
+
+typedef struct {
+	List gres_list;			/* node_usage gres_list before swap */
+	int node_inx;
+} undo_gres_t;
+
+typedef struct {
+	uint64_t alloc_memory;
+	int node_inx;
+	uint16_t node_state;
+} undo_node_t;
+
+typedef struct {
+	part_res_record_t *p_ptr;
+	part_row_data_t *row;		/* rows before first job removal */
+} undo_part_t;
+
+typedef struct {
+	struct job_resources *job;
+	uint32_t job_inx;		/* job's slot in row->job_list */
+	part_row_data_t *row;
+} undo_row_t;
+
+struct job_res_undo {
+	bitstr_t *gres_saved;		/* nodes with a gres[] entry */
+	undo_gres_t *gres;
+	uint32_t gres_cnt;
+	uint32_t gres_size;
+	bitstr_t *node_saved;		/* nodes with a node[] entry */
+	undo_node_t *node;
+	uint32_t node_cnt;
+	uint32_t node_size;
+	node_use_record_t *node_usage;
+	undo_part_t *part;
+	uint32_t part_cnt;
+	uint32_t part_size;
+	part_res_record_t *part_record_ptr;
+	undo_row_t *row;
+	uint32_t row_cnt;
+	uint32_t row_size;
+};
+
+static void _undo_save_node(job_res_undo_t *undo, int node_inx)
+{
+	undo_node_t *entry;
+
+	if (bit_test(undo->node_saved, node_inx))
+		return;
+	bit_set(undo->node_saved, node_inx);
+
+	if (undo->node_cnt >= undo->node_size) {
+		undo->node_size += 64;
+		xrealloc(undo->node, undo->node_size * sizeof(undo_node_t));
+	}
+	entry = &undo->node[undo->node_cnt++];
+	entry->node_inx = node_inx;
+	entry->alloc_memory = undo->node_usage[node_inx].alloc_memory;
+	entry->node_state = undo->node_usage[node_inx].node_state;
+}
+
+/*
+ * GRES deallocation modifies the node's gres_node_state_t records in place,
+ * so give the node a private copy the first time one of its jobs is removed.
+ */
+static void _undo_save_gres(job_res_undo_t *undo, int node_inx)
+{
+	node_use_record_t *node_use = &undo->node_usage[node_inx];
+	List gres_list;
+	undo_gres_t *entry;
+
+	if (bit_test(undo->gres_saved, node_inx))
+		return;
+	bit_set(undo->gres_saved, node_inx);
+
+	if (node_use->gres_list)
+		gres_list = node_use->gres_list;
+	else
+		gres_list = node_record_table_ptr[node_inx].gres_list;
+	if (!gres_list || !list_count(gres_list))
+		return;
+
+	if (undo->gres_cnt >= undo->gres_size) {
+		undo->gres_size += 64;
+		xrealloc(undo->gres, undo->gres_size * sizeof(undo_gres_t));
+	}
+	entry = &undo->gres[undo->gres_cnt++];
+	entry->node_inx = node_inx;
+	entry->gres_list = node_use->gres_list;
+	node_use->gres_list = gres_plugin_node_state_dup(gres_list);
+}
+
+/*
+ * A single row only has the job's cores cleared and its job_list entry
+ * removed, which can be reversed directly. Removing a job from a partition
+ * with several rows may repack every row, so save the rows instead.
+ */
+static void _undo_save_part(job_res_undo_t *undo, part_res_record_t *p_ptr,
+			    struct job_resources *job)
+{
+	uint32_t i;
+
+	if (!p_ptr->row)
+		return;
+
+	if (p_ptr->num_rows > 1) {
+		for (i = 0; i < undo->part_cnt; i++) {
+			if (undo->part[i].p_ptr == p_ptr)
+				return;
+		}
+		if (undo->part_cnt >= undo->part_size) {
+			undo->part_size += 8;
+			xrealloc(undo->part,
+				 undo->part_size * sizeof(undo_part_t));
+		}
+		undo->part[undo->part_cnt].p_ptr = p_ptr;
+		undo->part[undo->part_cnt].row =
+			part_data_dup_row(p_ptr->row, p_ptr->num_rows);
+		undo->part_cnt++;
+		return;
+	}
+
+	for (i = 0; i < p_ptr->row[0].num_jobs; i++) {
+		if (p_ptr->row[0].job_list[i] == job)
+			break;
+	}
+	if (i >= p_ptr->row[0].num_jobs)
+		return;	/* job_res_rm_job() will not change the row */
+
+	if (undo->row_cnt >= undo->row_size) {
+		undo->row_size += 64;
+		xrealloc(undo->row, undo->row_size * sizeof(undo_row_t));
+	}
+	undo->row[undo->row_cnt].job = job;
+	undo->row[undo->row_cnt].job_inx = i;
+	undo->row[undo->row_cnt].row = &p_ptr->row[0];
+	undo->row_cnt++;
+}
+
+/*
+ * Start a log of job removals from the given partition and node usage
+ * records, normally select_part_record and select_node_usage.
+ */
+extern job_res_undo_t *job_res_undo_create(part_res_record_t *part_record_ptr,
+					   node_use_record_t *node_usage)
+{
+	job_res_undo_t *undo = xmalloc(sizeof(job_res_undo_t));
+
+	undo->gres_saved = bit_alloc(select_node_cnt);
+	undo->node_saved = bit_alloc(select_node_cnt);
+	undo->node_usage = node_usage;
+	undo->part_record_ptr = part_record_ptr;
+
+	return undo;
+}
+
+/*
+ * Same as job_res_rm_job() with job_fini=false, but first record what the
+ * removal is going to change so job_res_undo_rollback() can reverse it.
+ */
+extern int job_res_undo_rm_job(job_res_undo_t *undo, job_record_t *job_ptr,
+			       int action, bitstr_t *node_map)
+{
+	struct job_resources *job = job_ptr->job_resrcs;
+	part_res_record_t *p_ptr;
+	int i, i_first, i_last, n;
+
+	if (select_state_initializing || !job || !job->core_bitmap)
+		goto remove;
+
+	i_first = bit_ffs(job->node_bitmap);
+	if (i_first != -1)
+		i_last = bit_fls(job->node_bitmap);
+	else
+		i_last = -2;
+	for (i = i_first, n = -1; i <= i_last; i++) {
+		if (!bit_test(job->node_bitmap, i))
+			continue;
+		n++;
+		if (node_map && !bit_test(node_map, i))
+			continue;
+		if (job->cpus[n] == 0)
+			continue;  /* node lost by job resize */
+		_undo_save_node(undo, i);
+		if (action != 2)
+			_undo_save_gres(undo, i);
+	}
+
+	if ((action != 1) && job_ptr->part_ptr) {
+		for (p_ptr = undo->part_record_ptr; p_ptr;
+		     p_ptr = p_ptr->next) {
+			if (p_ptr->part_ptr == job_ptr->part_ptr) {
+				_undo_save_part(undo, p_ptr, job);
+				break;
+			}
+		}
+	}
+
+remove:
+	return job_res_rm_job(undo->part_record_ptr, undo->node_usage,
+			      job_ptr, action, false, node_map);
+}
+
+/*
+ * Restore everything changed through job_res_undo_rm_job() and free the log
+ */
+extern void job_res_undo_rollback(job_res_undo_t *undo)
+{
+	part_row_data_t *row;
+	undo_part_t *part;
+	undo_row_t *entry;
+	uint32_t i, j;
+
+	if (!undo)
+		return;
+
+	/* Reinsert jobs in reverse order of removal to keep job_list order */
+	for (i = undo->row_cnt; i > 0; i--) {
+		entry = &undo->row[i - 1];
+		row = entry->row;
+		for (j = row->num_jobs; j > entry->job_inx; j--)
+			row->job_list[j] = row->job_list[j - 1];
+		row->job_list[j] = entry->job;
+		row->num_jobs++;
+		job_res_add_cores(entry->job, &row->row_bitmap);
+	}
+
+	for (i = 0; i < undo->part_cnt; i++) {
+		part = &undo->part[i];
+		part_data_destroy_row(part->p_ptr->row, part->p_ptr->num_rows);
+		part->p_ptr->row = part->row;
+	}
+
+	for (i = 0; i < undo->node_cnt; i++) {
+		node_use_record_t *node_use =
+			&undo->node_usage[undo->node[i].node_inx];
+		node_use->alloc_memory = undo->node[i].alloc_memory;
+		node_use->node_state = undo->node[i].node_state;
+	}
+
+	for (i = 0; i < undo->gres_cnt; i++) {
+		node_use_record_t *node_use =
+			&undo->node_usage[undo->gres[i].node_inx];
+		FREE_NULL_LIST(node_use->gres_list);
+		node_use->gres_list = undo->gres[i].gres_list;
+	}
+
+	FREE_NULL_BITMAP(undo->gres_saved);
+	FREE_NULL_BITMAP(undo->node_saved);
+	xfree(undo->gres);
+	xfree(undo->node);
+	xfree(undo->part);
+	xfree(undo->row);
+	xfree(undo);
+}
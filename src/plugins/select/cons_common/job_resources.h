@@ -107,4 +107,31 @@ extern int job_res_rm_job(part_res_record_t *part_record_ptr,
 			  job_record_t *job_ptr, int action, bool job_fini,
 			  bitstr_t *node_map);
 
+/*
+ * Log of job removals applied in place to the partition and node usage
+ * records, used to evaluate future resource availability without copying
+ * those records. Callers must hold the locks needed to modify select state
+ * until job_res_undo_rollback() is called.
+ */
+typedef struct job_res_undo job_res_undo_t;
+
+/*
+ * Start a log of job removals from the given partition and node usage
+ * records, normally select_part_record and select_node_usage.
+ */
+extern job_res_undo_t *job_res_undo_create(part_res_record_t *part_record_ptr,
+					   node_use_record_t *node_usage);
+
+/*
+ * Same as job_res_rm_job() with job_fini=false, but first record what the
+ * removal is going to change so job_res_undo_rollback() can reverse it.
+ */
+extern int job_res_undo_rm_job(job_res_undo_t *undo, job_record_t *job_ptr,
+			       int action, bitstr_t *node_map);
+
+/*
+ * Restore everything changed through job_res_undo_rm_job() and free the log
+ */
+extern void job_res_undo_rollback(job_res_undo_t *undo);
+
 #endif /* _CONS_COMMON_JOB_RES_H */
@@ -49,6 +49,7 @@ typedef struct {
 	node_use_record_t *node_usage;
 	part_res_record_t *part_record_ptr;
 	int rc;
+	job_res_undo_t *undo;
 } wrapper_rm_job_args_t;
 
 uint64_t def_cpu_per_gpu = 0;
@@ -1773,15 +1774,24 @@ static int _wrapper_job_res_rm_job(void *x, void *arg)
 	job_record_t *job_ptr = (job_record_t *)x;
 	wrapper_rm_job_args_t *wargs = (wrapper_rm_job_args_t *)arg;
 
-	(void)job_res_rm_job(wargs->part_record_ptr, wargs->node_usage,
-			     job_ptr, wargs->action, wargs->job_fini,
-			     wargs->node_map);
+	if (wargs->undo)
+		(void)job_res_undo_rm_job(wargs->undo, job_ptr, wargs->action,
+					  wargs->node_map);
+	else
+		(void)job_res_rm_job(wargs->part_record_ptr, wargs->node_usage,
+				     job_ptr, wargs->action, wargs->job_fini,
+				     wargs->node_map);
 
 	return 0;
 }
 
+/*
+ * Remove a job (all components of a hetjob) from the given records, or
+ * through the undo log if one is given
+ */
 static int _job_res_rm_job(part_res_record_t *part_record_ptr,
 			   node_use_record_t *node_usage,
+			   job_res_undo_t *undo,
 			   job_record_t *job_ptr, int action, bool job_fini,
 			   bitstr_t *node_map)
 {
@@ -1790,7 +1800,8 @@ static int _job_res_rm_job(part_res_record_t *part_record_ptr,
 		.job_fini = job_fini,
 		.node_usage = node_usage,
 		.part_record_ptr = part_record_ptr,
-		.node_map = node_map
+		.node_map = node_map,
+		.undo = undo
 	};
 
 	if (!job_overlap_and_running(node_map, job_ptr))
@@ -1818,8 +1829,7 @@ static int _will_run_test(job_record_t *job_ptr, bitstr_t *node_bitmap,
 			  List *preemptee_job_list,
 			  bitstr_t **exc_core_bitmap)
 {
-	part_res_record_t *future_part;
-	node_use_record_t *future_usage;
+	job_res_undo_t *undo;
 	job_record_t *tmp_job_ptr, *job_ptr_preempt = NULL;
 	List cr_job_list;
 	ListIterator job_iterator, preemptee_iterator;
@@ -1854,19 +1864,12 @@ static int _will_run_test(job_record_t *job_ptr, bitstr_t *node_bitmap,
 
 	/*
 	 * Job is still pending. Simulate termination of jobs one at a time
-	 * to determine when and where the job can start.
+	 * to determine when and where the job can start. Jobs are removed
+	 * from the live records and put back by job_res_undo_rollback()
+	 * before returning, the caller's locks keep anyone else from seeing
+	 * the intermediate state.
 	 */
-	future_part = part_data_dup_res(select_part_record, orig_map);
-	if (future_part == NULL) {
-		FREE_NULL_BITMAP(orig_map);
-		return SLURM_ERROR;
-	}
-	future_usage = node_data_dup_use(select_node_usage, orig_map);
-	if (future_usage == NULL) {
-		part_data_destroy_res(future_part);
-		FREE_NULL_BITMAP(orig_map);
-		return SLURM_ERROR;
-	}
+	undo = job_res_undo_create(select_part_record, select_node_usage);
 
 	/* Build list of running and suspended jobs */
 	cr_job_list = list_create(NULL);
@@ -1922,9 +1925,8 @@ static int _will_run_test(job_record_t *job_ptr, bitstr_t *node_bitmap,
 			} else
 				action = 0;	/* remove cores and memory */
 			/* Remove preemptable job now */
-			_job_res_rm_job(future_part, future_usage,
-					tmp_job_ptr, action, false,
-					orig_map);
+			_job_res_rm_job(NULL, NULL, undo, tmp_job_ptr, action,
+					false, orig_map);
 		}
 	}
 	list_iterator_destroy(job_iterator);
@@ -1934,8 +1936,8 @@ static int _will_run_test(job_record_t *job_ptr, bitstr_t *node_bitmap,
 		bit_or(node_bitmap, orig_map);
 		rc = _job_test(job_ptr, node_bitmap, min_nodes, max_nodes,
 			       req_nodes, SELECT_MODE_WILL_RUN, tmp_cr_type,
-			       job_node_req, future_part,
-			       future_usage, exc_core_bitmap, false,
+			       job_node_req, select_part_record,
+			       select_node_usage, exc_core_bitmap, false,
 			       qos_preemptor, true);
 		if (rc == SLURM_SUCCESS) {
 			/*
@@ -1996,9 +1998,8 @@ static int _will_run_test(job_record_t *job_ptr, bitstr_t *node_bitmap,
 							(time_window - delta);
 				}
 				last_job_ptr = tmp_job_ptr;
-				(void) job_res_rm_job(
-					future_part, future_usage,
-					tmp_job_ptr, 0, false, orig_map);
+				(void) job_res_undo_rm_job(
+					undo, tmp_job_ptr, 0, orig_map);
 				next_job_ptr = list_peek_next(job_iterator);
 				if (!next_job_ptr) {
 					more_jobs = false;
@@ -2022,9 +2023,10 @@ static int _will_run_test(job_record_t *job_ptr, bitstr_t *node_bitmap,
 			rc = _job_test(job_ptr, node_bitmap, min_nodes,
 				       max_nodes, req_nodes,
 				       SELECT_MODE_WILL_RUN, tmp_cr_type,
-				       job_node_req, future_part, future_usage,
-				       exc_core_bitmap, backfill_busy_nodes,
-				       qos_preemptor, true);
+				       job_node_req, select_part_record,
+				       select_node_usage, exc_core_bitmap,
+				       backfill_busy_nodes, qos_preemptor,
+				       true);
 			if (rc == SLURM_SUCCESS) {
 				if (last_job_ptr->end_time <= now) {
 					job_ptr->start_time =
@@ -2065,8 +2067,7 @@ timer_check:
 	}
 
 	FREE_NULL_LIST(cr_job_list);
-	part_data_destroy_res(future_part);
-	node_data_destroy(future_usage, NULL);
+	job_res_undo_rollback(undo);
 	FREE_NULL_BITMAP(orig_map);
 
 	return rc;
@@ -2154,7 +2155,7 @@ top:	orig_node_map = bit_copy(save_node_map);
 			    (mode != PREEMPT_MODE_CANCEL))
 				continue;	/* can't remove job */
 			/* Remove preemptable job now */
-			if(_job_res_rm_job(future_part, future_usage,
+			if(_job_res_rm_job(future_part, future_usage, NULL,
 					   tmp_job_ptr, 0, false,
 					   orig_node_map))
 				continue;
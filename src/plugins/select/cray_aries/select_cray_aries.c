@@ -934,7 +934,7 @@ extern int select_p_state_save(char *dir_name)
 	debug("cray: select_p_state_save");
 	START_TIMER;
 	/* write header: time */
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
 
 	slurm_mutex_lock(&blade_mutex);
 
@@ -942,7 +942,7 @@ extern int select_p_state_save(char *dir_name)
 
 	/* write blade records to buffer */
 	for (i=0; i<blade_cnt; i++)
-		_pack_blade(&blade_array[i], buffer, SLURM_PROTOCOL_VERSION);
+		_pack_blade(&blade_array[i], buffer, SLURM_STATE_PROTOCOL_VERSION);
 
 	slurm_mutex_unlock(&blade_mutex);
 
@@ -1193,7 +1193,8 @@ extern int select_p_job_init(List job_list)
 				     IS_JOB_CONFIGURING(job_ptr))) {
 					debug("CCM %pJ recovery rerun prologue",
 					      job_ptr);
-					job_ptr->job_state |= JOB_CONFIGURING;
+					job_state_set_flag(job_ptr,
+							   JOB_CONFIGURING);
 					slurm_thread_create_detached(NULL,
 								     ccm_begin,
 								     job_ptr);
@@ -1496,7 +1497,7 @@ extern int select_p_job_begin(job_record_t *job_ptr)
 				/* Cleared in prolog_running_decr() */
 				debug("CCM %pJ setting JOB_CONFIGURING",
 				      job_ptr);
-				job_ptr->job_state |= JOB_CONFIGURING;
+				job_state_set_flag(job_ptr, JOB_CONFIGURING);
 				slurm_thread_create_detached(NULL, ccm_begin,
 							     job_ptr);
 			}
@@ -294,7 +294,7 @@ extern int save_nonstop_state(void)
 	int log_fd;
 
 	/* write header: version, time */
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
 	pack_time(now, buffer);
 
 	/* write individual job records */
@@ -58,6 +58,10 @@ struct sdiag_parameters params;
 stats_info_response_msg_t *buf;
 uint32_t *rpc_type_ave_time = NULL, *rpc_user_ave_time = NULL;
 
+static void _print_lock_stats(void);
+static void _print_rpc_class_stats(void);
+static void _print_slab_stats(void);
+static void _print_fwd_stats(void);
 static int  _print_stats(void);
 static void _sort_rpc(void);
 
@@ -98,6 +102,96 @@ int main(int argc, char **argv)
 	exit(rc);
 }
 
+static void _print_lock_stats(void)
+{
+	uint32_t *hist;
+	int i, j;
+
+	printf("\nSlurmctld lock statistics (microseconds):\n");
+	for (i = 0; i < buf->lock_stats_count; i++) {
+		if (!buf->lock_cnt[i])
+			continue;
+		printf("\t%-16s count:%-8u ave_wait:%-6"PRIu64" "
+		       "ave_hold:%-6"PRIu64" max_hold:%u\n",
+		       buf->lock_stats_name[i], buf->lock_cnt[i],
+		       buf->lock_wait_time[i] / buf->lock_cnt[i],
+		       buf->lock_hold_time[i] / buf->lock_cnt[i],
+		       buf->lock_hold_max[i]);
+		hist = &buf->lock_hist[i * buf->lock_hist_size];
+		printf("\t%-16s hold:", "");
+		for (j = 0; j < buf->lock_hist_size; j++) {
+			if (buf->lock_hist_bound[j] == INFINITE)
+				printf(" >=%u:%u", buf->lock_hist_bound[j - 1],
+				       hist[j]);
+			else
+				printf(" <%u:%u", buf->lock_hist_bound[j],
+				       hist[j]);
+		}
+		printf("\n");
+	}
+}
+
+static void _print_rpc_class_stats(void)
+{
+	int i;
+
+	printf("\nRemote Procedure Call statistics by priority class\n");
+	for (i = 0; i < buf->rpc_class_count; i++) {
+		printf("\t%-8s count:%-8u ave_time:%-6"PRIu64" "
+		       "active:%-4u max_active:%-4u "
+		       "deferred_busy:%-6u deferred_rate:%u\n",
+		       buf->rpc_class_name[i], buf->rpc_class_cnt[i],
+		       buf->rpc_class_cnt[i] ?
+		       buf->rpc_class_time[i] / buf->rpc_class_cnt[i] : 0,
+		       buf->rpc_class_active[i], buf->rpc_class_active_max[i],
+		       buf->rpc_class_busy[i], buf->rpc_class_rate[i]);
+	}
+}
+
+static void _print_slab_stats(void)
+{
+	int i;
+
+	printf("\nSlab allocator statistics\n");
+	for (i = 0; i < buf->slab_cache_count; i++) {
+		printf("\t%-14s size:%-6u kbytes:%-8u free:%-8u "
+		       "alloc:%-10"PRIu64" freed:%-10"PRIu64" "
+		       "transfers:%"PRIu64"\n",
+		       buf->slab_cache_name[i], buf->slab_cache_size[i],
+		       buf->slab_cache_kbytes[i], buf->slab_cache_depot[i],
+		       buf->slab_cache_alloc[i], buf->slab_cache_free[i],
+		       buf->slab_cache_trips[i]);
+	}
+	printf("\tRPC arenas: %"PRIu64"\n", buf->arena_count);
+	if (buf->arena_count) {
+		printf("\tMean allocations per arena: %"PRIu64"\n",
+		       buf->arena_alloc_count / buf->arena_count);
+		printf("\tMean bytes per arena: %"PRIu64"\n",
+		       buf->arena_alloc_bytes / buf->arena_count);
+	}
+	printf("\tMax bytes in an arena: %u\n", buf->arena_max_bytes);
+	printf("\tArena blocks added: %"PRIu64"\n", buf->arena_block_count);
+}
+
+static void _print_fwd_stats(void)
+{
+	int i;
+
+	printf("\nMessage forwarding statistics\n");
+	printf("\tReplies timed: %"PRIu64"\n", buf->fwd_resp_count);
+	printf("\tFailures to reply: %"PRIu64"\n", buf->fwd_fail_count);
+	printf("\tNodes sent messages as leaves: %"PRIu64"\n",
+	       buf->fwd_leaf_count);
+	for (i = 0; i < buf->fwd_node_count; i++) {
+		printf("\t%-20s ave_time:%-8u max_time:%-8u replies:%-6u "
+		       "failures:%u%s\n",
+		       buf->fwd_node_name[i], buf->fwd_node_hop_avg[i],
+		       buf->fwd_node_hop_max[i], buf->fwd_node_resp[i],
+		       buf->fwd_node_fail[i],
+		       buf->fwd_node_leaf[i] ? " leaf" : "");
+	}
+}
+
 static int _print_stats(void)
 {
 	int i;
@@ -195,9 +289,42 @@ static int _print_stats(void)
 		       buf->bf_table_size_sum / buf->bf_cycle_counter);
 	}
 
+	if (buf->decay_threads) {
+		printf("\nPriority decay stats\n");
+		printf("\tTotal cycles: %u\n", buf->decay_cycle_counter);
+		if (buf->decay_when_last_cycle > 0) {
+			printf("\tLast cycle when: %s (%ld)\n",
+			       slurm_ctime2(&buf->decay_when_last_cycle),
+			       buf->decay_when_last_cycle);
+		} else {
+			printf("\tLast cycle when: N/A\n");
+		}
+		printf("\tLast cycle: %u\n", buf->decay_cycle_last);
+		printf("\tMax cycle:  %u\n", buf->decay_cycle_max);
+		if (buf->decay_cycle_counter > 0) {
+			printf("\tMean cycle: %"PRIu64"\n",
+			       buf->decay_cycle_sum /
+			       buf->decay_cycle_counter);
+		}
+		printf("\tLast job count: %u\n", buf->decay_jobs_last);
+		printf("\tThreads: %u\n", buf->decay_threads);
+	}
+
+	if (buf->lock_stats_count)
+		_print_lock_stats();
+
+	if (buf->slab_cache_count)
+		_print_slab_stats();
+
+	if (buf->fwd_resp_count || buf->fwd_fail_count)
+		_print_fwd_stats();
+
 	printf("\nLatency for 1000 calls to gettimeofday(): %d microseconds\n",
 	       buf->gettimeofday_latency);
 
+	if (buf->rpc_class_count)
+		_print_rpc_class_stats();
+
 	printf("\nRemote Procedure Call statistics by message type\n");
 	for (i = 0; i < buf->rpc_type_size; i++) {
 		printf("\t%-40s(%5u) count:%-6u "
@@ -2544,6 +2544,7 @@ static int _qos_job_time_out(job_record_t *job_ptr,
 	switch (tres_usage) {
 	case TRES_USAGE_CUR_EXCEEDS_LIMIT:
 		last_job_update = now;
+		job_record_changed(job_ptr);
 		info("%pJ timed out, the job is at or exceeds QOS %s's group max tres(%s) minutes of %"PRIu64" with %"PRIu64"",
 		     job_ptr, qos_ptr->name,
 		     assoc_mgr_tres_name_array[tres_pos],
@@ -2569,6 +2570,7 @@ static int _qos_job_time_out(job_record_t *job_ptr,
 
 		if (wall_mins >= qos_ptr->grp_wall) {
 			last_job_update = now;
+			job_record_changed(job_ptr);
 			info("%pJ timed out, the job is at or exceeds QOS %s's group wall limit of %u with %u",
 			     job_ptr, qos_ptr->name,
 			     qos_ptr->grp_wall, wall_mins);
@@ -2588,6 +2590,7 @@ static int _qos_job_time_out(job_record_t *job_ptr,
 		break;
 	case TRES_USAGE_REQ_EXCEEDS_LIMIT:
 		last_job_update = now;
+		job_record_changed(job_ptr);
 		info("%pJ timed out, the job is at or exceeds QOS %s's max tres(%s) minutes of %"PRIu64" with %"PRIu64,
 		     job_ptr, qos_ptr->name,
 		     assoc_mgr_tres_name_array[tres_pos],
@@ -4207,6 +4210,7 @@ extern int acct_policy_update_pending_job(job_record_t *job_ptr)
 
 	if (update_accounting) {
 		last_job_update = time(NULL);
+		job_record_changed(job_ptr);
 		debug("limits changed for %pJ: updating accounting", job_ptr);
 		/* Update job record in accounting to reflect changes */
 		jobacct_storage_job_start_direct(acct_db_conn, job_ptr);
@@ -4303,6 +4307,7 @@ extern bool acct_policy_job_time_out(job_record_t *job_ptr)
 		switch (tres_usage) {
 		case TRES_USAGE_CUR_EXCEEDS_LIMIT:
 			last_job_update = now;
+			job_record_changed(job_ptr);
 			info("%pJ timed out, the job is at or exceeds assoc %u(%s/%s/%s) group max tres(%s) minutes of %"PRIu64" with %"PRIu64,
 			     job_ptr, assoc->id, assoc->acct,
 			     assoc->user, assoc->partition,
@@ -4344,6 +4349,7 @@ extern bool acct_policy_job_time_out(job_record_t *job_ptr)
 			break;
 		case TRES_USAGE_REQ_EXCEEDS_LIMIT:
 			last_job_update = now;
+			job_record_changed(job_ptr);
 			info("%pJ timed out, the job is at or exceeds assoc %u(%s/%s/%s) max tres(%s) minutes of %"PRIu64" with %"PRIu64,
 			     job_ptr, assoc->id, assoc->acct,
 			     assoc->user, assoc->partition,
@@ -1105,16 +1105,17 @@ static void *_thread_per_group_rpc(void *args)
 					     __func__, job_id);
 				} else if (rc == SLURM_SUCCESS) {
 					if (msg_ptr->signal == SIGSTOP) {
-						job_ptr->job_state |=
-							JOB_STOPPED;
+						job_state_set_flag(job_ptr,
+								   JOB_STOPPED);
 					} else { // SIGCONT
-						job_ptr->job_state &=
-							~JOB_STOPPED;
+						job_state_unset_flag(job_ptr,
+								     JOB_STOPPED);
 					}
 				}
 
 				if (job_ptr)
-					job_ptr->job_state &= ~JOB_SIGNALING;
+					job_state_unset_flag(job_ptr,
+							     JOB_SIGNALING);
 
 				unlock_slurmctld(job_write_lock);
 			}
@@ -1204,7 +1205,7 @@ cleanup:
 			lock_slurmctld(job_write_lock);
 			job_ptr = find_job_record(job_id);
 			if (job_ptr)
-				job_ptr->job_state &= ~JOB_SIGNALING;
+				job_state_unset_flag(job_ptr, JOB_SIGNALING);
 			unlock_slurmctld(job_write_lock);
 		}
 	}
@@ -44,6 +44,7 @@
 #  include <sys/prctl.h>
 #endif
 
+#include <arpa/inet.h>
 #include <errno.h>
 #include <grp.h>
 #include <poll.h>
@@ -74,6 +75,7 @@
 #include "src/common/prep.h"
 #include "src/common/proc_args.h"
 #include "src/common/read_config.h"
+#include "src/common/slab.h"
 #include "src/common/slurm_acct_gather_profile.h"
 #include "src/common/slurm_accounting_storage.h"
 #include "src/common/slurm_auth.h"
@@ -114,6 +116,7 @@
 #include "src/slurmctld/proc_req.h"
 #include "src/slurmctld/read_config.h"
 #include "src/slurmctld/reservation.h"
+#include "src/slurmctld/rpc_class.h"
 #include "src/slurmctld/sched_plugin.h"
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/slurmctld_plugstack.h"
@@ -132,6 +135,18 @@
 				 * check-in before we ping them */
 #define SHUTDOWN_WAIT     2	/* Time to wait for backup server shutdown */
 #define JOB_COUNT_INTERVAL 30   /* Time to update running job count */
+#define MAX_RPC_CONNS   4096	/* Open connections with rpc_workers set */
+#define MAX_RPC_WORKERS 1024	/* Upper bound for rpc_workers */
+#define MAX_RPC_MSG_SIZE (1024*1024*1024) /* As slurm_msg_recvfrom_timeout */
+
+typedef struct {
+	arena_t *arena;		/* for the RPC's message buffers */
+	connection_arg_t *conn;
+	slurm_msg_t *msg;	/* NULL until unpacked by a worker */
+	char *recv_buf;		/* message read by _rpc_mgr_pool() */
+	uint32_t recv_len;	/* bytes read, length header included */
+	uint32_t msg_len;	/* message length from its header */
+} rpc_work_t;
 
 /**************************************************************************\
  * To test for memory leaks, set MEMORY_LEAK_DEBUG to 1 using
@@ -205,10 +220,19 @@ static int	debug_level = 0;
 static char *	debug_logfile = NULL;
 static bool	dump_core = false;
 static int      job_sched_cnt = 0;
+static uint32_t max_rpc_conns = MAX_RPC_CONNS;
 static uint32_t max_server_threads = MAX_SERVER_THREADS;
 static time_t	next_stats_reset = 0;
 static int	new_nice = 0;
 static int	recover   = DEFAULT_RECOVER;
+static pthread_cond_t rpc_work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t rpc_work_mutex = PTHREAD_MUTEX_INITIALIZER;
+static List	rpc_recv_queue = NULL;
+static List	rpc_work_queue[RPC_CLASS_CNT];
+static slab_cache_t *rpc_msg_slab = NULL;
+static slab_cache_t *rpc_work_slab = NULL;
+static bool	rpc_work_stop = false;
+static int	rpc_worker_cnt = 0;
 static pthread_mutex_t sched_cnt_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pid_t	slurmctld_pid;
 static char *	slurm_conf_filename;
@@ -228,6 +252,7 @@ typedef struct primary_thread_arg {
 	char *prog_type;
 } primary_thread_arg_t;
 
+static connection_arg_t *_accept_conn(int listen_fd);
 static int          _accounting_cluster_ready();
 static int          _accounting_mark_all_nodes_down(char *reason);
 static void *       _assoc_cache_mgr(void *no_data);
@@ -235,15 +260,23 @@ static int          _controller_index(void);
 static void         _become_slurm_user(void);
 static void         _create_clustername_file(void);
 static void         _default_sigaction(int sig);
+static void         _finish_connection(connection_arg_t *conn,
+				       slurm_msg_t *msg);
 static void         _get_fed_updates();
 static void         _init_config(void);
 static void         _init_pidfile(void);
 static int          _init_tres(void);
 static void         _kill_old_slurmctld(void);
 static void         _parse_commandline(int argc, char **argv);
+static int          _receive_connection(connection_arg_t *conn,
+					slurm_msg_t *msg);
+static int          _unpack_connection(connection_arg_t *conn, char *buf,
+				       uint32_t buf_len, slurm_msg_t *msg);
 static void *       _purge_files_thread(void *no_data);
 static void         _remove_assoc(slurmdb_assoc_rec_t *rec);
 static void         _remove_qos(slurmdb_qos_rec_t *rec);
+static void         _rpc_mgr_pool(struct pollfd *listen_fds, int nports);
+static int          _rpc_recv(rpc_work_t *work);
 static void         _run_primary_prog(bool primary_on);
 static void *       _service_connection(void *arg);
 static void         _set_work_dir(void);
@@ -289,6 +322,9 @@ int main(int argc, char **argv)
 	for (i = 3; i < cnt; i++)
 		close(i);
 
+	/* Allocate hot short-lived objects from per-thread slab caches */
+	slab_enable();
+
 	/*
 	 * Establish initial configuration
 	 */
@@ -905,6 +941,7 @@ int main(int argc, char **argv)
 	purge_front_end_state();
 	resv_fini();
 	trigger_fini();
+	rpc_class_fini();
 	assoc_mgr_fini(1);
 	reserve_port_config(NULL);
 	free_rpc_stats();
@@ -1132,15 +1169,15 @@ static void _sig_handler(int signal)
 }
 
 /*
- * _slurmctld_rpc_mgr - Read incoming RPCs and create pthread for each
+ * _slurmctld_rpc_mgr - Read incoming RPCs and create pthread for each,
+ *	or hand them to the rpc_workers pool when configured
  */
 static void *_slurmctld_rpc_mgr(void *no_data)
 {
-	int newsockfd;
 	struct pollfd *fds;
-	slurm_addr_t cli_addr, srv_addr;
+	slurm_addr_t srv_addr;
 	uint16_t port;
-	char ip[32];
+	char ip[32], *tmp_ptr;
 	int fd_next = 0, i, nports;
 	connection_arg_t *conn_arg = NULL;
 	/* Locks: Read config */
@@ -1182,6 +1219,17 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 			debug2("slurmctld listening on %s:%d", ip, ntohs(port));
 		}
 	}
+	rpc_worker_cnt = 0;
+	if ((tmp_ptr = xstrcasestr(slurmctld_conf.slurmctld_params,
+				   "rpc_workers="))) {
+		rpc_worker_cnt = atoi(tmp_ptr + 12);
+		if ((rpc_worker_cnt < 0) ||
+		    (rpc_worker_cnt > MAX_RPC_WORKERS)) {
+			error("Invalid SlurmctldParameters rpc_workers=%d, using one thread per connection",
+			      rpc_worker_cnt);
+			rpc_worker_cnt = 0;
+		}
+	}
 	unlock_slurmctld(config_read_lock);
 
 	/*
@@ -1194,6 +1242,11 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 	xsignal(SIGUSR1, _sig_handler);
 	xsignal_unblock(sigarray);
 
+	if (rpc_worker_cnt) {
+		_rpc_mgr_pool(fds, nports);
+		goto fini;
+	}
+
 	/*
 	 * Process incoming RPCs until told to shutdown
 	 */
@@ -1214,30 +1267,10 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 		}
 		fd_next = (i + 1) % nports;
 
-		/*
-		 * accept needed for stream implementation is a no-op in
-		 * message implementation that just passes sockfd to newsockfd
-		 */
-		if ((newsockfd = slurm_accept_msg_conn(fds[i].fd, &cli_addr))
-		    == SLURM_ERROR) {
-			if (errno != EINTR)
-				error("slurm_accept_msg_conn: %m");
+		if (!(conn_arg = _accept_conn(fds[i].fd))) {
 			server_thread_decr();
 			continue;
 		}
-		fd_set_close_on_exec(newsockfd);
-		conn_arg = xmalloc(sizeof(connection_arg_t));
-		conn_arg->newsockfd = newsockfd;
-		memcpy(&conn_arg->cli_addr, &cli_addr, sizeof(slurm_addr_t));
-
-		if (slurmctld_conf.debug_flags & DEBUG_FLAG_PROTOCOL) {
-			char inetbuf[64];
-
-			slurm_print_slurm_addr(&cli_addr,
-						inetbuf,
-						sizeof(inetbuf));
-			info("%s: accept() connection from %s", __func__, inetbuf);
-		}
 
 		if (slurmctld_config.shutdown_time) {
 			slurmctld_diag_stats.proc_req_raw++;
@@ -1248,6 +1281,7 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 		}
 	}
 
+fini:
 	debug3("%s shutting down", __func__);
 	for (i = 0; i < nports; i++)
 		close(fds[i].fd);
@@ -1258,55 +1292,462 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 }
 
 /*
- * _service_connection - service the RPC
- * IN/OUT arg - really just the connection's file descriptor, freed
- *	upon completion
- * RET - NULL
+ * _accept_conn - accept a new connection on a listening socket
+ * RET connection argument to be serviced or NULL on error
  */
-static void *_service_connection(void *arg)
+static connection_arg_t *_accept_conn(int listen_fd)
 {
-	connection_arg_t *conn = (connection_arg_t *) arg;
-	void *return_code = NULL;
-	slurm_msg_t msg;
+	int newsockfd;
+	slurm_addr_t cli_addr;
+	connection_arg_t *conn_arg;
+
+	/*
+	 * accept needed for stream implementation is a no-op in
+	 * message implementation that just passes sockfd to newsockfd
+	 */
+	if ((newsockfd = slurm_accept_msg_conn(listen_fd, &cli_addr))
+	    == SLURM_ERROR) {
+		if (errno != EINTR)
+			error("slurm_accept_msg_conn: %m");
+		return NULL;
+	}
+	fd_set_close_on_exec(newsockfd);
+	conn_arg = xmalloc(sizeof(connection_arg_t));
+	conn_arg->newsockfd = newsockfd;
+	memcpy(&conn_arg->cli_addr, &cli_addr, sizeof(slurm_addr_t));
+
+	if (slurmctld_conf.debug_flags & DEBUG_FLAG_PROTOCOL) {
+		char inetbuf[64];
+
+		slurm_print_slurm_addr(&cli_addr,
+					inetbuf,
+					sizeof(inetbuf));
+		info("%s: accept() connection from %s", __func__, inetbuf);
+	}
+
+	return conn_arg;
+}
+
+/* Queue work for the rpc_workers pool and wake one worker */
+static void _rpc_work_queue(rpc_work_t *work, List queue)
+{
+	slurm_mutex_lock(&rpc_work_mutex);
+	list_enqueue(queue, work);
+	slurm_cond_signal(&rpc_work_cond);
+	slurm_mutex_unlock(&rpc_work_mutex);
+}
+
+/*
+ * _rpc_next_work - pick the next work for an rpc_workers thread: high
+ *	priority RPCs, then messages to be unpacked, then normal and low
+ *	priority RPCs. Classes at their concurrency limit are deferred, the
+ *	class slot is taken along with the dequeue so no other worker can
+ *	take it in between.
+ *	Call with rpc_work_mutex locked.
+ */
+static rpc_work_t *_rpc_next_work(void)
+{
+	rpc_work_t *work;
+	rpc_class_t rpc_class;
+
+	if ((work = list_dequeue(rpc_work_queue[RPC_CLASS_HIGH])) ||
+	    (work = list_dequeue(rpc_recv_queue)))
+		return work;
+	for (rpc_class = RPC_CLASS_NORMAL; rpc_class < RPC_CLASS_CNT;
+	     rpc_class++) {
+		if (list_count(rpc_work_queue[rpc_class]) &&
+		    rpc_class_reserve(rpc_class)) {
+			work = list_dequeue(rpc_work_queue[rpc_class]);
+			work->conn->rpc_reserved = true;
+			return work;
+		}
+	}
+	return NULL;
+}
+
+/*
+ * _rpc_worker - rpc_workers pool thread. Unpacks messages read by
+ *	_rpc_mgr_pool() and processes them in _rpc_next_work() order.
+ *	Queued work is drained before exiting.
+ */
+static void *_rpc_worker(void *no_data)
+{
+	rpc_work_t *work;
+	int i, rc;
 
 #if HAVE_SYS_PRCTL_H
-	if (prctl(PR_SET_NAME, "srvcn", NULL, NULL, NULL) < 0) {
-		error("%s: cannot set my name to %s %m", __func__, "srvcn");
+	if (prctl(PR_SET_NAME, "rpcwrk", NULL, NULL, NULL) < 0) {
+		error("%s: cannot set my name to %s %m", __func__, "rpcwrk");
 	}
 #endif
-	slurm_msg_t_init(&msg);
-	msg.flags |= SLURM_MSG_KEEP_BUFFER;
+
+	while (1) {
+		work = NULL;
+		slurm_mutex_lock(&rpc_work_mutex);
+		while (1) {
+			if ((work = _rpc_next_work()))
+				break;
+			if (rpc_work_stop) {
+				/* Drain work deferred by class limits */
+				for (i = 0; !work && (i < RPC_CLASS_CNT); i++)
+					work = list_dequeue(rpc_work_queue[i]);
+				break;
+			}
+			slurm_cond_wait(&rpc_work_cond, &rpc_work_mutex);
+		}
+		slurm_mutex_unlock(&rpc_work_mutex);
+		if (!work)
+			break;
+
+		if (!work->msg) {
+			work->msg = slab_alloc(rpc_msg_slab);
+			arena_swap(work->arena);
+			rc = _unpack_connection(work->conn, work->recv_buf,
+						work->msg_len, work->msg);
+			work->recv_buf = NULL;	/* now owned by msg */
+			if (rc == SLURM_SUCCESS) {
+				arena_swap(NULL);
+				_rpc_work_queue(work, rpc_work_queue[
+					rpc_class_get(work->msg->msg_type)]);
+				continue;
+			}
+		} else {
+			arena_swap(work->arena);
+			slurmctld_req(work->msg, work->conn);
+		}
+		_finish_connection(work->conn, work->msg);
+		arena_swap(NULL);
+		arena_destroy(work->arena);
+		xfree(work->msg);
+		xfree(work);
+	}
+
+	return NULL;
+}
+
+/*
+ * _rpc_recv - read what is available of the message on a connection
+ *	without blocking: its length header, then the message itself into
+ *	memory from the RPC's arena
+ * IN/OUT work - connection's RPC, recv_len updated with the bytes read
+ * RET 1 once the whole message is read, 0 if more is to be read, or -1 if
+ *	the connection was closed or the message is invalid
+ */
+static int _rpc_recv(rpc_work_t *work)
+{
+	int fd = work->conn->newsockfd;
+	uint32_t hdr_len = sizeof(work->msg_len), off;
+	arena_t *prev_arena;
+	ssize_t len;
+
+	while (1) {
+		if ((work->recv_len >= hdr_len) &&
+		    (work->recv_len - hdr_len == work->msg_len))
+			return 1;
+		if (work->recv_len < hdr_len) {
+			off = work->recv_len;
+			len = read(fd, ((char *) &work->msg_len) + off,
+				   hdr_len - off);
+		} else {
+			off = work->recv_len - hdr_len;
+			len = read(fd, work->recv_buf + off,
+				   work->msg_len - off);
+		}
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+				return 0;
+			error("%s: read(%d): %m", __func__, fd);
+			return -1;
+		}
+		if (len == 0) {
+			debug("%s: connection %d closed after %u bytes",
+			      __func__, fd, work->recv_len);
+			return -1;
+		}
+		work->recv_len += len;
+		if (work->recv_len != hdr_len)
+			continue;
+
+		work->msg_len = ntohl(work->msg_len);
+		if (work->msg_len > MAX_RPC_MSG_SIZE) {
+			error("%s: %s", __func__,
+			      slurm_strerror(SLURM_PROTOCOL_INSANE_MSG_LENGTH));
+			return -1;
+		}
+		prev_arena = arena_swap(work->arena);
+		work->recv_buf = arena_alloc(work->msg_len);
+		arena_swap(prev_arena);
+	}
+}
+
+/* Close a connection whose message was not handed to the workers */
+static void _rpc_drop(rpc_work_t *work)
+{
+	_finish_connection(work->conn, NULL);
+	xfree(work->recv_buf);
+	arena_destroy(work->arena);
+	xfree(work);
+}
+
+/*
+ * _rpc_mgr_pool - Process incoming RPCs with a fixed pool of rpc_workers
+ *	threads until told to shutdown. Accepted connections are polled here
+ *	and their messages read as data arrives, a worker is only handed a
+ *	complete message to unpack and process, so a slow or idle client
+ *	does not hold a thread. Connections which have not sent their whole
+ *	message within MessageTimeout are closed.
+ * IN listen_fds - listening sockets
+ * IN nports - count of listen_fds
+ */
+static void _rpc_mgr_pool(struct pollfd *listen_fds, int nports)
+{
+	struct pollfd *fds = NULL;
+	rpc_work_t **pend_work = NULL;
+	time_t *pend_time = NULL, now;
+	pthread_t *workers;
+	rpc_work_t *work;
+	int fd_cnt, fd_size = 0, pend_cnt = 0, pend_size = 0, i, j, k, rc;
+	int msg_timeout = slurm_get_msg_timeout() / 1000;
+	bool accept_ok;
+
+	rpc_msg_slab = slab_cache_create("slurm_msg", sizeof(slurm_msg_t));
+	rpc_work_slab = slab_cache_create("rpc_work", sizeof(rpc_work_t));
+	rpc_recv_queue = list_create(NULL);
+	for (i = 0; i < RPC_CLASS_CNT; i++)
+		rpc_work_queue[i] = list_create(NULL);
+	rpc_work_stop = false;
+	workers = xcalloc(rpc_worker_cnt, sizeof(pthread_t));
+	for (i = 0; i < rpc_worker_cnt; i++)
+		slurm_thread_create(&workers[i], _rpc_worker, NULL);
+	info("%s: servicing RPCs with %d worker threads",
+	     __func__, rpc_worker_cnt);
+
+	while (!slurmctld_config.shutdown_time) {
+		slurm_mutex_lock(&slurmctld_config.thread_count_lock);
+		accept_ok = (slurmctld_config.server_thread_count <
+			     max_rpc_conns);
+		slurm_mutex_unlock(&slurmctld_config.thread_count_lock);
+		if (!accept_ok) {
+			static time_t last_print_time = 0;
+			now = time(NULL);
+			if (difftime(now, last_print_time) > 2) {
+				verbose("server_thread_count over limit (%u), not accepting",
+					max_rpc_conns);
+				last_print_time = now;
+			}
+		}
+
+		fd_cnt = nports + pend_cnt;
+		if (fd_cnt > fd_size) {
+			fd_size = fd_cnt * 2;
+			xrecalloc(fds, fd_size, sizeof(struct pollfd));
+		}
+		for (i = 0; i < nports; i++) {
+			fds[i].fd = listen_fds[i].fd;
+			fds[i].events = accept_ok ? POLLIN : 0;
+			fds[i].revents = 0;
+		}
+		for (j = 0; j < pend_cnt; j++) {
+			fds[nports + j].fd = pend_work[j]->conn->newsockfd;
+			fds[nports + j].events = POLLIN;
+			fds[nports + j].revents = 0;
+		}
+
+		if (poll(fds, fd_cnt, 1000) == -1) {
+			if (errno != EINTR)
+				error("%s: poll: %m", __func__);
+			continue;
+		}
+		now = time(NULL);
+
+		/*
+		 * Read from readable connections, hand complete messages to
+		 * the workers
+		 */
+		for (j = 0, k = 0; j < pend_cnt; j++) {
+			work = pend_work[j];
+			if (fds[nports + j].revents) {
+				rc = _rpc_recv(work);
+				if (rc > 0) {
+					fd_set_blocking(work->conn->newsockfd);
+					_rpc_work_queue(work, rpc_recv_queue);
+					continue;
+				} else if (rc < 0) {
+					_rpc_drop(work);
+					continue;
+				}
+			}
+			if (difftime(now, pend_time[j]) > msg_timeout) {
+				char addr_buf[32];
+				slurm_print_slurm_addr(&work->conn->cli_addr,
+						       addr_buf,
+						       sizeof(addr_buf));
+				error("%s: closing connection from %s, message incomplete after %u bytes",
+				      __func__, addr_buf, work->recv_len);
+				_rpc_drop(work);
+				continue;
+			}
+			pend_work[k] = work;
+			pend_time[k] = pend_time[j];
+			k++;
+		}
+		pend_cnt = k;
+
+		for (i = 0; i < nports; i++) {
+			connection_arg_t *conn_arg;
+
+			if (!fds[i].revents)
+				continue;
+			if (!(conn_arg = _accept_conn(fds[i].fd)))
+				continue;
+			server_thread_incr();
+			fd_set_nonblocking(conn_arg->newsockfd);
+			if (pend_cnt >= pend_size) {
+				pend_size = MAX(pend_size * 2, 64);
+				xrecalloc(pend_work, pend_size,
+					  sizeof(rpc_work_t *));
+				xrecalloc(pend_time, pend_size, sizeof(time_t));
+			}
+			work = slab_alloc(rpc_work_slab);
+			work->arena = arena_create();
+			work->conn = conn_arg;
+			pend_work[pend_cnt] = work;
+			pend_time[pend_cnt] = now;
+			pend_cnt++;
+		}
+	}
+
+	/*
+	 * Connections with a message not yet read are dropped, requests
+	 * already read are processed before the workers exit.
+	 */
+	for (j = 0; j < pend_cnt; j++)
+		_rpc_drop(pend_work[j]);
+	slurm_mutex_lock(&rpc_work_mutex);
+	rpc_work_stop = true;
+	slurm_cond_broadcast(&rpc_work_cond);
+	slurm_mutex_unlock(&rpc_work_mutex);
+	for (i = 0; i < rpc_worker_cnt; i++)
+		pthread_join(workers[i], NULL);
+	FREE_NULL_LIST(rpc_recv_queue);
+	for (i = 0; i < RPC_CLASS_CNT; i++)
+		FREE_NULL_LIST(rpc_work_queue[i]);
+
+	xfree(workers);
+	xfree(pend_work);
+	xfree(pend_time);
+	xfree(fds);
+}
+
+/*
+ * _receive_connection - read the RPC from a new connection
+ * IN/OUT conn - connection, newsockfd set to -1 if closed here
+ * OUT msg - message received, free with _finish_connection()
+ * RET SLURM_SUCCESS if msg should be processed by slurmctld_req()
+ */
+static int _receive_connection(connection_arg_t *conn, slurm_msg_t *msg)
+{
+	slurm_msg_t_init(msg);
+	msg->flags |= SLURM_MSG_KEEP_BUFFER;
 	/*
 	 * slurm_receive_msg sets msg connection fd to accepted fd. This allows
 	 * possibility for slurmctld_req() to close accepted connection.
 	 */
-	if (slurm_receive_msg(conn->newsockfd, &msg, 0) != 0) {
+	if (slurm_receive_msg(conn->newsockfd, msg, 0) != 0) {
 		char addr_buf[32];
 		slurm_print_slurm_addr(&conn->cli_addr, addr_buf,
 				       sizeof(addr_buf));
 		error("slurm_receive_msg [%s]: %m", addr_buf);
 		/* close the new socket */
 		close(conn->newsockfd);
-		goto cleanup;
+		conn->newsockfd = -1;
+		return SLURM_ERROR;
 	}
 
 	if (errno != SLURM_SUCCESS) {
 		if (errno == SLURM_PROTOCOL_VERSION_ERROR) {
-			slurm_send_rc_msg(&msg, SLURM_PROTOCOL_VERSION_ERROR);
+			slurm_send_rc_msg(msg, SLURM_PROTOCOL_VERSION_ERROR);
 		} else
 			info("_service_connection/slurm_receive_msg %m");
-	} else {
-		/* process the request */
-		slurmctld_req(&msg, conn);
+		return SLURM_ERROR;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+/*
+ * _unpack_connection - unpack an RPC read from a connection by
+ *	_rpc_mgr_pool(), as _receive_connection() does once it has read it
+ * IN/OUT conn - connection, newsockfd set to -1 if closed here
+ * IN buf - message read, owned by msg once called
+ * IN buf_len - size of buf
+ * OUT msg - message received, free with _finish_connection()
+ * RET SLURM_SUCCESS if msg should be processed by slurmctld_req()
+ */
+static int _unpack_connection(connection_arg_t *conn, char *buf,
+			      uint32_t buf_len, slurm_msg_t *msg)
+{
+	slurm_msg_t_init(msg);
+	msg->conn_fd = conn->newsockfd;
+	msg->buffer = create_buf(buf, buf_len);
+	if (slurm_unpack_received_msg(msg, conn->newsockfd, msg->buffer)) {
+		char addr_buf[32];
+		slurm_print_slurm_addr(&conn->cli_addr, addr_buf,
+				       sizeof(addr_buf));
+		error("slurm_unpack_received_msg [%s]: %m", addr_buf);
+		/* close the new socket */
+		close(conn->newsockfd);
+		conn->newsockfd = -1;
+		return SLURM_ERROR;
 	}
 
+	return SLURM_SUCCESS;
+}
+
+/*
+ * _finish_connection - close the connection and release its resources
+ * IN conn - connection, freed here
+ * IN msg - message received on the connection or NULL, members freed here
+ */
+static void _finish_connection(connection_arg_t *conn, slurm_msg_t *msg)
+{
 	if ((conn->newsockfd >= 0) && (close(conn->newsockfd) < 0))
 		error ("close(%d): %m",  conn->newsockfd);
-
-cleanup:
-	slurm_free_msg_members(&msg);
-	xfree(arg);
+	if (msg)
+		slurm_free_msg_members(msg);
+	xfree(conn);
 	server_thread_decr();
+}
+
+/*
+ * _service_connection - service the RPC
+ * IN/OUT arg - really just the connection's file descriptor, freed
+ *	upon completion
+ * RET - NULL
+ */
+static void *_service_connection(void *arg)
+{
+	connection_arg_t *conn = (connection_arg_t *) arg;
+	void *return_code = NULL;
+	slurm_msg_t msg;
+	arena_t *arena, *prev_arena;
+
+#if HAVE_SYS_PRCTL_H
+	if (prctl(PR_SET_NAME, "srvcn", NULL, NULL, NULL) < 0) {
+		error("%s: cannot set my name to %s %m", __func__, "srvcn");
+	}
+#endif
+	arena = arena_create();
+	prev_arena = arena_swap(arena);
+	if (_receive_connection(conn, &msg) == SLURM_SUCCESS) {
+		/* process the request */
+		slurmctld_req(&msg, conn);
+	}
+	_finish_connection(conn, &msg);
+	arena_swap(prev_arena);
+	arena_destroy(arena);
 
 	return return_code;
 }
@@ -2300,6 +2741,7 @@ extern void save_all_state(void)
 {
 	/* Each of these functions lock their own databases */
 	schedule_front_end_save();
+	job_state_full_save();
 	schedule_job_save();
 	schedule_node_save();
 	schedule_part_save();
@@ -3318,13 +3760,19 @@ static void _test_thread_limit(void)
 #ifdef RLIMIT_NOFILE
 {
 	struct rlimit rlim[1];
-	if (getrlimit(RLIMIT_NOFILE, rlim) < 0)
+	if (getrlimit(RLIMIT_NOFILE, rlim) < 0) {
 		error("Unable to get file count limit");
-	else if ((rlim->rlim_cur != RLIM_INFINITY) &&
-		 (max_server_threads > rlim->rlim_cur)) {
-		max_server_threads = rlim->rlim_cur;
-		info("Reducing max_server_thread to %u due to file count limit "
-		     "of %u", max_server_threads, max_server_threads);
+	} else if (rlim->rlim_cur != RLIM_INFINITY) {
+		if (max_server_threads > rlim->rlim_cur) {
+			max_server_threads = rlim->rlim_cur;
+			info("Reducing max_server_thread to %u due to file count limit "
+			     "of %u", max_server_threads, max_server_threads);
+		}
+		if (max_rpc_conns > rlim->rlim_cur / 2) {
+			max_rpc_conns = rlim->rlim_cur / 2;
+			info("Reducing max_rpc_conns to %u due to file count limit "
+			     "of %u", max_rpc_conns, (uint32_t) rlim->rlim_cur);
+		}
 	}
 }
 #endif
@@ -3383,7 +3831,7 @@ static void *_purge_files_thread(void *no_data)
 	int *job_id;
 
 	/*
-	 * Use the purge_files_list as a queue. _delete_job_details()
+	 * Use the purge_files_list as a queue. _list_delete_job()
 	 * in job_mgr.c always enqueues (at the end), while
 	 *_purge_files_thread consumes off the front.
 	 *
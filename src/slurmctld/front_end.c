@@ -59,7 +59,7 @@
 #include "src/slurmctld/state_save.h"
 #include "src/slurmctld/trigger_mgr.h"
 
-/* No need to change we always pack SLURM_PROTOCOL_VERSION */
+/* No need to change we always pack SLURM_STATE_PROTOCOL_VERSION */
 #define FRONT_END_STATE_VERSION        "PROTOCOL_VERSION"
 
 front_end_record_t *front_end_nodes = NULL;
@@ -680,7 +680,7 @@ extern int dump_all_front_end_state(void)
 	START_TIMER;
 	/* write header: version, time */
 	packstr(FRONT_END_STATE_VERSION, buffer);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
 	pack_time(time(NULL), buffer);
 
 	/* write node records to buffer */
@@ -956,8 +956,8 @@ extern void sync_front_end_state(void)
 			    IS_JOB_RUNNING(job_ptr)) {
 				error("front end node %s has vanished, killing %pJ",
 				      job_ptr->batch_host, job_ptr);
-				job_ptr->job_state = JOB_NODE_FAIL |
-						     JOB_COMPLETING;
+				job_state_set(job_ptr,
+					      JOB_NODE_FAIL | JOB_COMPLETING);
 			} else if (job_ptr->front_end_ptr == NULL) {
 				info("front end node %s has vanished",
 				     job_ptr->batch_host);
@@ -43,11 +43,13 @@
 #include "config.h"
 #define _GNU_SOURCE
 
+#include <arpa/inet.h>
 #include <ctype.h>
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <libgen.h>
+#include <pthread.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -84,6 +86,7 @@
 #include "src/common/tres_frequency.h"
 #include "src/common/uid.h"
 #include "src/common/xassert.h"
+#include "src/common/xhash.h"
 #include "src/common/xstring.h"
 
 #include "src/slurmctld/acct_policy.h"
@@ -113,14 +116,28 @@
 #define SLURM_CREATE_JOB_FLAG_NO_ALLOCATE_0 0
 #define TOP_PRIORITY 0xffff0000	/* large, but leave headroom for higher */
 #define PURGE_OLD_JOB_IN_SEC 2592000 /* 30 days in seconds */
+#define JOB_CACHE_CNT 4		/* protocol/show_flags combinations cached */
+#define JOB_CACHE_REMOVED_AGE 600 /* seconds to remember removed jobs */
+#define JOB_JOURNAL_MIN_SIZE (1024 * 1024) /* compact no sooner than this */
+#define JOB_RECOVER_CHUNK (4 * 1024 * 1024) /* job_state bytes read at once */
+#define JOB_RECOVER_DEF_THREADS 8	/* default state_recover_threads max */
+#define JOB_RECOVER_MAX_THREADS 64	/* upper bound for state_recover_threads */
 
 #define JOB_HASH_INX(_job_id)	(_job_id % hash_table_size)
 #define JOB_ARRAY_HASH_INX(_job_id, _task_id) \
 	((_job_id + _task_id) % hash_table_size)
 
-/* No need to change we always pack SLURM_PROTOCOL_VERSION */
+/* No need to change we always pack SLURM_STATE_PROTOCOL_VERSION */
 #define JOB_STATE_VERSION     "PROTOCOL_VERSION"
+/* As JOB_STATE_VERSION, but each job record follows its size */
+#define JOB_STATE_SIZED_VERSION "SIZED_PROTOCOL_VERSION"
 #define JOB_CKPT_VERSION      "PROTOCOL_VERSION"
+#define JOB_JOURNAL_VERSION   "JOURNAL_VERSION"
+
+/* job_state.journal record types */
+#define JOB_JOURNAL_UPDATE	1	/* job record, created or changed */
+#define JOB_JOURNAL_PURGE	2	/* job record removed */
+#define JOB_JOURNAL_COMMIT	3	/* end of one save, job_id_sequence */
 
 typedef enum {
 	JOB_HASH_JOB,
@@ -149,6 +166,85 @@ typedef struct {
 	int rc;
 } job_overlap_args_t;
 
+/* One job's packed record in a job_cache_t */
+typedef struct {
+	uint32_t job_id;
+	uint32_t offset;	/* of the record in job_cache_t.buffer */
+	uint32_t size;
+	time_t change_time;	/* when the packed record last changed */
+} job_cache_rec_t;
+
+/*
+ * Packed job records for one protocol version and show_flags combination,
+ * see _job_cache_get()
+ */
+typedef struct {
+	time_t build_time;	/* zero if unused */
+	time_t delta_start;	/* removed jobs are known after this time */
+	time_t job_update;	/* last_job_update when built */
+	time_t part_update;	/* last_part_update when built */
+	time_t last_used;
+	uint16_t protocol_version;
+	uint16_t show_flags;
+	bool root;		/* built for uid 0, see _all_parts_hidden() */
+	Buf buffer;
+	job_cache_rec_t *recs;
+	uint32_t rec_cnt;
+	xhash_t *rec_hash;	/* job_id to recs entry */
+	uint32_t *removed_id;	/* jobs no longer packed */
+	time_t *removed_time;
+	uint32_t removed_cnt;
+} job_cache_t;
+
+/* Where the last saved state of one job is, see dump_all_job_state() */
+typedef struct {
+	uint32_t job_id;
+	uint32_t snap_offset;	/* of the job's record in job_state, NO_VAL
+				 * once superseded by a journal record */
+	uint32_t snap_size;
+	uint32_t journal_offset; /* of the job data of the job's last record
+				  * in job_state.journal */
+	uint32_t journal_size;
+} job_journal_rec_t;
+
+/* A job's last record in job_state.journal, used to replay the journal */
+typedef struct {
+	uint32_t job_id;
+	uint16_t type;		/* JOB_JOURNAL_UPDATE or JOB_JOURNAL_PURGE */
+	uint32_t offset;	/* of the record's job data in the journal */
+} job_journal_last_t;
+
+/* A job_state record superseded by the journal */
+typedef struct {
+	uint32_t offset;
+	uint32_t size;
+} job_journal_skip_t;
+
+/* Contents of a job_state.journal matching the job_state file */
+typedef struct {
+	Buf buffer;
+	uint16_t protocol_version;
+	uint32_t start;		/* offset of the first record */
+	uint32_t commit_offset;	/* end of the last complete save */
+	uint32_t job_id_sequence;
+	xhash_t *last;		/* job_id to job_journal_last_t */
+	job_journal_skip_t *skip; /* superseded job_state records, sorted */
+	uint32_t skip_cnt;
+} job_journal_replay_t;
+
+/*
+ * Task state counts for the separate job records of one job array (those
+ * linked through job_array_hash_j), see job_state_set()
+ */
+typedef struct job_array_index {
+	uint32_t array_job_id;
+	uint32_t member_cnt;	/* job records in the index */
+	uint32_t pending_cnt;	/* IS_JOB_PENDING() */
+	uint32_t complete_cnt;	/* IS_JOB_COMPLETE() */
+	uint32_t completed_cnt;	/* IS_JOB_COMPLETED() */
+	uint32_t finished_cnt;	/* IS_JOB_FINISHED() */
+} job_array_index_t;
+
 /* Global variables */
 List   job_list = NULL;		/* job_record list */
 time_t last_job_update;		/* time of last update to job records */
@@ -166,6 +262,17 @@ static uint32_t job_id_sequence = 0;	/* first job_id to assign new job */
 static struct   job_record **job_hash = NULL;
 static struct   job_record **job_array_hash_j = NULL;
 static struct   job_record **job_array_hash_t = NULL;
+static xhash_t *job_array_index = NULL;
+static job_cache_t job_cache[JOB_CACHE_CNT];
+static pthread_mutex_t job_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static xhash_t *job_journal = NULL;	/* job_id to job_journal_rec_t */
+static bool     job_journal_failed = false;
+static bool     job_journal_full = false; /* see job_state_full_save() */
+static uint32_t *job_journal_purge = NULL; /* jobs removed since last save */
+static uint32_t job_journal_purge_cnt = 0;
+static uint32_t job_journal_purge_size = 0;
+static uint32_t job_journal_size = 0;	/* bytes in job_state.journal */
+static uint32_t job_journal_snap_size = 0; /* bytes in job_state */
 static bool     kill_invalid_dep;
 static time_t   last_file_write_time = (time_t) 0;
 static uint32_t max_array_size = NO_VAL;
@@ -175,6 +282,7 @@ static bool     validate_cfgd_licenses = true;
 
 /* Local functions */
 static void _add_job_hash(job_record_t *job_ptr);
+static void _job_cache_fini(void);
 static void _add_job_array_hash(job_record_t *job_ptr);
 static void _clear_job_gres_details(job_record_t *job_ptr);
 static int  _copy_job_desc_to_file(job_desc_msg_t * job_desc,
@@ -184,6 +292,7 @@ static int  _copy_job_desc_to_job_record(job_desc_msg_t * job_desc,
 					 bitstr_t ** exc_bitmap,
 					 bitstr_t ** req_bitmap);
 static char *_copy_nodelist_no_dup(char *node_list);
+static job_record_t *_alloc_job_record(void);
 static job_record_t *_create_job_record(uint32_t num_jobs);
 static void _delete_job_details(job_record_t *job_entry);
 static slurmdb_qos_rec_t *_determine_and_validate_qos(
@@ -195,8 +304,10 @@ static void _dump_job_state(job_record_t *dump_job_ptr, Buf buffer);
 static void _dump_job_fed_details(job_fed_details_t *fed_details_ptr,
 				  Buf buffer);
 static job_fed_details_t *_dup_job_fed_details(job_fed_details_t *src);
+static void _free_job_record(job_record_t *job_ptr);
 static void _get_batch_job_dir_ids(List batch_dirs);
 static bool _get_whole_hetjob(void);
+static int  _install_job_state(job_record_t *job_ptr);
 static void _job_array_comp(job_record_t *job_ptr, bool was_running,
 			    bool requeue);
 static int  _job_create(job_desc_msg_t * job_specs, int allocate, int will_run,
@@ -204,6 +315,7 @@ static int  _job_create(job_desc_msg_t * job_specs, int allocate, int will_run,
 			char **err_msg, uint16_t protocol_version);
 static void _job_timed_out(job_record_t *job_ptr, bool preempted);
 static void _kill_dependent(job_record_t *job_ptr);
+static void _link_job_record(job_record_t *job_ptr, uint32_t num_jobs);
 static void _list_delete_job(void *job_entry);
 static int  _list_find_job_old(void *job_entry, void *key);
 static int  _load_job_details(job_record_t *job_ptr, Buf buffer,
@@ -247,6 +359,8 @@ static void _signal_job(job_record_t *job_ptr, int signal, uint16_t flags);
 static void _suspend_job(job_record_t *job_ptr, uint16_t op, bool indf_susp);
 static int  _suspend_job_nodes(job_record_t *job_ptr, bool indf_susp);
 static bool _top_priority(job_record_t *job_ptr, uint32_t het_job_offset);
+static int  _unpack_job_state(Buf buffer, uint16_t protocol_version,
+			      job_record_t **job_pptr);
 static int  _valid_job_part(job_desc_msg_t *job_desc, uid_t submit_uid,
 			    bitstr_t *req_bitmap, part_record_t *part_ptr,
 			    List part_ptr_list,
@@ -599,16 +713,22 @@ static job_array_resp_msg_t *_resp_array_xlate(resp_array_struct_t *resp,
  */
 static job_record_t *_create_job_record(uint32_t num_jobs)
 {
-	job_record_t *job_ptr = xmalloc(sizeof(*job_ptr));
-	struct job_details *detail_ptr = xmalloc(sizeof(*detail_ptr));
+	job_record_t *job_ptr = _alloc_job_record();
 
-	if ((job_count + num_jobs) >= slurmctld_conf.max_job_cnt) {
-		error("%s: MaxJobCount limit from slurm.conf reached (%u)",
-		      __func__, slurmctld_conf.max_job_cnt);
-	}
+	_link_job_record(job_ptr, num_jobs);
 
-	job_count += num_jobs;
-	last_job_update = time(NULL);
+	return job_ptr;
+}
+
+/*
+ * _alloc_job_record - create an empty job_record including job_details, not
+ *	yet in the job list, see _create_job_record()
+ * NOTE: free with _free_job_record() until linked by _link_job_record()
+ */
+static job_record_t *_alloc_job_record(void)
+{
+	job_record_t *job_ptr = xmalloc(sizeof(*job_ptr));
+	struct job_details *detail_ptr = xmalloc(sizeof(*detail_ptr));
 
 	job_ptr->magic = JOB_MAGIC;
 	job_ptr->array_task_id = NO_VAL;
@@ -622,11 +742,24 @@ static job_record_t *_create_job_record(uint32_t num_jobs)
 	job_ptr->requid = -1; /* force to -1 for sacct to know this
 			       * hasn't been set yet  */
 	job_ptr->billable_tres = (double)NO_VAL;
-	(void) list_append(job_list, job_ptr);
 
 	return job_ptr;
 }
 
+/* _link_job_record - add a record from _alloc_job_record() to the job list */
+static void _link_job_record(job_record_t *job_ptr, uint32_t num_jobs)
+{
+	if ((job_count + num_jobs) >= slurmctld_conf.max_job_cnt) {
+		error("%s: MaxJobCount limit from slurm.conf reached (%u)",
+		      __func__, slurmctld_conf.max_job_cnt);
+	}
+
+	job_count += num_jobs;
+	last_job_update = time(NULL);
+
+	(void) list_append(job_list, job_ptr);
+}
+
 
 /*
  * _delete_job_details - delete a job's detail record and clear it's pointer
@@ -641,17 +774,6 @@ static void _delete_job_details(job_record_t *job_entry)
 
 	xassert (job_entry->details->magic == DETAILS_MAGIC);
 
-	/*
-	 * Queue up job to have the batch script and environment deleted.
-	 * This is handled by a separate thread to limit the amount of
-	 * time purge_old_job needs to spend holding locks.
-	 */
-	if (IS_JOB_FINISHED(job_entry)) {
-		uint32_t *job_id = xmalloc(sizeof(uint32_t));
-		*job_id = job_entry->job_id;
-		list_enqueue(purge_files_list, job_id);
-	}
-
 	xfree(job_entry->details->acctg_freq);
 	for (i=0; i<job_entry->details->argc; i++)
 		xfree(job_entry->details->argv[i]);
@@ -797,6 +919,853 @@ static slurmdb_qos_rec_t *_determine_and_validate_qos(
 	return qos_ptr;
 }
 
+static void _job_journal_rec_id(void *item, const char **key,
+				uint32_t *key_len)
+{
+	job_journal_rec_t *rec = item;
+
+	*key = (const char *) &rec->job_id;
+	*key_len = sizeof(uint32_t);
+}
+
+static void _job_journal_last_id(void *item, const char **key,
+				 uint32_t *key_len)
+{
+	job_journal_last_t *last = item;
+
+	*key = (const char *) &last->job_id;
+	*key_len = sizeof(uint32_t);
+}
+
+/*
+ * Note that a job record is gone, so that the next journaled state save
+ * writes its removal. Call with job write lock.
+ */
+static void _job_journal_removed(uint32_t job_id)
+{
+	if (job_id == NO_VAL)
+		return;		/* unlinked job, already noted */
+	if (job_journal_purge_cnt >= job_journal_purge_size) {
+		job_journal_purge_size += 1024;
+		xrealloc(job_journal_purge,
+			 job_journal_purge_size * sizeof(uint32_t));
+	}
+	job_journal_purge[job_journal_purge_cnt++] = job_id;
+}
+
+extern void job_record_changed(job_record_t *job_ptr)
+{
+	job_ptr->state_saved = false;
+}
+
+extern void job_state_full_save(void)
+{
+	__atomic_store_n(&job_journal_full, true, __ATOMIC_RELEASE);
+}
+
+/*
+ * Return true if this job state save should write a complete job_state file
+ * from job_list in place of appending to the journal: with every periodic
+ * full state save, see job_state_full_save(), or once the journal outgrows
+ * the job_state file.
+ */
+static bool _job_journal_compact_due(void)
+{
+	if (__atomic_exchange_n(&job_journal_full, false, __ATOMIC_ACQ_REL))
+		return true;
+	if (job_journal_size > MAX(job_journal_snap_size, JOB_JOURNAL_MIN_SIZE))
+		return true;
+	return false;
+}
+
+/*
+ * Pack the start of a journal record. The record ends with the job data,
+ * packed as by packmem().
+ */
+static void _job_journal_pack(uint16_t type, uint32_t job_id,
+			      job_journal_rec_t *rec, Buf buffer)
+{
+	pack16(type, buffer);
+	pack32(job_id, buffer);
+	if (rec) {
+		pack32(rec->snap_offset, buffer);
+		pack32(rec->snap_size, buffer);
+		rec->snap_offset = NO_VAL;
+	} else {
+		pack32(NO_VAL, buffer);
+		pack32(0, buffer);
+	}
+}
+
+/*
+ * Pack journal records for every job changed since the last save (see
+ * job_record_changed()) and for every job removed since then, starting with
+ * the journal header if the journal is empty.
+ * Call with job read lock.
+ * RET buffer of records, NULL if nothing changed
+ */
+static Buf _job_journal_build(void)
+{
+	job_journal_rec_t *rec;
+	job_record_t *job_ptr;
+	ListIterator job_iterator;
+	Buf buffer = init_buf(BUF_SIZE);
+	uint32_t i, start, offset, size;
+
+	if (!job_journal_size) {
+		packstr(JOB_JOURNAL_VERSION, buffer);
+		pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
+		pack_time(last_file_write_time, buffer);
+	}
+	start = get_buf_offset(buffer);
+
+	/* Removals first, as a job_id could have been used again since */
+	for (i = 0; i < job_journal_purge_cnt; i++) {
+		if (!(rec = xhash_get(job_journal,
+				      (char *) &job_journal_purge[i],
+				      sizeof(uint32_t))))
+			continue;	/* never saved */
+		_job_journal_pack(JOB_JOURNAL_PURGE, rec->job_id, rec, buffer);
+		packmem(NULL, 0, buffer);
+		xhash_delete(job_journal, (char *) &job_journal_purge[i],
+			     sizeof(uint32_t));
+	}
+	job_journal_purge_cnt = 0;
+
+	job_iterator = list_iterator_create(job_list);
+	while ((job_ptr = list_next(job_iterator))) {
+		if (job_ptr->state_saved || (job_ptr->job_id == NO_VAL))
+			continue;
+		rec = xhash_get(job_journal, (char *) &job_ptr->job_id,
+				sizeof(uint32_t));
+		if (!rec) {
+			rec = xmalloc(sizeof(job_journal_rec_t));
+			rec->job_id = job_ptr->job_id;
+			rec->snap_offset = NO_VAL;
+			xhash_add(job_journal, rec);
+		}
+		_job_journal_pack(JOB_JOURNAL_UPDATE, rec->job_id, rec, buffer);
+
+		/* Pack the job data in place of packmem() */
+		offset = get_buf_offset(buffer);
+		pack32(0, buffer);
+		_dump_job_state(job_ptr, buffer);
+		size = get_buf_offset(buffer) - offset - sizeof(uint32_t);
+		set_buf_offset(buffer, offset);
+		pack32(size, buffer);
+		set_buf_offset(buffer, offset + sizeof(uint32_t) + size);
+
+		rec->journal_offset = job_journal_size + offset +
+				      sizeof(uint32_t);
+		rec->journal_size = size;
+		job_ptr->state_saved = true;
+	}
+	list_iterator_destroy(job_iterator);
+
+	if (get_buf_offset(buffer) == start) {
+		free_buf(buffer);
+		return NULL;
+	}
+	_job_journal_pack(JOB_JOURNAL_COMMIT, job_id_sequence, NULL, buffer);
+	packmem(NULL, 0, buffer);
+
+	return buffer;
+}
+
+/* Write all of buffer to fd. RET 0 or errno */
+static int _job_journal_write_fd(int fd, char *file, Buf buffer)
+{
+	int pos = 0, nwrite, amount;
+	char *data;
+
+	nwrite = get_buf_offset(buffer);
+	data = get_buf_data(buffer);
+	while (nwrite > 0) {
+		amount = write(fd, &data[pos], nwrite);
+		if (amount < 0) {
+			if (errno == EINTR)
+				continue;
+			error("Error writing file %s, %m", file);
+			return errno;
+		}
+		nwrite -= amount;
+		pos    += amount;
+	}
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Append the records from _job_journal_build() to job_state.journal.
+ * Call with lock_state_files().
+ */
+static int _job_journal_append(Buf buffer)
+{
+	int error_code = SLURM_SUCCESS, fd, rc;
+	char *file;
+
+	file = xstrdup_printf("%s/job_state.journal",
+			      slurmctld_conf.state_save_location);
+	if (!job_journal_size)
+		fd = open(file, O_CREAT|O_WRONLY|O_TRUNC|O_CLOEXEC, 0600);
+	else
+		fd = open(file, O_WRONLY|O_APPEND|O_CLOEXEC);
+
+	if (fd < 0) {
+		error("Can't save state, open file %s error %m", file);
+		error_code = errno;
+	} else {
+		error_code = _job_journal_write_fd(fd, file, buffer);
+		rc = fsync_and_close(fd, "job journal");
+		if (rc && !error_code)
+			error_code = rc;
+	}
+
+	if (!error_code)
+		job_journal_size += get_buf_offset(buffer);
+	else {
+		/* The records are lost, rewrite job_state next time */
+		job_journal_failed = true;
+	}
+	xfree(file);
+
+	return error_code;
+}
+
+/* Discard the in-memory journal state, job_state is rewritten next save */
+static void _job_journal_reset(void)
+{
+	xhash_free(job_journal);
+	job_journal_size = 0;
+	job_journal_snap_size = 0;
+	job_journal_failed = false;
+}
+
+/*
+ * Write buffer as the new job_state file, keeping the previous one as
+ * job_state.old. The journal applied to the previous file is removed.
+ * Call with lock_state_files().
+ */
+static int _job_state_write(Buf buffer, time_t now)
+{
+	static time_t last_mtime = (time_t) 0;
+	int error_code = SLURM_SUCCESS, log_fd, rc;
+	char *old_file, *new_file, *reg_file, *journal_file;
+	struct stat stat_buf;
+
+	old_file = xstrdup_printf("%s/job_state.old",
+				  slurmctld_conf.state_save_location);
+	reg_file = xstrdup_printf("%s/job_state",
+				  slurmctld_conf.state_save_location);
+	new_file = xstrdup_printf("%s/job_state.new",
+				  slurmctld_conf.state_save_location);
+	journal_file = xstrdup_printf("%s/job_state.journal",
+				      slurmctld_conf.state_save_location);
+
+	if (stat(reg_file, &stat_buf) == 0) {
+		int delta_t = difftime(stat_buf.st_mtime, last_mtime);
+		if (delta_t < -10) {
+			error("The modification time of %s moved backwards "
+			      "by %d seconds",
+			      reg_file, (0-delta_t));
+			error("The clock of the file system and this computer "
+			      "appear to not be synchronized");
+			/* It could be safest to exit here. We likely mounted
+			 * a different file system with the state save files */
+		}
+		last_mtime = time(NULL);
+	}
+
+	log_fd = open(new_file, O_CREAT|O_WRONLY|O_TRUNC|O_CLOEXEC, 0600);
+	if (log_fd < 0) {
+		error("Can't save state, create file %s error %m",
+		      new_file);
+		error_code = errno;
+	} else {
+		error_code = _job_journal_write_fd(log_fd, new_file, buffer);
+		rc = fsync_and_close(log_fd, "job");
+		if (rc && !error_code)
+			error_code = rc;
+	}
+	if (error_code)
+		(void) unlink(new_file);
+	else {			/* file shuffle */
+		(void) unlink(old_file);
+		if (link(reg_file, old_file))
+			debug4("unable to create link for %s -> %s: %m",
+			       reg_file, old_file);
+		(void) unlink(reg_file);
+		if (link(new_file, reg_file))
+			debug4("unable to create link for %s -> %s: %m",
+			       new_file, reg_file);
+		(void) unlink(new_file);
+		last_file_write_time = now;
+
+		/* The journal applied to the previous job_state file */
+		(void) unlink(journal_file);
+		job_journal_size = 0;
+	}
+	xfree(old_file);
+	xfree(reg_file);
+	xfree(new_file);
+	xfree(journal_file);
+
+	return error_code;
+}
+
+static void _job_journal_replay_free(job_journal_replay_t *replay)
+{
+	FREE_NULL_BUFFER(replay->buffer);
+	xhash_free(replay->last);
+	xfree(replay->skip);
+}
+
+static int _cmp_journal_skip(const void *a, const void *b)
+{
+	const job_journal_skip_t *x = a, *y = b;
+
+	return (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+/* Unpack the next record of job_state.journal, see _job_journal_pack() */
+static int _job_journal_unpack(Buf buffer, uint16_t *type, uint32_t *job_id,
+			       job_journal_skip_t *skip,
+			       uint32_t *data_offset)
+{
+	char *data;
+	uint32_t data_size;
+
+	safe_unpack16(type, buffer);
+	safe_unpack32(job_id, buffer);
+	safe_unpack32(&skip->offset, buffer);
+	safe_unpack32(&skip->size, buffer);
+	safe_unpackmem_ptr(&data, &data_size, buffer);
+	*data_offset = get_buf_offset(buffer) - data_size;
+	if ((*type < JOB_JOURNAL_UPDATE) || (*type > JOB_JOURNAL_COMMIT))
+		return SLURM_ERROR;
+	return SLURM_SUCCESS;
+
+unpack_error:
+	return SLURM_ERROR;
+}
+
+/*
+ * Read job_state.journal if it applies to the job_state file written at
+ * snap_time. Only records up to the last JOB_JOURNAL_COMMIT are used, so a
+ * partially written save is ignored.
+ * RET true if replay was filled in, free with _job_journal_replay_free()
+ */
+static bool _job_journal_read(time_t snap_time, job_journal_replay_t *replay)
+{
+	char *file, *ver_str = NULL;
+	uint32_t ver_str_len, job_id, data_offset, start, skip_alloc = 0;
+	uint16_t type;
+	time_t buf_time;
+	job_journal_last_t *last;
+	job_journal_skip_t skip;
+	Buf buffer;
+
+	memset(replay, 0, sizeof(job_journal_replay_t));
+	replay->job_id_sequence = NO_VAL;
+	replay->protocol_version = NO_VAL16;
+
+	file = xstrdup_printf("%s/job_state.journal",
+			      slurmctld_conf.state_save_location);
+	buffer = create_mmap_buf(file);
+	xfree(file);
+	if (!buffer)
+		return false;
+	replay->buffer = buffer;
+
+	safe_unpackstr_xmalloc(&ver_str, &ver_str_len, buffer);
+	if (ver_str && !xstrcmp(ver_str, JOB_JOURNAL_VERSION))
+		safe_unpack16(&replay->protocol_version, buffer);
+	xfree(ver_str);
+	if (replay->protocol_version == NO_VAL16) {
+		error("Ignoring job state journal, incompatible version");
+		goto fail;
+	}
+	safe_unpack_time(&buf_time, buffer);
+	if (buf_time != snap_time) {
+		debug("Ignoring job state journal of an older job_state file");
+		goto fail;
+	}
+	start = replay->start = get_buf_offset(buffer);
+	replay->commit_offset = start;
+
+	/* Find the end of the last complete save */
+	while (remaining_buf(buffer) > 0) {
+		if (_job_journal_unpack(buffer, &type, &job_id, &skip,
+					&data_offset)) {
+			error("Incomplete job state journal, ignoring data after offset %u",
+			      replay->commit_offset);
+			break;
+		}
+		if (type == JOB_JOURNAL_COMMIT) {
+			replay->commit_offset = get_buf_offset(buffer);
+			replay->job_id_sequence = job_id;
+		}
+	}
+
+	/* Index the last record of each job */
+	replay->last = xhash_init(_job_journal_last_id, xfree_ptr);
+	set_buf_offset(buffer, start);
+	while (get_buf_offset(buffer) < replay->commit_offset) {
+		(void) _job_journal_unpack(buffer, &type, &job_id, &skip,
+					   &data_offset);
+		if (type == JOB_JOURNAL_COMMIT)
+			continue;
+		if (skip.offset != NO_VAL) {
+			if (replay->skip_cnt >= skip_alloc) {
+				skip_alloc += 1024;
+				xrealloc(replay->skip, skip_alloc *
+					 sizeof(job_journal_skip_t));
+			}
+			replay->skip[replay->skip_cnt++] = skip;
+		}
+		if (!(last = xhash_get(replay->last, (char *) &job_id,
+				       sizeof(uint32_t)))) {
+			last = xmalloc(sizeof(job_journal_last_t));
+			last->job_id = job_id;
+			xhash_add(replay->last, last);
+		}
+		last->type = type;
+		last->offset = data_offset;
+	}
+	if (replay->skip_cnt) {
+		qsort(replay->skip, replay->skip_cnt,
+		      sizeof(job_journal_skip_t), _cmp_journal_skip);
+	}
+	return true;
+
+unpack_error:
+	xfree(ver_str);
+	error("Invalid job state journal header");
+fail:
+	_job_journal_replay_free(replay);
+	return false;
+}
+
+/*
+ * Load the last record of every job created or changed in the journal
+ * RET count of jobs loaded
+ */
+static int _job_journal_load(job_journal_replay_t *replay)
+{
+	Buf buffer = replay->buffer;
+	job_journal_last_t *last;
+	job_journal_skip_t skip;
+	uint32_t job_id, data_offset, next;
+	uint16_t type;
+	int job_cnt = 0;
+
+	set_buf_offset(buffer, replay->start);
+	while (get_buf_offset(buffer) < replay->commit_offset) {
+		(void) _job_journal_unpack(buffer, &type, &job_id, &skip,
+					   &data_offset);
+		if (type != JOB_JOURNAL_UPDATE)
+			continue;
+		last = xhash_get(replay->last, (char *) &job_id,
+				 sizeof(uint32_t));
+		if (!last || (last->offset != data_offset) ||
+		    (last->type != JOB_JOURNAL_UPDATE))
+			continue;	/* superseded later in the journal */
+
+		next = get_buf_offset(buffer);
+		set_buf_offset(buffer, data_offset);
+		if (_load_job_state(buffer, replay->protocol_version)) {
+			error("Invalid JobId=%u record in job state journal",
+			      job_id);
+		} else
+			job_cnt++;
+		set_buf_offset(buffer, next);
+	}
+
+	return job_cnt;
+}
+
+/* A run of whole job_state records, see _job_recover_stream() */
+typedef struct job_recover_chunk {
+	char *data;		/* records, each after its uint32_t size */
+	uint32_t size;
+	uint32_t offset;	/* of data in the job_state file */
+	uint32_t rec_cnt;
+	job_record_t **jobs;	/* unpacked records, NULL if none */
+	int rc;			/* SLURM_ERROR if the last record is bad */
+	bool taken;		/* being or already unpacked */
+	bool unpacked;
+	struct job_recover_chunk *next;
+} job_recover_chunk_t;
+
+/* State shared by the threads recovering the job_state file */
+typedef struct {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	job_recover_chunk_t *head;	/* chunks read and not yet installed */
+	job_recover_chunk_t *tail;
+	uint32_t chunk_cnt;
+	bool shutdown;
+	uint16_t protocol_version;
+	job_journal_replay_t *replay;	/* records superseded by the journal */
+	uint64_t unpack_usec;		/* summed over all threads */
+} job_recover_t;
+
+/* Reader state of _job_recover_read() */
+typedef struct {
+	int fd;
+	char *file;
+	uint32_t offset;	/* of the carried over bytes in the file */
+	char *carry;		/* start of a record split by the last read */
+	uint32_t carry_size;
+	bool eof;
+	uint64_t read_usec;
+} job_recover_reader_t;
+
+/*
+ * Return the number of threads to unpack job state records with, see
+ * SlurmctldParameters=state_recover_threads
+ */
+static int _job_recover_threads(void)
+{
+	char *tmp_ptr;
+	long cnt;
+
+	if ((tmp_ptr = xstrcasestr(slurmctld_conf.slurmctld_params,
+				   "state_recover_threads="))) {
+		cnt = atoi(tmp_ptr + 22);
+		if ((cnt >= 1) && (cnt <= JOB_RECOVER_MAX_THREADS))
+			return cnt;
+		error("Invalid SlurmctldParameters state_recover_threads=%ld, using default",
+		      cnt);
+	}
+
+	cnt = sysconf(_SC_NPROCESSORS_ONLN);
+	return MAX(1, MIN(cnt, JOB_RECOVER_DEF_THREADS));
+}
+
+/* Return true if the job_state record at offset was replaced by the journal */
+static bool _job_journal_superseded(job_journal_replay_t *replay,
+				    uint32_t offset)
+{
+	job_journal_skip_t key = { .offset = offset };
+
+	if (!replay || !replay->skip_cnt)
+		return false;
+	return bsearch(&key, replay->skip, replay->skip_cnt,
+		       sizeof(job_journal_skip_t), _cmp_journal_skip) != NULL;
+}
+
+/*
+ * Read the next run of whole records from the job_state file. The start of a
+ * record split by the end of a read is carried over to the next chunk.
+ * RET chunk or NULL at the end of the file
+ */
+static job_recover_chunk_t *_job_recover_read(job_recover_reader_t *reader)
+{
+	job_recover_chunk_t *chunk;
+	uint32_t alloc = JOB_RECOVER_CHUNK, used, pos, rec_size, rec_cnt;
+	ssize_t n;
+	char *data;
+	DEF_TIMERS;
+
+	if (reader->eof && !reader->carry_size)
+		return NULL;
+
+	START_TIMER;
+	alloc = MAX(alloc, reader->carry_size);
+	data = xmalloc_nz(alloc);
+	if (reader->carry_size)
+		memcpy(data, reader->carry, reader->carry_size);
+	used = reader->carry_size;
+	xfree(reader->carry);
+	reader->carry_size = 0;
+
+	while (1) {
+		while (!reader->eof && (used < alloc)) {
+			n = read(reader->fd, data + used, alloc - used);
+			if (n < 0) {
+				if (errno == EINTR)
+					continue;
+				error("Error reading file %s, %m",
+				      reader->file);
+				reader->eof = true;
+			} else if (n == 0)
+				reader->eof = true;
+			else
+				used += n;
+		}
+
+		if (!used) {
+			xfree(data);
+			return NULL;
+		}
+
+		/* Find the end of the last whole record */
+		pos = 0;
+		rec_cnt = 0;
+		rec_size = 0;
+		while ((used - pos) >= sizeof(uint32_t)) {
+			memcpy(&rec_size, data + pos, sizeof(uint32_t));
+			rec_size = ntohl(rec_size);
+			if (rec_size > (MAX_BUF_SIZE - sizeof(uint32_t)) ||
+			    ((used - pos - sizeof(uint32_t)) < rec_size))
+				break;
+			pos += sizeof(uint32_t) + rec_size;
+			rec_cnt++;
+		}
+		if (rec_cnt || reader->eof ||
+		    (rec_size > (MAX_BUF_SIZE - sizeof(uint32_t))))
+			break;
+
+		/* A single record larger than the chunk */
+		alloc = sizeof(uint32_t) + rec_size;
+		xrealloc_nz(data, alloc);
+	}
+
+	chunk = xmalloc(sizeof(job_recover_chunk_t));
+	chunk->data = data;
+	chunk->size = pos;
+	chunk->offset = reader->offset;
+	chunk->rec_cnt = rec_cnt;
+	reader->offset += pos;
+
+	if (pos < used) {
+		if (reader->eof ||
+		    (rec_size > (MAX_BUF_SIZE - sizeof(uint32_t)))) {
+			/* Stop after this chunk, like an unpack error */
+			error("Invalid job state record at offset %u of %s",
+			      reader->offset, reader->file);
+			chunk->rc = SLURM_ERROR;
+			reader->eof = true;
+		} else {
+			reader->carry_size = used - pos;
+			reader->carry = xmalloc_nz(reader->carry_size);
+			memcpy(reader->carry, data + pos, reader->carry_size);
+		}
+	}
+	END_TIMER;
+	reader->read_usec += DELTA_TIMER;
+
+	return chunk;
+}
+
+/* Unpack all records of one chunk, stopping at the first bad record */
+static void _job_recover_unpack(job_recover_t *recover,
+				job_recover_chunk_t *chunk)
+{
+	uint32_t pos = 0, rec_size, i;
+	Buf buffer;
+	int rc;
+	DEF_TIMERS;
+
+	START_TIMER;
+	chunk->jobs = xcalloc(MAX(chunk->rec_cnt, 1), sizeof(job_record_t *));
+	for (i = 0; i < chunk->rec_cnt; i++) {
+		memcpy(&rec_size, chunk->data + pos, sizeof(uint32_t));
+		rec_size = ntohl(rec_size);
+		if (_job_journal_superseded(recover->replay,
+					    chunk->offset + pos)) {
+			pos += sizeof(uint32_t) + rec_size;
+			continue;
+		}
+		pos += sizeof(uint32_t);
+		buffer = create_buf(chunk->data + pos, rec_size);
+		rc = _unpack_job_state(buffer, recover->protocol_version,
+				       &chunk->jobs[i]);
+		(void) xfer_buf_data(buffer);	/* data belongs to chunk */
+		if (rc != SLURM_SUCCESS) {
+			chunk->rc = rc;
+			break;
+		}
+		pos += rec_size;
+	}
+	END_TIMER;
+
+	slurm_mutex_lock(&recover->mutex);
+	recover->unpack_usec += DELTA_TIMER;
+	slurm_mutex_unlock(&recover->mutex);
+}
+
+/*
+ * Take the first chunk not yet being unpacked, unpack it and wake the thread
+ * waiting to install it.
+ * Call with recover->mutex locked.
+ * RET true if a chunk was unpacked
+ */
+static bool _job_recover_unpack_next(job_recover_t *recover)
+{
+	job_recover_chunk_t *chunk;
+
+	for (chunk = recover->head; chunk; chunk = chunk->next) {
+		if (!chunk->taken)
+			break;
+	}
+	if (!chunk)
+		return false;
+
+	chunk->taken = true;
+	slurm_mutex_unlock(&recover->mutex);
+	_job_recover_unpack(recover, chunk);
+	slurm_mutex_lock(&recover->mutex);
+	chunk->unpacked = true;
+	slurm_cond_broadcast(&recover->cond);
+
+	return true;
+}
+
+static void *_job_recover_thread(void *arg)
+{
+	job_recover_t *recover = arg;
+
+	slurm_mutex_lock(&recover->mutex);
+	while (!recover->shutdown) {
+		if (!_job_recover_unpack_next(recover))
+			slurm_cond_wait(&recover->cond, &recover->mutex);
+	}
+	slurm_mutex_unlock(&recover->mutex);
+
+	return NULL;
+}
+
+static void _job_recover_chunk_free(job_recover_chunk_t *chunk)
+{
+	uint32_t i;
+
+	if (chunk->jobs) {
+		for (i = 0; i < chunk->rec_cnt; i++) {
+			if (chunk->jobs[i])
+				_free_job_record(chunk->jobs[i]);
+		}
+		xfree(chunk->jobs);
+	}
+	xfree(chunk->data);
+	xfree(chunk);
+}
+
+/*
+ * Recover the job records of a job_state file written with
+ * JOB_STATE_SIZED_VERSION. The file is read in chunks by this thread while
+ * other threads unpack earlier chunks, and the unpacked records are added to
+ * the job list in file order.
+ * IN state_file - job_state file
+ * IN offset - offset of the first record in the file
+ * IN protocol_version - of the records
+ * IN replay - journal of the file, records it supersedes are skipped
+ * OUT job_cnt - number of jobs recovered
+ * RET SLURM_SUCCESS or SLURM_ERROR if a record is invalid
+ */
+static int _job_recover_stream(char *state_file, uint32_t offset,
+			       uint16_t protocol_version,
+			       job_journal_replay_t *replay, int *job_cnt)
+{
+	job_recover_t recover;
+	job_recover_reader_t reader;
+	job_recover_chunk_t *chunk;
+	pthread_t *threads;
+	int thread_cnt, i, rc = SLURM_SUCCESS;
+	uint64_t install_usec = 0, wait_usec = 0;
+	DEF_TIMERS;
+
+	memset(&reader, 0, sizeof(reader));
+	reader.file = state_file;
+	reader.offset = offset;
+	if ((reader.fd = open(state_file, O_RDONLY | O_CLOEXEC)) < 0) {
+		error("Could not open job state file %s: %m", state_file);
+		return SLURM_ERROR;
+	}
+	if (lseek(reader.fd, offset, SEEK_SET) < 0) {
+		error("Could not seek job state file %s: %m", state_file);
+		close(reader.fd);
+		return SLURM_ERROR;
+	}
+
+	memset(&recover, 0, sizeof(recover));
+	slurm_mutex_init(&recover.mutex);
+	slurm_cond_init(&recover.cond, NULL);
+	recover.protocol_version = protocol_version;
+	recover.replay = replay;
+
+	/* This thread reads, installs and unpacks when it would wait */
+	thread_cnt = _job_recover_threads();
+	threads = xcalloc(thread_cnt, sizeof(pthread_t));
+	for (i = 1; i < thread_cnt; i++)
+		slurm_thread_create(&threads[i], _job_recover_thread, &recover);
+
+	while (1) {
+		/* Read ahead by up to two chunks per thread */
+		while (!reader.eof && (recover.chunk_cnt < (thread_cnt * 2))) {
+			if (!(chunk = _job_recover_read(&reader)))
+				break;
+			slurm_mutex_lock(&recover.mutex);
+			if (recover.tail)
+				recover.tail->next = chunk;
+			else
+				recover.head = chunk;
+			recover.tail = chunk;
+			recover.chunk_cnt++;
+			slurm_cond_broadcast(&recover.cond);
+			slurm_mutex_unlock(&recover.mutex);
+		}
+
+		slurm_mutex_lock(&recover.mutex);
+		if (!(chunk = recover.head)) {
+			slurm_mutex_unlock(&recover.mutex);
+			break;
+		}
+		if (!chunk->unpacked) {
+			START_TIMER;
+			if (!_job_recover_unpack_next(&recover))
+				slurm_cond_wait(&recover.cond, &recover.mutex);
+			END_TIMER;
+			wait_usec += DELTA_TIMER;
+			slurm_mutex_unlock(&recover.mutex);
+			continue;
+		}
+		if (!(recover.head = chunk->next))
+			recover.tail = NULL;
+		recover.chunk_cnt--;
+		slurm_mutex_unlock(&recover.mutex);
+
+		START_TIMER;
+		for (i = 0; i < chunk->rec_cnt; i++) {
+			if (!chunk->jobs[i])
+				continue;
+			if (_install_job_state(chunk->jobs[i]) ==
+			    SLURM_SUCCESS)
+				(*job_cnt)++;
+			chunk->jobs[i] = NULL;
+		}
+		END_TIMER;
+		install_usec += DELTA_TIMER;
+		rc = chunk->rc;
+		_job_recover_chunk_free(chunk);
+		if (rc != SLURM_SUCCESS)
+			break;
+	}
+
+	slurm_mutex_lock(&recover.mutex);
+	recover.shutdown = true;
+	slurm_cond_broadcast(&recover.cond);
+	slurm_mutex_unlock(&recover.mutex);
+	for (i = 1; i < thread_cnt; i++)
+		pthread_join(threads[i], NULL);
+	xfree(threads);
+
+	while ((chunk = recover.head)) {
+		recover.head = chunk->next;
+		_job_recover_chunk_free(chunk);
+	}
+	slurm_mutex_destroy(&recover.mutex);
+	slurm_cond_destroy(&recover.cond);
+	xfree(reader.carry);
+	close(reader.fd);
+
+	info("Recovered %d jobs from %s with %d threads: read=%"PRIu64"us unpack=%"PRIu64"us install=%"PRIu64"us wait=%"PRIu64"us",
+	     *job_cnt, state_file, thread_cnt, reader.read_usec,
+	     recover.unpack_usec, install_usec, wait_usec);
+
+	return rc;
+}
+
 /*
  * dump_all_job_state - save the state of all jobs to file for checkpoint
  *	Changes here should be reflected in load_last_job_id() and
@@ -807,15 +1776,17 @@ int dump_all_job_state(void)
 {
 	/* Save high-water mark to avoid buffer growth with copies */
 	static int high_buffer_size = (1024 * 1024);
-	int error_code = SLURM_SUCCESS, log_fd;
-	char *old_file, *new_file, *reg_file;
-	struct stat stat_buf;
+	int error_code = SLURM_SUCCESS;
 	/* Locks: Read config and job */
 	slurmctld_lock_t job_read_lock =
 		{ READ_LOCK, READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK };
 	ListIterator job_iterator;
 	job_record_t *job_ptr;
-	Buf buffer = init_buf(high_buffer_size);
+	job_journal_rec_t *rec;
+	xhash_t *new_journal = NULL;
+	Buf buffer;
+	uint32_t offset, rec_size;
+	bool sized;
 	time_t now = time(NULL);
 	time_t last_state_file_time;
 	DEF_TIMERS;
@@ -840,9 +1811,46 @@ int dump_all_job_state(void)
 		}
 	}
 
+	lock_slurmctld(job_read_lock);
+	if (xstrcasestr(slurmctld_conf.slurmctld_params, "state_journal")) {
+		if (job_journal && !job_journal_failed &&
+		    last_file_write_time && !_job_journal_compact_due()) {
+			/* Only append changed and removed jobs */
+			buffer = _job_journal_build();
+			unlock_slurmctld(job_read_lock);
+			if (buffer) {
+				lock_state_files();
+				error_code = _job_journal_append(buffer);
+				unlock_state_files();
+				free_buf(buffer);
+			}
+			END_TIMER2("dump_all_job_state");
+			return error_code;
+		}
+		/*
+		 * Rewrite job_state from job_list, which also saves any job
+		 * changes made without job_record_changed()
+		 */
+		new_journal = xhash_init(_job_journal_rec_id, xfree_ptr);
+	}
+	/* The complete file covers all jobs removed so far */
+	job_journal_purge_cnt = 0;
+
+	/*
+	 * Sized records can't be read by an earlier slurmctld, so only write
+	 * them if asked to or if the journal needs their offsets
+	 */
+	sized = new_journal ||
+		xstrcasestr(slurmctld_conf.slurmctld_params,
+			    "state_sized_records");
+
 	/* write header: version, time */
-	packstr(JOB_STATE_VERSION, buffer);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	buffer = init_buf(high_buffer_size);
+	if (sized)
+		packstr(JOB_STATE_SIZED_VERSION, buffer);
+	else
+		packstr(JOB_STATE_VERSION, buffer);
+	pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
 	pack_time(now, buffer);
 
 	/*
@@ -855,86 +1863,57 @@ int dump_all_job_state(void)
 	debug3("Writing job id %u to header record of job_state file",
 	       job_id_sequence);
 
-	/* write individual job records */
-	lock_slurmctld(job_read_lock);
+	/*
+	 * write individual job records, if sized each after its size so that
+	 * they can be unpacked in parallel by load_all_job_state()
+	 */
 	job_iterator = list_iterator_create(job_list);
 	while ((job_ptr = list_next(job_iterator))) {
+		if (!sized) {
+			_dump_job_state(job_ptr, buffer);
+			job_ptr->state_saved = true;
+			continue;
+		}
+		offset = get_buf_offset(buffer);
+		pack32(0, buffer);
 		_dump_job_state(job_ptr, buffer);
+		rec_size = get_buf_offset(buffer) - offset - sizeof(uint32_t);
+		set_buf_offset(buffer, offset);
+		if (!rec_size)
+			continue;	/* unlinked job */
+		pack32(rec_size, buffer);
+		set_buf_offset(buffer, offset + sizeof(uint32_t) + rec_size);
+		job_ptr->state_saved = true;
+		if (!new_journal)
+			continue;
+		/* Remember the record for journaling later changes */
+		rec = xmalloc(sizeof(job_journal_rec_t));
+		rec->job_id = job_ptr->job_id;
+		rec->snap_offset = offset;
+		rec->snap_size = sizeof(uint32_t) + rec_size;
+		xhash_add(new_journal, rec);
 	}
 	list_iterator_destroy(job_iterator);
-
-
-	/* write the buffer to file */
-	old_file = xstrdup(slurmctld_conf.state_save_location);
-	xstrcat(old_file, "/job_state.old");
-	reg_file = xstrdup(slurmctld_conf.state_save_location);
-	xstrcat(reg_file, "/job_state");
-	new_file = xstrdup(slurmctld_conf.state_save_location);
-	xstrcat(new_file, "/job_state.new");
 	unlock_slurmctld(job_read_lock);
 
-	if (stat(reg_file, &stat_buf) == 0) {
-		static time_t last_mtime = (time_t) 0;
-		int delta_t = difftime(stat_buf.st_mtime, last_mtime);
-		if (delta_t < -10) {
-			error("The modification time of %s moved backwards "
-			      "by %d seconds",
-			      reg_file, (0-delta_t));
-			error("The clock of the file system and this computer "
-			      "appear to not be synchronized");
-			/* It could be safest to exit here. We likely mounted
-			 * a different file system with the state save files */
-		}
-		last_mtime = time(NULL);
-	}
-
+	/* write the buffer to file */
+	high_buffer_size = MAX(get_buf_offset(buffer), high_buffer_size);
 	lock_state_files();
-	log_fd = open(new_file, O_CREAT|O_WRONLY|O_TRUNC|O_CLOEXEC, 0600);
-	if (log_fd < 0) {
-		error("Can't save state, create file %s error %m",
-		      new_file);
-		error_code = errno;
+	error_code = _job_state_write(buffer, now);
+	if (error_code) {
+		/* Jobs were marked saved, so don't journal on this file */
+		job_journal_failed = true;
 	} else {
-		int pos = 0, nwrite, amount, rc;
-		char *data;
-
-		nwrite = get_buf_offset(buffer);
-		data = (char *)get_buf_data(buffer);
-		high_buffer_size = MAX(nwrite, high_buffer_size);
-		while (nwrite > 0) {
-			amount = write(log_fd, &data[pos], nwrite);
-			if ((amount < 0) && (errno != EINTR)) {
-				error("Error writing file %s, %m", new_file);
-				error_code = errno;
-				break;
-			}
-			nwrite -= amount;
-			pos    += amount;
+		_job_journal_reset();
+		if (new_journal) {
+			job_journal = new_journal;
+			new_journal = NULL;
+			job_journal_snap_size = get_buf_offset(buffer);
 		}
-
-		rc = fsync_and_close(log_fd, "job");
-		if (rc && !error_code)
-			error_code = rc;
-	}
-	if (error_code)
-		(void) unlink(new_file);
-	else {			/* file shuffle */
-		(void) unlink(old_file);
-		if (link(reg_file, old_file))
-			debug4("unable to create link for %s -> %s: %m",
-			       reg_file, old_file);
-		(void) unlink(reg_file);
-		if (link(new_file, reg_file))
-			debug4("unable to create link for %s -> %s: %m",
-			       new_file, reg_file);
-		(void) unlink(new_file);
-		last_file_write_time = now;
 	}
-	xfree(old_file);
-	xfree(reg_file);
-	xfree(new_file);
 	unlock_state_files();
 
+	xhash_free(new_journal);
 	free_buf(buffer);
 	END_TIMER2("dump_all_job_state");
 	return error_code;
@@ -1004,6 +1983,7 @@ extern void set_job_failed_assoc_qos_ptr(job_record_t *job_ptr)
 			job_ptr->state_reason = WAIT_NO_REASON;
 			xfree(job_ptr->state_desc);
 			last_job_update = time(NULL);
+			job_record_changed(job_ptr);
 		}
 	}
 
@@ -1023,6 +2003,7 @@ extern void set_job_failed_assoc_qos_ptr(job_record_t *job_ptr)
 			job_ptr->state_reason = WAIT_NO_REASON;
 			xfree(job_ptr->state_desc);
 			last_job_update = time(NULL);
+			job_record_changed(job_ptr);
 		}
 	}
 }
@@ -1076,6 +2057,18 @@ extern void backup_slurmctld_restart(void)
 	last_file_write_time = (time_t) 0;
 }
 
+/*
+ * Return true if ver_str is a job_state file version string we can read
+ * OUT sized - set if each job record follows its size, optional
+ */
+static bool _job_state_version(char *ver_str, bool *sized)
+{
+	if (sized)
+		*sized = !xstrcmp(ver_str, JOB_STATE_SIZED_VERSION);
+	return (!xstrcmp(ver_str, JOB_STATE_VERSION) ||
+		!xstrcmp(ver_str, JOB_STATE_SIZED_VERSION));
+}
+
 /* Return the time stamp in the current job state save file, 0 is returned on
  * error */
 static time_t _get_last_job_state_write_time(void)
@@ -1098,7 +2091,7 @@ static time_t _get_last_job_state_write_time(void)
 		return buf_time;
 
 	safe_unpackstr_xmalloc(&ver_str, &ver_str_len, buffer);
-	if (ver_str && !xstrcmp(ver_str, JOB_STATE_VERSION))
+	if (_job_state_version(ver_str, NULL))
 		safe_unpack16(&protocol_version, buffer);
 	safe_unpack_time(&buf_time, buffer);
 
@@ -1117,7 +2110,10 @@ unpack_error:
 extern int load_all_job_state(void)
 {
 	int error_code = SLURM_SUCCESS;
-	int job_cnt = 0;
+	int job_cnt = 0, journal_cnt;
+	job_journal_replay_t replay;
+	bool journal = false, sized = false;
+	uint32_t skip_inx = 0, header_len;
 	char *state_file = NULL;
 	Buf buffer;
 	time_t buf_time;
@@ -1125,6 +2121,7 @@ extern int load_all_job_state(void)
 	char *ver_str = NULL;
 	uint32_t ver_str_len;
 	uint16_t protocol_version = NO_VAL16;
+	DEF_TIMERS;
 
 	/* read the file */
 	lock_state_files();
@@ -1134,14 +2131,13 @@ extern int load_all_job_state(void)
 		unlock_state_files();
 		return ENOENT;
 	}
-	xfree(state_file);
 	unlock_state_files();
 
 	job_id_sequence = MAX(job_id_sequence, slurmctld_conf.first_job_id);
 
 	safe_unpackstr_xmalloc(&ver_str, &ver_str_len, buffer);
 	debug3("Version string in job_state header is %s", ver_str);
-	if (ver_str && !xstrcmp(ver_str, JOB_STATE_VERSION))
+	if (_job_state_version(ver_str, &sized))
 		safe_unpack16(&protocol_version, buffer);
 	xfree(ver_str);
 
@@ -1151,6 +2147,7 @@ extern int load_all_job_state(void)
 		error("***********************************************");
 		error("Can not recover job state, incompatible version");
 		error("***********************************************");
+		xfree(state_file);
 		free_buf(buffer);
 		return EFAULT;
 	}
@@ -1160,6 +2157,11 @@ extern int load_all_job_state(void)
 	if (saved_job_id <= slurmctld_conf.max_job_id)
 		job_id_sequence = MAX(saved_job_id, job_id_sequence);
 	debug3("Job id in job_state header is %u", saved_job_id);
+	header_len = get_buf_offset(buffer);
+
+	/* Jobs changed after job_state was written are in the journal */
+	_job_journal_reset();
+	journal = _job_journal_read(buf_time, &replay);
 
 	/*
 	 * Previously we locked the tres read lock before this loop.  It turned
@@ -1168,23 +2170,62 @@ extern int load_all_job_state(void)
 	 * It ended up being much easier to move the locks for the assoc_mgr
 	 * into the _load_job_state function than any other option.
 	 */
-	while (remaining_buf(buffer) > 0) {
+	if (sized) {
+		/* Records are unpacked in parallel, see _job_recover_stream */
+		free_buf(buffer);
+		buffer = NULL;
+		error_code = _job_recover_stream(state_file, header_len,
+						 protocol_version,
+						 journal ? &replay : NULL,
+						 &job_cnt);
+		if (error_code != SLURM_SUCCESS)
+			goto unpack_error;
+	}
+	while (buffer && (remaining_buf(buffer) > 0)) {
+		while (journal && (skip_inx < replay.skip_cnt) &&
+		       (replay.skip[skip_inx].offset < get_buf_offset(buffer)))
+			skip_inx++;
+		if (journal && (skip_inx < replay.skip_cnt) &&
+		    (replay.skip[skip_inx].offset == get_buf_offset(buffer))) {
+			/* Superseded by the journal */
+			set_buf_offset(buffer, replay.skip[skip_inx].offset +
+					       replay.skip[skip_inx].size);
+			skip_inx++;
+			continue;
+		}
 		error_code = _load_job_state(buffer, protocol_version);
 		if (error_code != SLURM_SUCCESS)
 			goto unpack_error;
 		job_cnt++;
 	}
+	if (journal) {
+		START_TIMER;
+		journal_cnt = _job_journal_load(&replay);
+		if ((replay.job_id_sequence != NO_VAL) &&
+		    (replay.job_id_sequence <= slurmctld_conf.max_job_id))
+			job_id_sequence = MAX(replay.job_id_sequence,
+					      job_id_sequence);
+		_job_journal_replay_free(&replay);
+		END_TIMER;
+		info("Recovered %d job records from job state journal %s",
+		     journal_cnt, TIME_STR);
+		job_cnt += journal_cnt;
+	}
 	debug3("Set job_id_sequence to %u", job_id_sequence);
 
+	xfree(state_file);
 	free_buf(buffer);
 	info("Recovered information about %d jobs", job_cnt);
 	return error_code;
 
 unpack_error:
+	if (journal)
+		_job_journal_replay_free(&replay);
 	if (!ignore_state_errors)
 		fatal("Incomplete job state save file, start with '-i' to ignore this. Warning: using -i will lose the data that can't be recovered.");
 	error("Incomplete job state save file");
 	info("Recovered information about %d jobs", job_cnt);
+	xfree(state_file);
 	free_buf(buffer);
 	return SLURM_ERROR;
 }
@@ -1196,6 +2237,7 @@ unpack_error:
  */
 extern int load_last_job_id( void )
 {
+	job_journal_replay_t replay;
 	char *state_file = NULL;
 	Buf buffer;
 	time_t buf_time;
@@ -1216,7 +2258,7 @@ extern int load_last_job_id( void )
 
 	safe_unpackstr_xmalloc(&ver_str, &ver_str_len, buffer);
 	debug3("Version string in job_state header is %s", ver_str);
-	if (ver_str && !xstrcmp(ver_str, JOB_STATE_VERSION))
+	if (_job_state_version(ver_str, NULL))
 		safe_unpack16(&protocol_version, buffer);
 	xfree(ver_str);
 
@@ -1234,6 +2276,12 @@ extern int load_last_job_id( void )
 	safe_unpack32( &job_id_sequence, buffer);
 	debug3("Job ID in job_state header is %u", job_id_sequence);
 
+	if (_job_journal_read(buf_time, &replay)) {
+		if (replay.job_id_sequence != NO_VAL)
+			job_id_sequence = replay.job_id_sequence;
+		_job_journal_replay_free(&replay);
+	}
+
 	/* Ignore the state for individual jobs stored here */
 
 	xfree(ver_str);
@@ -1386,7 +2434,7 @@ static void _dump_job_state(job_record_t *dump_job_ptr, Buf buffer)
 	pack16(dump_job_ptr->warn_time, buffer);
 
 	_pack_acct_policy_limit(&dump_job_ptr->limit_set, buffer,
-				SLURM_PROTOCOL_VERSION);
+				SLURM_STATE_PROTOCOL_VERSION);
 
 	packstr(dump_job_ptr->state_desc, buffer);
 	packstr(dump_job_ptr->resp_host, buffer);
@@ -1427,16 +2475,16 @@ static void _dump_job_state(job_record_t *dump_job_ptr, Buf buffer)
 	packstr(dump_job_ptr->system_comment, buffer);
 
 	select_g_select_jobinfo_pack(dump_job_ptr->select_jobinfo,
-				     buffer, SLURM_PROTOCOL_VERSION);
+				     buffer, SLURM_STATE_PROTOCOL_VERSION);
 	pack_job_resources(dump_job_ptr->job_resrcs, buffer,
-			   SLURM_PROTOCOL_VERSION);
+			   SLURM_STATE_PROTOCOL_VERSION);
 
 	packstr_array(dump_job_ptr->spank_job_env,
 		      dump_job_ptr->spank_job_env_size, buffer);
 
 	(void) gres_plugin_job_state_pack(dump_job_ptr->gres_list, buffer,
 					  dump_job_ptr->job_id, true,
-					  SLURM_PROTOCOL_VERSION);
+					  SLURM_STATE_PROTOCOL_VERSION);
 
 	/* Dump job details, if available */
 	detail_ptr = dump_job_ptr->details;
@@ -1472,10 +2520,17 @@ static void _dump_job_state(job_record_t *dump_job_ptr, Buf buffer)
 	packstr(dump_job_ptr->tres_per_task, buffer);
 }
 
-/* Unpack a job's state information from a buffer */
-/* NOTE: assoc_mgr qos, tres and assoc read lock must be unlocked before
- * calling */
-static int _load_job_state(Buf buffer, uint16_t protocol_version)
+/*
+ * _unpack_job_state - unpack a job's state information from a buffer into a
+ *	new record, not yet in the job list or hash tables. Nothing but the
+ *	record itself is modified, so several records may be unpacked at once.
+ * OUT job_pptr - the job record, NULL for an unlinked job, add to the job
+ *	list with _install_job_state()
+ * NOTE: assoc_mgr qos, tres and assoc read lock must be unlocked before
+ *	calling
+ */
+static int _unpack_job_state(Buf buffer, uint16_t protocol_version,
+			     job_record_t **job_pptr)
 {
 	uint64_t db_index;
 	uint32_t job_id, user_id, group_id, time_limit, priority, alloc_sid;
@@ -1517,22 +2572,15 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 	List gres_list = NULL, part_ptr_list = NULL;
 	job_record_t *job_ptr = NULL;
 	part_record_t *part_ptr;
-	int error_code, i, qos_error, rc;
+	int error_code, i, rc;
 	dynamic_plugin_data_t *select_jobinfo = NULL;
 	job_resources_t *job_resources = NULL;
-	slurmdb_assoc_rec_t assoc_rec;
-	slurmdb_qos_rec_t qos_rec;
-	bool job_finished = false;
 	double billable_tres = (double)NO_VAL;
 	char *tres_alloc_str = NULL, *tres_fmt_alloc_str = NULL,
 		*tres_req_str = NULL, *tres_fmt_req_str = NULL;
 	uint32_t pelog_env_size = 0;
 	char **pelog_env = (char **) NULL;
 	job_fed_details_t *job_fed_details = NULL;
-	assoc_mgr_lock_t locks = { .assoc = READ_LOCK,
-				   .qos = READ_LOCK,
-				   .tres = READ_LOCK,
-				   .user = READ_LOCK };
 
 	memset(&limit_set, 0, sizeof(limit_set));
 	limit_set.tres = xcalloc(slurmctld_tres_cnt, sizeof(uint16_t));
@@ -1567,18 +2615,10 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 			goto unpack_error;
 		}
 
-		job_ptr = find_job_record(job_id);
-		if (job_ptr == NULL) {
-			job_ptr = _create_job_record(1);
-			if (!job_ptr) {
-				error("Create job entry failed for JobId=%u",
-				      job_id);
-				goto unpack_error;
-			}
-			job_ptr->job_id = job_id;
-			job_ptr->array_job_id = array_job_id;
-			job_ptr->array_task_id = array_task_id;
-		}
+		job_ptr = _alloc_job_record();
+		job_ptr->job_id = job_id;
+		job_ptr->array_job_id = array_job_id;
+		job_ptr->array_task_id = array_task_id;
 
 		safe_unpack32(&user_id, buffer);
 		safe_unpack32(&group_id, buffer);
@@ -1793,18 +2833,10 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 			goto unpack_error;
 		}
 
-		job_ptr = find_job_record(job_id);
-		if (job_ptr == NULL) {
-			job_ptr = _create_job_record(1);
-			if (!job_ptr) {
-				error("Create job entry failed for JobId=%u",
-				      job_id);
-				goto unpack_error;
-			}
-			job_ptr->job_id = job_id;
-			job_ptr->array_job_id = array_job_id;
-			job_ptr->array_task_id = array_task_id;
-		}
+		job_ptr = _alloc_job_record();
+		job_ptr->job_id = job_id;
+		job_ptr->array_job_id = array_job_id;
+		job_ptr->array_task_id = array_task_id;
 
 		safe_unpack32(&user_id, buffer);
 		safe_unpack32(&group_id, buffer);
@@ -2036,18 +3068,10 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 			goto unpack_error;
 		}
 
-		job_ptr = find_job_record(job_id);
-		if (job_ptr == NULL) {
-			job_ptr = _create_job_record(1);
-			if (!job_ptr) {
-				error("Create job entry failed for JobId=%u",
-				      job_id);
-				goto unpack_error;
-			}
-			job_ptr->job_id = job_id;
-			job_ptr->array_job_id = array_job_id;
-			job_ptr->array_task_id = array_task_id;
-		}
+		job_ptr = _alloc_job_record();
+		job_ptr->job_id = job_id;
+		job_ptr->array_job_id = array_job_id;
+		job_ptr->array_task_id = array_task_id;
 
 		safe_unpack32(&user_id, buffer);
 		safe_unpack32(&group_id, buffer);
@@ -2266,11 +3290,6 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 		goto unpack_error;
 	}
 
-	if ((priority > 1) && (direct_set_prio == 0)) {
-		highest_prio = MAX(highest_prio, priority);
-		lowest_prio  = MIN(lowest_prio,  priority);
-	}
-
 #if 0
 	/*
 	 * This is not necessary since the job_id_sequence is checkpointed and
@@ -2355,6 +3374,7 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 	job_ptr->end_time     = end_time;
 	job_ptr->exit_code    = exit_code;
 	job_ptr->group_id     = group_id;
+	/* Not yet linked, _install_job_state() notifies dependent jobs */
 	job_ptr->job_state    = job_state;
 	job_ptr->kill_on_node_fail = kill_on_node_fail;
 	xfree(job_ptr->licenses);
@@ -2446,8 +3466,6 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 				bit_set_count(job_ptr->array_recs->
 					      task_id_bitmap);
 
-			if (job_ptr->array_recs->task_cnt > 1)
-				job_count += (job_ptr->array_recs->task_cnt-1);
 		} else
 			xfree(task_id_str);
 		job_ptr->array_recs->array_flags    = array_flags;
@@ -2492,9 +3510,102 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 	 */
 	job_ptr->best_switch     = true;
 	job_ptr->start_protocol_ver = start_protocol_ver;
+	job_ptr->clusters     = clusters;
+	job_ptr->fed_details  = job_fed_details;
+
+	*job_pptr = job_ptr;
+	return SLURM_SUCCESS;
+
+unpack_error:
+	error("Incomplete job record");
+	rc = SLURM_ERROR;
+
+free_it:
+	xfree(alloc_node);
+	xfree(account);
+	xfree(admin_comment);
+	xfree(batch_features);
+	xfree(batch_host);
+	xfree(burst_buffer);
+	xfree(clusters);
+	xfree(comment);
+	xfree(gres_alloc);
+	xfree(gres_req);
+	xfree(gres_used);
+	xfree(het_job_id_set);
+	free_job_fed_details(&job_fed_details);
+	free_job_resources(&job_resources);
+	xfree(resp_host);
+	xfree(licenses);
+	xfree(limit_set.tres);
+	xfree(mail_user);
+	xfree(mcs_label);
+	xfree(name);
+	xfree(nodes);
+	xfree(nodes_completing);
+	xfree(partition);
+	FREE_NULL_LIST(part_ptr_list);
+	xfree(resv_name);
+	for (i = 0; i < spank_job_env_size; i++)
+		xfree(spank_job_env[i]);
+	xfree(spank_job_env);
+	xfree(state_desc);
+	xfree(system_comment);
+	xfree(task_id_str);
+	xfree(tres_alloc_str);
+	xfree(tres_fmt_alloc_str);
+	xfree(tres_fmt_req_str);
+	xfree(tres_req_str);
+	xfree(user_name);
+	xfree(wckey);
+	select_g_select_jobinfo_free(select_jobinfo);
+	if (job_ptr)
+		_free_job_record(job_ptr);
+	for (i = 0; i < pelog_env_size; i++)
+		xfree(pelog_env[i]);
+	xfree(pelog_env);
+
+	return rc;
+}
+
+/*
+ * _install_job_state - add a job record from _unpack_job_state() to the job
+ *	list and hash tables and validate its association and QOS
+ * RET SLURM_SUCCESS or ESLURM_DUPLICATE_JOB_ID if the job was already
+ *	recovered, in which case the record is freed
+ */
+static int _install_job_state(job_record_t *job_ptr)
+{
+	slurmdb_assoc_rec_t assoc_rec;
+	slurmdb_qos_rec_t qos_rec;
+	bool job_finished = false;
+	uint32_t job_cnt = 1;
+	int qos_error;
+	assoc_mgr_lock_t locks = { .assoc = READ_LOCK,
+				   .qos = READ_LOCK,
+				   .tres = READ_LOCK,
+				   .user = READ_LOCK };
+
+	if (find_job_record(job_ptr->job_id)) {
+		error("Ignoring duplicate record for JobId=%u",
+		      job_ptr->job_id);
+		_free_job_record(job_ptr);
+		return ESLURM_DUPLICATE_JOB_ID;
+	}
+
+	if (job_ptr->array_recs && (job_ptr->array_recs->task_cnt > 1))
+		job_cnt = job_ptr->array_recs->task_cnt;
+	_link_job_record(job_ptr, job_cnt);
+
+	if ((job_ptr->priority > 1) && (job_ptr->direct_set_prio == 0)) {
+		highest_prio = MAX(highest_prio, job_ptr->priority);
+		lowest_prio  = MIN(lowest_prio,  job_ptr->priority);
+	}
 
 	_add_job_hash(job_ptr);
 	_add_job_array_hash(job_ptr);
+	depend_graph_notify(job_ptr);
+	recover_job_steps(job_ptr);
 
 	memset(&assoc_rec, 0, sizeof(assoc_rec));
 
@@ -2595,61 +3706,21 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 			       &job_ptr->gres_detail_cnt,
 			       &job_ptr->gres_detail_str,
 			       &job_ptr->gres_used);
-	job_ptr->clusters     = clusters;
-	job_ptr->fed_details  = job_fed_details;
 	return SLURM_SUCCESS;
+}
 
-unpack_error:
-	error("Incomplete job record");
-	rc = SLURM_ERROR;
+/*
+ * _load_job_state - unpack one job record and add it to the job list
+ * RET SLURM_SUCCESS unless the record could not be unpacked
+ */
+static int _load_job_state(Buf buffer, uint16_t protocol_version)
+{
+	job_record_t *job_ptr = NULL;
+	int rc;
 
-free_it:
-	xfree(alloc_node);
-	xfree(account);
-	xfree(admin_comment);
-	xfree(batch_features);
-	xfree(batch_host);
-	xfree(burst_buffer);
-	xfree(clusters);
-	xfree(comment);
-	xfree(gres_alloc);
-	xfree(gres_req);
-	xfree(gres_used);
-	xfree(het_job_id_set);
-	free_job_fed_details(&job_fed_details);
-	free_job_resources(&job_resources);
-	xfree(resp_host);
-	xfree(licenses);
-	xfree(limit_set.tres);
-	xfree(mail_user);
-	xfree(mcs_label);
-	xfree(name);
-	xfree(nodes);
-	xfree(nodes_completing);
-	xfree(partition);
-	FREE_NULL_LIST(part_ptr_list);
-	xfree(resv_name);
-	for (i = 0; i < spank_job_env_size; i++)
-		xfree(spank_job_env[i]);
-	xfree(spank_job_env);
-	xfree(state_desc);
-	xfree(system_comment);
-	xfree(task_id_str);
-	xfree(tres_alloc_str);
-	xfree(tres_fmt_alloc_str);
-	xfree(tres_fmt_req_str);
-	xfree(tres_req_str);
-	xfree(user_name);
-	xfree(wckey);
-	select_g_select_jobinfo_free(select_jobinfo);
-	if (job_ptr) {
-		if (job_ptr->job_id == 0)
-			job_ptr->job_id = NO_VAL;
-		purge_job_record(job_ptr->job_id);
-	}
-	for (i = 0; i < pelog_env_size; i++)
-		xfree(pelog_env[i]);
-	xfree(pelog_env);
+	rc = _unpack_job_state(buffer, protocol_version, &job_ptr);
+	if ((rc == SLURM_SUCCESS) && job_ptr)
+		(void) _install_job_state(job_ptr);
 
 	return rc;
 }
@@ -2718,7 +3789,8 @@ void _dump_job_details(struct job_details *detail_ptr, Buf buffer)
 	packstr(detail_ptr->exc_nodes,  buffer);
 	packstr(detail_ptr->features,   buffer);
 	packstr(detail_ptr->cluster_features, buffer);
-	pack_dep_list(detail_ptr->depend_list, buffer, SLURM_PROTOCOL_VERSION);
+	pack_dep_list(detail_ptr->depend_list, buffer,
+		      SLURM_STATE_PROTOCOL_VERSION);
 	packstr(detail_ptr->dependency, buffer);
 	packstr(detail_ptr->orig_dependency, buffer);	/* subject to change */
 
@@ -2728,7 +3800,7 @@ void _dump_job_details(struct job_details *detail_ptr, Buf buffer)
 	packstr(detail_ptr->work_dir,  buffer);
 
 	pack_multi_core_data(detail_ptr->mc_ptr, buffer,
-			     SLURM_PROTOCOL_VERSION);
+			     SLURM_STATE_PROTOCOL_VERSION);
 	packstr_array(detail_ptr->argv, detail_ptr->argc, buffer);
 	packstr_array(detail_ptr->env_sup, detail_ptr->env_cnt, buffer);
 }
@@ -3021,6 +4093,106 @@ static void _add_job_hash(job_record_t *job_ptr)
 	job_hash[inx] = job_ptr;
 }
 
+static void _job_array_index_id(void *item, const char **key,
+				uint32_t *key_len)
+{
+	job_array_index_t *index = item;
+
+	*key = (const char *) &index->array_job_id;
+	*key_len = sizeof(uint32_t);
+}
+
+/* Add (incr=1) or remove (incr=-1) one job state from an index's counts */
+static void _job_array_index_count(job_array_index_t *index, uint32_t state,
+				   int incr)
+{
+	uint32_t base = state & JOB_STATE_BASE;
+
+	index->member_cnt += incr;
+	if (base == JOB_PENDING)
+		index->pending_cnt += incr;
+	if (base == JOB_COMPLETE)
+		index->complete_cnt += incr;
+	if (base > JOB_SUSPENDED) {
+		index->finished_cnt += incr;
+		if (!(state & JOB_COMPLETING))
+			index->completed_cnt += incr;
+	}
+}
+
+/* Add a job array task's record to its job array's index */
+static void _job_array_index_add(job_record_t *job_ptr)
+{
+	job_array_index_t *index;
+
+	if (job_ptr->array_index) {
+		error("%s: %pJ already indexed", __func__, job_ptr);
+		return;
+	}
+	if (!job_array_index)
+		job_array_index = xhash_init(_job_array_index_id, xfree_ptr);
+	index = xhash_get(job_array_index, (char *) &job_ptr->array_job_id,
+			  sizeof(uint32_t));
+	if (!index) {
+		index = xmalloc(sizeof(job_array_index_t));
+		index->array_job_id = job_ptr->array_job_id;
+		xhash_add(job_array_index, index);
+	}
+	job_ptr->array_index = index;
+	job_ptr->array_index_state = job_ptr->job_state;
+	_job_array_index_count(index, job_ptr->job_state, 1);
+}
+
+/* Remove a job array task's record from its job array's index */
+static void _job_array_index_del(job_record_t *job_ptr)
+{
+	job_array_index_t *index = job_ptr->array_index;
+
+	if (!index)
+		return;
+	_job_array_index_count(index, job_ptr->array_index_state, -1);
+	job_ptr->array_index = NULL;
+	if (index->member_cnt == 0) {
+		xhash_delete(job_array_index, (char *) &index->array_job_id,
+			     sizeof(uint32_t));
+	}
+}
+
+static job_array_index_t *_job_array_index_find(uint32_t array_job_id)
+{
+	if (!job_array_index)
+		return NULL;
+	return xhash_get(job_array_index, (char *) &array_job_id,
+			 sizeof(uint32_t));
+}
+
+extern void job_state_set(job_record_t *job_ptr, uint32_t state)
+{
+	job_array_index_t *index = job_ptr->array_index;
+
+	if (state == job_ptr->job_state)
+		return;
+
+	job_ptr->job_state = state;
+	job_record_changed(job_ptr);
+	if (index && (state != job_ptr->array_index_state)) {
+		_job_array_index_count(index, job_ptr->array_index_state, -1);
+		_job_array_index_count(index, state, 1);
+		job_ptr->array_index_state = state;
+	}
+	depend_graph_notify(job_ptr);
+}
+
+extern void job_state_set_flag(job_record_t *job_ptr, uint32_t flag)
+{
+	job_state_set(job_ptr, job_ptr->job_state | flag);
+}
+
+extern void job_state_unset_flag(job_record_t *job_ptr, uint32_t flag)
+{
+	job_state_set(job_ptr, job_ptr->job_state & (~flag));
+}
+
 /* _remove_job_hash - remove a job hash entry for given job record, job_id must
  *	already be set
  * IN job_ptr - pointer to job record
@@ -3098,6 +4270,7 @@ static void _remove_job_hash(job_record_t *job_entry, job_hash_type_t type)
 	case JOB_HASH_ARRAY_JOB:
 		*job_pptr = job_entry->job_array_next_j;
 		job_entry->job_array_next_j = NULL;
+		_job_array_index_del(job_entry);
 		break;
 	case JOB_HASH_ARRAY_TASK:
 		*job_pptr = job_entry->job_array_next_t;
@@ -3121,6 +4294,7 @@ void _add_job_array_hash(job_record_t *job_ptr)
 	inx = JOB_HASH_INX(job_ptr->array_job_id);
 	job_ptr->job_array_next_j = job_array_hash_j[inx];
 	job_array_hash_j[inx] = job_ptr;
+	_job_array_index_add(job_ptr);
 
 	inx = JOB_ARRAY_HASH_INX(job_ptr->array_job_id,job_ptr->array_task_id);
 	job_ptr->job_array_next_t = job_array_hash_t[inx];
@@ -3161,14 +4335,14 @@ extern void build_array_str(job_record_t *job_ptr)
 	 */
 
 	if (job_ptr->db_index)
-		job_ptr->job_state |= JOB_UPDATE_DB;
+		job_state_set_flag(job_ptr, JOB_UPDATE_DB);
 }
 
 /* Return true if ALL tasks of specific array job ID are complete */
 extern bool test_job_array_complete(uint32_t array_job_id)
 {
 	job_record_t *job_ptr;
-	int inx;
+	job_array_index_t *index;
 
 	job_ptr = find_job_record(array_job_id);
 	if (job_ptr) {
@@ -3178,16 +4352,10 @@ extern bool test_job_array_complete(uint32_t array_job_id)
 			return false;
 	}
 
-	/* Need to test individual job array records */
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
-	while (job_ptr) {
-		if (job_ptr->array_job_id == array_job_id) {
-			if (!IS_JOB_COMPLETE(job_ptr))
-				return false;
-		}
-		job_ptr = job_ptr->job_array_next_j;
-	}
+	/* Test individual job array records */
+	if ((index = _job_array_index_find(array_job_id)) &&
+	    (index->complete_cnt != index->member_cnt))
+		return false;
 	return true;
 }
 
@@ -3195,7 +4363,7 @@ extern bool test_job_array_complete(uint32_t array_job_id)
 extern bool test_job_array_completed(uint32_t array_job_id)
 {
 	job_record_t *job_ptr;
-	int inx;
+	job_array_index_t *index;
 
 	job_ptr = find_job_record(array_job_id);
 	if (job_ptr) {
@@ -3203,16 +4371,10 @@ extern bool test_job_array_completed(uint32_t array_job_id)
 			return false;
 	}
 
-	/* Need to test individual job array records */
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
-	while (job_ptr) {
-		if (job_ptr->array_job_id == array_job_id) {
-			if (!IS_JOB_COMPLETED(job_ptr))
-				return false;
-		}
-		job_ptr = job_ptr->job_array_next_j;
-	}
+	/* Test individual job array records */
+	if ((index = _job_array_index_find(array_job_id)) &&
+	    (index->completed_cnt != index->member_cnt))
+		return false;
 	return true;
 }
 
@@ -3222,25 +4384,22 @@ extern bool test_job_array_completed(uint32_t array_job_id)
  */
 extern bool _test_job_array_purged(uint32_t array_job_id)
 {
-	job_record_t *job_ptr, *head_job_ptr;
-	int inx;
+	job_record_t *head_job_ptr;
+	job_array_index_t *index;
+	uint32_t head_cnt = 0;
 
 	head_job_ptr = find_job_record(array_job_id);
 	if (head_job_ptr) {
 		if (!IS_JOB_COMPLETED(head_job_ptr))
 			return false;
+		if (head_job_ptr->array_index)
+			head_cnt = 1;
 	}
 
-	/* Need to test individual job array records */
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
-	while (job_ptr) {
-		if ((job_ptr->array_job_id == array_job_id) &&
-		    (job_ptr != head_job_ptr)) {
-			return false;
-		}
-		job_ptr = job_ptr->job_array_next_j;
-	}
+	/* Test individual job array records */
+	if ((index = _job_array_index_find(array_job_id)) &&
+	    (index->member_cnt != head_cnt))
+		return false;
 	return true;
 }
 
@@ -3248,7 +4407,7 @@ extern bool _test_job_array_purged(uint32_t array_job_id)
 extern bool test_job_array_finished(uint32_t array_job_id)
 {
 	job_record_t *job_ptr;
-	int inx;
+	job_array_index_t *index;
 
 	job_ptr = find_job_record(array_job_id);
 	if (job_ptr) {
@@ -3256,16 +4415,10 @@ extern bool test_job_array_finished(uint32_t array_job_id)
 			return false;
 	}
 
-	/* Need to test individual job array records */
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
-	while (job_ptr) {
-		if (job_ptr->array_job_id == array_job_id) {
-			if (!IS_JOB_FINISHED(job_ptr))
-				return false;
-		}
-		job_ptr = job_ptr->job_array_next_j;
-	}
+	/* Test individual job array records */
+	if ((index = _job_array_index_find(array_job_id)) &&
+	    (index->finished_cnt != index->member_cnt))
+		return false;
 
 	return true;
 }
@@ -3274,7 +4427,7 @@ extern bool test_job_array_finished(uint32_t array_job_id)
 extern bool test_job_array_pending(uint32_t array_job_id)
 {
 	job_record_t *job_ptr;
-	int inx;
+	job_array_index_t *index;
 
 	job_ptr = find_job_record(array_job_id);
 	if (job_ptr) {
@@ -3284,16 +4437,10 @@ extern bool test_job_array_pending(uint32_t array_job_id)
 			return true;
 	}
 
-	/* Need to test individual job array records */
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
-	while (job_ptr) {
-		if (job_ptr->array_job_id == array_job_id) {
-			if (IS_JOB_PENDING(job_ptr))
-				return true;
-		}
-		job_ptr = job_ptr->job_array_next_j;
-	}
+	/* Test individual job array records */
+	if ((index = _job_array_index_find(array_job_id)) &&
+	    index->pending_cnt)
+		return true;
 	return false;
 }
 
@@ -3301,19 +4448,12 @@ extern bool test_job_array_pending(uint32_t array_job_id)
  * own separate job_record (do not count tasks in pending META job record) */
 extern int num_pending_job_array_tasks(uint32_t array_job_id)
 {
-	job_record_t *job_ptr;
-	int count = 0, inx;
+	job_array_index_t *index;
 
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
-	while (job_ptr) {
-		if ((job_ptr->array_job_id == array_job_id) &&
-		    IS_JOB_PENDING(job_ptr))
-			count++;
-		job_ptr = job_ptr->job_array_next_j;
-	}
+	if (!(index = _job_array_index_find(array_job_id)))
+		return 0;
 
-	return count;
+	return index->pending_cnt;
 }
 
 /*
@@ -3402,6 +4542,13 @@ extern job_record_t *find_het_job_record(uint32_t job_id, uint32_t het_job_id)
 
 	if (!het_job_leader->het_job_list)
 		return NULL;
+
+	/* Components normally get consecutive job IDs from the leader's */
+	het_job = find_job_record(job_id + het_job_id);
+	if (het_job && (het_job->het_job_id == het_job_leader->het_job_id) &&
+	    (het_job->het_job_offset == het_job_id))
+		return het_job;
+
 	iter = list_iterator_create(het_job_leader->het_job_list);
 	while ((het_job = list_next(iter))) {
 		if (het_job_leader->het_job_id != het_job->het_job_id) {
@@ -3449,6 +4596,7 @@ static void _rebuild_part_name_list(job_record_t *job_ptr)
 	if (!job_ptr->part_ptr_list) {
 		job_ptr->partition = xstrdup(job_ptr->part_ptr->name);
 		last_job_update = time(NULL);
+		job_record_changed(job_ptr);
 		return;
 	}
 
@@ -3473,6 +4621,7 @@ static void _rebuild_part_name_list(job_record_t *job_ptr)
 	}
 	list_iterator_destroy(part_iterator);
 	last_job_update = time(NULL);
+	job_record_changed(job_ptr);
 }
 
 /*
@@ -3684,16 +4833,16 @@ extern int kill_job_by_part_name(char *part_name)
 			/* we can't have it as suspended when we call the
 			 * accounting stuff.
 			 */
-			job_ptr->job_state = JOB_CANCELLED;
+			job_state_set(job_ptr, JOB_CANCELLED);
 			jobacct_storage_g_job_suspend(acct_db_conn, job_ptr);
-			job_ptr->job_state = suspend_job_state;
+			job_state_set(job_ptr, suspend_job_state);
 			suspended = true;
 		}
 		if (IS_JOB_RUNNING(job_ptr) || suspended) {
 			kill_job_cnt++;
 			info("Killing %pJ on defunct partition %s",
 			     job_ptr, part_name);
-			job_ptr->job_state = JOB_NODE_FAIL | JOB_COMPLETING;
+			job_state_set(job_ptr, JOB_NODE_FAIL | JOB_COMPLETING);
 			build_cg_bitmap(job_ptr);
 			job_ptr->state_reason = FAIL_DOWN_PARTITION;
 			xfree(job_ptr->state_desc);
@@ -3711,7 +4860,7 @@ extern int kill_job_by_part_name(char *part_name)
 			kill_job_cnt++;
 			info("Killing %pJ on defunct partition %s",
 			     job_ptr, part_name);
-			job_ptr->job_state	= JOB_CANCELLED;
+			job_state_set(job_ptr, JOB_CANCELLED);
 			job_ptr->start_time	= now;
 			job_ptr->end_time	= now;
 			job_ptr->exit_code	= 1;
@@ -3769,9 +4918,9 @@ extern int kill_job_by_front_end_name(char *node_name)
 			 * we can't have it as suspended when we call the
 			 * accounting stuff.
 			 */
-			job_ptr->job_state = JOB_CANCELLED;
+			job_state_set(job_ptr, JOB_CANCELLED);
 			jobacct_storage_g_job_suspend(acct_db_conn, job_ptr);
-			job_ptr->job_state = suspend_job_state;
+			job_state_set(job_ptr, suspend_job_state);
 			suspended = true;
 		}
 		if (IS_JOB_COMPLETING(job_ptr)) {
@@ -3828,7 +4977,7 @@ extern int kill_job_by_front_end_name(char *node_name)
 				 * Set a new submit time so the restarted
 				 * job looks like a new job.
 				 */
-				job_ptr->job_state  = JOB_NODE_FAIL;
+				job_state_set(job_ptr, JOB_NODE_FAIL);
 				build_cg_bitmap(job_ptr);
 				job_completion_logger(job_ptr, true);
 				deallocate_nodes(job_ptr, false, suspended,
@@ -3839,9 +4988,10 @@ extern int kill_job_by_front_end_name(char *node_name)
 				//job_ptr->db_index = 0;
 				//job_ptr->details->submit_time = now;
 
-				job_ptr->job_state = JOB_PENDING;
+				job_state_set(job_ptr, JOB_PENDING);
 				if (job_ptr->node_cnt)
-					job_ptr->job_state |= JOB_COMPLETING;
+					job_state_set_flag(job_ptr,
+							   JOB_COMPLETING);
 
 				job_ptr->restart_cnt++;
 
@@ -3860,8 +5010,8 @@ extern int kill_job_by_front_end_name(char *node_name)
 				info("Killing %pJ on failed node %s",
 				     job_ptr, node_name);
 				srun_node_fail(job_ptr, node_name);
-				job_ptr->job_state = JOB_NODE_FAIL |
-						     JOB_COMPLETING;
+				job_state_set(job_ptr,
+					      JOB_NODE_FAIL | JOB_COMPLETING);
 				build_cg_bitmap(job_ptr);
 				job_ptr->state_reason = FAIL_DOWN_NODE;
 				xfree(job_ptr->state_desc);
@@ -4022,9 +5172,9 @@ extern int kill_running_job_by_node_name(char *node_name)
 			 * we can't have it as suspended when we call the
 			 * accounting stuff.
 			 */
-			job_ptr->job_state = JOB_CANCELLED;
+			job_state_set(job_ptr, JOB_CANCELLED);
 			jobacct_storage_g_job_suspend(acct_db_conn, job_ptr);
-			job_ptr->job_state = suspend_job_state;
+			job_state_set(job_ptr, suspend_job_state);
 			suspended = true;
 		}
 
@@ -4095,7 +5245,7 @@ extern int kill_running_job_by_node_name(char *node_name)
 				 * Set a new submit time so the restarted
 				 * job looks like a new job.
 				 */
-				job_ptr->job_state = JOB_NODE_FAIL;
+				job_state_set(job_ptr, JOB_NODE_FAIL);
 				build_cg_bitmap(job_ptr);
 				job_completion_logger(job_ptr, true);
 				deallocate_nodes(job_ptr, false, suspended,
@@ -4106,9 +5256,10 @@ extern int kill_running_job_by_node_name(char *node_name)
 				//job_ptr->db_index = 0;
 				//job_ptr->details->submit_time = now;
 
-				job_ptr->job_state = JOB_PENDING;
+				job_state_set(job_ptr, JOB_PENDING);
 				if (job_ptr->node_cnt)
-					job_ptr->job_state |= JOB_COMPLETING;
+					job_state_set_flag(job_ptr,
+							   JOB_COMPLETING);
 
 				job_ptr->restart_cnt++;
 
@@ -4129,8 +5280,8 @@ extern int kill_running_job_by_node_name(char *node_name)
 				info("Killing %pJ on failed node %s",
 				     job_ptr, node_name);
 				srun_node_fail(job_ptr, node_name);
-				job_ptr->job_state = JOB_NODE_FAIL |
-						     JOB_COMPLETING;
+				job_state_set(job_ptr,
+					      JOB_NODE_FAIL | JOB_COMPLETING);
 				build_cg_bitmap(job_ptr);
 				job_ptr->state_reason = FAIL_DOWN_NODE;
 				xfree(job_ptr->state_desc);
@@ -4531,6 +5682,8 @@ extern job_record_t *job_array_split(job_record_t *job_ptr)
 	job_ptr_pend->db_flags = 0;
 	job_ptr_pend->step_list = save_step_list;
 	job_ptr_pend->db_index = save_db_index;
+	job_ptr_pend->array_index = NULL;
+	job_ptr_pend->depend_cached = false;
 
 	job_ptr_pend->prio_factors = save_prio_factors;
 	slurm_copy_priority_factors_object(job_ptr_pend->prio_factors,
@@ -5043,7 +6196,7 @@ extern int job_allocate(job_desc_msg_t * job_specs, int immediate,
 	if (error_code) {
 		if (job_ptr && (immediate || will_run)) {
 			/* this should never really happen here */
-			job_ptr->job_state = JOB_FAILED;
+			job_state_set(job_ptr, JOB_FAILED);
 			job_ptr->exit_code = 1;
 			job_ptr->state_reason = FAIL_BAD_CONSTRAINTS;
 			xfree(job_ptr->state_desc);
@@ -5098,7 +6251,7 @@ extern int job_allocate(job_desc_msg_t * job_specs, int immediate,
 
 	if (immediate &&
 	    (too_fragmented || (!top_prio) || (!independent) || defer_sched)) {
-		job_ptr->job_state  = JOB_FAILED;
+		job_state_set(job_ptr, JOB_FAILED);
 		job_ptr->exit_code  = 1;
 		job_ptr->state_reason = FAIL_BAD_CONSTRAINTS;
 		xfree(job_ptr->state_desc);
@@ -5140,7 +6293,7 @@ extern int job_allocate(job_desc_msg_t * job_specs, int immediate,
 		slurm_init_job_desc_msg(&job_desc_msg);
 		job_desc_msg.job_id = job_ptr->job_id;
 		rc = job_start_data(&job_desc_msg, resp);
-		job_ptr->job_state  = JOB_FAILED;
+		job_state_set(job_ptr, JOB_FAILED);
 		job_ptr->exit_code  = 1;
 		job_ptr->start_time = job_ptr->end_time = now;
 		purge_job_record(job_ptr->job_id);
@@ -5163,6 +6316,7 @@ extern int job_allocate(job_desc_msg_t * job_specs, int immediate,
 	error_code = _select_nodes_parts(job_ptr, no_alloc, NULL, err_msg);
 	if (!test_only) {
 		last_job_update = now;
+		job_record_changed(job_ptr);
 	}
 
 	if (held_user)
@@ -5198,7 +6352,7 @@ extern int job_allocate(job_desc_msg_t * job_specs, int immediate,
 		 (error_code == ESLURM_PARTITION_DOWN)) {
 		/* Not fatal error, but job can't be scheduled right now */
 		if (immediate) {
-			job_ptr->job_state  = JOB_FAILED;
+			job_state_set(job_ptr, JOB_FAILED);
 			job_ptr->exit_code  = 1;
 			job_ptr->state_reason = FAIL_BAD_CONSTRAINTS;
 			xfree(job_ptr->state_desc);
@@ -5222,7 +6376,7 @@ extern int job_allocate(job_desc_msg_t * job_specs, int immediate,
 	}
 
 	if (error_code) {	/* fundamental flaw in job request */
-		job_ptr->job_state  = JOB_FAILED;
+		job_state_set(job_ptr, JOB_FAILED);
 		job_ptr->exit_code  = 1;
 		job_ptr->state_reason = FAIL_BAD_CONSTRAINTS;
 		xfree(job_ptr->state_desc);
@@ -5236,7 +6390,7 @@ extern int job_allocate(job_desc_msg_t * job_specs, int immediate,
 	}
 
 	if (will_run) {		/* job would run, flag job destruction */
-		job_ptr->job_state  = JOB_FAILED;
+		job_state_set(job_ptr, JOB_FAILED);
 		job_ptr->exit_code  = 1;
 		job_ptr->start_time = job_ptr->end_time = now;
 		purge_job_record(job_ptr->job_id);
@@ -5271,9 +6425,9 @@ static int _job_fail(job_record_t *job_ptr, uint32_t job_state)
 		 * we can't have it as suspended when we call the
 		 * accounting stuff.
 		 */
-		job_ptr->job_state = JOB_CANCELLED;
+		job_state_set(job_ptr, JOB_CANCELLED);
 		jobacct_storage_g_job_suspend(acct_db_conn, job_ptr);
-		job_ptr->job_state = suspend_job_state;
+		job_state_set(job_ptr, suspend_job_state);
 		suspended = true;
 	}
 
@@ -5288,7 +6442,8 @@ static int _job_fail(job_record_t *job_ptr, uint32_t job_state)
 		} else
 			job_ptr->end_time       = now;
 		last_job_update                 = now;
-		job_ptr->job_state = job_state | JOB_COMPLETING;
+		job_record_changed(job_ptr);
+		job_state_set(job_ptr, job_state | JOB_COMPLETING);
 		job_ptr->exit_code = 1;
 		job_ptr->state_reason = FAIL_LAUNCH;
 		xfree(job_ptr->state_desc);
@@ -5416,6 +6571,7 @@ extern int job_signal(job_record_t *job_ptr, uint16_t signal,
 	/* let node select plugin do any state-dependent signaling actions */
 	select_g_job_signal(job_ptr, signal);
 	last_job_update = now;
+	job_record_changed(job_ptr);
 
 	/* save user ID of the one who requested the job be cancelled */
 	if (signal == SIGKILL)
@@ -5423,7 +6579,7 @@ extern int job_signal(job_record_t *job_ptr, uint16_t signal,
 	if (IS_JOB_PENDING(job_ptr) && IS_JOB_COMPLETING(job_ptr) &&
 	    (signal == SIGKILL)) {
 		/* Prevent job requeue, otherwise preserve state */
-		job_ptr->job_state = JOB_CANCELLED | JOB_COMPLETING;
+		job_state_set(job_ptr, JOB_CANCELLED | JOB_COMPLETING);
 
 		/* build_cg_bitmap() not needed, job already completing */
 		verbose("%s: %u of requeuing %pJ successful",
@@ -5436,15 +6592,16 @@ extern int job_signal(job_record_t *job_ptr, uint16_t signal,
 
 	if (IS_JOB_CONFIGURING(job_ptr) && (signal == SIGKILL)) {
 		last_job_update         = now;
+		job_record_changed(job_ptr);
 		job_ptr->end_time       = now;
-		job_ptr->job_state      = JOB_CANCELLED | JOB_COMPLETING;
+		job_state_set(job_ptr, JOB_CANCELLED | JOB_COMPLETING);
 		if (flags & KILL_FED_REQUEUE)
-			job_ptr->job_state |= JOB_REQUEUE;
+			job_state_set_flag(job_ptr, JOB_REQUEUE);
 		build_cg_bitmap(job_ptr);
 		job_completion_logger(job_ptr, false);
 		deallocate_nodes(job_ptr, false, false, false);
 		if (flags & KILL_FED_REQUEUE) {
-			job_ptr->job_state &= (~JOB_REQUEUE);
+			job_state_unset_flag(job_ptr, JOB_REQUEUE);
 		}
 		verbose("%s: %u of configuring %pJ successful",
 			__func__, signal, job_ptr);
@@ -5452,15 +6609,15 @@ extern int job_signal(job_record_t *job_ptr, uint16_t signal,
 	}
 
 	if (IS_JOB_PENDING(job_ptr) && (signal == SIGKILL)) {
-		job_ptr->job_state	= JOB_CANCELLED;
+		job_state_set(job_ptr, JOB_CANCELLED);
 		if (flags & KILL_FED_REQUEUE)
-			job_ptr->job_state |= JOB_REQUEUE;
+			job_state_set_flag(job_ptr, JOB_REQUEUE);
 		job_ptr->start_time	= now;
 		job_ptr->end_time	= now;
 		srun_allocate_abort(job_ptr);
 		job_completion_logger(job_ptr, false);
 		if (flags & KILL_FED_REQUEUE) {
-			job_ptr->job_state &= (~JOB_REQUEUE);
+			job_state_unset_flag(job_ptr, JOB_REQUEUE);
 		}
 		/*
 		 * Send back a response to the origin cluster, in other cases
@@ -5481,16 +6638,17 @@ extern int job_signal(job_record_t *job_ptr, uint16_t signal,
 		job_term_state = JOB_CANCELLED;
 	if (IS_JOB_SUSPENDED(job_ptr) && (signal == SIGKILL)) {
 		last_job_update         = now;
+		job_record_changed(job_ptr);
 		job_ptr->end_time       = job_ptr->suspend_time;
 		job_ptr->tot_sus_time  += difftime(now, job_ptr->suspend_time);
-		job_ptr->job_state      = job_term_state | JOB_COMPLETING;
+		job_state_set(job_ptr, job_term_state | JOB_COMPLETING);
 		if (flags & KILL_FED_REQUEUE)
-			job_ptr->job_state |= JOB_REQUEUE;
+			job_state_set_flag(job_ptr, JOB_REQUEUE);
 		build_cg_bitmap(job_ptr);
 		jobacct_storage_g_job_suspend(acct_db_conn, job_ptr);
 		job_completion_logger(job_ptr, false);
 		if (flags & KILL_FED_REQUEUE)
-			job_ptr->job_state &= (~JOB_REQUEUE);
+			job_state_unset_flag(job_ptr, JOB_REQUEUE);
 		deallocate_nodes(job_ptr, false, true, preempt);
 		verbose("%s: %u of suspended %pJ successful",
 			__func__, signal, job_ptr);
@@ -5506,7 +6664,7 @@ extern int job_signal(job_record_t *job_ptr, uint16_t signal,
 					job_ptr->job_state);
 				return ESLURM_TRANSITION_STATE_NO_UPDATE;
 			}
-			job_ptr->job_state |= JOB_SIGNALING;
+			job_state_set_flag(job_ptr, JOB_SIGNALING);
 		}
 
 		if ((signal == SIGKILL)
@@ -5517,19 +6675,19 @@ extern int job_signal(job_record_t *job_ptr, uint16_t signal,
 			job_ptr->time_last_active	= now;
 			job_ptr->end_time		= now;
 			last_job_update			= now;
-			job_ptr->job_state = job_term_state | JOB_COMPLETING;
+			job_state_set(job_ptr, job_term_state | JOB_COMPLETING);
 			if (flags & KILL_FED_REQUEUE)
-				job_ptr->job_state |= JOB_REQUEUE;
+				job_state_set_flag(job_ptr, JOB_REQUEUE);
 			build_cg_bitmap(job_ptr);
 			job_completion_logger(job_ptr, false);
 			deallocate_nodes(job_ptr, false, false, preempt);
 			if (flags & KILL_FED_REQUEUE)
-				job_ptr->job_state &= (~JOB_REQUEUE);
+				job_state_unset_flag(job_ptr, JOB_REQUEUE);
 		} else if (job_ptr->batch_flag && (flags & KILL_JOB_BATCH)) {
 			_signal_batch_job(job_ptr, signal, flags);
 		} else if ((flags & KILL_JOB_BATCH) && !job_ptr->batch_flag) {
 			if ((signal == SIGSTOP) || (signal == SIGCONT))
-				job_ptr->job_state &= ~JOB_SIGNALING;
+				job_state_unset_flag(job_ptr, JOB_SIGNALING);
 			return ESLURM_JOB_SCRIPT_MISSING;
 		} else {
 			_signal_job(job_ptr, signal, flags);
@@ -5842,7 +7000,7 @@ extern int job_str_signal(char *job_id_str, uint16_t signal, uint16_t flags,
 						       task_id_bitmap);
 			if (!new_task_count) {
 				last_job_update		= now;
-				job_ptr->job_state	= JOB_CANCELLED;
+				job_state_set(job_ptr, JOB_CANCELLED);
 				job_ptr->start_time	= now;
 				job_ptr->end_time	= now;
 				job_ptr->requid		= uid;
@@ -5865,13 +7023,13 @@ extern int job_str_signal(char *job_id_str, uint16_t signal, uint16_t flags,
 				if (job_ptr->array_recs->task_cnt >
 				    new_task_count) {
 					uint32_t tmp_state = job_ptr->job_state;
-					job_ptr->job_state = JOB_CANCELLED;
+					job_state_set(job_ptr, JOB_CANCELLED);
 
 					job_ptr->array_recs->task_cnt -=
 						new_task_count;
 					acct_policy_remove_job_submit(job_ptr);
 					job_ptr->bit_flags &= ~JOB_ACCRUE_OVER;
-					job_ptr->job_state = tmp_state;
+					job_state_set(job_ptr, tmp_state);
 				}
 			}
 
@@ -6046,9 +7204,9 @@ static int _job_complete(job_record_t *job_ptr, uid_t uid, bool requeue,
 		 * we can't have it as suspended when we call the
 		 * accounting stuff.
 		 */
-		job_ptr->job_state = JOB_CANCELLED;
+		job_state_set(job_ptr, JOB_CANCELLED);
 		jobacct_storage_g_job_suspend(acct_db_conn, job_ptr);
-		job_ptr->job_state = suspend_job_state;
+		job_state_set(job_ptr, suspend_job_state);
 		job_comp_flag = JOB_COMPLETING;
 		suspended = true;
 	}
@@ -6068,7 +7226,7 @@ static int _job_complete(job_record_t *job_ptr, uid_t uid, bool requeue,
 		 * job looks like a new job.
 		 */
 		job_ptr->end_time = now;
-		job_ptr->job_state  = JOB_NODE_FAIL;
+		job_state_set(job_ptr, JOB_NODE_FAIL);
 		job_completion_logger(job_ptr, true);
 		/*
 		 * Do this after the epilog complete.
@@ -6091,7 +7249,7 @@ static int _job_complete(job_record_t *job_ptr, uid_t uid, bool requeue,
 		/* clear signal sent flag on requeue */
 		job_ptr->warn_flags &= ~WARN_SENT;
 
-		job_ptr->job_state = JOB_PENDING | job_comp_flag;
+		job_state_set(job_ptr, JOB_PENDING | job_comp_flag);
 		/*
 		 * Since the job completion logger removes the job submit
 		 * information, we need to add it again.
@@ -6109,7 +7267,7 @@ static int _job_complete(job_record_t *job_ptr, uid_t uid, bool requeue,
 		 * attempts hold the job with HoldMaxRequeue reason.
 		 */
 		if (job_ptr->batch_flag > MAX_BATCH_REQUEUE) {
-			job_ptr->job_state |= JOB_REQUEUE_HOLD;
+			job_state_set_flag(job_ptr, JOB_REQUEUE_HOLD);
 			job_ptr->state_reason = WAIT_MAX_REQUEUE;
 			job_ptr->batch_flag = 1;
 			debug("%s: Holding %pJ, repeated requeue failures",
@@ -6135,24 +7293,24 @@ static int _job_complete(job_record_t *job_ptr, uid_t uid, bool requeue,
 		}
 
 		if (node_fail) {
-			job_ptr->job_state = JOB_NODE_FAIL | job_comp_flag;
+			job_state_set(job_ptr, JOB_NODE_FAIL | job_comp_flag);
 			job_ptr->requid = uid;
 		} else if (job_return_code == NO_VAL) {
-			job_ptr->job_state = JOB_CANCELLED | job_comp_flag;
+			job_state_set(job_ptr, JOB_CANCELLED | job_comp_flag);
 			job_ptr->requid = uid;
 		} else if ((job_return_code & 0xff) == SIG_OOM) {
-			job_ptr->job_state = JOB_OOM | job_comp_flag;
+			job_state_set(job_ptr, JOB_OOM | job_comp_flag);
 			job_ptr->exit_code = job_return_code;
 			job_ptr->state_reason = FAIL_OOM;
 			xfree(job_ptr->state_desc);
 		} else if (WIFEXITED(job_return_code) &&
 			   WEXITSTATUS(job_return_code)) {
-			job_ptr->job_state = JOB_FAILED   | job_comp_flag;
+			job_state_set(job_ptr, JOB_FAILED   | job_comp_flag);
 			job_ptr->exit_code = job_return_code;
 			job_ptr->state_reason = FAIL_EXIT_CODE;
 			xfree(job_ptr->state_desc);
 		} else if (WIFSIGNALED(job_return_code)) {
-			job_ptr->job_state = JOB_FAILED | job_comp_flag;
+			job_state_set(job_ptr, JOB_FAILED | job_comp_flag);
 			job_ptr->exit_code = job_return_code;
 			job_ptr->state_reason = FAIL_LAUNCH;
 		} else if (job_comp_flag
@@ -6162,11 +7320,11 @@ static int _job_complete(job_record_t *job_ptr, uid_t uid, bool requeue,
 			 * Test if the job has finished before its allowed
 			 * over time has expired.
 			 */
-			job_ptr->job_state = JOB_TIMEOUT  | job_comp_flag;
+			job_state_set(job_ptr, JOB_TIMEOUT  | job_comp_flag);
 			job_ptr->state_reason = FAIL_TIMEOUT;
 			xfree(job_ptr->state_desc);
 		} else {
-			job_ptr->job_state = JOB_COMPLETE | job_comp_flag;
+			job_state_set(job_ptr, JOB_COMPLETE | job_comp_flag);
 			job_ptr->exit_code = job_return_code;
 			if (nonstop_ops.job_fini)
 				(nonstop_ops.job_fini)(job_ptr);
@@ -6182,6 +7340,7 @@ static int _job_complete(job_record_t *job_ptr, uid_t uid, bool requeue,
 	}
 
 	last_job_update = now;
+	job_record_changed(job_ptr);
 	job_ptr->time_last_active = now;   /* Timer for resending kill RPC */
 	if (job_comp_flag) {	/* job was running */
 		build_cg_bitmap(job_ptr);
@@ -7333,7 +8492,7 @@ static int _job_create(job_desc_msg_t *job_desc, int allocate, int will_run,
 
 cleanup_fail:
 	if (job_ptr) {
-		job_ptr->job_state = JOB_FAILED;
+		job_state_set(job_ptr, JOB_FAILED);
 		job_ptr->exit_code = 1;
 		job_ptr->state_reason = FAIL_SYSTEM;
 		xfree(job_ptr->state_desc);
@@ -8146,7 +9305,7 @@ static int _copy_job_desc_to_job_record(job_desc_msg_t *job_desc,
 
 	job_ptr->user_id    = (uid_t) job_desc->user_id;
 	job_ptr->group_id   = (gid_t) job_desc->group_id;
-	job_ptr->job_state  = JOB_PENDING;
+	job_state_set(job_ptr, JOB_PENDING);
 	job_ptr->time_limit = job_desc->time_limit;
 	job_ptr->deadline   = job_desc->deadline;
 	if (job_desc->delay_boot == NO_VAL)
@@ -8659,10 +9818,11 @@ extern void job_config_fini(job_record_t *job_ptr)
 	time_t now = time(NULL);
 
 	last_job_update = now;
-	job_ptr->job_state &= ~JOB_CONFIGURING;
+	job_record_changed(job_ptr);
+	job_state_unset_flag(job_ptr, JOB_CONFIGURING);
 	if (IS_JOB_POWER_UP_NODE(job_ptr)) {
 		info("Resetting %pJ start time for node power up", job_ptr);
-		job_ptr->job_state &= ~JOB_POWER_UP_NODE;
+		job_state_unset_flag(job_ptr, JOB_POWER_UP_NODE);
 		job_ptr->start_time = now;
 		_het_job_time_limit_incr(job_ptr, job_ptr->job_id);
 		jobacct_storage_g_job_start(acct_db_conn, job_ptr);
@@ -8826,6 +9986,7 @@ void job_time_limit(void)
 			job_ptr->state_reason = WAIT_NO_REASON;
 			set_job_prio(job_ptr);
 			last_job_update = now;
+			job_record_changed(job_ptr);
 		}
 
 		/* Don't enforce time limits for configuring hetjobs */
@@ -8906,6 +10067,7 @@ void job_time_limit(void)
 				over_run = now - (over_time_limit  * 60);
 			if (job_ptr->end_time <= over_run) {
 				last_job_update = now;
+				job_record_changed(job_ptr);
 				info("Time limit exhausted for %pJ", job_ptr);
 				_job_timed_out(job_ptr, false);
 				job_ptr->state_reason = FAIL_TIMEOUT;
@@ -8918,6 +10080,7 @@ void job_time_limit(void)
 		    !(job_ptr->resv_ptr->flags & RESERVE_FLAG_FLEX) &&
 		    (job_ptr->resv_ptr->end_time + resv_over_run) < time(NULL)){
 			last_job_update = now;
+			job_record_changed(job_ptr);
 			info("Reservation ended for %pJ", job_ptr);
 			_job_timed_out(job_ptr, false);
 			job_ptr->state_reason = FAIL_TIMEOUT;
@@ -8937,6 +10100,7 @@ void job_time_limit(void)
 
 		if (job_ptr->state_reason == FAIL_TIMEOUT) {
 			last_job_update = now;
+			job_record_changed(job_ptr);
 			_job_timed_out(job_ptr, false);
 			xfree(job_ptr->state_desc);
 			goto time_check;
@@ -9178,7 +10342,7 @@ static void _job_timed_out(job_record_t *job_ptr, bool preempted)
 		job_ptr->end_time           = now;
 		job_ptr->time_last_active   = now;
 		if (!job_ptr->preempt_time)
-			job_ptr->job_state = JOB_TIMEOUT | JOB_COMPLETING;
+			job_state_set(job_ptr, JOB_TIMEOUT | JOB_COMPLETING);
 		build_cg_bitmap(job_ptr);
 		job_completion_logger(job_ptr, false);
 		deallocate_nodes(job_ptr, !preempted, false, preempted);
@@ -9381,9 +10545,15 @@ extern void free_null_array_recs(job_record_t *job_ptr)
 
 static void _delete_job_common(job_record_t *job_ptr)
 {
+	/* Journal the removal with the next job state save */
+	_job_journal_removed(job_ptr->job_id);
+
 	/* Remove record from fed_job_list */
 	fed_mgr_remove_fed_job_info(job_ptr->job_id);
 
+	/* Jobs waiting on this one will find it gone */
+	depend_graph_notify(job_ptr);
+
 	/* Remove the record from job hash table */
 	_remove_job_hash(job_ptr, JOB_HASH_JOB);
 
@@ -9402,7 +10572,7 @@ static void _delete_job_common(job_record_t *job_ptr)
 static void _list_delete_job(void *job_entry)
 {
 	job_record_t *job_ptr = (job_record_t *) job_entry;
-	int job_array_size, i;
+	int job_array_size;
 
 	xassert(job_entry);
 	xassert (job_ptr->magic == JOB_MAGIC);
@@ -9416,6 +10586,35 @@ static void _list_delete_job(void *job_entry)
 		job_array_size = 1;
 	}
 
+	/*
+	 * Queue up job to have the batch script and environment deleted.
+	 * This is handled by a separate thread to limit the amount of
+	 * time purge_old_job needs to spend holding locks.
+	 */
+	if (job_ptr->details && IS_JOB_FINISHED(job_ptr)) {
+		uint32_t *job_id = xmalloc(sizeof(uint32_t));
+		*job_id = job_ptr->job_id;
+		list_enqueue(purge_files_list, job_id);
+	}
+
+	_free_job_record(job_ptr);
+
+	if (job_array_size > job_count) {
+		error("job_count underflow");
+		job_count = 0;
+	} else {
+		job_count -= job_array_size;
+	}
+}
+
+/*
+ * _free_job_record - free a job record's memory, the record must no longer be
+ *	in the job list or hash tables
+ */
+static void _free_job_record(job_record_t *job_ptr)
+{
+	int i;
+
 	_delete_job_details(job_ptr);
 	xfree(job_ptr->account);
 	xfree(job_ptr->admin_comment);
@@ -9491,12 +10690,6 @@ static void _list_delete_job(void *job_entry)
 	select_g_select_jobinfo_free(job_ptr->select_jobinfo);
 	xfree(job_ptr->user_name);
 	xfree(job_ptr->wckey);
-	if (job_array_size > job_count) {
-		error("job_count underflow");
-		job_count = 0;
-	} else {
-		job_count -= job_array_size;
-	}
 	job_ptr->job_id = 0;
 	xfree(job_ptr);
 }
@@ -9697,6 +10890,203 @@ static int _foreach_pack_jobid(void *object, void *arg)
 	return SLURM_SUCCESS;
 }
 
+/* Return true if a job has no partition for _all_parts_hidden() to test */
+static bool _job_no_parts(job_record_t *job_ptr)
+{
+	if (job_ptr->part_ptr_list)
+		return (list_count(job_ptr->part_ptr_list) == 0);
+	return (job_ptr->part_ptr == NULL);
+}
+
+/*
+ * Return true if the jobs seen by this user with these show_flags do not
+ * depend upon the user's identity, other than for uid 0, so a job_cache_t
+ * can be used. Call with job and partition read locks.
+ */
+static bool _job_cache_usable(uid_t uid, uint16_t show_flags,
+			      uint32_t filter_uid)
+{
+	ListIterator part_iterator;
+	part_record_t *part_ptr;
+	bool rc = true;
+
+	if (filter_uid != NO_VAL)
+		return false;
+	if ((slurmctld_conf.private_data & PRIVATE_DATA_JOBS) &&
+	    !validate_operator(uid))
+		return false;
+	if ((show_flags & SHOW_ALL) || (uid == 0) || validate_slurm_user(uid))
+		return true;
+
+	part_iterator = list_iterator_create(part_list);
+	while ((part_ptr = list_next(part_iterator))) {
+		if ((part_ptr->flags & PART_FLAG_HIDDEN) ||
+		    part_ptr->allow_groups) {
+			rc = false;
+			break;
+		}
+	}
+	list_iterator_destroy(part_iterator);
+
+	return rc;
+}
+
+static void _job_cache_rec_id(void *item, const char **key,
+			      uint32_t *key_len)
+{
+	job_cache_rec_t *rec = item;
+
+	*key = (const char *) &rec->job_id;
+	*key_len = sizeof(uint32_t);
+}
+
+static void _job_cache_clear(job_cache_t *cache)
+{
+	FREE_NULL_BUFFER(cache->buffer);
+	xfree(cache->recs);
+	xhash_free(cache->rec_hash);
+	xfree(cache->removed_id);
+	xfree(cache->removed_time);
+	memset(cache, 0, sizeof(job_cache_t));
+}
+
+static void _job_cache_fini(void)
+{
+	int i;
+
+	slurm_mutex_lock(&job_cache_mutex);
+	for (i = 0; i < JOB_CACHE_CNT; i++)
+		_job_cache_clear(&job_cache[i]);
+	slurm_mutex_unlock(&job_cache_mutex);
+}
+
+/*
+ * Pack every job into the cache. A job keeps the change_time of its previous
+ * record if its packed record is unchanged, jobs no longer packed are added
+ * to the removed list. Call with job_cache_mutex and job read lock.
+ */
+static void _job_cache_build(job_cache_t *cache, time_t now)
+{
+	ListIterator itr;
+	job_record_t *job_ptr;
+	job_cache_rec_t *recs, *rec, *old_rec;
+	xhash_t *rec_hash;
+	Buf buffer;
+	uint32_t i, j, offset, rec_cnt = 0;
+	time_t removed_min = now - JOB_CACHE_REMOVED_AGE;
+
+	buffer = init_buf(BUF_SIZE);
+	recs = xcalloc(list_count(job_list) + 1, sizeof(job_cache_rec_t));
+	rec_hash = xhash_init(_job_cache_rec_id, NULL);
+
+	itr = list_iterator_create(job_list);
+	while ((job_ptr = list_next(itr))) {
+		if (!(cache->show_flags & SHOW_ALL) &&
+		    (IS_JOB_REVOKED(job_ptr) ||
+		     (!cache->root && _job_no_parts(job_ptr))))
+			continue;
+		offset = get_buf_offset(buffer);
+		pack_job(job_ptr, cache->show_flags, buffer,
+			 cache->protocol_version, 0);
+		rec = &recs[rec_cnt++];
+		rec->job_id = job_ptr->job_id;
+		rec->offset = offset;
+		rec->size = get_buf_offset(buffer) - offset;
+		rec->change_time = now;
+		if (cache->rec_hash &&
+		    (old_rec = xhash_get(cache->rec_hash,
+					 (char *) &rec->job_id,
+					 sizeof(uint32_t))) &&
+		    (old_rec->size == rec->size) &&
+		    !memcmp(get_buf_data(cache->buffer) + old_rec->offset,
+			    get_buf_data(buffer) + offset, rec->size))
+			rec->change_time = old_rec->change_time;
+	}
+	list_iterator_destroy(itr);
+	for (i = 0; i < rec_cnt; i++)
+		xhash_add(rec_hash, &recs[i]);
+
+	/* Remember jobs purged or hidden since the last build */
+	for (i = 0; i < cache->rec_cnt; i++) {
+		if (xhash_get(rec_hash, (char *) &cache->recs[i].job_id,
+			      sizeof(uint32_t)))
+			continue;
+		xrecalloc(cache->removed_id, cache->removed_cnt + 1,
+			  sizeof(uint32_t));
+		xrecalloc(cache->removed_time, cache->removed_cnt + 1,
+			  sizeof(time_t));
+		cache->removed_id[cache->removed_cnt] = cache->recs[i].job_id;
+		cache->removed_time[cache->removed_cnt] = now;
+		cache->removed_cnt++;
+	}
+	for (i = 0, j = 0; i < cache->removed_cnt; i++) {
+		if (cache->removed_time[i] < removed_min)
+			continue;
+		cache->removed_id[j] = cache->removed_id[i];
+		cache->removed_time[j] = cache->removed_time[i];
+		j++;
+	}
+	cache->removed_cnt = j;
+	if (!cache->build_time)
+		cache->delta_start = now;
+	else
+		cache->delta_start = MAX(cache->delta_start, removed_min);
+
+	FREE_NULL_BUFFER(cache->buffer);
+	xfree(cache->recs);
+	xhash_free(cache->rec_hash);
+	cache->buffer = buffer;
+	cache->recs = recs;
+	cache->rec_cnt = rec_cnt;
+	cache->rec_hash = rec_hash;
+	cache->build_time = now;
+	cache->job_update = last_job_update;
+	cache->part_update = last_part_update;
+}
+
+/*
+ * Return the job cache for this combination, rebuilding it if the job or
+ * partition state changed or it was built in an earlier second (pack_job()
+ * output depends upon the current time). Records are packed with the
+ * job read lock, so a cache is rebuilt at most once per second and state
+ * change no matter how many clients ask.
+ * Call with job_cache_mutex and job and partition read locks.
+ */
+static job_cache_t *_job_cache_get(uint16_t show_flags, bool root,
+				   uint16_t protocol_version)
+{
+	job_cache_t *cache = NULL;
+	time_t now = time(NULL);
+	int i;
+
+	for (i = 0; i < JOB_CACHE_CNT; i++) {
+		if (job_cache[i].build_time &&
+		    (job_cache[i].protocol_version == protocol_version) &&
+		    (job_cache[i].show_flags == show_flags) &&
+		    (job_cache[i].root == root)) {
+			cache = &job_cache[i];
+			break;
+		}
+		if (!cache || (job_cache[i].last_used < cache->last_used))
+			cache = &job_cache[i];
+	}
+	if (i >= JOB_CACHE_CNT) {
+		/* Replace the least recently used entry */
+		_job_cache_clear(cache);
+		cache->protocol_version = protocol_version;
+		cache->show_flags = show_flags;
+		cache->root = root;
+	}
+
+	if ((cache->build_time != now) ||
+	    (cache->job_update != last_job_update) ||
+	    (cache->part_update != last_part_update))
+		_job_cache_build(cache, now);
+	cache->last_used = now;
+
+	return cache;
+}
+
 /*
  * pack_all_jobs - dump all job information for all jobs in
  *	machine independent form (for network transmission)
@@ -9730,6 +11120,19 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 	pack32(jobs_packed, buffer);
 	pack_time(time(NULL), buffer);
 
+	if (_job_cache_usable(uid, show_flags, filter_uid)) {
+		job_cache_t *cache;
+
+		slurm_mutex_lock(&job_cache_mutex);
+		cache = _job_cache_get(show_flags, (uid == 0),
+				       protocol_version);
+		jobs_packed = cache->rec_cnt;
+		packmem_array(get_buf_data(cache->buffer),
+			      get_buf_offset(cache->buffer), buffer);
+		slurm_mutex_unlock(&job_cache_mutex);
+		goto fini;
+	}
+
 	/* write individual job records */
 	pack_info.buffer           = buffer;
 	pack_info.filter_uid       = filter_uid;
@@ -9744,6 +11147,79 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 	}
 	list_iterator_destroy(itr);
 
+fini:
+
+	/* put the real record count in the message body header */
+	tmp_offset = get_buf_offset(buffer);
+	set_buf_offset(buffer, 0);
+	pack32(jobs_packed, buffer);
+	set_buf_offset(buffer, tmp_offset);
+
+	*buffer_size = get_buf_offset(buffer);
+	buffer_ptr[0] = xfer_buf_data(buffer);
+}
+
+/*
+ * pack_job_delta - dump job information for jobs whose packed record changed
+ *	since a given time, followed by the IDs of jobs removed since then,
+ *	in machine independent form (for network transmission)
+ * OUT buffer_ptr - the pointer is set to the allocated buffer.
+ * OUT buffer_size - set to size of the buffer in bytes
+ * IN show_flags - job filtering options
+ * IN uid - uid of user making request (for partition filtering)
+ * IN since - last_update of the client's previous job information
+ * IN protocol_version - slurm protocol version of client
+ * RET SLURM_SUCCESS or SLURM_ERROR if the changes since that time are not
+ *	known, use pack_all_jobs() instead
+ * global: job_list - global list of job records
+ * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
+ * NOTE: change _unpack_job_info_delta_msg() in common/slurm_protocol_pack.c
+ *	whenever the data format changes
+ */
+extern int pack_job_delta(char **buffer_ptr, int *buffer_size,
+			  uint16_t show_flags, uid_t uid, time_t since,
+			  uint16_t protocol_version)
+{
+	uint32_t i, jobs_packed = 0, removed_cnt = 0, tmp_offset;
+	uint32_t *removed_id = NULL;
+	job_cache_t *cache;
+	job_cache_rec_t *rec;
+	Buf buffer;
+
+	buffer_ptr[0] = NULL;
+	*buffer_size = 0;
+
+	if (!_job_cache_usable(uid, show_flags, NO_VAL))
+		return SLURM_ERROR;
+
+	slurm_mutex_lock(&job_cache_mutex);
+	cache = _job_cache_get(show_flags, (uid == 0), protocol_version);
+	if (since <= cache->delta_start) {
+		slurm_mutex_unlock(&job_cache_mutex);
+		return SLURM_ERROR;
+	}
+
+	buffer = init_buf(BUF_SIZE);
+	pack32(jobs_packed, buffer);
+	pack_time(cache->build_time, buffer);
+	for (i = 0; i < cache->rec_cnt; i++) {
+		rec = &cache->recs[i];
+		if (rec->change_time < since)
+			continue;
+		packmem_array(get_buf_data(cache->buffer) + rec->offset,
+			      rec->size, buffer);
+		jobs_packed++;
+	}
+
+	removed_id = xcalloc(cache->removed_cnt + 1, sizeof(uint32_t));
+	for (i = 0; i < cache->removed_cnt; i++) {
+		if (cache->removed_time[i] >= since)
+			removed_id[removed_cnt++] = cache->removed_id[i];
+	}
+	slurm_mutex_unlock(&job_cache_mutex);
+	pack32_array(removed_id, removed_cnt, buffer);
+	xfree(removed_id);
+
 	/* put the real record count in the message body header */
 	tmp_offset = get_buf_offset(buffer);
 	set_buf_offset(buffer, 0);
@@ -9752,6 +11228,8 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 
 	*buffer_size = get_buf_offset(buffer);
 	buffer_ptr[0] = xfer_buf_data(buffer);
+
+	return SLURM_SUCCESS;
 }
 
 /*
@@ -11057,6 +12535,97 @@ extern void unlink_job_record(job_record_t *job_ptr)
 	slurm_mutex_unlock(&purge_thread_lock);
 }
 
+/* Node bitmaps of one job, built by _reset_job_node_bitmaps() */
+typedef struct {
+	job_record_t *job_ptr;
+	bitstr_t *node_bitmap;
+	bitstr_t *node_bitmap_cg;
+	int rc;			/* of node_name2bitmap() for nodes */
+	int rc_cg;		/* of node_name2bitmap() for nodes_completing */
+} job_node_bitmaps_t;
+
+typedef struct {
+	pthread_mutex_t mutex;
+	job_node_bitmaps_t *jobs;
+	uint32_t job_cnt;
+	uint32_t next;		/* first job not yet taken by a thread */
+} job_node_bitmaps_work_t;
+
+#define JOB_NODE_BITMAPS_BLOCK 256
+
+static void _job_node_bitmaps(job_node_bitmaps_t *bitmaps)
+{
+	job_record_t *job_ptr = bitmaps->job_ptr;
+
+	if (job_ptr->nodes_completing)
+		bitmaps->rc_cg = node_name2bitmap(job_ptr->nodes_completing,
+						  false,
+						  &bitmaps->node_bitmap_cg);
+	if (job_ptr->nodes)
+		bitmaps->rc = node_name2bitmap(job_ptr->nodes, false,
+					       &bitmaps->node_bitmap);
+}
+
+static void *_job_node_bitmaps_thread(void *arg)
+{
+	job_node_bitmaps_work_t *work = arg;
+	uint32_t i, end;
+
+	while (1) {
+		slurm_mutex_lock(&work->mutex);
+		i = work->next;
+		end = MIN(i + JOB_NODE_BITMAPS_BLOCK, work->job_cnt);
+		work->next = end;
+		slurm_mutex_unlock(&work->mutex);
+		if (i >= end)
+			break;
+		for ( ; i < end; i++)
+			_job_node_bitmaps(&work->jobs[i]);
+	}
+
+	return NULL;
+}
+
+/*
+ * Translate the node lists of all jobs into bitmaps, using as many threads as
+ * state recovery does. Node names are only looked up here, so this is the
+ * part of reset_job_bitmaps() that can run in parallel.
+ * OUT job_cnt - number of records returned
+ * RET bitmaps of each job in job_list order, free with xfree()
+ */
+static job_node_bitmaps_t *_reset_job_node_bitmaps(uint32_t *job_cnt)
+{
+	job_node_bitmaps_work_t work;
+	ListIterator job_iterator;
+	job_record_t *job_ptr;
+	pthread_t *threads;
+	int thread_cnt, i;
+
+	memset(&work, 0, sizeof(work));
+	work.jobs = xcalloc(MAX(list_count(job_list), 1),
+			    sizeof(job_node_bitmaps_t));
+	job_iterator = list_iterator_create(job_list);
+	while ((job_ptr = list_next(job_iterator)))
+		work.jobs[work.job_cnt++].job_ptr = job_ptr;
+	list_iterator_destroy(job_iterator);
+
+	thread_cnt = _job_recover_threads();
+	thread_cnt = MIN(thread_cnt, (work.job_cnt / JOB_NODE_BITMAPS_BLOCK));
+	slurm_mutex_init(&work.mutex);
+	threads = xcalloc(MAX(thread_cnt, 1), sizeof(pthread_t));
+	for (i = 1; i < thread_cnt; i++)
+		slurm_thread_create(&threads[i], _job_node_bitmaps_thread,
+				    &work);
+	(void) _job_node_bitmaps_thread(&work);
+	for (i = 1; i < thread_cnt; i++)
+		pthread_join(threads[i], NULL);
+	xfree(threads);
+	slurm_mutex_destroy(&work.mutex);
+
+	*job_cnt = work.job_cnt;
+	return work.jobs;
+}
+
 /*
  * reset_job_bitmaps - reestablish bitmaps for existing jobs.
  *	this should be called after rebuilding node information,
@@ -11074,6 +12643,8 @@ void reset_job_bitmaps(void)
 	time_t now = time(NULL);
 	bool gang_flag = false;
 	static uint32_t cr_flag = NO_VAL;
+	job_node_bitmaps_t *bitmaps, *job_bitmaps, unlisted_bitmaps;
+	uint32_t bitmap_cnt, bitmap_inx = 0;
 
 	xassert(job_list);
 
@@ -11088,10 +12659,17 @@ void reset_job_bitmaps(void)
 	if (slurmctld_conf.preempt_mode & PREEMPT_MODE_GANG)
 		gang_flag = true;
 
+	bitmaps = _reset_job_node_bitmaps(&bitmap_cnt);
 	job_iterator = list_iterator_create(job_list);
 	while ((job_ptr = list_next(job_iterator))) {
 		xassert (job_ptr->magic == JOB_MAGIC);
 		job_fail = false;
+		job_bitmaps = NULL;
+		if ((bitmap_inx < bitmap_cnt) &&
+		    (bitmaps[bitmap_inx].job_ptr == job_ptr))
+			job_bitmaps = &bitmaps[bitmap_inx++];
+		else	/* job_list changed, should never happen */
+			error("%s: no node bitmaps for %pJ", __func__, job_ptr);
 
 		if (job_ptr->partition == NULL) {
 			error("No partition for %pJ", job_ptr);
@@ -11125,17 +12703,21 @@ void reset_job_bitmaps(void)
 		}
 
 		FREE_NULL_BITMAP(job_ptr->node_bitmap_cg);
-		if (job_ptr->nodes_completing &&
-		    node_name2bitmap(job_ptr->nodes_completing,
-				     false,  &job_ptr->node_bitmap_cg)) {
+		FREE_NULL_BITMAP(job_ptr->node_bitmap);
+		if (!job_bitmaps) {
+			memset(&unlisted_bitmaps, 0, sizeof(unlisted_bitmaps));
+			unlisted_bitmaps.job_ptr = job_ptr;
+			_job_node_bitmaps(&unlisted_bitmaps);
+			job_bitmaps = &unlisted_bitmaps;
+		}
+		job_ptr->node_bitmap_cg = job_bitmaps->node_bitmap_cg;
+		job_ptr->node_bitmap = job_bitmaps->node_bitmap;
+		if (job_bitmaps->rc_cg) {
 			error("Invalid nodes (%s) for %pJ",
 			      job_ptr->nodes_completing, job_ptr);
 			job_fail = true;
 		}
-		FREE_NULL_BITMAP(job_ptr->node_bitmap);
-		if (job_ptr->nodes &&
-		    node_name2bitmap(job_ptr->nodes, false,
-				     &job_ptr->node_bitmap) && !job_fail) {
+		if (job_bitmaps->rc && !job_fail) {
 			error("Invalid nodes (%s) for %pJ",
 			      job_ptr->nodes, job_ptr);
 			job_fail = true;
@@ -11185,16 +12767,16 @@ void reset_job_bitmaps(void)
 			if (IS_JOB_PENDING(job_ptr)) {
 				job_ptr->start_time =
 					job_ptr->end_time = time(NULL);
-				job_ptr->job_state = JOB_NODE_FAIL;
+				job_state_set(job_ptr, JOB_NODE_FAIL);
 			} else if (IS_JOB_RUNNING(job_ptr)) {
 				job_ptr->end_time = time(NULL);
-				job_ptr->job_state = JOB_NODE_FAIL |
-						     JOB_COMPLETING;
+				job_state_set(job_ptr,
+					      JOB_NODE_FAIL | JOB_COMPLETING);
 				build_cg_bitmap(job_ptr);
 			} else if (IS_JOB_SUSPENDED(job_ptr)) {
 				job_ptr->end_time = job_ptr->suspend_time;
-				job_ptr->job_state = JOB_NODE_FAIL |
-						     JOB_COMPLETING;
+				job_state_set(job_ptr,
+					      JOB_NODE_FAIL | JOB_COMPLETING);
 				build_cg_bitmap(job_ptr);
 				job_ptr->tot_sus_time +=
 					difftime(now, job_ptr->suspend_time);
@@ -11210,6 +12792,7 @@ void reset_job_bitmaps(void)
 			}
 		}
 	}
+	xfree(bitmaps);
 
 	list_iterator_reset(job_iterator);
 	/* This will reinitialize the select plugin database, which
@@ -11370,6 +12953,7 @@ extern void set_job_prio(job_record_t *job_ptr)
 		return;
 	job_ptr->priority = slurm_sched_g_initial_priority(lowest_prio,
 							   job_ptr);
+	job_record_changed(job_ptr);
 	if ((job_ptr->priority == 0) || (job_ptr->direct_set_prio))
 		return;
 
@@ -11594,7 +13178,7 @@ static void _release_job_rec(job_record_t *job_ptr, uid_t uid)
 	set_job_prio(job_ptr);
 	job_ptr->state_reason = WAIT_NO_REASON;
 	job_ptr->state_reason_prev = WAIT_NO_REASON;
-	job_ptr->job_state &= ~JOB_SPECIAL_EXIT;
+	job_state_unset_flag(job_ptr, JOB_SPECIAL_EXIT);
 	xfree(job_ptr->state_desc);
 	job_ptr->exit_code = 0;
 	fed_mgr_job_requeue(job_ptr); /* submit sibling jobs */
@@ -11796,6 +13380,7 @@ static int _update_job(job_record_t *job_ptr, job_desc_msg_t *job_specs,
 		    (job_specs->burst_buffer[0] == '\0')) {
 			xfree(job_ptr->burst_buffer);
 			last_job_update = now;
+			job_record_changed(job_ptr);
 		} else {
 			error_code = ESLURM_NOT_SUPPORTED;
 		}
@@ -11896,6 +13481,7 @@ static int _update_job(job_record_t *job_ptr, job_desc_msg_t *job_specs,
 	if (detail_ptr)
 		mc_ptr = detail_ptr->mc_ptr;
 	last_job_update = now;
+	job_record_changed(job_ptr);
 
 	/*
 	 * Check to see if the new requested job_specs exceeds any
@@ -13457,8 +15043,9 @@ static int _update_job(job_record_t *job_ptr, job_desc_msg_t *job_specs,
 				orig_job_node_bitmap = NULL;
 				deallocate_nodes(job_ptr, false, false, false);
 				bit_clear_all(job_ptr->node_bitmap);
-				job_ptr->job_state &= JOB_STATE_FLAGS;
-				job_ptr->job_state |= JOB_COMPLETE;
+				job_state_set(job_ptr,
+					      (job_ptr->job_state &
+					       JOB_STATE_FLAGS) | JOB_COMPLETE);
 				_realloc_nodes(expand_job_ptr,
 					       orig_jobx_node_bitmap);
 				rebuild_step_bitmaps(expand_job_ptr,
@@ -14455,7 +16042,7 @@ extern void job_pre_resize_acctg(job_record_t *job_ptr)
 	    && !job_ptr->resize_time)
 		jobacct_storage_g_job_start(acct_db_conn, job_ptr);
 
-	job_ptr->job_state |= JOB_RESIZING;
+	job_state_set_flag(job_ptr, JOB_RESIZING);
 	/* NOTE: job_completion_logger() calls
 	 *	 acct_policy_remove_job_submit() */
 	job_completion_logger(job_ptr, false);
@@ -14493,7 +16080,7 @@ extern void job_post_resize_acctg(job_record_t *job_ptr)
 	jobacct_storage_g_job_start(acct_db_conn, job_ptr);
 
 	job_ptr->details->submit_time = org_submit;
-	job_ptr->job_state &= (~JOB_RESIZING);
+	job_state_unset_flag(job_ptr, JOB_RESIZING);
 
 	/*
 	 * Reset the end_time_exp that was probably set to NO_VAL when
@@ -15034,6 +16621,7 @@ extern int job_alloc_info_ptr(uint32_t uid, job_record_t *job_ptr)
 	    (prolog == 0) && job_ptr->node_bitmap &&
 	    (bit_overlap_any(power_node_bitmap, job_ptr->node_bitmap) == 0)) {
 		last_job_update = time(NULL);
+		job_record_changed(job_ptr);
 		set_job_alias_list(job_ptr);
 	}
 
@@ -15155,7 +16743,7 @@ static int _test_state_dir_flag(void *x, void *arg)
 		return 0;	/* No files expected */
 
 	error("Script for %pJ lost, state set to FAILED", job_ptr);
-	job_ptr->job_state = JOB_FAILED;
+	job_state_set(job_ptr, JOB_FAILED);
 	job_ptr->exit_code = 1;
 	job_ptr->state_reason = FAIL_SYSTEM;
 	xfree(job_ptr->state_desc);
@@ -15537,9 +17125,15 @@ void job_fini (void)
 	xfree(job_hash);
 	xfree(job_array_hash_j);
 	xfree(job_array_hash_t);
+	xhash_free(job_array_index);
+	depend_graph_fini();
 	FREE_NULL_LIST(purge_files_list);
 	FREE_NULL_BITMAP(requeue_exit);
 	FREE_NULL_BITMAP(requeue_exit_hold);
+	_job_cache_fini();
+	_job_journal_reset();
+	xfree(job_journal_purge);
+	job_journal_purge_cnt = job_journal_purge_size = 0;
 }
 
 /* Record the start of one job array task */
@@ -15658,7 +17252,7 @@ extern void job_completion_logger(job_record_t *job_ptr, bool requeue)
 	     (arr_finished = test_job_array_finished(job_ptr->array_job_id)))) {
 		/* Remove configuring state just to make sure it isn't there
 		 * since it will throw off displays of the job. */
-		job_ptr->job_state &= ~JOB_CONFIGURING;
+		job_state_unset_flag(job_ptr, JOB_CONFIGURING);
 
 		/* make sure all parts of the job are notified
 		 * Fed Jobs: only signal the srun from where the job is running
@@ -15859,6 +17453,7 @@ extern int job_node_ready(uint32_t job_id, int *ready)
 	    job_ptr->node_bitmap &&
 	    (bit_overlap_any(power_node_bitmap, job_ptr->node_bitmap) == 0)) {
 		last_job_update = time(NULL);
+		job_record_changed(job_ptr);
 		set_job_alias_list(job_ptr);
 	}
 
@@ -16111,6 +17706,7 @@ static int _suspend_job_nodes(job_record_t *job_ptr, bool indf_susp)
 		}
 	}
 	last_job_update = last_node_update = now;
+	job_record_changed(job_ptr);
 	return rc;
 }
 
@@ -16171,6 +17767,7 @@ static int _resume_job_nodes(job_record_t *job_ptr, bool indf_susp)
 		node_ptr->node_state = NODE_STATE_ALLOCATED | node_flags;
 	}
 	last_job_update = last_node_update = time(NULL);
+	job_record_changed(job_ptr);
 	return rc;
 }
 
@@ -16264,7 +17861,7 @@ static int _job_suspend_op(job_record_t *job_ptr, uint16_t op, bool indf_susp)
 		if (rc != SLURM_SUCCESS)
 			return rc;
 		_suspend_job(job_ptr, op, indf_susp);
-		job_ptr->job_state = JOB_SUSPENDED;
+		job_state_set(job_ptr, JOB_SUSPENDED);
 		if (indf_susp) {    /* Job being manually suspended, not gang */
 			debug("%s: Holding %pJ, suspend operation",
 			      __func__, job_ptr);
@@ -16292,7 +17889,7 @@ static int _job_suspend_op(job_record_t *job_ptr, uint16_t op, bool indf_susp)
 			set_job_prio(job_ptr);
 			(void) gs_job_start(job_ptr);
 		}
-		job_ptr->job_state = JOB_RUNNING;
+		job_state_set(job_ptr, JOB_RUNNING);
 		job_ptr->tot_sus_time +=
 			difftime(now, job_ptr->suspend_time);
 
@@ -16655,6 +18252,7 @@ static int _job_requeue_op(uid_t uid, job_record_t *job_ptr, bool preempt,
 	}
 
 	last_job_update = now;
+	job_record_changed(job_ptr);
 
 	/*
 	 * In the job is in the process of completing
@@ -16673,9 +18271,9 @@ static int _job_requeue_op(uid_t uid, job_record_t *job_ptr, bool preempt,
 		 * we can't have it as suspended when we call the
 		 * accounting stuff.
 		 */
-		job_ptr->job_state = JOB_REQUEUE;
+		job_state_set(job_ptr, JOB_REQUEUE);
 		jobacct_storage_g_job_suspend(acct_db_conn, job_ptr);
-		job_ptr->job_state = suspend_job_state;
+		job_state_set(job_ptr, suspend_job_state);
 		is_suspended = true;
 	}
 
@@ -16704,12 +18302,12 @@ static int _job_requeue_op(uid_t uid, job_record_t *job_ptr, bool preempt,
 		 * job looks like a new job.
 		 */
 		if (preempt) {
-			job_ptr->job_state = JOB_PREEMPTED;
+			job_state_set(job_ptr, JOB_PREEMPTED);
 			build_cg_bitmap(job_ptr);
 			job_completion_logger(job_ptr, false);
-			job_ptr->job_state = JOB_REQUEUE;
+			job_state_set(job_ptr, JOB_REQUEUE);
 		} else {
-			job_ptr->job_state = JOB_REQUEUE;
+			job_state_set(job_ptr, JOB_REQUEUE);
 			build_cg_bitmap(job_ptr);
 			job_completion_logger(job_ptr, true);
 		}
@@ -16723,7 +18321,7 @@ static int _job_requeue_op(uid_t uid, job_record_t *job_ptr, bool preempt,
 	job_ptr->restart_cnt++;
 
 	if (is_completing) {
-		job_ptr->job_state = JOB_PENDING | completing_flags;
+		job_state_set(job_ptr, JOB_PENDING | completing_flags);
 		goto reply;
 	}
 
@@ -16732,18 +18330,18 @@ static int _job_requeue_op(uid_t uid, job_record_t *job_ptr, bool preempt,
 	 * JOB_COMPLETING is needed to properly clean up steps.
 	 */
 	if (is_running) {
-		job_ptr->job_state |= JOB_COMPLETING;
+		job_state_set_flag(job_ptr, JOB_COMPLETING);
 		deallocate_nodes(job_ptr, false, is_suspended, preempt);
-		job_ptr->job_state &= (~JOB_COMPLETING);
+		job_state_unset_flag(job_ptr, JOB_COMPLETING);
 	}
 
 	/* do this after the epilog complete, setting it here is too early */
 	//job_ptr->db_index = 0;
 	//job_ptr->details->submit_time = now;
 
-	job_ptr->job_state = JOB_PENDING;
+	job_state_set(job_ptr, JOB_PENDING);
 	if (job_ptr->node_cnt)
-		job_ptr->job_state |= JOB_COMPLETING;
+		job_state_set_flag(job_ptr, JOB_COMPLETING);
 
 	/*
 	 * Mark the origin job as requeueing. Will finish requeueing fed job
@@ -16755,8 +18353,8 @@ static int _job_requeue_op(uid_t uid, job_record_t *job_ptr, bool preempt,
 	 * reports that the job is finished.
 	 */
 	if (job_ptr->fed_details && !is_completed) {
-		job_ptr->job_state |= JOB_COMPLETING;
-		job_ptr->job_state |= JOB_REQUEUE_FED;
+		job_state_set_flag(job_ptr, JOB_COMPLETING);
+		job_state_set_flag(job_ptr, JOB_REQUEUE_FED);
 	}
 
 	/*
@@ -16787,7 +18385,7 @@ reply:
 	acct_policy_update_pending_job(job_ptr);
 
 	if (flags & JOB_SPECIAL_EXIT) {
-		job_ptr->job_state |= JOB_SPECIAL_EXIT;
+		job_state_set_flag(job_ptr, JOB_SPECIAL_EXIT);
 		job_ptr->state_reason = WAIT_HELD_USER;
 		xfree(job_ptr->state_desc);
 		job_ptr->state_desc =
@@ -17175,6 +18773,7 @@ static int _set_top(List top_job_list, uid_t uid)
 		job_ptr->priority = next_prio;
 		job_ptr->details->nice -= delta_nice;
 		job_ptr->bit_flags &= (~TOP_PRIO_TMP);
+		job_record_changed(job_ptr);
 	}
 	list_iterator_destroy(iter);
 	FREE_NULL_LIST(prio_list);
@@ -17193,6 +18792,7 @@ static int _set_top(List top_job_list, uid_t uid)
 			job_ptr->priority = next_prio;
 			job_ptr->details->nice += delta_nice;
 			job_ptr->bit_flags &= (~TOP_PRIO_TMP);
+			job_record_changed(job_ptr);
 			total_delta -= delta_nice;
 			if (--other_job_cnt == 0)
 				break;	/* Count will match list size anyway */
@@ -17480,6 +19080,7 @@ extern int update_job_wckey(char *module, job_record_t *job_ptr,
 	}
 
 	last_job_update = time(NULL);
+	job_record_changed(job_ptr);
 
 	return SLURM_SUCCESS;
 }
@@ -17680,11 +19281,11 @@ extern void build_cg_bitmap(job_record_t *job_ptr)
 	if (job_ptr->node_bitmap) {
 		job_ptr->node_bitmap_cg = bit_copy(job_ptr->node_bitmap);
 		if (bit_set_count(job_ptr->node_bitmap_cg) == 0)
-			job_ptr->job_state &= (~JOB_COMPLETING);
+			job_state_unset_flag(job_ptr, JOB_COMPLETING);
 	} else {
 		error("build_cg_bitmap: node_bitmap is NULL");
 		job_ptr->node_bitmap_cg = bit_alloc(node_record_count);
-		job_ptr->job_state &= (~JOB_COMPLETING);
+		job_state_unset_flag(job_ptr, JOB_COMPLETING);
 	}
 }
 
@@ -17751,7 +19352,7 @@ extern bool job_hold_requeue(job_record_t *job_ptr)
 
 	/* Set the job pending */
 	flags = job_ptr->job_state & JOB_STATE_FLAGS;
-	job_ptr->job_state = JOB_PENDING | flags;
+	job_state_set(job_ptr, JOB_PENDING | flags);
 
 	job_ptr->restart_cnt++;
 
@@ -17767,13 +19368,13 @@ extern bool job_hold_requeue(job_record_t *job_ptr)
 		 * JOB_SPECIAL_EXIT means requeue the job,
 		 * put it on hold and display state as JOB_SPECIAL_EXIT.
 		 */
-		job_ptr->job_state |= JOB_SPECIAL_EXIT;
+		job_state_set_flag(job_ptr, JOB_SPECIAL_EXIT);
 		job_ptr->state_reason = WAIT_HELD_USER;
 		debug("%s: Holding %pJ, special exit", __func__, job_ptr);
 		job_ptr->priority = 0;
 	}
 
-	job_ptr->job_state &= ~JOB_REQUEUE;
+	job_state_unset_flag(job_ptr, JOB_REQUEUE);
 
 	/*
 	 * Mark array as requeued. Exit codes have already been handled in
@@ -17920,7 +19521,7 @@ static void _set_job_requeue_exit_value(job_record_t *job_ptr)
 	if (requeue_exit && bit_test(requeue_exit, exit_code)) {
 		debug2("%s: %pJ exit code %d state JOB_REQUEUE",
 		       __func__, job_ptr, exit_code);
-		job_ptr->job_state |= JOB_REQUEUE;
+		job_state_set_flag(job_ptr, JOB_REQUEUE);
 		return;
 	}
 
@@ -17928,8 +19529,8 @@ static void _set_job_requeue_exit_value(job_record_t *job_ptr)
 		/* Not sure if want to set special exit state in this case */
 		debug2("%s: %pJ exit code %d state JOB_SPECIAL_EXIT",
 		       __func__, job_ptr, exit_code);
-		job_ptr->job_state |= JOB_REQUEUE;
-		job_ptr->job_state |= JOB_SPECIAL_EXIT;
+		job_state_set_flag(job_ptr, JOB_REQUEUE);
+		job_state_set_flag(job_ptr, JOB_SPECIAL_EXIT);
 		return;
 	}
 }
@@ -18017,7 +19618,7 @@ extern job_record_t *job_array_post_sched(job_record_t *job_ptr)
 		 * sets things up so the db_index isn't lost but the
 		 * start message is still sent to get the desired behavior. */
 		if (job_ptr->db_index)
-			job_ptr->job_state |= JOB_UPDATE_DB;
+			job_state_set_flag(job_ptr, JOB_UPDATE_DB);
 
 		/* If job is requeued, it will already be in the hash table */
 		if (!find_job_array_rec(job_ptr->array_job_id,
@@ -18028,7 +19629,7 @@ extern job_record_t *job_array_post_sched(job_record_t *job_ptr)
 	} else {
 		new_job_ptr = job_array_split(job_ptr);
 		if (new_job_ptr) {
-			new_job_ptr->job_state = JOB_PENDING;
+			job_state_set(new_job_ptr, JOB_PENDING);
 			new_job_ptr->start_time = (time_t) 0;
 			/* Do NOT set the JOB_UPDATE_DB flag here, it
 			 * is handled when task_id_str is created elsewhere */
@@ -18052,11 +19653,12 @@ static void _kill_dependent(job_record_t *job_ptr)
 
 	info("%s: Job dependency can't be satisfied, cancelling %pJ",
 	     __func__, job_ptr);
-	job_ptr->job_state = JOB_CANCELLED;
+	job_state_set(job_ptr, JOB_CANCELLED);
 	job_ptr->start_time = now;
 	job_ptr->end_time = now;
 	job_completion_logger(job_ptr, false);
 	last_job_update = now;
+	job_record_changed(job_ptr);
 	srun_allocate_abort(job_ptr);
 }
 
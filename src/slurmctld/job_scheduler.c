@@ -73,6 +73,7 @@
 #include "src/common/track_script.h"
 #include "src/common/uid.h"
 #include "src/common/xassert.h"
+#include "src/common/xhash.h"
 #include "src/common/xstring.h"
 
 #include "src/slurmctld/acct_policy.h"
@@ -106,6 +107,18 @@ typedef struct wait_boot_arg {
 	bitstr_t *node_bitmap;
 } wait_boot_arg_t;
 
+/* Dependency graph reverse edge, see depend_graph_notify() */
+typedef struct {
+	uint32_t job_id;	/* dependent job */
+	uint32_t gen;		/* dependent's depend_gen when added */
+} depend_edge_t;
+
+/* Jobs waiting on one job ID */
+typedef struct {
+	uint32_t job_id;	/* dependee job or job array */
+	List edges;		/* depend_edge_t */
+} depend_node_t;
+
 static batch_job_launch_msg_t *_build_launch_job_msg(job_record_t *job_ptr,
 						     uint16_t protocol_version);
 static void	_job_queue_append(List job_queue, job_record_t *job_ptr,
@@ -134,6 +147,7 @@ static uint16_t bf_hetjob_prio = 0;
 static int sched_min_interval = 2;
 
 static int bb_array_stage_cnt = 10;
+static xhash_t *depend_graph = NULL;
 extern diag_stats_t slurmctld_diag_stats;
 
 static int _find_singleton_job (void *x, void *key)
@@ -292,6 +306,7 @@ static bool _job_runnable_test1(job_record_t *job_ptr, bool sched_plugin)
 		job_ptr->state_reason = WAIT_NO_REASON;
 		xfree(job_ptr->state_desc);
 		last_job_update = now;
+		job_record_changed(job_ptr);
 	}
 #endif
 
@@ -308,6 +323,7 @@ static bool _job_runnable_test1(job_record_t *job_ptr, bool sched_plugin)
 			job_ptr->state_reason = WAIT_HELD;
 			xfree(job_ptr->state_desc);
 			last_job_update = now;
+			job_record_changed(job_ptr);
 		}
 		sched_debug3("%pJ. State=%s. Reason=%s. Priority=%u.",
 			     job_ptr,
@@ -446,7 +462,7 @@ extern List build_job_queue(bool clear_start, bool backfill)
 		if (new_job_ptr) {
 			debug("%s: Split out %pJ for burst buffer use",
 			      __func__, job_ptr);
-			new_job_ptr->job_state = JOB_PENDING;
+			job_state_set(new_job_ptr, JOB_PENDING);
 			new_job_ptr->start_time = (time_t) 0;
 			/* Do NOT clear db_index here, it is handled when
 			 * task_id_str is created elsewhere */
@@ -505,7 +521,7 @@ extern List build_job_queue(bool clear_start, bool backfill)
 		if (new_job_ptr) {
 			info("%s: Split out %pJ for SLURM_DEPEND_AFTER_CORRESPOND use",
 			     __func__, job_ptr);
-			new_job_ptr->job_state = JOB_PENDING;
+			job_state_set(new_job_ptr, JOB_PENDING);
 			new_job_ptr->start_time = (time_t) 0;
 			/* Do NOT clear db_index here, it is handled when
 			 * task_id_str is created elsewhere */
@@ -543,18 +559,26 @@ extern List build_job_queue(bool clear_start, bool backfill)
 		if (job_ptr->state_reason != WAIT_NO_REASON) {
 			job_ptr->state_reason_prev = job_ptr->state_reason;
 			if ((job_ptr->state_reason != WAIT_PRIORITY) &&
-			    (job_ptr->state_reason != WAIT_RESOURCES))
+			    (job_ptr->state_reason != WAIT_RESOURCES) &&
+			    (job_ptr->state_reason_prev_db !=
+			     job_ptr->state_reason)) {
 				job_ptr->state_reason_prev_db =
 					job_ptr->state_reason;
+				job_record_changed(job_ptr);
+			}
 			last_job_update = now;
 		} else if ((job_ptr->state_reason_prev == WAIT_TIME) &&
 			   job_ptr->details &&
 			   (job_ptr->details->begin_time <= now)) {
 			job_ptr->state_reason_prev = job_ptr->state_reason;
 			if ((job_ptr->state_reason != WAIT_PRIORITY) &&
-			    (job_ptr->state_reason != WAIT_RESOURCES))
+			    (job_ptr->state_reason != WAIT_RESOURCES) &&
+			    (job_ptr->state_reason_prev_db !=
+			     job_ptr->state_reason)) {
 				job_ptr->state_reason_prev_db =
 					job_ptr->state_reason;
+				job_record_changed(job_ptr);
+			}
 			last_job_update = now;
 		}
 		if (!_job_runnable_test1(job_ptr, clear_start))
@@ -572,6 +596,7 @@ extern List build_job_queue(bool clear_start, bool backfill)
 					job_ptr->state_reason = reason;
 					xfree(job_ptr->state_desc);
 					last_job_update = now;
+					job_record_changed(job_ptr);
 				}
 				/* priority_array index matches part_ptr_list
 				 * position: increment inx */
@@ -911,7 +936,8 @@ extern bool deadline_ok(job_record_t *job_ptr, char *func)
 	}
 	if (fail_job) {
 		last_job_update = now;
-		job_ptr->job_state = JOB_DEADLINE;
+		job_record_changed(job_ptr);
+		job_state_set(job_ptr, JOB_DEADLINE);
 		job_ptr->exit_code = 1;
 		job_ptr->state_reason = FAIL_DEADLINE;
 		xfree(job_ptr->state_desc);
@@ -1378,6 +1404,7 @@ static int _schedule(uint32_t job_limit)
 				job_ptr->state_reason = WAIT_FRONT_END;
 				xfree(job_ptr->state_desc);
 				last_job_update = now;
+				job_record_changed(job_ptr);
 				continue;
 			}
 			if (!_job_runnable_test1(job_ptr, false))
@@ -1421,6 +1448,7 @@ next_part:
 				job_ptr->state_reason = WAIT_FRONT_END;
 				xfree(job_ptr->state_desc);
 				last_job_update = now;
+				job_record_changed(job_ptr);
 				continue;
 			}
 			if ((job_ptr->array_task_id != array_task_id) &&
@@ -1576,6 +1604,7 @@ next_task:
 					     job_ptr->priority);
 			}
 			last_job_update = now;
+			job_record_changed(job_ptr);
 
 			continue;
 		} else if (wait_on_resv &&
@@ -1603,6 +1632,7 @@ next_task:
 				xfree(job_ptr->state_desc);
 				job_ptr->assoc_id = assoc_rec.id;
 				last_job_update = now;
+				job_record_changed(job_ptr);
 			} else {
 				sched_debug("%pJ has invalid association",
 					    job_ptr);
@@ -1629,11 +1659,13 @@ next_task:
 				sched_debug("%pJ has invalid QOS", job_ptr);
 				job_fail_qos(job_ptr, __func__);
 				last_job_update = now;
+				job_record_changed(job_ptr);
 				continue;
 			} else if (job_ptr->state_reason == FAIL_QOS) {
 				xfree(job_ptr->state_desc);
 				job_ptr->state_reason = WAIT_NO_REASON;
 				last_job_update = now;
+				job_record_changed(job_ptr);
 			}
 			assoc_mgr_unlock(&locks);
 		}
@@ -1691,6 +1723,7 @@ next_task:
 			xfree(job_ptr->state_desc);
 			job_ptr->state_desc = xstrdup("Nodes required for job are DOWN, DRAINED or reserved for jobs in higher priority partitions");
 			last_job_update = now;
+			job_record_changed(job_ptr);
 			sched_debug3("%pJ. State=%s. Reason=%s. Priority=%u. Partition=%s.",
 				     job_ptr,
 				     job_state_string(job_ptr->job_state),
@@ -1704,6 +1737,7 @@ next_task:
 			job_ptr->state_reason = WAIT_LICENSES;
 			xfree(job_ptr->state_desc);
 			last_job_update = now;
+			job_record_changed(job_ptr);
 			sched_debug3("%pJ. State=%s. Reason=%s. Priority=%u.",
 				     job_ptr,
 				     job_state_string(job_ptr->job_state),
@@ -1735,6 +1769,7 @@ next_task:
 			 * very rare. */
 			sched_info("%pJ has invalid account", job_ptr);
 			last_job_update = now;
+			job_record_changed(job_ptr);
 			job_ptr->state_reason = FAIL_ACCOUNT;
 			xfree(job_ptr->state_desc);
 			continue;
@@ -1823,6 +1858,7 @@ skip_start:
 			job_ptr->state_reason = WAIT_FED_JOB_LOCK;
 			xfree(job_ptr->state_desc);
 			last_job_update = now;
+			job_record_changed(job_ptr);
 			sched_debug3("%pJ. State=%s. Reason=%s. Priority=%u. Partition=%s.",
 				     job_ptr,
 				     job_state_string(job_ptr->job_state),
@@ -1833,6 +1869,7 @@ skip_start:
 			/* job initiated */
 			sched_debug3("%pJ initiated", job_ptr);
 			last_job_update = now;
+			job_record_changed(job_ptr);
 
 			/* Clear assumed rejected array status */
 			reject_array_job = NULL;
@@ -1883,7 +1920,8 @@ skip_start:
 			sched_info("schedule: %pJ non-runnable: %s",
 				   job_ptr, slurm_strerror(error_code));
 			last_job_update = now;
-			job_ptr->job_state = JOB_PENDING;
+			job_record_changed(job_ptr);
+			job_state_set(job_ptr, JOB_PENDING);
 			job_ptr->state_reason = FAIL_BAD_CONSTRAINTS;
 			xfree(job_ptr->state_desc);
 			job_ptr->start_time = job_ptr->end_time = now;
@@ -2970,6 +3008,129 @@ static void _test_dependency_state(depend_spec_t *dep_ptr, bool *or_satisfied,
 	}
 }
 
+static void _depend_node_id(void *item, const char **key, uint32_t *key_len)
+{
+	depend_node_t *node = item;
+
+	*key = (const char *) &node->job_id;
+	*key_len = sizeof(uint32_t);
+}
+
+static void _depend_node_free(void *item)
+{
+	depend_node_t *node = item;
+
+	FREE_NULL_LIST(node->edges);
+	xfree(node);
+}
+
+/*
+ * Return true if the result of test_job_dependency() for this job can only
+ * change when one of its dependees changes state: all unfulfilled
+ * dependencies are local and do not depend upon time, names or burst buffers.
+ */
+static bool _depend_graph_only(job_record_t *job_ptr)
+{
+	ListIterator depend_iter;
+	depend_spec_t *dep_ptr;
+	bool rc = true;
+
+	depend_iter = list_iterator_create(job_ptr->details->depend_list);
+	while ((dep_ptr = list_next(depend_iter))) {
+		if (dep_ptr->depend_flags & SLURM_FLAGS_REMOTE) {
+			rc = false;
+			break;
+		}
+		if (dep_ptr->depend_state != DEPEND_NOT_FULFILLED)
+			continue;
+		if ((dep_ptr->depend_type == SLURM_DEPEND_AFTER_ANY) ||
+		    (dep_ptr->depend_type == SLURM_DEPEND_AFTER_OK) ||
+		    (dep_ptr->depend_type == SLURM_DEPEND_AFTER_NOT_OK) ||
+		    (dep_ptr->depend_type == SLURM_DEPEND_AFTER_CORRESPOND) ||
+		    ((dep_ptr->depend_type == SLURM_DEPEND_AFTER) &&
+		     !dep_ptr->depend_time))
+			continue;
+		rc = false;
+		break;
+	}
+	list_iterator_destroy(depend_iter);
+
+	return rc;
+}
+
+/*
+ * Add reverse edges from each of the job's unfulfilled dependees to the job,
+ * so the cached LOCAL_DEPEND result is dropped when any of them changes state.
+ * Edges added before are invalidated by bumping depend_gen.
+ */
+static void _depend_graph_add(job_record_t *job_ptr)
+{
+	ListIterator depend_iter;
+	depend_spec_t *dep_ptr;
+	depend_node_t *node;
+	depend_edge_t *edge;
+
+	if (!depend_graph)
+		depend_graph = xhash_init(_depend_node_id, _depend_node_free);
+
+	job_ptr->depend_gen++;
+	depend_iter = list_iterator_create(job_ptr->details->depend_list);
+	while ((dep_ptr = list_next(depend_iter))) {
+		if (dep_ptr->depend_state != DEPEND_NOT_FULFILLED)
+			continue;
+		node = xhash_get(depend_graph, (char *) &dep_ptr->job_id,
+				 sizeof(uint32_t));
+		if (!node) {
+			node = xmalloc(sizeof(depend_node_t));
+			node->job_id = dep_ptr->job_id;
+			node->edges = list_create(xfree_ptr);
+			xhash_add(depend_graph, node);
+		}
+		edge = xmalloc(sizeof(depend_edge_t));
+		edge->job_id = job_ptr->job_id;
+		edge->gen = job_ptr->depend_gen;
+		list_append(node->edges, edge);
+	}
+	list_iterator_destroy(depend_iter);
+
+	job_ptr->depend_cached = true;
+	job_ptr->depend_task_id = job_ptr->array_task_id;
+}
+
+static void _depend_graph_notify_id(uint32_t job_id)
+{
+	depend_node_t *node;
+	depend_edge_t *edge;
+	job_record_t *job_ptr;
+
+	if (!(node = xhash_get(depend_graph, (char *) &job_id,
+			       sizeof(uint32_t))))
+		return;
+
+	while ((edge = list_pop(node->edges))) {
+		if ((job_ptr = find_job_record(edge->job_id)) &&
+		    (job_ptr->depend_gen == edge->gen))
+			job_ptr->depend_cached = false;
+		xfree(edge);
+	}
+	xhash_delete(depend_graph, (char *) &job_id, sizeof(uint32_t));
+}
+
+extern void depend_graph_notify(job_record_t *job_ptr)
+{
+	if (!depend_graph)
+		return;
+
+	_depend_graph_notify_id(job_ptr->job_id);
+	if (job_ptr->array_job_id && (job_ptr->array_job_id != job_ptr->job_id))
+		_depend_graph_notify_id(job_ptr->array_job_id);
+}
+
+extern void depend_graph_fini(void)
+{
+	xhash_free(depend_graph);
+}
+
 /*
  * Determine if a job's dependencies are met
  * Inputs: job_ptr
@@ -3002,6 +3163,17 @@ extern int test_job_dependency(job_record_t *job_ptr, bool *was_changed)
 		return NO_DEPEND;
 	}
 
+	/* No dependee changed state since dependencies were last tested */
+	if (job_ptr->depend_cached &&
+	    (job_ptr->depend_task_id == job_ptr->array_task_id)) {
+		job_ptr->bit_flags |= JOB_DEPENDENT;
+		acct_policy_remove_accrue_time(job_ptr, false);
+		if (was_changed)
+			*was_changed = changed;
+		return LOCAL_DEPEND;
+	}
+	job_ptr->depend_cached = false;
+
 	depend_iter = list_iterator_create(job_ptr->details->depend_list);
 	while ((dep_ptr = list_next(depend_iter))) {
 		bool clear_dep = false, depends = false, failure = false;
@@ -3138,6 +3310,8 @@ extern int test_job_dependency(job_record_t *job_ptr, bool *was_changed)
 			/* Still dependent */
 			results = has_local_depend ? LOCAL_DEPEND :
 				REMOTE_DEPEND;
+		if ((results == LOCAL_DEPEND) && _depend_graph_only(job_ptr))
+			_depend_graph_add(job_ptr);
 	}
 
 	if (was_changed)
@@ -3535,6 +3709,7 @@ extern bool update_job_dependency_list(job_record_t *job_ptr,
 	xassert(job_ptr->details->depend_list);
 
 	job_depend_list = job_ptr->details->depend_list;
+	job_ptr->depend_cached = false;
 
 	itr = list_iterator_create(new_depend_list);
 	while ((dep_ptr = list_next(itr))) {
@@ -3675,6 +3850,8 @@ extern int update_job_dependency(job_record_t *job_ptr, char *new_depend)
 	if (job_ptr->details == NULL)
 		return EINVAL;
 
+	job_ptr->depend_cached = false;
+
 	if (select_hetero == -1) {
 		/*
 		 * Determine if the select plugin supports heterogeneous
@@ -4548,7 +4725,7 @@ extern void prolog_slurmctld(job_record_t *job_ptr)
 	xassert(verify_lock(NODE_LOCK, WRITE_LOCK));
 
 	job_ptr->details->prolog_running++;
-	job_ptr->job_state |= JOB_CONFIGURING;
+	job_state_set_flag(job_ptr, JOB_CONFIGURING);
 
 	*job_id = job_ptr->job_id;
 	slurm_thread_create_detached(NULL, _start_prolog_slurmctld_thread, job_id);
@@ -5007,7 +5184,7 @@ void cleanup_completing(job_record_t *job_ptr)
 	gs_job_fini(job_ptr);
 
 	delete_step_records(job_ptr);
-	job_ptr->job_state &= (~JOB_COMPLETING);
+	job_state_unset_flag(job_ptr, JOB_COMPLETING);
 	job_hold_requeue(job_ptr);
 
 	/*
@@ -98,6 +98,15 @@ extern batch_job_launch_msg_t *build_launch_job_msg(job_record_t *job_ptr,
  */
 extern bool deadline_ok(job_record_t *job_ptr, char *func);
 
+/*
+ * Re-evaluate jobs waiting on the given job on their next dependency test.
+ * Call whenever a job's state changes or its record is purged.
+ */
+extern void depend_graph_notify(job_record_t *job_ptr);
+
+/* Free the dependency graph */
+extern void depend_graph_fini(void);
+
 /*
  * epilog_slurmctld - execute the prolog_slurmctld for a job that has just
  *	terminated.
@@ -42,13 +42,41 @@
 #include <string.h>
 #include <sys/types.h>
 
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
 #include "src/slurmctld/locks.h"
 #include "src/slurmctld/slurmctld.h"
 
+/*
+ * Updated with relaxed atomics by the threads taking each lock, so no mutex
+ * beyond the entity lock itself is taken to account for it
+ */
+typedef struct {
+	uint32_t cnt;
+	uint64_t wait_time;	/* usec spent waiting for the lock */
+	uint64_t hold_time;	/* usec the lock was held */
+	uint32_t hold_max;	/* longest hold, usec */
+	uint32_t hold_hist[LOCK_HIST_BUCKETS];
+} lock_stats_t;
+
 static pthread_mutex_t state_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static pthread_rwlock_t slurmctld_locks[ENTITY_COUNT];
 
+/* Upper bound of each hold time histogram bucket in usec */
+static const uint32_t lock_hist_bound[LOCK_HIST_BUCKETS] = {
+	10, 100, 1000, 10000, 100000, 1000000, INFINITE
+};
+static const char *lock_stats_name[ENTITY_COUNT] = {
+	"config", "job", "node", "partition", "federation"
+};
+/* Indexed by entity and lock level - 1 (read or write) */
+static lock_stats_t lock_stats[ENTITY_COUNT][2];
+
+/* Per thread time at which each entity lock was acquired */
+static pthread_key_t lock_time_key;
+static pthread_once_t lock_time_once = PTHREAD_ONCE_INIT;
+
 #ifndef NDEBUG
 /*
  * Used to protect against double-locking within a single thread. Calling
@@ -102,10 +130,99 @@ extern bool verify_lock(lock_datatype_t datatype, lock_level_t level)
 }
 #endif
 
+static void _lock_time_key_init(void)
+{
+	if (pthread_key_create(&lock_time_key, xfree_ptr))
+		fatal("%s: pthread_key_create: %m", __func__);
+}
+
+static struct timeval *_lock_time_get(void)
+{
+	struct timeval *lock_time;
+
+	pthread_once(&lock_time_once, _lock_time_key_init);
+	if (!(lock_time = pthread_getspecific(lock_time_key))) {
+		lock_time = xcalloc(ENTITY_COUNT, sizeof(struct timeval));
+		pthread_setspecific(lock_time_key, lock_time);
+	}
+
+	return lock_time;
+}
+
+static uint32_t _delta_usec(struct timeval *tv1, struct timeval *tv2)
+{
+	int64_t delta;
+
+	delta = (tv2->tv_sec - tv1->tv_sec) * USEC_IN_SEC;
+	delta += tv2->tv_usec - tv1->tv_usec;
+	if (delta < 0)		/* clock stepped back */
+		return 0;
+	if (delta > INFINITE)
+		return INFINITE - 1;
+	return (uint32_t) delta;
+}
+
+/*
+ * last IN/OUT - time the previous lock of this request was acquired, or the
+ *	request started. Sharing it saves one clock read per lock.
+ */
+static void _lock(lock_datatype_t datatype, lock_level_t level,
+		  struct timeval *lock_time, struct timeval *last)
+{
+	lock_stats_t *stats;
+
+	if (level == NO_LOCK)
+		return;
+
+	if (level == READ_LOCK)
+		slurm_rwlock_rdlock(&slurmctld_locks[datatype]);
+	else
+		slurm_rwlock_wrlock(&slurmctld_locks[datatype]);
+	gettimeofday(&lock_time[datatype], NULL);
+
+	stats = &lock_stats[datatype][level - 1];
+	__atomic_fetch_add(&stats->cnt, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&stats->wait_time,
+			   _delta_usec(last, &lock_time[datatype]),
+			   __ATOMIC_RELAXED);
+	*last = lock_time[datatype];
+}
+
+/* now IN - time the request started releasing its locks */
+static void _unlock(lock_datatype_t datatype, lock_level_t level,
+		    struct timeval *lock_time, struct timeval *now)
+{
+	lock_stats_t *stats;
+	uint32_t hold_time, hold_max;
+	int i;
+
+	if (level == NO_LOCK)
+		return;
+
+	slurm_rwlock_unlock(&slurmctld_locks[datatype]);
+
+	hold_time = _delta_usec(&lock_time[datatype], now);
+	for (i = 0; i < (LOCK_HIST_BUCKETS - 1); i++) {
+		if (hold_time < lock_hist_bound[i])
+			break;
+	}
+	stats = &lock_stats[datatype][level - 1];
+	__atomic_fetch_add(&stats->hold_time, hold_time, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&stats->hold_hist[i], 1, __ATOMIC_RELAXED);
+	hold_max = __atomic_load_n(&stats->hold_max, __ATOMIC_RELAXED);
+	while ((hold_max < hold_time) &&
+	       !__atomic_compare_exchange_n(&stats->hold_max, &hold_max,
+					    hold_time, false,
+					    __ATOMIC_RELAXED,
+					    __ATOMIC_RELAXED))
+		;
+}
+
 /* lock_slurmctld - Issue the required lock requests in a well defined order */
 extern void lock_slurmctld(slurmctld_lock_t lock_levels)
 {
 	static bool init_run = false;
+	struct timeval *lock_time, last;
 	xassert(_store_locks(lock_levels));
 
 	if (!init_run) {
@@ -114,52 +231,101 @@ extern void lock_slurmctld(slurmctld_lock_t lock_levels)
 			slurm_rwlock_init(&slurmctld_locks[i]);
 	}
 
-	if (lock_levels.conf == READ_LOCK)
-		slurm_rwlock_rdlock(&slurmctld_locks[CONF_LOCK]);
-	else if (lock_levels.conf == WRITE_LOCK)
-		slurm_rwlock_wrlock(&slurmctld_locks[CONF_LOCK]);
-
-	if (lock_levels.job == READ_LOCK)
-		slurm_rwlock_rdlock(&slurmctld_locks[JOB_LOCK]);
-	else if (lock_levels.job == WRITE_LOCK)
-		slurm_rwlock_wrlock(&slurmctld_locks[JOB_LOCK]);
-
-	if (lock_levels.node == READ_LOCK)
-		slurm_rwlock_rdlock(&slurmctld_locks[NODE_LOCK]);
-	else if (lock_levels.node == WRITE_LOCK)
-		slurm_rwlock_wrlock(&slurmctld_locks[NODE_LOCK]);
-
-	if (lock_levels.part == READ_LOCK)
-		slurm_rwlock_rdlock(&slurmctld_locks[PART_LOCK]);
-	else if (lock_levels.part == WRITE_LOCK)
-		slurm_rwlock_wrlock(&slurmctld_locks[PART_LOCK]);
-
-	if (lock_levels.fed == READ_LOCK)
-		slurm_rwlock_rdlock(&slurmctld_locks[FED_LOCK]);
-	else if (lock_levels.fed == WRITE_LOCK)
-		slurm_rwlock_wrlock(&slurmctld_locks[FED_LOCK]);
+	lock_time = _lock_time_get();
+	gettimeofday(&last, NULL);
+	_lock(CONF_LOCK, lock_levels.conf, lock_time, &last);
+	_lock(JOB_LOCK, lock_levels.job, lock_time, &last);
+	_lock(NODE_LOCK, lock_levels.node, lock_time, &last);
+	_lock(PART_LOCK, lock_levels.part, lock_time, &last);
+	_lock(FED_LOCK, lock_levels.fed, lock_time, &last);
 }
 
 /* unlock_slurmctld - Issue the required unlock requests in a well
  *	defined order */
 extern void unlock_slurmctld(slurmctld_lock_t lock_levels)
 {
+	struct timeval *lock_time, now;
 	xassert(_clear_locks(lock_levels));
 
-	if (lock_levels.fed)
-		slurm_rwlock_unlock(&slurmctld_locks[FED_LOCK]);
+	lock_time = _lock_time_get();
+	gettimeofday(&now, NULL);
+	_unlock(FED_LOCK, lock_levels.fed, lock_time, &now);
+	_unlock(PART_LOCK, lock_levels.part, lock_time, &now);
+	_unlock(NODE_LOCK, lock_levels.node, lock_time, &now);
+	_unlock(JOB_LOCK, lock_levels.job, lock_time, &now);
+	_unlock(CONF_LOCK, lock_levels.conf, lock_time, &now);
+}
 
-	if (lock_levels.part)
-		slurm_rwlock_unlock(&slurmctld_locks[PART_LOCK]);
+/*
+ * pack_lock_stats - pack wait and hold time statistics of each entity lock
+ *	as one record per entity and lock level
+ */
+extern void pack_lock_stats(Buf buffer, uint16_t protocol_version)
+{
+	uint32_t cnt[ENTITY_COUNT * 2], hold_max[ENTITY_COUNT * 2];
+	uint32_t hist[ENTITY_COUNT * 2 * LOCK_HIST_BUCKETS];
+	uint64_t wait_time[ENTITY_COUNT * 2], hold_time[ENTITY_COUNT * 2];
+	char *name[ENTITY_COUNT * 2];
+	lock_stats_t *stats;
+	int i, j, k = 0, l;
+
+	for (i = 0; i < ENTITY_COUNT; i++) {
+		for (j = 0; j < 2; j++, k++) {
+			stats = &lock_stats[i][j];
+			name[k] = xstrdup_printf("%s %s", lock_stats_name[i],
+						 j ? "write" : "read");
+			cnt[k] = __atomic_load_n(&stats->cnt,
+						 __ATOMIC_RELAXED);
+			wait_time[k] = __atomic_load_n(&stats->wait_time,
+						       __ATOMIC_RELAXED);
+			hold_time[k] = __atomic_load_n(&stats->hold_time,
+						       __ATOMIC_RELAXED);
+			hold_max[k] = __atomic_load_n(&stats->hold_max,
+						      __ATOMIC_RELAXED);
+			for (l = 0; l < LOCK_HIST_BUCKETS; l++) {
+				hist[k * LOCK_HIST_BUCKETS + l] =
+					__atomic_load_n(&stats->hold_hist[l],
+							__ATOMIC_RELAXED);
+			}
+		}
+	}
 
-	if (lock_levels.node)
-		slurm_rwlock_unlock(&slurmctld_locks[NODE_LOCK]);
+	if (protocol_version >= SLURM_20_02_EXT_PROTOCOL_VERSION) {
+		packstr_array(name, k, buffer);
+		pack32_array(cnt, k, buffer);
+		pack64_array(wait_time, k, buffer);
+		pack64_array(hold_time, k, buffer);
+		pack32_array(hold_max, k, buffer);
+		pack32_array((uint32_t *) lock_hist_bound, LOCK_HIST_BUCKETS,
+			     buffer);
+		pack32_array(hist, k * LOCK_HIST_BUCKETS, buffer);
+	}
 
-	if (lock_levels.job)
-		slurm_rwlock_unlock(&slurmctld_locks[JOB_LOCK]);
+	for (i = 0; i < k; i++)
+		xfree(name[i]);
+}
 
-	if (lock_levels.conf)
-		slurm_rwlock_unlock(&slurmctld_locks[CONF_LOCK]);
+/* reset_lock_stats - clear lock wait and hold time statistics */
+extern void reset_lock_stats(void)
+{
+	lock_stats_t *stats;
+	int i, j, l;
+
+	for (i = 0; i < ENTITY_COUNT; i++) {
+		for (j = 0; j < 2; j++) {
+			stats = &lock_stats[i][j];
+			__atomic_store_n(&stats->cnt, 0, __ATOMIC_RELAXED);
+			__atomic_store_n(&stats->wait_time, 0,
+					 __ATOMIC_RELAXED);
+			__atomic_store_n(&stats->hold_time, 0,
+					 __ATOMIC_RELAXED);
+			__atomic_store_n(&stats->hold_max, 0,
+					 __ATOMIC_RELAXED);
+			for (l = 0; l < LOCK_HIST_BUCKETS; l++)
+				__atomic_store_n(&stats->hold_hist[l], 0,
+						 __ATOMIC_RELAXED);
+		}
+	}
 }
 
 /*
@@ -86,6 +86,16 @@
  * NOTE: When using lock_slurmctld() and assoc_mgr_lock(), always call
  * lock_slurmctld() before calling assoc_mgr_lock() and then call
  * assoc_mgr_unlock() before calling unlock_slurmctld().
+ *
+ * The complete lock order is:
+ *	config -> job -> node -> partition -> federation (lock_slurmctld)
+ *	-> assoc_mgr locks (assoc_mgr_lock)
+ * Locks must be released in the reverse order. lock_state_files() only
+ * serializes the writing of state files and is taken once the records have
+ * been packed and the slurmctld locks released.
+ *
+ * The time spent waiting for and holding each entity lock is recorded for
+ * every lock_slurmctld()/unlock_slurmctld() pair and reported by sdiag.
 \*****************************************************************************/
 
 #ifndef _SLURMCTLD_LOCKS_H
@@ -93,6 +103,8 @@
 
 #include <stdbool.h>
 
+#include "src/common/pack.h"
+
 /* levels of locking required for each data structure */
 typedef enum {
 	NO_LOCK,
@@ -135,6 +147,15 @@ extern void unlock_slurmctld (slurmctld_lock_t lock_levels);
 
 extern int report_locks_set(void);
 
+/* Count of lock hold time histogram buckets, see lock_hist_bound */
+#define LOCK_HIST_BUCKETS 7
+
+/* Pack lock wait/hold time statistics for sdiag */
+extern void pack_lock_stats(Buf buffer, uint16_t protocol_version);
+
+/* Clear lock wait/hold time statistics */
+extern void reset_lock_stats(void);
+
 /* un/lock semaphore used for saving state of slurmctld */
 extern void lock_state_files ( void );
 extern void unlock_state_files ( void );
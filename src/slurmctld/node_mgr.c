@@ -85,7 +85,7 @@
 #include "src/common/timers.h"
 #include "src/slurmctld/trigger_mgr.h"
 
-/* No need to change we always pack SLURM_PROTOCOL_VERSION */
+/* No need to change we always pack SLURM_STATE_PROTOCOL_VERSION */
 #define NODE_STATE_VERSION        "PROTOCOL_VERSION"
 
 typedef enum {
@@ -145,7 +145,7 @@ int dump_all_node_state ( void )
 	START_TIMER;
 	/* write header: version, time */
 	packstr(NODE_STATE_VERSION, buffer);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
 	pack_time(time (NULL), buffer);
 
 	/* write node records to buffer */
@@ -3597,9 +3597,14 @@ void push_reconfig_to_slurmd(void)
 		if (IS_NODE_CLOUD(node_ptr) && IS_NODE_POWER_SAVE(node_ptr))
 			continue;
 
-		if (node_ptr->protocol_version == SLURM_PROTOCOL_VERSION) {
+		if (node_ptr->protocol_version >=
+		    SLURM_20_02_PROTOCOL_VERSION) {
 			hostlist_push_host(new_args->hostlist, node_ptr->name);
 			new_args->node_count++;
+			if (new_args->protocol_version >
+			    node_ptr->protocol_version)
+				new_args->protocol_version =
+					node_ptr->protocol_version;
 		} else {
 			hostlist_push_host(old_args->hostlist, node_ptr->name);
 			old_args->node_count++;
@@ -3802,6 +3807,7 @@ void make_node_idle(node_record_t *node_ptr, job_record_t *job_ptr)
 	if (node_bitmap && (bit_test(node_bitmap, inx))) {
 		/* Not a replay */
 		last_job_update = now;
+		job_record_changed(job_ptr);
 		bit_clear(node_bitmap, inx);
 
 		if (!IS_JOB_FINISHED(job_ptr))
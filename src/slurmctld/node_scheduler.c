@@ -2522,7 +2522,7 @@ static void _end_null_job(job_record_t *job_ptr)
 
 	job_ptr->exit_code = 0;
 	gres_plugin_job_clear(job_ptr->gres_list);
-	job_ptr->job_state = JOB_RUNNING;
+	job_state_set(job_ptr, JOB_RUNNING);
 	job_ptr->bit_flags |= JOB_WAS_RUNNING;
 	FREE_NULL_BITMAP(job_ptr->node_bitmap);
 	xfree(job_ptr->nodes);
@@ -2555,7 +2555,7 @@ static void _end_null_job(job_record_t *job_ptr)
 	prolog_slurmctld(job_ptr);
 
 	job_ptr->end_time = now;
-	job_ptr->job_state = JOB_COMPLETE;
+	job_state_set(job_ptr, JOB_COMPLETE);
 	job_completion_logger(job_ptr, false);
 	acct_policy_job_fini(job_ptr);
 	if (select_g_job_fini(job_ptr) != SLURM_SUCCESS)
@@ -2737,6 +2737,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 			return ESLURM_BURST_BUFFER_WAIT; /* Fatal BB event */
 		xfree(job_ptr->state_desc);
 		last_job_update = now;
+		job_record_changed(job_ptr);
 		if (bb == 0)
 			job_ptr->state_reason = WAIT_BURST_BUFFER_STAGING;
 		else
@@ -2898,6 +2899,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 			job_ptr->state_reason = WAIT_PART_NODE_LIMIT;
 			xfree(job_ptr->state_desc);
 			last_job_update = now;
+			job_record_changed(job_ptr);
 
 		/* Non-fatal errors for job below */
 		} else if (error_code == ESLURM_NODE_NOT_AVAIL) {
@@ -2937,6 +2939,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 			}
 			xfree(unavail_node);
 			last_job_update = now;
+			job_record_changed(job_ptr);
 		} else if (error_code == ESLURM_RESERVATION_MAINT) {
 			error_code = ESLURM_RESERVATION_BUSY;	/* All reserved */
 			job_ptr->state_reason = WAIT_NODE_NOT_AVAIL;
@@ -2976,7 +2979,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 	 * step data.
 	 */
 	job_ptr->bit_flags &= ~JOB_KILL_HURRY;
-	job_ptr->job_state &= ~JOB_POWER_UP_NODE;
+	job_state_unset_flag(job_ptr, JOB_POWER_UP_NODE);
 	FREE_NULL_BITMAP(job_ptr->node_bitmap);
 	xfree(job_ptr->nodes);
 	xfree(job_ptr->sched_nodes);
@@ -3018,6 +3021,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 		job_ptr->priority = 0;
 		job_ptr->state_reason = WAIT_HELD;
 		last_job_update = now;
+		job_record_changed(job_ptr);
 		goto cleanup;
 	}
 	if (select_g_job_begin(job_ptr) != SLURM_SUCCESS) {
@@ -3033,6 +3037,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 		job_ptr->end_time = 0;
 		job_ptr->state_reason = WAIT_RESOURCES;
 		last_job_update = now;
+		job_record_changed(job_ptr);
 		goto cleanup;
 	}
 
@@ -3056,6 +3061,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 		job_ptr->end_time = 0;
 		job_ptr->state_reason = WAIT_RESOURCES;
 		last_job_update = now;
+		job_record_changed(job_ptr);
 		goto cleanup;
 	}
 
@@ -3065,7 +3071,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 	/* This could be set in the select plugin so we want to keep the flag */
 	configuring = IS_JOB_CONFIGURING(job_ptr);
 
-	job_ptr->job_state = JOB_RUNNING;
+	job_state_set(job_ptr, JOB_RUNNING);
 	job_ptr->bit_flags |= JOB_WAS_RUNNING;
 
 	if (select_g_select_nodeinfo_set(job_ptr) != SLURM_SUCCESS) {
@@ -3082,8 +3088,9 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 			job_ptr->time_last_active = 0;
 			job_ptr->end_time = 0;
 			job_ptr->state_reason = WAIT_RESOURCES;
-			job_ptr->job_state = JOB_PENDING;
+			job_state_set(job_ptr, JOB_PENDING);
 			last_job_update = now;
+			job_record_changed(job_ptr);
 			goto cleanup;
 		}
 	}
@@ -3128,11 +3135,11 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 	power_g_job_start(job_ptr);
 
 	if (bit_overlap_any(job_ptr->node_bitmap, power_node_bitmap))
-		job_ptr->job_state |= JOB_POWER_UP_NODE;
+		job_state_set_flag(job_ptr, JOB_POWER_UP_NODE);
 	if (configuring || IS_JOB_POWER_UP_NODE(job_ptr) ||
 	    !bit_super_set(job_ptr->node_bitmap, avail_node_bitmap)) {
 		/* This handles nodes explicitly requesting node reboot */
-		job_ptr->job_state |= JOB_CONFIGURING;
+		job_state_set_flag(job_ptr, JOB_CONFIGURING);
 	}
 
 	/*
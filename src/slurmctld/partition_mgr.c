@@ -73,7 +73,7 @@
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/state_save.h"
 
-/* No need to change we always pack SLURM_PROTOCOL_VERSION */
+/* No need to change we always pack SLURM_STATE_PROTOCOL_VERSION */
 #define PART_STATE_VERSION        "PROTOCOL_VERSION"
 
 /* Global variables */
@@ -429,7 +429,7 @@ int dump_all_part_state(void)
 	START_TIMER;
 	/* write header: time */
 	packstr(PART_STATE_VERSION, buffer);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
 	pack_time(time(NULL), buffer);
 
 	/* write partition records to buffer */
@@ -2197,6 +2197,7 @@ extern int part_policy_valid_acct(part_record_t *part_ptr, char *acct,
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_ACCOUNT;
 				last_job_update = time(NULL);
+				job_record_changed(job_ptr);
 			} else {
 				xfree(tmp_err);
 			}
@@ -2221,6 +2222,7 @@ extern int part_policy_valid_acct(part_record_t *part_ptr, char *acct,
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_ACCOUNT;
 				last_job_update = time(NULL);
+				job_record_changed(job_ptr);
 			} else {
 				xfree(tmp_err);
 			}
@@ -2252,6 +2254,7 @@ extern int part_policy_valid_acct(part_record_t *part_ptr, char *acct,
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_ACCOUNT;
 				last_job_update = time(NULL);
+				job_record_changed(job_ptr);
 			} else {
 				xfree(tmp_err);
 			}
@@ -2288,6 +2291,7 @@ extern int part_policy_valid_qos(part_record_t *part_ptr,
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_QOS;
 				last_job_update = time(NULL);
+				job_record_changed(job_ptr);
 			} else {
 				xfree(tmp_err);
 			}
@@ -2307,6 +2311,7 @@ extern int part_policy_valid_qos(part_record_t *part_ptr,
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_QOS;
 				last_job_update = time(NULL);
+				job_record_changed(job_ptr);
 			} else {
 				xfree(tmp_err);
 			}
@@ -2333,6 +2338,7 @@ extern int part_policy_valid_qos(part_record_t *part_ptr,
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_QOS;
 				last_job_update = time(NULL);
+				job_record_changed(job_ptr);
 			} else {
 				xfree(tmp_err);
 			}
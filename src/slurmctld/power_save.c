@@ -522,7 +522,7 @@ extern int power_job_reboot(job_record_t *job_ptr)
 		if (bit_overlap_any(power_node_bitmap, job_ptr->node_bitmap) ||
 		    bit_overlap_any(booting_node_bitmap,
 				    job_ptr->node_bitmap)) {
-			job_ptr->job_state |= JOB_CONFIGURING;
+			job_state_set_flag(job_ptr, JOB_CONFIGURING);
 			job_ptr->bit_flags |= NODE_REBOOT;
 		}
 		return SLURM_SUCCESS;
@@ -576,7 +576,7 @@ extern int power_job_reboot(job_record_t *job_ptr)
 		/* Reboot nodes to change KNL NUMA and/or MCDRAM mode */
 		nodes = bitmap2node_name(feature_node_bitmap);
 		if (nodes) {
-			job_ptr->job_state |= JOB_CONFIGURING;
+			job_state_set_flag(job_ptr, JOB_CONFIGURING);
 			job_ptr->wait_all_nodes = 1;
 			job_ptr->bit_flags |= NODE_REBOOT;
 			pid = _run_prog(resume_prog, nodes, reboot_features,
@@ -596,7 +596,7 @@ extern int power_job_reboot(job_record_t *job_ptr)
 		/* Reboot nodes with no feature changes */
 		nodes = bitmap2node_name(boot_node_bitmap);
 		if (nodes) {
-			job_ptr->job_state |= JOB_CONFIGURING;
+			job_state_set_flag(job_ptr, JOB_CONFIGURING);
 			job_ptr->wait_all_nodes = 1;
 			job_ptr->bit_flags |= NODE_REBOOT;
 			pid = _run_prog(resume_prog, nodes, NULL,
@@ -98,6 +98,7 @@
 #include "src/slurmctld/proc_req.h"
 #include "src/slurmctld/read_config.h"
 #include "src/slurmctld/reservation.h"
+#include "src/slurmctld/rpc_class.h"
 #include "src/slurmctld/sched_plugin.h"
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/slurmctld_plugstack.h"
@@ -123,6 +124,17 @@ static pthread_cond_t throttle_cond = PTHREAD_COND_INITIALIZER;
 static pthread_cond_t  reconfig_cond = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t reconfig_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/* Epilog and batch script complete RPCs waiting to be processed together */
+typedef struct {
+	bool done;
+	bool owner;	/* process the next batch */
+	slurm_msg_t *msg;
+} comp_batch_t;
+static pthread_mutex_t comp_batch_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t comp_batch_cond = PTHREAD_COND_INITIALIZER;
+static List comp_batch_list = NULL;
+static bool comp_batch_active = false;
+
 static void         _create_het_job_id_set(hostset_t jobid_hostset,
 					    uint32_t het_job_offset,
 					    char **het_job_id_set);
@@ -156,6 +168,7 @@ inline static void  _slurm_rpc_dump_batch_script(slurm_msg_t *msg);
 inline static void  _slurm_rpc_dump_conf(slurm_msg_t * msg);
 inline static void  _slurm_rpc_dump_front_end(slurm_msg_t * msg);
 inline static void  _slurm_rpc_dump_jobs(slurm_msg_t * msg);
+inline static void  _slurm_rpc_dump_jobs_delta(slurm_msg_t *msg);
 inline static void  _slurm_rpc_dump_jobs_user(slurm_msg_t * msg);
 inline static void  _slurm_rpc_dump_job_single(slurm_msg_t * msg);
 inline static void  _slurm_rpc_dump_licenses(slurm_msg_t * msg);
@@ -227,6 +240,7 @@ inline static void  _slurm_rpc_update_powercap(slurm_msg_t * msg);
 inline static void  _update_cred_key(void);
 static void _slurm_rpc_config_request(slurm_msg_t *msg);
 
+static void  _slurm_rpc_comp_batch(slurm_msg_t *msg);
 static void  _slurm_rpc_composite_msg(slurm_msg_t *msg);
 static void  _slurm_rpc_comp_msg_list(composite_msg_t * comp_msg,
 				      bool *run_scheduler,
@@ -258,8 +272,10 @@ static __thread bool drop_priv = false;
 void slurmctld_req(slurm_msg_t *msg, connection_arg_t *arg)
 {
 	DEF_TIMERS;
-	int i, rpc_type_index = -1, rpc_user_index = -1;
+	int i, rc, rpc_type_index = -1, rpc_user_index = -1;
 	uint32_t rpc_uid;
+	rpc_class_t rpc_class = rpc_class_get(msg->msg_type);
+	bool rpc_admit = !msg->conn;
 
 	if (arg && (arg->newsockfd >= 0))
 		fd_set_nonblocking(arg->newsockfd);
@@ -272,10 +288,28 @@ void slurmctld_req(slurm_msg_t *msg, connection_arg_t *arg)
 	/* Validate the credential */
 	if (g_slurm_auth_verify(msg->auth_cred, slurmctld_config.auth_info)) {
 		error("Bad authentication: %m");
+		if (arg && arg->rpc_reserved)
+			rpc_class_release(rpc_class);
 		return;
 	}
 	rpc_uid = (uint32_t) g_slurm_auth_get_uid(msg->auth_cred);
 
+	/*
+	 * Persistent connections (slurmdbd, federation) are not subject to
+	 * admission control, their peers do not retry on backoff.
+	 */
+	if (rpc_admit &&
+	    ((rc = rpc_class_admit(rpc_class, rpc_uid, msg->protocol_version,
+				   arg && arg->rpc_reserved)) !=
+	     SLURM_SUCCESS)) {
+		if (slurmctld_conf.debug_flags & DEBUG_FLAG_PROTOCOL)
+			info("%s: deferring opcode %s from uid %u: %s",
+			     __func__, rpc_num2string(msg->msg_type), rpc_uid,
+			     slurm_strerror(rc));
+		slurm_send_rc_msg(msg, rc);
+		return;
+	}
+
 	slurm_mutex_lock(&rpc_mutex);
 	if (rpc_type_size == 0) {
 		rpc_type_size = 100;  /* Capture info for first 100 RPC types */
@@ -344,6 +378,9 @@ void slurmctld_req(slurm_msg_t *msg, connection_arg_t *arg)
 	case REQUEST_JOB_USER_INFO:
 		_slurm_rpc_dump_jobs_user(msg);
 		break;
+	case REQUEST_JOB_INFO_DELTA:
+		_slurm_rpc_dump_jobs_delta(msg);
+		break;
 	case REQUEST_JOB_INFO_SINGLE:
 		_slurm_rpc_dump_job_single(msg);
 		break;
@@ -375,8 +412,7 @@ void slurmctld_req(slurm_msg_t *msg, connection_arg_t *arg)
 		_slurm_rpc_dump_partitions(msg);
 		break;
 	case MESSAGE_EPILOG_COMPLETE:
-		i = 0;
-		_slurm_rpc_epilog_complete(msg, (bool *)&i, 0);
+		_slurm_rpc_comp_batch(msg);
 		break;
 	case REQUEST_CANCEL_JOB_STEP:
 		_slurm_rpc_job_step_kill(rpc_uid, msg);
@@ -388,8 +424,7 @@ void slurmctld_req(slurm_msg_t *msg, connection_arg_t *arg)
 		_slurm_rpc_complete_prolog(msg);
 		break;
 	case REQUEST_COMPLETE_BATCH_SCRIPT:
-		i = 0;
-		_slurm_rpc_complete_batch_script(msg, (bool *)&i, 0);
+		_slurm_rpc_comp_batch(msg);
 		break;
 	case REQUEST_JOB_STEP_CREATE:
 		_slurm_rpc_job_step_create(msg);
@@ -608,6 +643,8 @@ void slurmctld_req(slurm_msg_t *msg, connection_arg_t *arg)
 		rpc_user_time[rpc_user_index] += DELTA_TIMER;
 	}
 	slurm_mutex_unlock(&rpc_mutex);
+	if (rpc_admit)
+		rpc_class_done(rpc_class, DELTA_TIMER);
 }
 
 /* These functions prevent certain RPCs from keeping the slurmctld write locks
@@ -1228,7 +1265,7 @@ static int _het_job_cancel(void *x, void *arg)
 	time_t now = time(NULL);
 
 	info("Cancelling aborted hetjob submit: %pJ", job_ptr);
-	job_ptr->job_state	= JOB_CANCELLED;
+	job_state_set(job_ptr, JOB_CANCELLED);
 	job_ptr->start_time	= now;
 	job_ptr->end_time	= now;
 	job_ptr->exit_code	= 1;
@@ -1976,6 +2013,57 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 	}
 }
 
+/*
+ * _slurm_rpc_dump_jobs_delta - process RPC for job state information changed
+ *	since the client's last update
+ */
+static void _slurm_rpc_dump_jobs_delta(slurm_msg_t *msg)
+{
+	DEF_TIMERS;
+	char *dump;
+	int dump_size;
+	slurm_msg_t response_msg;
+	job_info_request_msg_t *job_info_request_msg =
+		(job_info_request_msg_t *) msg->data;
+	/* Locks: Read config job part */
+	slurmctld_lock_t job_read_lock = {
+		READ_LOCK, READ_LOCK, NO_LOCK, READ_LOCK, READ_LOCK };
+	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred);
+
+	START_TIMER;
+	debug3("Processing RPC: REQUEST_JOB_INFO_DELTA from uid=%d", uid);
+	lock_slurmctld(job_read_lock);
+
+	if ((job_info_request_msg->last_update - 1) >= last_job_update) {
+		unlock_slurmctld(job_read_lock);
+		debug3("_slurm_rpc_dump_jobs_delta, no change");
+		slurm_send_rc_msg(msg, SLURM_NO_CHANGE_IN_DATA);
+		return;
+	}
+
+	response_init(&response_msg, msg);
+	if (pack_job_delta(&dump, &dump_size,
+			   job_info_request_msg->show_flags, uid,
+			   job_info_request_msg->last_update,
+			   msg->protocol_version) == SLURM_SUCCESS) {
+		response_msg.msg_type = RESPONSE_JOB_INFO_DELTA;
+	} else {
+		pack_all_jobs(&dump, &dump_size,
+			      job_info_request_msg->show_flags, uid,
+			      NO_VAL, msg->protocol_version);
+		response_msg.msg_type = RESPONSE_JOB_INFO;
+	}
+	unlock_slurmctld(job_read_lock);
+	END_TIMER2("_slurm_rpc_dump_jobs_delta");
+
+	response_msg.data = dump;
+	response_msg.data_size = dump_size;
+
+	/* send message */
+	slurm_send_node_msg(msg->conn_fd, &response_msg);
+	xfree(dump);
+}
+
 /* _slurm_rpc_dump_jobs - process RPC for job state information */
 static void _slurm_rpc_dump_jobs_user(slurm_msg_t * msg)
 {
@@ -3418,6 +3506,33 @@ static slurm_addr_t *_build_node_addr(char *node_list, uint32_t node_cnt,
 		xfree(node_addr);
 	return node_addr;
 }
+
+/* Return the oldest protocol version of the slurmd daemons in node_list */
+static uint16_t _node_list_protocol_version(char *node_list)
+{
+	bitstr_t *node_bitmap = NULL;
+	uint16_t protocol_version = SLURM_PROTOCOL_VERSION;
+	int i, i_first, i_last;
+
+	if (node_name2bitmap(node_list, false, &node_bitmap)) {
+		FREE_NULL_BITMAP(node_bitmap);
+		return 0;
+	}
+	i_first = bit_ffs(node_bitmap);
+	if (i_first >= 0)
+		i_last = bit_fls(node_bitmap);
+	else
+		i_last = -2;
+	for (i = i_first; i <= i_last; i++) {
+		if (!bit_test(node_bitmap, i))
+			continue;
+		protocol_version = MIN(protocol_version,
+				       node_record_table_ptr[i].protocol_version);
+	}
+	FREE_NULL_BITMAP(node_bitmap);
+
+	return protocol_version;
+}
 #endif
 
 /* _slurm_rpc_job_sbcast_cred - process RPC to get details on existing job
@@ -3595,6 +3710,8 @@ static void _slurm_rpc_job_sbcast_cred(slurm_msg_t * msg)
 		job_info_resp_msg.node_addr      = node_addr;
 		job_info_resp_msg.node_cnt       = node_cnt;
 		job_info_resp_msg.node_list      = xstrdup(node_list);
+		job_info_resp_msg.protocol_version =
+			_node_list_protocol_version(node_list);
 		job_info_resp_msg.sbcast_cred    = sbcast_cred;
 		unlock_slurmctld(job_read_lock);
 
@@ -6163,6 +6280,7 @@ inline static void _slurm_rpc_dump_stats(slurm_msg_t * msg)
 	} else {
 		pack_all_stat(1, &dump, &dump_size, msg->protocol_version);
 		_pack_rpc_stats(1, &dump, &dump_size, msg->protocol_version);
+		pack_ext_stat(1, &dump, &dump_size, msg->protocol_version);
 		response_msg.data = dump;
 		response_msg.data_size = dump_size;
 	}
@@ -6346,6 +6464,128 @@ static void _slurmctld_free_comp_msg_list(void *x)
 	}
 }
 
+/*
+ * _slurm_rpc_comp_batch - process MESSAGE_EPILOG_COMPLETE and
+ *	REQUEST_COMPLETE_BATCH_SCRIPT RPCs in batches.
+ * The thread which finds no batch in progress waits complete_msg_window
+ * milliseconds, then processes every queued RPC under a single job write
+ * lock. RPCs which arrived meanwhile are handed to the thread of the first
+ * of them to process as the next batch, so no thread processes more than
+ * one batch. The other threads wait for their RPC to be processed, its
+ * reply is captured on a ret_list as for composite messages and sent by the
+ * thread owning the connection.
+ */
+static void  _slurm_rpc_comp_batch(slurm_msg_t *msg)
+{
+	static time_t config_update = 0;
+	static bool defer_sched = false;
+	static int window = 0;
+	bool run_scheduler = false;
+	comp_batch_t entry = { .done = false, .owner = false, .msg = msg };
+	comp_batch_t *next;
+	List batch, ret_list = list_create(_slurmctld_free_comp_msg_list);
+	slurm_msg_t *resp_msg;
+	ListIterator itr;
+	int cnt;
+	/* Locks: Read configuration, write job, write node, read federation */
+	slurmctld_lock_t job_write_lock = {
+		READ_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK, READ_LOCK };
+
+	/* Have slurm_send_rc_msg() append the reply to ret_list */
+	msg->ret_list = ret_list;
+	msg->msg_index = 1;
+
+	slurm_mutex_lock(&comp_batch_mutex);
+	if (config_update != slurmctld_conf.last_update) {
+		char *sched_params = slurm_get_sched_params();
+		char *tmp_ptr;
+
+		defer_sched = (xstrcasestr(sched_params, "defer"));
+		window = 0;
+		if ((tmp_ptr = xstrcasestr(sched_params,
+					   "complete_msg_window="))) {
+			window = atoi(tmp_ptr + 20);
+			if ((window < 0) || (window > 1000)) {
+				error("Invalid complete_msg_window: %d",
+				      window);
+				window = 0;
+			}
+		}
+		xfree(sched_params);
+		config_update = slurmctld_conf.last_update;
+	}
+	if (!comp_batch_list)
+		comp_batch_list = list_create(NULL);
+	list_append(comp_batch_list, &entry);
+	if (comp_batch_active) {
+		while (!entry.done && !entry.owner)
+			slurm_cond_wait(&comp_batch_cond, &comp_batch_mutex);
+		if (entry.done) {
+			slurm_mutex_unlock(&comp_batch_mutex);
+			goto reply;
+		}
+	} else {
+		comp_batch_active = true;
+		slurm_mutex_unlock(&comp_batch_mutex);
+		if (window)
+			usleep(window * 1000);
+		slurm_mutex_lock(&comp_batch_mutex);
+	}
+	batch = comp_batch_list;
+	comp_batch_list = list_create(NULL);
+	slurm_mutex_unlock(&comp_batch_mutex);
+
+	cnt = 0;
+	lock_slurmctld(job_write_lock);
+	itr = list_iterator_create(batch);
+	while ((next = list_next(itr))) {
+		if (next->msg->msg_type == MESSAGE_EPILOG_COMPLETE)
+			_slurm_rpc_epilog_complete(next->msg, &run_scheduler,
+						   1);
+		else
+			_slurm_rpc_complete_batch_script(next->msg,
+							 &run_scheduler, 1);
+		cnt++;
+	}
+	list_iterator_destroy(itr);
+	unlock_slurmctld(job_write_lock);
+	debug2("%s: processed %d completion RPCs", __func__, cnt);
+
+	slurm_mutex_lock(&comp_batch_mutex);
+	itr = list_iterator_create(batch);
+	while ((next = list_next(itr)))
+		next->done = true;
+	list_iterator_destroy(itr);
+	if ((next = list_peek(comp_batch_list)))
+		next->owner = true;
+	else
+		comp_batch_active = false;
+	slurm_cond_broadcast(&comp_batch_cond);
+	slurm_mutex_unlock(&comp_batch_mutex);
+	FREE_NULL_LIST(batch);
+
+reply:
+	msg->ret_list = NULL;
+	msg->msg_index = 0;
+	if ((resp_msg = list_peek(ret_list))) {
+		return_code_msg_t *rc_msg = resp_msg->data;
+		slurm_send_rc_msg(msg, rc_msg->return_code);
+	}
+	FREE_NULL_LIST(ret_list);
+	/* NOTE: MESSAGE_EPILOG_COMPLETE has no response */
+
+	/* Functions below provide their own locking */
+	if (run_scheduler) {
+		/*
+		 * In defer mode, avoid triggering the scheduler logic
+		 * for every epilog complete message.
+		 */
+		if (!LOTS_OF_AGENTS && !defer_sched)
+			(void) schedule(0);	/* Has own locking */
+		schedule_node_save();		/* Has own locking */
+		schedule_job_save();		/* Has own locking */
+	}
+}
 
 static void  _slurm_rpc_composite_msg(slurm_msg_t *msg)
 {
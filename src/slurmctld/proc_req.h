@@ -49,6 +49,7 @@
 typedef struct connection_arg {
 	int newsockfd;
 	slurm_addr_t cli_addr;
+	bool rpc_reserved;	/* RPC class slot taken by rpc_workers pool */
 } connection_arg_t;
 
 /* Free memory used to track RPC usage by type and user */
@@ -114,6 +114,8 @@ static int  _compare_hostnames(node_record_t *old_node_table,
 static void _gres_reconfig(bool reconfig);
 static int  _init_all_slurm_conf(void);
 static void _list_delete_feature(void *feature_entry);
+static void _phase_time(struct timeval *phase_tv, char **phases,
+			const char *name);
 static int  _preserve_select_type_param(slurm_ctl_conf_t * ctl_conf_ptr,
 					uint16_t old_select_type_p);
 static void _purge_old_node_state(node_record_t *old_node_table_ptr,
@@ -944,7 +946,7 @@ static void _abort_job(job_record_t *job_ptr, uint32_t job_state,
 {
 	time_t now = time(NULL);
 
-	job_ptr->job_state = job_state | JOB_COMPLETING;
+	job_state_set(job_ptr, job_state | JOB_COMPLETING);
 	build_cg_bitmap(job_ptr);
 	job_ptr->end_time = MIN(job_ptr->end_time, now);
 	job_ptr->state_reason = state_reason;
@@ -1086,6 +1088,20 @@ static void _test_cgroup_plugin_use(void)
 	xfree(plugins);
 }
 
+/*
+ * Append the time spent in one phase of read_slurm_conf() to phases and start
+ * timing the next phase
+ */
+static void _phase_time(struct timeval *phase_tv, char **phases,
+			const char *name)
+{
+	int delta_t = slurm_delta_tv(phase_tv);
+
+	xstrfmtcat(*phases, "%s%s=%dus", *phases ? " " : "", name, delta_t);
+	phase_tv->tv_sec = 0;
+	(void) slurm_delta_tv(phase_tv);
+}
+
 /*
  * read_slurm_conf - load the slurm configuration from the configured file.
  * read_slurm_conf can be called more than once if so desired.
@@ -1122,9 +1138,12 @@ int read_slurm_conf(int recover, bool reconfig)
 	char *mpi_params;
 	uint16_t old_select_type_p = slurmctld_conf.select_type_param;
 	bool cgroup_mem_confinement = false;
+	struct timeval phase_tv = { 0, 0 };
+	char *phases = NULL;
 
 	/* initialization */
 	START_TIMER;
+	(void) slurm_delta_tv(&phase_tv);
 
 	xfree(slurmctld_config.auth_info);
 	slurmctld_config.auth_info = slurm_get_auth_info();
@@ -1275,6 +1294,8 @@ int read_slurm_conf(int recover, bool reconfig)
 		_reorder_nodes_by_name();
 
 	rehash_node();
+	if (node_record_count)
+		bit_cache_size(node_record_count);
 	slurm_topo_build_config();
 	route_g_reconfigure();
 	if (reconfig)
@@ -1300,6 +1321,8 @@ int read_slurm_conf(int recover, bool reconfig)
 		}
 	}
 
+	_phase_time(&phase_tv, &phases, "config");
+
 	/*
 	 * Set standard features and preserve the plugin controlled ones.
 	 * A reconfig always imply load the state from slurm.conf
@@ -1353,6 +1376,7 @@ int read_slurm_conf(int recover, bool reconfig)
 		load_job_ret = load_all_job_state();
 		sync_job_priorities();
 	}
+	_phase_time(&phase_tv, &phases, "state");
 
 	_sync_part_prio();
 	_build_bitmaps_pre_select();
@@ -1369,8 +1393,11 @@ int read_slurm_conf(int recover, bool reconfig)
 		}
 	}
 
+	_phase_time(&phase_tv, &phases, "select_init");
+
 	_gres_reconfig(reconfig);
 	reset_job_bitmaps();		/* must follow select_g_job_init() */
+	_phase_time(&phase_tv, &phases, "job_bitmaps");
 
 	(void) _sync_nodes_to_jobs(reconfig);
 	(void) sync_job_files();
@@ -1427,6 +1454,7 @@ int read_slurm_conf(int recover, bool reconfig)
 	_validate_het_jobs();
 	(void) _sync_nodes_to_comp_job();/* must follow select_g_node_init() */
 	load_part_uid_allow_list(1);
+	_phase_time(&phase_tv, &phases, "sync");
 
 	/* NOTE: Run load_all_resv_state() before _restore_job_accounting */
 	if (reconfig) {
@@ -1438,10 +1466,12 @@ int read_slurm_conf(int recover, bool reconfig)
 			(void) slurm_sched_g_reconfig();
 		}
 	}
+	_phase_time(&phase_tv, &phases, "resv_trigger");
 	 if (test_config)
 		goto end_it;
 
 	_restore_job_accounting();
+	_phase_time(&phase_tv, &phases, "job_accounting");
 
 	/* sort config_list by weight for scheduling */
 	list_sort(config_list, &list_compare_config);
@@ -1545,7 +1575,13 @@ int read_slurm_conf(int recover, bool reconfig)
 	_set_response_cluster_rec();
 
 	slurmctld_conf.last_update = time(NULL);
+	_phase_time(&phase_tv, &phases, "plugins");
+	if (recover && !reconfig)
+		info("%s: startup phases %s", __func__, phases);
+	else
+		debug("%s: phases %s", __func__, phases);
 end_it:
+	xfree(phases);
 	xfree(old_auth_type);
 	xfree(old_bb_type);
 	xfree(old_cred_type);
@@ -2820,8 +2856,10 @@ static void _acct_restore_active_jobs(void)
 			if (!with_slurmdbd)
 				jobacct_storage_g_job_start(
 					acct_db_conn, job_ptr);
-			else if (job_ptr->db_index != NO_VAL64)
+			else if (job_ptr->db_index != NO_VAL64) {
 				job_ptr->db_index = 0;
+				job_record_changed(job_ptr);
+			}
 			step_iterator = list_iterator_create(
 				job_ptr->step_list);
 			while ((step_ptr = list_next(step_iterator))) {
@@ -2896,7 +2934,7 @@ extern int dump_config_state_lite(void)
 
 	START_TIMER;
 	/* write header: version, time */
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
 	pack_time(time(NULL), buffer);
 	packstr(slurmctld_conf.accounting_storage_type, buffer);
 
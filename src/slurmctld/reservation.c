@@ -88,7 +88,7 @@
 
 #define MAX_RESV_COUNT	9999
 
-/* No need to change we always pack SLURM_PROTOCOL_VERSION */
+/* No need to change we always pack SLURM_STATE_PROTOCOL_VERSION */
 #define RESV_STATE_VERSION          "PROTOCOL_VERSION"
 
 typedef struct resv_thread_args {
@@ -2991,6 +2991,7 @@ static void _clear_job_resv(slurmctld_resv_t *resv_ptr)
 			 */
 			job_ptr->state_reason = WAIT_NO_REASON;
 			xfree(job_ptr->state_desc);
+			job_record_changed(job_ptr);
 		    }
 
 		if (job_ptr->resv_ptr != resv_ptr)
@@ -3002,12 +3003,13 @@ static void _clear_job_resv(slurmctld_resv_t *resv_ptr)
 		job_ptr->resv_id = 0;
 		job_ptr->resv_ptr = NULL;
 		xfree(job_ptr->resv_name);
+		job_record_changed(job_ptr);
 		if (!(resv_ptr->flags & RESERVE_FLAG_NO_HOLD_JOBS) &&
 		    IS_JOB_PENDING(job_ptr) &&
 		    (job_ptr->state_reason != WAIT_HELD)) {
 			xfree(job_ptr->state_desc);
 			job_ptr->state_reason = WAIT_RESV_DELETED;
-			job_ptr->job_state |= JOB_RESV_DEL_HOLD;
+			job_state_set_flag(job_ptr, JOB_RESV_DEL_HOLD);
 			xstrfmtcat(job_ptr->state_desc,
 				   "Reservation %s was deleted",
 				    resv_ptr->name);
@@ -3237,7 +3239,7 @@ extern int dump_all_resv_state(void)
 
 	/* write header: time */
 	packstr(RESV_STATE_VERSION, buffer);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
 	pack_time(time(NULL), buffer);
 	pack32(top_suffix, buffer);
 
@@ -3245,7 +3247,7 @@ extern int dump_all_resv_state(void)
 	lock_slurmctld(resv_read_lock);
 	iter = list_iterator_create(resv_list);
 	while ((resv_ptr = list_next(iter)))
-		_pack_resv(resv_ptr, buffer, true, SLURM_PROTOCOL_VERSION);
+		_pack_resv(resv_ptr, buffer, true, SLURM_STATE_PROTOCOL_VERSION);
 	list_iterator_destroy(iter);
 
 	old_file = xstrdup(slurmctld_conf.state_save_location);
@@ -3493,6 +3495,7 @@ static void _validate_all_reservations(void)
 			       job_ptr, job_ptr->resv_name);
 			job_ptr->resv_id = 0;
 			xfree(job_ptr->resv_name);
+			job_record_changed(job_ptr);
 		}
 	}
 	list_iterator_destroy(iter);
@@ -6080,4 +6083,5 @@ extern void job_resv_clear_promiscous_flag(job_record_t *job_ptr)
 	job_ptr->resv_id = 0;
 	job_ptr->resv_ptr = NULL;
 	job_ptr->bit_flags &= (~JOB_PROM);
+	job_record_changed(job_ptr);
 }
@@ -0,0 +1,311 @@
+/*****************************************************************************\
+ *  rpc_class.c - RPC priority classes and admission control for slurmctld
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "slurm/slurm_errno.h"
+
+#include "src/common/macros.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/xhash.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "src/slurmctld/rpc_class.h"
+#include "src/slurmctld/slurmctld.h"
+
+/* Seconds worth of rpc_user_rate a user may burst */
+#define RPC_USER_BURST 5
+
+typedef struct {
+	uint32_t cnt;		/* RPCs processed */
+	uint64_t time;		/* usec spent processing */
+	uint32_t active;	/* RPCs currently being processed */
+	uint32_t active_max;	/* high water mark of active */
+	uint32_t busy;		/* rejected, class at concurrency limit */
+	uint32_t rate;		/* rejected, user over rpc_user_rate */
+} rpc_class_stats_t;
+
+typedef struct {
+	uid_t uid;
+	uint32_t tokens;
+	time_t last_fill;
+} rpc_user_bucket_t;
+
+static char *rpc_class_names[RPC_CLASS_CNT] = { "high", "normal", "low" };
+
+static pthread_mutex_t rpc_class_mutex = PTHREAD_MUTEX_INITIALIZER;
+static rpc_class_stats_t rpc_class_stats[RPC_CLASS_CNT];
+static uint32_t rpc_class_limit[RPC_CLASS_CNT];	/* 0 is unlimited */
+static uint32_t rpc_user_rate = 0;		/* per second, 0 is unlimited */
+static xhash_t *rpc_user_table = NULL;
+static time_t config_update = 0;
+
+static void _user_bucket_id(void *item, const char **key, uint32_t *key_len)
+{
+	rpc_user_bucket_t *bucket = item;
+
+	*key = (const char *) &bucket->uid;
+	*key_len = sizeof(uid_t);
+}
+
+static uint32_t _get_param(char *params, char *name)
+{
+	char *tmp_ptr;
+	int i;
+
+	if (!(tmp_ptr = xstrcasestr(params, name)))
+		return 0;
+	i = atoi(tmp_ptr + strlen(name));
+	if (i < 0) {
+		error("Invalid SlurmctldParameters %s%d", name, i);
+		return 0;
+	}
+	return i;
+}
+
+/* Reload configuration after a reconfigure. Call with rpc_class_mutex */
+static void _load_config(void)
+{
+	char *ctld_params;
+
+	if (config_update == slurmctld_conf.last_update)
+		return;
+
+	ctld_params = slurm_get_slurmctld_params();
+	rpc_class_limit[RPC_CLASS_HIGH] = 0;
+	rpc_class_limit[RPC_CLASS_NORMAL] = _get_param(ctld_params,
+						       "rpc_limit_normal=");
+	rpc_class_limit[RPC_CLASS_LOW] = _get_param(ctld_params,
+						    "rpc_limit_low=");
+	rpc_user_rate = _get_param(ctld_params, "rpc_user_rate=");
+	xfree(ctld_params);
+
+	xhash_free(rpc_user_table);
+	if (rpc_user_rate)
+		rpc_user_table = xhash_init(_user_bucket_id, xfree_ptr);
+	config_update = slurmctld_conf.last_update;
+}
+
+/* Take a token from the user's bucket. Call with rpc_class_mutex */
+static bool _user_rate_ok(uid_t uid)
+{
+	rpc_user_bucket_t *bucket;
+	uint32_t burst = rpc_user_rate * RPC_USER_BURST;
+	time_t now = time(NULL);
+
+	if (!(bucket = xhash_get(rpc_user_table, (char *) &uid,
+				 sizeof(uid_t)))) {
+		bucket = xmalloc(sizeof(rpc_user_bucket_t));
+		bucket->uid = uid;
+		bucket->tokens = burst;
+		bucket->last_fill = now;
+		xhash_add(rpc_user_table, bucket);
+	} else if (now > bucket->last_fill) {
+		bucket->tokens += MIN((now - bucket->last_fill), RPC_USER_BURST)
+				  * rpc_user_rate;
+		bucket->tokens = MIN(bucket->tokens, burst);
+		bucket->last_fill = now;
+	}
+
+	if (!bucket->tokens)
+		return false;
+	bucket->tokens--;
+	return true;
+}
+
+extern rpc_class_t rpc_class_get(uint16_t msg_type)
+{
+	switch (msg_type) {
+	case MESSAGE_EPILOG_COMPLETE:
+	case MESSAGE_NODE_REGISTRATION_STATUS:
+	case MESSAGE_COMPOSITE:
+	case REQUEST_COMPLETE_BATCH_SCRIPT:
+	case REQUEST_COMPLETE_JOB_ALLOCATION:
+	case REQUEST_COMPLETE_PROLOG:
+	case REQUEST_STEP_COMPLETE:
+	case REQUEST_STEP_COMPLETE_AGGR:
+		return RPC_CLASS_HIGH;
+	case REQUEST_ASSOC_MGR_INFO:
+	case REQUEST_BURST_BUFFER_INFO:
+	case REQUEST_FRONT_END_INFO:
+	case REQUEST_JOB_INFO:
+	case REQUEST_JOB_INFO_DELTA:
+	case REQUEST_JOB_INFO_SINGLE:
+	case REQUEST_JOB_STEP_INFO:
+	case REQUEST_JOB_USER_INFO:
+	case REQUEST_LICENSE_INFO:
+	case REQUEST_NODE_INFO:
+	case REQUEST_NODE_INFO_SINGLE:
+	case REQUEST_PARTITION_INFO:
+	case REQUEST_PRIORITY_FACTORS:
+	case REQUEST_RESERVATION_INFO:
+	case REQUEST_SHARE_INFO:
+	case REQUEST_STATS_INFO:
+		return RPC_CLASS_LOW;
+	default:
+		return RPC_CLASS_NORMAL;
+	}
+}
+
+extern int rpc_class_admit(rpc_class_t rpc_class, uid_t uid,
+			   uint16_t protocol_version, bool reserved)
+{
+	rpc_class_stats_t *stats = &rpc_class_stats[rpc_class];
+	bool privileged = false;
+	int rc = SLURM_SUCCESS;
+
+	if ((rpc_class != RPC_CLASS_HIGH) &&
+	    (protocol_version >= SLURM_20_02_EXT_PROTOCOL_VERSION))
+		privileged = validate_slurm_user(uid);
+	else
+		privileged = true;
+
+	slurm_mutex_lock(&rpc_class_mutex);
+	_load_config();
+	if (privileged) {
+		;
+	} else if (!reserved && rpc_class_limit[rpc_class] &&
+		   (stats->active >= rpc_class_limit[rpc_class])) {
+		stats->busy++;
+		rc = SLURMCTLD_COMMUNICATIONS_BACKOFF;
+	} else if ((rpc_class == RPC_CLASS_LOW) && rpc_user_rate &&
+		   !_user_rate_ok(uid)) {
+		stats->rate++;
+		rc = SLURMCTLD_COMMUNICATIONS_BACKOFF;
+	}
+	if (reserved) {
+		if ((rc != SLURM_SUCCESS) && stats->active)
+			stats->active--;
+	} else if (rc == SLURM_SUCCESS) {
+		stats->active++;
+		stats->active_max = MAX(stats->active_max, stats->active);
+	}
+	slurm_mutex_unlock(&rpc_class_mutex);
+
+	return rc;
+}
+
+extern void rpc_class_done(rpc_class_t rpc_class, uint64_t usec)
+{
+	rpc_class_stats_t *stats = &rpc_class_stats[rpc_class];
+
+	slurm_mutex_lock(&rpc_class_mutex);
+	stats->cnt++;
+	stats->time += usec;
+	if (stats->active)
+		stats->active--;
+	else
+		error("%s: %s RPC active count underflow",
+		      __func__, rpc_class_names[rpc_class]);
+	slurm_mutex_unlock(&rpc_class_mutex);
+}
+
+extern bool rpc_class_reserve(rpc_class_t rpc_class)
+{
+	rpc_class_stats_t *stats = &rpc_class_stats[rpc_class];
+	bool rc = false;
+
+	slurm_mutex_lock(&rpc_class_mutex);
+	_load_config();
+	if (!rpc_class_limit[rpc_class] ||
+	    (stats->active < rpc_class_limit[rpc_class])) {
+		stats->active++;
+		stats->active_max = MAX(stats->active_max, stats->active);
+		rc = true;
+	}
+	slurm_mutex_unlock(&rpc_class_mutex);
+
+	return rc;
+}
+
+extern void rpc_class_release(rpc_class_t rpc_class)
+{
+	slurm_mutex_lock(&rpc_class_mutex);
+	if (rpc_class_stats[rpc_class].active)
+		rpc_class_stats[rpc_class].active--;
+	slurm_mutex_unlock(&rpc_class_mutex);
+}
+
+extern void pack_rpc_class_stats(Buf buffer, uint16_t protocol_version)
+{
+	uint32_t cnt[RPC_CLASS_CNT], active[RPC_CLASS_CNT];
+	uint32_t active_max[RPC_CLASS_CNT], busy[RPC_CLASS_CNT];
+	uint32_t rate[RPC_CLASS_CNT];
+	uint64_t usec[RPC_CLASS_CNT];
+	int i;
+
+	slurm_mutex_lock(&rpc_class_mutex);
+	for (i = 0; i < RPC_CLASS_CNT; i++) {
+		cnt[i] = rpc_class_stats[i].cnt;
+		usec[i] = rpc_class_stats[i].time;
+		active[i] = rpc_class_stats[i].active;
+		active_max[i] = rpc_class_stats[i].active_max;
+		busy[i] = rpc_class_stats[i].busy;
+		rate[i] = rpc_class_stats[i].rate;
+	}
+	slurm_mutex_unlock(&rpc_class_mutex);
+
+	packstr_array(rpc_class_names, RPC_CLASS_CNT, buffer);
+	pack32_array(cnt, RPC_CLASS_CNT, buffer);
+	pack64_array(usec, RPC_CLASS_CNT, buffer);
+	pack32_array(active, RPC_CLASS_CNT, buffer);
+	pack32_array(active_max, RPC_CLASS_CNT, buffer);
+	pack32_array(busy, RPC_CLASS_CNT, buffer);
+	pack32_array(rate, RPC_CLASS_CNT, buffer);
+}
+
+extern void reset_rpc_class_stats(void)
+{
+	int i;
+
+	slurm_mutex_lock(&rpc_class_mutex);
+	for (i = 0; i < RPC_CLASS_CNT; i++) {
+		rpc_class_stats[i].cnt = 0;
+		rpc_class_stats[i].time = 0;
+		rpc_class_stats[i].active_max = rpc_class_stats[i].active;
+		rpc_class_stats[i].busy = 0;
+		rpc_class_stats[i].rate = 0;
+	}
+	slurm_mutex_unlock(&rpc_class_mutex);
+}
+
+extern void rpc_class_fini(void)
+{
+	slurm_mutex_lock(&rpc_class_mutex);
+	xhash_free(rpc_user_table);
+	config_update = 0;
+	slurm_mutex_unlock(&rpc_class_mutex);
+}
@@ -0,0 +1,87 @@
+/*****************************************************************************\
+ *  rpc_class.h - RPC priority classes and admission control for slurmctld
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _RPC_CLASS_H
+#define _RPC_CLASS_H
+
+#include <sys/types.h>
+
+#include "src/common/pack.h"
+
+/* Priority classes of incoming RPCs, highest priority first */
+typedef enum {
+	RPC_CLASS_HIGH,		/* job/step completion, node registration */
+	RPC_CLASS_NORMAL,
+	RPC_CLASS_LOW,		/* state queries (squeue, sinfo, etc.) */
+	RPC_CLASS_CNT
+} rpc_class_t;
+
+/* Return the priority class of a message type */
+extern rpc_class_t rpc_class_get(uint16_t msg_type);
+
+/*
+ * Admit an RPC of the given class from the given user for processing.
+ * Enforces the rpc_limit_normal, rpc_limit_low and rpc_user_rate
+ * SlurmctldParameters. High priority RPCs, RPCs from SlurmUser or root and
+ * RPCs from clients older than SLURM_20_02_EXT_PROTOCOL_VERSION, which do
+ * not retry on backoff, are always admitted.
+ * IN reserved - the class slot was already taken by rpc_class_reserve()
+ * RET SLURM_SUCCESS or SLURMCTLD_COMMUNICATIONS_BACKOFF if the client should
+ *	retry later. Call rpc_class_done() once an admitted RPC completes.
+ */
+extern int rpc_class_admit(rpc_class_t rpc_class, uid_t uid,
+			   uint16_t protocol_version, bool reserved);
+
+/* Record completion of an RPC admitted by rpc_class_admit() */
+extern void rpc_class_done(rpc_class_t rpc_class, uint64_t usec);
+
+/*
+ * Take a slot of the class for an RPC about to be processed, the RPC is
+ * then passed to rpc_class_admit() as reserved.
+ * RET false if the class is at its concurrency limit
+ */
+extern bool rpc_class_reserve(rpc_class_t rpc_class);
+
+/* Return a slot taken by rpc_class_reserve() for an RPC not processed */
+extern void rpc_class_release(rpc_class_t rpc_class);
+
+/* Pack per-class RPC counters for sdiag */
+extern void pack_rpc_class_stats(Buf buffer, uint16_t protocol_version);
+
+/* Clear per-class RPC counters, the active counts are preserved */
+extern void reset_rpc_class_stats(void);
+
+/* Free memory used by the per-user rate limiting table */
+extern void rpc_class_fini(void);
+
+#endif /* !_RPC_CLASS_H */
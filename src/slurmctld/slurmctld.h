@@ -200,6 +200,14 @@ typedef struct diag_stats {
 	uint32_t bf_table_size_sum;
 	time_t   bf_when_last_cycle;
 
+	uint32_t decay_cycle_counter;
+	uint32_t decay_cycle_last;
+	uint32_t decay_cycle_max;
+	uint64_t decay_cycle_sum;
+	uint32_t decay_jobs_last;
+	uint32_t decay_threads;
+	time_t   decay_when_last_cycle;
+
 	uint32_t latency;
 } diag_stats_t;
 
@@ -710,6 +718,12 @@ struct job_record {
 	uint64_t db_index;              /* used only for database plugins */
 	time_t deadline;		/* deadline */
 	uint32_t delay_boot;		/* Delay boot for desired node mode */
+	bool depend_cached;		/* dependencies known unfulfilled until
+					 * a dependee changes state, see
+					 * depend_graph_notify() */
+	uint32_t depend_gen;		/* dependency graph edge generation */
+	uint32_t depend_task_id;	/* array_task_id when depend_cached
+					 * was set */
 	uint32_t derived_ec;		/* highest exit code of all job steps */
 	struct job_details *details;	/* job details */
 	uint16_t direct_set_prio;	/* Priority set directly if
@@ -747,6 +761,9 @@ struct job_record {
 	job_record_t *job_next;		/* next entry with same hash index */
 	job_record_t *job_array_next_j;	/* job array linked list by job_id */
 	job_record_t *job_array_next_t;	/* job array linked list by task_id */
+	struct job_array_index *array_index; /* task state counts for the
+					 * job array, see job_state_set() */
+	uint32_t array_index_state;	/* job_state in array_index counts */
 	job_record_t *job_preempt_comp; /* het job preempt component */
 	job_resources_t *job_resrcs;	/* details of allocated cores */
 	uint32_t job_state;		/* state of the job */
@@ -848,6 +865,8 @@ struct job_record {
 	uint32_t state_reason_prev_db;	/* Previous state_reason that isn't
 					 * priority or resources, only stored in
 					 * the database. */
+	bool state_saved;		/* saved state is current, cleared by
+					 * job_record_changed() */
 	List step_list;			/* list of job's steps */
 	time_t suspend_time;		/* time job last suspended or resumed */
 	char *system_comment;		/* slurmctld's arbitrary comment */
@@ -1738,6 +1757,29 @@ extern void job_set_req_tres(job_record_t *job_ptr, bool assoc_mgr_locked);
  * NOTE: job write lock must be locked before calling this */
 extern void job_set_alloc_tres(job_record_t *job_ptr, bool assoc_mgr_locked);
 
+/*
+ * job_state_set - set a job's state. All changes to job_state of a job record
+ *	should go through here (or job_state_set_flag/job_state_unset_flag) so
+ *	the job array task state counts stay current.
+ * IN/OUT job_ptr - job structure to be updated
+ * IN state - new job state including flags
+ * NOTE: job write lock must be locked before calling this */
+extern void job_state_set(job_record_t *job_ptr, uint32_t state);
+extern void job_state_set_flag(job_record_t *job_ptr, uint32_t flag);
+extern void job_state_unset_flag(job_record_t *job_ptr, uint32_t flag);
+
+/*
+ * job_record_changed - note that a job's saved state changed, so that the
+ *	next journaled state save writes its record, see dump_all_job_state()
+ * NOTE: job write lock must be locked before calling this */
+extern void job_record_changed(job_record_t *job_ptr);
+
+/*
+ * job_state_full_save - have the next job state save write a complete
+ *	job_state file from job_list rather than append to the journal
+ */
+extern void job_state_full_save(void);
+
 /*
  * job_update_tres_cnt - when job is completing remove allocated tres
  *                      from count.
@@ -1879,6 +1921,12 @@ extern int load_all_part_state ( void );
 extern int load_step_state(job_record_t *job_ptr, Buf buffer,
 			   uint16_t protocol_version);
 
+/*
+ * Note the switch resources of the steps of a recovered job as allocated,
+ * see load_step_state()
+ */
+extern void recover_job_steps(job_record_t *job_ptr);
+
 /*
  * Log contents of avail_feature_list and active_feature_list
  */
@@ -1960,6 +2008,24 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 			  uint16_t show_flags, uid_t uid, uint32_t filter_uid,
 			  uint16_t protocol_version);
 
+/*
+ * pack_job_delta - dump job information for jobs whose packed record changed
+ *	since a given time, followed by the IDs of jobs removed since then,
+ *	in machine independent form (for network transmission)
+ * OUT buffer_ptr - the pointer is set to the allocated buffer.
+ * OUT buffer_size - set to size of the buffer in bytes
+ * IN show_flags - job filtering options
+ * IN uid - uid of user making request (for partition filtering)
+ * IN since - last_update of the client's previous job information
+ * IN protocol_version - slurm protocol version of client
+ * RET SLURM_SUCCESS or SLURM_ERROR if the changes since that time are not
+ *	known, use pack_all_jobs() instead
+ * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
+ */
+extern int pack_job_delta(char **buffer_ptr, int *buffer_size,
+			  uint16_t show_flags, uid_t uid, time_t since,
+			  uint16_t protocol_version);
+
 /*
  * pack_spec_jobs - dump job information for specified jobs in
  *	machine independent form (for network transmission)
@@ -1999,6 +2065,10 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 			  uint16_t protocol_version);
 
+/* Append the statistics added with SLURM_20_02_EXT_PROTOCOL_VERSION */
+extern void pack_ext_stat(int resp, char **buffer_ptr, int *buffer_size,
+			  uint16_t protocol_version);
+
 /*
  * pack_ctld_job_step_info_response_msg - packs job step info
  * IN job_id - specific id or NO_VAL for all
@@ -39,9 +39,13 @@
 #include <stdio.h>
 
 #include "src/slurmctld/agent.h"
+#include "src/slurmctld/locks.h"
+#include "src/slurmctld/rpc_class.h"
 #include "src/slurmctld/slurmctld.h"
+#include "src/common/forward.h"
 #include "src/common/list.h"
 #include "src/common/pack.h"
+#include "src/common/slab.h"
 #include "src/common/xstring.h"
 #include "src/common/slurmdbd_defs.h"
 
@@ -215,6 +219,40 @@ extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 	buffer_ptr[0] = xfer_buf_data(buffer);
 }
 
+/*
+ * Append the statistics added with SLURM_20_02_EXT_PROTOCOL_VERSION. They go
+ * after the rpc statistics packed by the caller so a 20.02 client stops
+ * reading before them.
+ */
+extern void pack_ext_stat(int resp, char **buffer_ptr, int *buffer_size,
+			  uint16_t protocol_version)
+{
+	Buf buffer;
+
+	if (!resp || (protocol_version < SLURM_20_02_EXT_PROTOCOL_VERSION))
+		return;
+
+	buffer = create_buf(*buffer_ptr, *buffer_size);
+	set_buf_offset(buffer, *buffer_size);
+
+	pack_lock_stats(buffer, protocol_version);
+	pack_rpc_class_stats(buffer, protocol_version);
+
+	pack32(slurmctld_diag_stats.decay_cycle_counter, buffer);
+	pack64(slurmctld_diag_stats.decay_cycle_sum, buffer);
+	pack32(slurmctld_diag_stats.decay_cycle_last, buffer);
+	pack32(slurmctld_diag_stats.decay_cycle_max, buffer);
+	pack32(slurmctld_diag_stats.decay_jobs_last, buffer);
+	pack32(slurmctld_diag_stats.decay_threads, buffer);
+	pack_time(slurmctld_diag_stats.decay_when_last_cycle, buffer);
+
+	pack_slab_stats(buffer, protocol_version);
+	forward_pack_stats(buffer, protocol_version);
+
+	*buffer_size = get_buf_offset(buffer);
+	buffer_ptr[0] = xfer_buf_data(buffer);
+}
+
 /* Reset all scheduling statistics
  * level IN - clear backfilled_jobs count if set */
 extern void reset_stats(int level)
@@ -251,5 +289,13 @@ extern void reset_stats(int level)
 	slurmctld_diag_stats.bf_last_depth = 0;
 	slurmctld_diag_stats.bf_last_depth_try = 0;
 
+	slurmctld_diag_stats.decay_cycle_counter = 0;
+	slurmctld_diag_stats.decay_cycle_sum = 0;
+	slurmctld_diag_stats.decay_cycle_max = 0;
+
+	reset_lock_stats();
+	reset_rpc_class_stats();
+	forward_reset_stats();
+
 	last_proc_req_start = time(NULL);
 }
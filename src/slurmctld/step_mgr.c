@@ -156,14 +156,11 @@ static int _opt_node_cnt(uint32_t step_min_nodes, uint32_t step_max_nodes,
 }
 
 /*
- * _create_step_record - create an empty step_record for the specified job.
- * IN job_ptr - pointer to job table entry to have step record added
- * IN protocol_version - slurm protocol version of client
- * RET a pointer to the record or NULL if error
- * NOTE: allocates memory that should be xfreed with delete_step_record
+ * _alloc_step_record - create an empty step_record for the specified job
+ *	without noting a job update, see _create_step_record()
  */
-static step_record_t *_create_step_record(job_record_t *job_ptr,
-					  uint16_t protocol_version)
+static step_record_t *_alloc_step_record(job_record_t *job_ptr,
+					 uint16_t protocol_version)
 {
 	step_record_t *step_ptr;
 
@@ -179,7 +176,6 @@ static step_record_t *_create_step_record(job_record_t *job_ptr,
 
 	step_ptr = xmalloc(sizeof(*step_ptr));
 
-	last_job_update = time(NULL);
 	step_ptr->job_ptr    = job_ptr;
 	step_ptr->exit_code  = NO_VAL;
 	step_ptr->time_limit = INFINITE;
@@ -196,6 +192,25 @@ static step_record_t *_create_step_record(job_record_t *job_ptr,
 	return step_ptr;
 }
 
+/*
+ * _create_step_record - create an empty step_record for the specified job.
+ * IN job_ptr - pointer to job table entry to have step record added
+ * IN protocol_version - slurm protocol version of client
+ * RET a pointer to the record or NULL if error
+ * NOTE: allocates memory that should be xfreed with delete_step_record
+ */
+static step_record_t *_create_step_record(job_record_t *job_ptr,
+					  uint16_t protocol_version)
+{
+	step_record_t *step_ptr;
+
+	if ((step_ptr = _alloc_step_record(job_ptr, protocol_version))) {
+		last_job_update = time(NULL);
+		job_record_changed(job_ptr);
+	}
+	return step_ptr;
+}
+
 /* Purge any duplicate job steps for this PID */
 static int _purge_duplicate_steps(job_record_t *job_ptr,
 				  job_step_create_request_msg_t *step_specs)
@@ -316,6 +331,7 @@ extern void delete_step_records(job_record_t *job_ptr)
 	xassert(job_ptr);
 
 	last_job_update = time(NULL);
+	job_record_changed(job_ptr);
 	step_iterator = list_iterator_create(job_ptr->step_list);
 	while ((step_ptr = list_next(step_iterator))) {
 		/* Only check if not a pending step */
@@ -426,6 +442,7 @@ int delete_step_record(job_record_t *job_ptr, uint32_t step_id)
 		return error_code;
 
 	last_job_update = time(NULL);
+	job_record_changed(job_ptr);
 	step_iterator = list_iterator_create (job_ptr->step_list);
 	while ((step_ptr = list_next(step_iterator))) {
 		if (step_ptr->step_id != step_id)
@@ -827,6 +844,7 @@ int job_step_complete(uint32_t job_id, uint32_t step_id, uid_t uid,
 	_internal_step_complete(job_ptr, step_ptr);
 
 	last_job_update = time(NULL);
+	job_record_changed(job_ptr);
 
 	return SLURM_SUCCESS;
 }
@@ -3820,22 +3838,22 @@ extern int dump_job_step_state(void *x, void *arg)
 	(void) gres_plugin_step_state_pack(step_ptr->gres_list, buffer,
 					   step_ptr->job_ptr->job_id,
 					   step_ptr->step_id,
-					   SLURM_PROTOCOL_VERSION);
+					   SLURM_STATE_PROTOCOL_VERSION);
 
 	pack16(step_ptr->batch_step, buffer);
 
 	pack_slurm_step_layout(step_ptr->step_layout, buffer,
-			       SLURM_PROTOCOL_VERSION);
+			       SLURM_STATE_PROTOCOL_VERSION);
 
 	if (step_ptr->switch_job) {
 		pack8(1, buffer);
 		switch_g_pack_jobinfo(step_ptr->switch_job, buffer,
-				      SLURM_PROTOCOL_VERSION);
+				      SLURM_STATE_PROTOCOL_VERSION);
 	} else
 		pack8(0, buffer);
 
 	select_g_select_jobinfo_pack(step_ptr->select_jobinfo, buffer,
-				     SLURM_PROTOCOL_VERSION);
+				     SLURM_STATE_PROTOCOL_VERSION);
 	packstr(step_ptr->tres_alloc_str, buffer);
 	packstr(step_ptr->tres_fmt_alloc_str, buffer);
 
@@ -4050,9 +4068,14 @@ extern int load_step_state(job_record_t *job_ptr, Buf buffer,
 		goto unpack_error;
 	}
 
+	/*
+	 * The job record is not yet installed and may be unpacked by one of
+	 * several threads, see load_all_job_state(), so nothing global may be
+	 * changed here
+	 */
 	step_ptr = find_step_record(job_ptr, step_id);
 	if (step_ptr == NULL)
-		step_ptr = _create_step_record(job_ptr, start_protocol_ver);
+		step_ptr = _alloc_step_record(job_ptr, start_protocol_ver);
 	if (step_ptr == NULL)
 		goto unpack_error;
 
@@ -4147,10 +4170,6 @@ extern int load_step_state(job_record_t *job_ptr, Buf buffer,
 		core_bitmap_job = NULL;
 	}
 
-	if (step_ptr->step_layout && switch_tmp)
-		switch_g_job_step_allocated(switch_tmp,
-					    step_ptr->step_layout->node_list);
-
 	info("recovered %pS", step_ptr);
 	return SLURM_SUCCESS;
 
@@ -4181,6 +4200,28 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+/*
+ * Note the switch resources of the steps recovered by load_step_state() as
+ * allocated, once the job record is installed
+ */
+extern void recover_job_steps(job_record_t *job_ptr)
+{
+	ListIterator step_iterator;
+	step_record_t *step_ptr;
+
+	if (!job_ptr->step_list)
+		return;
+
+	step_iterator = list_iterator_create(job_ptr->step_list);
+	while ((step_ptr = list_next(step_iterator))) {
+		if (step_ptr->step_layout && step_ptr->switch_job) {
+			switch_g_job_step_allocated(step_ptr->switch_job,
+					step_ptr->step_layout->node_list);
+		}
+	}
+	list_iterator_destroy(step_iterator);
+}
+
 static void _signal_step_timelimit(job_record_t *job_ptr, step_record_t *step_ptr,
 				   time_t now)
 {
@@ -4420,8 +4461,10 @@ extern int update_step(step_update_request_msg_t *req, uid_t uid)
 			     step_ptr, req->time_limit);
 		}
 	}
-	if (mod_cnt)
+	if (mod_cnt) {
 		last_job_update = time(NULL);
+		job_record_changed(job_ptr);
+	}
 	if (new_step) {
 		/*
 		 * This was a temporary step record, never linked to the job,
@@ -828,7 +828,7 @@ extern int trigger_state_save(void)
 
 	/* write header: version, time */
 	packstr(TRIGGER_STATE_VERSION, buffer);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack16(SLURM_STATE_PROTOCOL_VERSION, buffer);
 	pack_time(time(NULL), buffer);
 
 	/* write individual trigger records */
@@ -492,8 +492,29 @@ rwfail:
 	return (-1);
 }
 
+/*
+ * Send the configuration part of the slurmstepd initialization data.
+ * A pooled slurmstepd is sent this when started, the rest at launch.
+ */
+static int _send_slurmstepd_conf(int fd)
+{
+	/* send conf over to slurmstepd */
+	if (send_slurmd_conf_lite(fd, conf) < 0)
+		return -1;
+
+	/* send cgroup conf over to slurmstepd */
+	if (xcgroup_write_conf(fd) < 0)
+		return -1;
+
+	/* send acct_gather.conf over to slurmstepd */
+	if (acct_gather_write_conf(fd) < 0)
+		return -1;
+
+	return 0;
+}
+
 static int
-_send_slurmstepd_init(int fd, int type, void *req,
+_send_slurmstepd_init(int fd, bool send_conf, int type, void *req,
 		      slurm_addr_t *cli, slurm_addr_t *self,
 		      hostset_t step_hset, uint16_t protocol_version)
 {
@@ -508,16 +529,7 @@ _send_slurmstepd_init(int fd, int type, void *req,
 
 	slurm_msg_t_init(&msg);
 
-	/* send conf over to slurmstepd */
-	if (send_slurmd_conf_lite(fd, conf) < 0)
-		goto rwfail;
-
-	/* send cgroup conf over to slurmstepd */
-	if (xcgroup_write_conf(fd) < 0)
-		goto rwfail;
-
-	/* send acct_gather.conf over to slurmstepd */
-	if (acct_gather_write_conf(fd) < 0)
+	if (send_conf && (_send_slurmstepd_conf(fd) < 0))
 		goto rwfail;
 
 	/* send type over to slurmstepd */
@@ -683,21 +695,76 @@ rwfail:
 }
 
 
+/* Add a step whose slurmstepd has started to the stepd registry */
+static void _register_step(uint16_t type, void *req)
+{
+	if (type == LAUNCH_BATCH_JOB)
+		stepd_registry_add(((batch_job_launch_msg_t *)req)->job_id,
+				   SLURM_BATCH_SCRIPT);
+	else if (type == LAUNCH_TASKS)
+		stepd_registry_add(
+			((launch_tasks_request_msg_t *)req)->job_id,
+			((launch_tasks_request_msg_t *)req)->job_step_id);
+}
+
+/*
+ * Pool of idle slurmstepd processes kept with LaunchParameters=stepd_pool=#.
+ * A pooled slurmstepd has been sent the configuration part of its
+ * initialization data and has loaded its plugins. It is handed the rest
+ * when a step is launched, which saves the fork, exec and plugin loading
+ * from the launch latency.
+ */
+typedef struct {
+	int to_stepd;		/* write end of the slurmstepd's stdin */
+	int to_slurmd;		/* read end of the slurmstepd's stdout */
+} pool_stepd_t;
+
+static pthread_mutex_t stepd_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t stepd_pool_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t stepd_pool_thread = 0;
+static List stepd_pool = NULL;
+static int stepd_pool_size = 0;
+static uint32_t stepd_pool_gen = 0;	/* bumped when the pool is flushed */
+static bool stepd_pool_shutdown = false;
+
 /*
- * Fork and exec the slurmstepd, then send the slurmstepd its
- * initialization data.  Then wait for slurmstepd to send an "ok"
- * message before returning.  When the "ok" message is received,
- * the slurmstepd has created and begun listening on its unix
- * domain socket.
+ * Histograms of slurmstepd launch latency, from the start of
+ * _forkexec_slurmstepd() to the slurmstepd's reply. Bucket i counts
+ * latencies under 2^i msec, the last one everything longer.
+ */
+#define LAUNCH_HIST_CNT 12
+static pthread_mutex_t launch_hist_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t launch_hist_new[LAUNCH_HIST_CNT];
+static uint32_t launch_hist_pooled[LAUNCH_HIST_CNT];
+
+static void _launch_hist_add(bool pooled, long usec)
+{
+	long msec = usec / 1000;
+	int i = 0;
+
+	while ((i < (LAUNCH_HIST_CNT - 1)) && (msec >= (1L << i)))
+		i++;
+
+	slurm_mutex_lock(&launch_hist_mutex);
+	if (pooled)
+		launch_hist_pooled[i]++;
+	else
+		launch_hist_new[i]++;
+	slurm_mutex_unlock(&launch_hist_mutex);
+}
+
+/*
+ * Fork and exec a slurmstepd reading its initialization data from
+ * *to_stepd_fd and replying on *to_slurmd_fd. type and req name the
+ * valgrind log file, req may be NULL.
+ * RET pid of the child process to reap, or -1 on error
  *
  * Note that this code forks twice and it is the grandchild that
  * becomes the slurmstepd process, so the slurmstepd's parent process
  * will be init, not slurmd.
  */
-static int
-_forkexec_slurmstepd(uint16_t type, void *req,
-		     slurm_addr_t *cli, slurm_addr_t *self,
-		     const hostset_t step_hset, uint16_t protocol_version)
+static pid_t _spawn_slurmstepd(int type, void *req,
+			       int *to_stepd_fd, int *to_slurmd_fd)
 {
 	pid_t pid;
 	int to_stepd[2] = {-1, -1};
@@ -705,12 +772,11 @@ _forkexec_slurmstepd(uint16_t type, void *req,
 
 	if (pipe(to_stepd) < 0 || pipe(to_slurmd) < 0) {
 		error("%s: pipe failed: %m", __func__);
-		return SLURM_ERROR;
-	}
-
-	if (_add_starting_step(type, req)) {
-		error("%s: failed in _add_starting_step: %m", __func__);
-		return SLURM_ERROR;
+		if (to_stepd[0] >= 0) {
+			close(to_stepd[0]);
+			close(to_stepd[1]);
+		}
+		return -1;
 	}
 
 	if ((pid = fork()) < 0) {
@@ -719,75 +785,15 @@ _forkexec_slurmstepd(uint16_t type, void *req,
 		close(to_stepd[1]);
 		close(to_slurmd[0]);
 		close(to_slurmd[1]);
-		_remove_starting_step(type, req);
-		return SLURM_ERROR;
+		return -1;
 	} else if (pid > 0) {
-		int rc = SLURM_SUCCESS;
-#if (SLURMSTEPD_MEMCHECK == 0)
-		int i;
-		time_t start_time = time(NULL);
-#endif
-		/*
-		 * Parent sends initialization data to the slurmstepd
-		 * over the to_stepd pipe, and waits for the return code
-		 * reply on the to_slurmd pipe.
-		 */
 		if (close(to_stepd[0]) < 0)
 			error("Unable to close read to_stepd in parent: %m");
 		if (close(to_slurmd[1]) < 0)
 			error("Unable to close write to_slurmd in parent: %m");
-
-		if ((rc = _send_slurmstepd_init(to_stepd[1], type,
-						req, cli, self,
-						step_hset,
-						protocol_version)) != 0) {
-			error("Unable to init slurmstepd");
-			goto done;
-		}
-
-		/* If running under valgrind/memcheck, this pipe doesn't work
-		 * correctly so just skip it. */
-#if (SLURMSTEPD_MEMCHECK == 0)
-		i = read(to_slurmd[0], &rc, sizeof(int));
-		if (i < 0) {
-			error("%s: Can not read return code from slurmstepd "
-			      "got %d: %m", __func__, i);
-			rc = SLURM_ERROR;
-		} else if (i != sizeof(int)) {
-			error("%s: slurmstepd failed to send return code "
-			      "got %d: %m", __func__, i);
-			rc = SLURM_ERROR;
-		} else {
-			int delta_time = time(NULL) - start_time;
-			int cc;
-			if (delta_time > 5) {
-				info("Warning: slurmstepd startup took %d sec, "
-				     "possible file system problem or full "
-				     "memory", delta_time);
-			}
-			if (rc != SLURM_SUCCESS)
-				error("slurmstepd return code %d", rc);
-
-			cc = SLURM_SUCCESS;
-			cc = write(to_stepd[1], &cc, sizeof(int));
-			if (cc != sizeof(int)) {
-				error("%s: failed to send ack to stepd %d: %m",
-				      __func__, cc);
-			}
-		}
-#endif
-	done:
-		if (_remove_starting_step(type, req))
-			error("Error cleaning up starting_step list");
-
-		/* Reap child */
-		if (waitpid(pid, NULL, 0) < 0)
-			error("Unable to reap slurmd child process");
-		if (close(to_stepd[1]) < 0)
-			error("close write to_stepd in parent: %m");
-		if (close(to_slurmd[0]) < 0)
-			error("close read to_slurmd in parent: %m");
-		return rc;
+		*to_stepd_fd = to_stepd[1];
+		*to_slurmd_fd = to_slurmd[0];
+		return pid;
 	} else {
 #if (SLURMSTEPD_MEMCHECK == 1)
 		/* memcheck test of slurmstepd, option #1 */
@@ -935,6 +941,271 @@ _forkexec_slurmstepd(uint16_t type, void *req,
 	}
 }
 
+/*
+ * Send a started slurmstepd the rest of its initialization data, then wait
+ * for it to send an "ok" message. When the "ok" message is received, the
+ * slurmstepd has created and begun listening on its unix domain socket.
+ */
+static int _init_slurmstepd(int to_stepd, int to_slurmd, bool send_conf,
+			    uint16_t type, void *req,
+			    slurm_addr_t *cli, slurm_addr_t *self,
+			    const hostset_t step_hset,
+			    uint16_t protocol_version)
+{
+	int rc = SLURM_SUCCESS;
+#if (SLURMSTEPD_MEMCHECK == 0)
+	int i;
+	time_t start_time = time(NULL);
+#endif
+
+	if ((rc = _send_slurmstepd_init(to_stepd, send_conf, type,
+					req, cli, self,
+					step_hset,
+					protocol_version)) != 0) {
+		error("Unable to init slurmstepd");
+		return rc;
+	}
+
+	/* If running under valgrind/memcheck, this pipe doesn't work
+	 * correctly so just skip it. */
+#if (SLURMSTEPD_MEMCHECK == 0)
+	i = read(to_slurmd, &rc, sizeof(int));
+	if (i < 0) {
+		error("%s: Can not read return code from slurmstepd "
+		      "got %d: %m", __func__, i);
+		rc = SLURM_ERROR;
+	} else if (i != sizeof(int)) {
+		error("%s: slurmstepd failed to send return code "
+		      "got %d: %m", __func__, i);
+		rc = SLURM_ERROR;
+	} else {
+		int delta_time = time(NULL) - start_time;
+		int cc;
+		if (delta_time > 5) {
+			info("Warning: slurmstepd startup took %d sec, "
+			     "possible file system problem or full "
+			     "memory", delta_time);
+		}
+		if (rc != SLURM_SUCCESS)
+			error("slurmstepd return code %d", rc);
+
+		cc = SLURM_SUCCESS;
+		cc = write(to_stepd, &cc, sizeof(int));
+		if (cc != sizeof(int)) {
+			error("%s: failed to send ack to stepd %d: %m",
+			      __func__, cc);
+		}
+	}
+#endif
+	return rc;
+}
+
+static void _pool_stepd_free(void *x)
+{
+	pool_stepd_t *stepd = (pool_stepd_t *) x;
+
+	/* A pooled slurmstepd exits when its stdin is closed */
+	if (close(stepd->to_stepd) < 0)
+		error("close write to_stepd in parent: %m");
+	if (close(stepd->to_slurmd) < 0)
+		error("close read to_slurmd in parent: %m");
+	xfree(stepd);
+}
+
+static pool_stepd_t *_stepd_pool_spawn(void)
+{
+	pool_stepd_t *stepd = xmalloc(sizeof(pool_stepd_t));
+	pid_t pid;
+
+	if ((pid = _spawn_slurmstepd(-1, NULL, &stepd->to_stepd,
+				     &stepd->to_slurmd)) < 0) {
+		xfree(stepd);
+		return NULL;
+	}
+	if (waitpid(pid, NULL, 0) < 0)
+		error("Unable to reap slurmd child process");
+
+	/* Keep the pipes out of other slurmd children while pooled */
+	fd_set_close_on_exec(stepd->to_stepd);
+	fd_set_close_on_exec(stepd->to_slurmd);
+
+	if (_send_slurmstepd_conf(stepd->to_stepd) < 0) {
+		error("%s: Unable to send configuration to slurmstepd",
+		      __func__);
+		_pool_stepd_free(stepd);
+		return NULL;
+	}
+	return stepd;
+}
+
+/* Keep stepd_pool_size idle slurmstepds started */
+static void *_stepd_pool_agent(void *arg)
+{
+	pool_stepd_t *stepd;
+	struct timespec ts = {0, 0};
+	uint32_t gen;
+
+	slurm_mutex_lock(&stepd_pool_mutex);
+	while (!stepd_pool_shutdown) {
+		if (list_count(stepd_pool) >= stepd_pool_size) {
+			slurm_cond_wait(&stepd_pool_cond, &stepd_pool_mutex);
+			continue;
+		}
+		gen = stepd_pool_gen;
+		slurm_mutex_unlock(&stepd_pool_mutex);
+
+		stepd = _stepd_pool_spawn();
+
+		slurm_mutex_lock(&stepd_pool_mutex);
+		if (!stepd) {
+			/* Don't retry a failing fork or exec in a loop */
+			ts.tv_sec = time(NULL) + 5;
+			slurm_cond_timedwait(&stepd_pool_cond,
+					     &stepd_pool_mutex, &ts);
+		} else if ((gen != stepd_pool_gen) || stepd_pool_shutdown) {
+			/* Started with a configuration since replaced */
+			_pool_stepd_free(stepd);
+		} else {
+			list_append(stepd_pool, stepd);
+		}
+	}
+	slurm_mutex_unlock(&stepd_pool_mutex);
+
+	return NULL;
+}
+
+/*
+ * Take an idle slurmstepd from the pool
+ * RET true if one was available and its pipes are set in the arguments
+ */
+static bool _stepd_pool_get(int *to_stepd, int *to_slurmd)
+{
+	pool_stepd_t *stepd;
+	struct pollfd pfd;
+	bool found = false;
+
+	slurm_mutex_lock(&stepd_pool_mutex);
+	while (stepd_pool && (stepd = list_pop(stepd_pool))) {
+		/* An idle slurmstepd writes nothing, any event is its exit */
+		pfd.fd = stepd->to_slurmd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (poll(&pfd, 1, 0) != 0) {
+			debug("%s: discarding exited slurmstepd", __func__);
+			_pool_stepd_free(stepd);
+			continue;
+		}
+		*to_stepd = stepd->to_stepd;
+		*to_slurmd = stepd->to_slurmd;
+		xfree(stepd);
+		found = true;
+		break;
+	}
+	if (stepd_pool_size)
+		slurm_cond_signal(&stepd_pool_cond);
+	slurm_mutex_unlock(&stepd_pool_mutex);
+
+	return found;
+}
+
+extern void stepd_pool_init(void)
+{
+	char *launch_params, *tmp_ptr;
+	int size = 0;
+
+	launch_params = slurm_get_launch_params();
+	if ((tmp_ptr = xstrcasestr(launch_params, "stepd_pool="))) {
+		size = atoi(tmp_ptr + 11);
+		if (size < 0) {
+			error("Invalid LaunchParameters stepd_pool value %d",
+			      size);
+			size = 0;
+		}
+	}
+	xfree(launch_params);
+
+	slurm_mutex_lock(&stepd_pool_mutex);
+	if (!stepd_pool)
+		stepd_pool = list_create(_pool_stepd_free);
+	/* Idle slurmstepds were sent the previous configuration */
+	list_flush(stepd_pool);
+	stepd_pool_gen++;
+	stepd_pool_size = size;
+	if (stepd_pool_size && !stepd_pool_thread)
+		slurm_thread_create(&stepd_pool_thread, _stepd_pool_agent,
+				    NULL);
+	slurm_cond_signal(&stepd_pool_cond);
+	slurm_mutex_unlock(&stepd_pool_mutex);
+
+	if (size)
+		debug("%s: keeping %d idle slurmstepd processes",
+		      __func__, size);
+}
+
+extern void stepd_pool_fini(void)
+{
+	slurm_mutex_lock(&stepd_pool_mutex);
+	stepd_pool_shutdown = true;
+	slurm_cond_signal(&stepd_pool_cond);
+	slurm_mutex_unlock(&stepd_pool_mutex);
+
+	if (stepd_pool_thread) {
+		pthread_join(stepd_pool_thread, NULL);
+		stepd_pool_thread = 0;
+	}
+	FREE_NULL_LIST(stepd_pool);
+}
+
+/*
+ * Start a slurmstepd, taking an idle one from the pool if available, and
+ * send it its initialization data. Then wait for slurmstepd to send an "ok"
+ * message before returning.
+ */
+static int
+_forkexec_slurmstepd(uint16_t type, void *req,
+		     slurm_addr_t *cli, slurm_addr_t *self,
+		     const hostset_t step_hset, uint16_t protocol_version)
+{
+	pid_t pid = 0;
+	int to_stepd = -1, to_slurmd = -1;
+	bool pooled;
+	int rc;
+	DEF_TIMERS;
+
+	START_TIMER;
+	if (_add_starting_step(type, req)) {
+		error("%s: failed in _add_starting_step: %m", __func__);
+		return SLURM_ERROR;
+	}
+
+	if (!(pooled = _stepd_pool_get(&to_stepd, &to_slurmd)) &&
+	    ((pid = _spawn_slurmstepd(type, req, &to_stepd,
+				      &to_slurmd)) < 0)) {
+		_remove_starting_step(type, req);
+		return SLURM_ERROR;
+	}
+
+	rc = _init_slurmstepd(to_stepd, to_slurmd, !pooled, type, req,
+			      cli, self, step_hset, protocol_version);
+	if (rc == SLURM_SUCCESS)
+		_register_step(type, req);
+	if (_remove_starting_step(type, req))
+		error("Error cleaning up starting_step list");
+
+	/* Reap child */
+	if (pid && (waitpid(pid, NULL, 0) < 0))
+		error("Unable to reap slurmd child process");
+	if (close(to_stepd) < 0)
+		error("close write to_stepd in parent: %m");
+	if (close(to_slurmd) < 0)
+		error("close read to_slurmd in parent: %m");
+
+	END_TIMER;
+	if (rc == SLURM_SUCCESS)
+		_launch_hist_add(pooled, DELTA_TIMER);
+	return rc;
+}
+
 static void _setup_x11_display(uint32_t job_id, uint32_t step_id,
 			       char ***env, uint32_t *envc)
 {
@@ -953,7 +1224,8 @@ static void _setup_x11_display(uint32_t job_id, uint32_t step_id,
 	}
 
 	display = stepd_get_x11_display(fd, protocol_version, &xauthority);
-	close(fd);
+	/* zero is also returned if the display could not be read */
+	stepd_disconnect(fd, (display != 0));
 
 	if (!display) {
 		error("could not get x11 forwarding display for job %u step %u,"
@@ -2631,9 +2903,11 @@ _rpc_job_notify(slurm_msg_t *msg)
 		info("send notification to job %u.%u",
 		     stepd->jobid, stepd->stepid);
 		if (stepd_notify_job(fd, stepd->protocol_version,
-				     req->message) < 0)
+				     req->message) < 0) {
 			debug("notify jobid=%u failed: %m", stepd->jobid);
-		close(fd);
+			stepd_disconnect(fd, false);
+		} else
+			stepd_disconnect(fd, true);
 	}
 	list_iterator_destroy(i);
 	FREE_NULL_LIST(steps);
@@ -2916,7 +3190,7 @@ _load_job_limits(void)
 			error("Error reading step %u.%u memory limits from "
 			      "slurmstepd",
 			      stepd->jobid, stepd->stepid);
-			close(fd);
+			stepd_disconnect(fd, false);
 			continue;
 		}
 
@@ -2940,7 +3214,7 @@ _load_job_limits(void)
 #endif
 			list_append(job_limits_list, job_limits_ptr);
 		}
-		close(fd);
+		stepd_disconnect(fd, true);
 	}
 	list_iterator_destroy(step_iter);
 	FREE_NULL_LIST(steps);
@@ -2982,7 +3256,7 @@ _enforce_job_mem_limit(void)
 	ListIterator step_iter, job_limits_iter;
 	job_mem_limits_t *job_limits_ptr;
 	step_loc_t *stepd;
-	int fd, i, job_inx, job_cnt;
+	int fd, i, job_inx, job_cnt, rc;
 	uint16_t vsize_factor;
 	uint64_t step_rss, step_vsize;
 	job_step_id_msg_t acct_req;
@@ -3059,10 +3333,9 @@ _enforce_job_mem_limit(void)
 		acct_req.step_id = stepd->stepid;
 		resp = xmalloc(sizeof(job_step_stat_t));
 
-		if ((!stepd_stat_jobacct(
-			     fd, stepd->protocol_version,
-			     &acct_req, resp)) &&
-		    (resp->jobacct)) {
+		rc = stepd_stat_jobacct(fd, stepd->protocol_version,
+					&acct_req, resp);
+		if ((rc == SLURM_SUCCESS) && resp->jobacct) {
 			/* resp->jobacct is NULL if account is disabled */
 			jobacctinfo_getinfo((struct jobacctinfo *)
 					    resp->jobacct,
@@ -3092,7 +3365,7 @@ _enforce_job_mem_limit(void)
 			}
 		}
 		slurm_free_job_step_stat(resp);
-		close(fd);
+		stepd_disconnect(fd, (rc == SLURM_SUCCESS));
 	}
 	list_iterator_destroy(step_iter);
 	FREE_NULL_LIST(steps);
@@ -3370,10 +3643,10 @@ _signal_jobstep(uint32_t jobid, uint32_t stepid, uint16_t signal,
 	debug2("container signal %d to job %u.%u", signal, jobid, stepid);
 	rc = stepd_signal_container(fd, protocol_version, signal, flags,
 				    req_uid);
+	stepd_disconnect(fd, (rc != -1));
 	if (rc == -1)
 		rc = ESLURMD_JOB_NOTRUNNING;
 
-	close(fd);
 	return rc;
 }
 
@@ -3427,6 +3700,7 @@ _rpc_terminate_tasks(slurm_msg_t *msg)
 	signal_tasks_msg_t *req = (signal_tasks_msg_t *) msg->data;
 	int               rc = SLURM_SUCCESS;
 	int               fd;
+	bool reuse = true;
 	uint16_t protocol_version;
 	uid_t uid;
 	uid_t req_uid = g_slurm_auth_get_uid(msg->auth_cred);
@@ -3445,6 +3719,7 @@ _rpc_terminate_tasks(slurm_msg_t *msg)
 		debug("terminate_tasks couldn't read from the step %u.%u: %m",
 		      req->job_id, req->job_step_id);
 		rc = ESLURM_INVALID_JOB_ID;
+		reuse = false;
 		goto done2;
 	}
 
@@ -3458,11 +3733,13 @@ _rpc_terminate_tasks(slurm_msg_t *msg)
 	}
 
 	rc = stepd_terminate(fd, protocol_version);
-	if (rc == -1)
+	if (rc == -1) {
 		rc = ESLURMD_JOB_NOTRUNNING;
+		reuse = false;
+	}
 
 done2:
-	close(fd);
+	stepd_disconnect(fd, reuse);
 done:
 	slurm_send_rc_msg(msg, rc);
 }
@@ -3473,6 +3750,7 @@ _rpc_step_complete(slurm_msg_t *msg)
 	step_complete_msg_t *req = (step_complete_msg_t *)msg->data;
 	int               rc = SLURM_SUCCESS;
 	int               fd;
+	bool reuse = true;
 	uint16_t protocol_version;
 	uid_t req_uid = g_slurm_auth_get_uid(msg->auth_cred);
 
@@ -3496,11 +3774,13 @@ _rpc_step_complete(slurm_msg_t *msg)
 	}
 
 	rc = stepd_completion(fd, protocol_version, req);
-	if (rc == -1)
+	if (rc == -1) {
 		rc = ESLURMD_JOB_NOTRUNNING;
+		reuse = false;
+	}
 
 done2:
-	close(fd);
+	stepd_disconnect(fd, reuse);
 done:
 	slurm_send_rc_msg(msg, rc);
 
@@ -3581,10 +3861,10 @@ _get_step_list(void)
 		    == SLURMSTEPD_NOT_RUNNING) {
 			debug("stale domain socket for stepd %u.%u ",
 			      stepd->jobid, stepd->stepid);
-			close(fd);
+			stepd_disconnect(fd, false);
 			continue;
 		}
-		close(fd);
+		stepd_disconnect(fd, true);
 
 		if (step_list)
 			xstrcat(step_list, ", ");
@@ -3629,6 +3909,21 @@ _rpc_daemon_status(slurm_msg_t *msg)
 	resp->slurmd_logfile     = xstrdup(conf->logfile);
 	resp->version            = xstrdup(SLURM_VERSION_STRING);
 
+	slurm_mutex_lock(&stepd_pool_mutex);
+	resp->stepd_pool_size    = stepd_pool_size;
+	resp->stepd_pool_idle    = stepd_pool ? list_count(stepd_pool) : 0;
+	slurm_mutex_unlock(&stepd_pool_mutex);
+
+	resp->launch_hist_cnt    = LAUNCH_HIST_CNT;
+	resp->launch_hist_new    = xcalloc(LAUNCH_HIST_CNT, sizeof(uint32_t));
+	resp->launch_hist_pooled = xcalloc(LAUNCH_HIST_CNT, sizeof(uint32_t));
+	slurm_mutex_lock(&launch_hist_mutex);
+	memcpy(resp->launch_hist_new, launch_hist_new,
+	       sizeof(launch_hist_new));
+	memcpy(resp->launch_hist_pooled, launch_hist_pooled,
+	       sizeof(launch_hist_pooled));
+	slurm_mutex_unlock(&launch_hist_mutex);
+
 	slurm_msg_t_copy(&resp_msg, msg);
 	resp_msg.msg_type = RESPONSE_SLURMD_STATUS;
 	resp_msg.data     = resp;
@@ -3644,6 +3939,7 @@ _rpc_stat_jobacct(slurm_msg_t *msg)
 	slurm_msg_t        resp_msg;
 	job_step_stat_t *resp = NULL;
 	int fd;
+	bool reuse = true;
 	uint16_t protocol_version;
 	uid_t uid;
 	uid_t req_uid = g_slurm_auth_get_uid(msg->auth_cred);
@@ -3664,7 +3960,7 @@ _rpc_stat_jobacct(slurm_msg_t *msg)
 	if ((int)(uid = stepd_get_uid(fd, protocol_version)) < 0) {
 		debug("stat_jobacct couldn't read from the step %u.%u: %m",
 		      req->job_id, req->step_id);
-		close(fd);
+		stepd_disconnect(fd, false);
 		if (msg->conn_fd >= 0)
 			slurm_send_rc_msg(msg, ESLURM_INVALID_JOB_ID);
 		return	ESLURM_INVALID_JOB_ID;
@@ -3680,7 +3976,7 @@ _rpc_stat_jobacct(slurm_msg_t *msg)
 
 		if (msg->conn_fd >= 0) {
 			slurm_send_rc_msg(msg, ESLURM_USER_ID_MISSING);
-			close(fd);
+			stepd_disconnect(fd, true);
 			return ESLURM_USER_ID_MISSING;/* or bad in this case */
 		}
 	}
@@ -3695,6 +3991,7 @@ _rpc_stat_jobacct(slurm_msg_t *msg)
 	    == SLURM_ERROR) {
 		debug("accounting for nonexistent job %u.%u requested",
 		      req->job_id, req->step_id);
+		reuse = false;
 	}
 
 	/* FIX ME: This should probably happen in the
@@ -3704,9 +4001,10 @@ _rpc_stat_jobacct(slurm_msg_t *msg)
 			    &resp->step_pids->pid_cnt) == SLURM_ERROR) {
 		debug("No pids for nonexistent job %u.%u requested",
 		      req->job_id, req->step_id);
+		reuse = false;
 	}
 
-	close(fd);
+	stepd_disconnect(fd, reuse);
 
 	resp_msg.msg_type     = RESPONSE_JOB_STEP_STAT;
 	resp_msg.data         = resp;
@@ -3866,9 +4164,9 @@ _rpc_list_pids(slurm_msg_t *msg)
 			    &resp->pid, &resp->pid_cnt) == SLURM_ERROR) {
 		debug("No pids for nonexistent job %u.%u requested",
 		      req->job_id, req->step_id);
-	}
-
-	close(fd);
+		stepd_disconnect(fd, false);
+	} else
+		stepd_disconnect(fd, true);
 
 	resp_msg.msg_type = RESPONSE_JOB_STEP_PIDS;
 	resp_msg.data     = resp;
@@ -3967,25 +4265,28 @@ static void  _rpc_pid2jid(slurm_msg_t *msg)
 	i = list_iterator_create(steps);
 	while ((stepd = list_next(i))) {
 		int fd;
+		pid_t daemon_pid;
 		fd = stepd_connect(stepd->directory, stepd->nodename,
 				   stepd->jobid, stepd->stepid,
 				   &stepd->protocol_version);
 		if (fd == -1)
 			continue;
 
+		daemon_pid = 0;
 		if (stepd_pid_in_container(
 			    fd, stepd->protocol_version,
 			    req->job_pid)
-		    || req->job_pid == stepd_daemon_pid(
-			    fd, stepd->protocol_version)) {
+		    || req->job_pid == (daemon_pid = stepd_daemon_pid(
+			    fd, stepd->protocol_version))) {
 			slurm_msg_t_copy(&resp_msg, msg);
 			resp.job_id = stepd->jobid;
 			resp.return_code = SLURM_SUCCESS;
 			found = true;
-			close(fd);
+			stepd_disconnect(fd, true);
 			break;
 		}
-		close(fd);
+		/* A failed read in either call leaves daemon_pid at -1 */
+		stepd_disconnect(fd, (daemon_pid != -1));
 	}
 	list_iterator_destroy(i);
 	FREE_NULL_LIST(steps);
@@ -4184,7 +4485,7 @@ void file_bcast_purge(void)
 
 static int _rpc_file_bcast(slurm_msg_t *msg)
 {
-	int rc;
+	int rc, received;
 	int64_t offset, inx;
 	sbcast_cred_arg_t *cred_arg;
 	file_bcast_info_t *file_info;
@@ -4255,10 +4556,15 @@ static int _rpc_file_bcast(slurm_msg_t *msg)
 		return SLURM_ERROR;
 	}
 
+	/*
+	 * Write at the block's offset in the file, a pipelined sbcast sends
+	 * blocks in parallel and they may be written in any order
+	 */
 	offset = 0;
 	while (req->block_len - offset) {
-		inx = write(file_info->fd, &req->block[offset],
-			    (req->block_len - offset));
+		inx = pwrite(file_info->fd, &req->block[offset],
+			     (req->block_len - offset),
+			     req->block_offset + offset);
 		if (inx == -1) {
 			if ((errno == EINTR) || (errno == EAGAIN))
 				continue;
@@ -4271,6 +4577,17 @@ static int _rpc_file_bcast(slurm_msg_t *msg)
 	}
 
 	file_info->last_update = time(NULL);
+	received = __atomic_add_fetch(&file_info->received_blocks, 1,
+				      __ATOMIC_SEQ_CST);
+
+	/* all other blocks are written before the last one is sent */
+	if (req->last_block && (received != req->block_no)) {
+		error("sbcast: uid:%u received %d of %u blocks of `%s`",
+		      key.uid, received, req->block_no, key.fname);
+		_fb_rdunlock();
+		_file_bcast_close_file(&key);
+		return SLURM_ERROR;
+	}
 
 	if (req->last_block && fchmod(file_info->fd, (req->modes & 0777))) {
 		error("sbcast: uid:%u can't chmod `%s`: %m",
@@ -4355,6 +4672,7 @@ _rpc_reattach_tasks(slurm_msg_t *msg)
 	void        *job_cred_sig;
 	uint32_t     len;
 	int               fd;
+	bool reuse = true;
 	slurm_addr_t *cli = &msg->orig_addr;
 	uint32_t nodeid = NO_VAL;
 	uid_t uid = -1;
@@ -4376,10 +4694,13 @@ _rpc_reattach_tasks(slurm_msg_t *msg)
 		      "step %u.%u: %m",
 		      req->job_id, req->job_step_id);
 		rc = ESLURM_INVALID_JOB_ID;
+		reuse = false;
 		goto done2;
 	}
 
 	nodeid = stepd_get_nodeid(fd, protocol_version);
+	if (nodeid == NO_VAL)
+		reuse = false;
 
 	debug2("_rpc_reattach_tasks: nodeid %d in the job step", nodeid);
 
@@ -4436,11 +4757,12 @@ _rpc_reattach_tasks(slurm_msg_t *msg)
 			  &resp_msg.address, job_cred_sig, resp);
 	if (rc != SLURM_SUCCESS) {
 		debug2("stepd_attach call failed");
+		reuse = false;
 		goto done2;
 	}
 
 done2:
-	close(fd);
+	stepd_disconnect(fd, reuse);
 done:
 	debug2("update step addrs rc = %d", rc);
 	resp_msg.data         = resp;
@@ -4478,7 +4800,7 @@ static uid_t _get_job_uid(uint32_t jobid)
 		}
 		uid = stepd_get_uid(fd, stepd->protocol_version);
 
-		close(fd);
+		stepd_disconnect(fd, ((int)uid >= 0));
 		if ((int)uid < 0) {
 			debug("stepd_get_uid failed %u.%u: %m",
 			      stepd->jobid, stepd->stepid);
@@ -4586,9 +4908,11 @@ extern int ume_notify(void)
 		       stepd->jobid, stepd->stepid);
 		if (stepd_signal_container(
 			    fd, stepd->protocol_version, SIG_UME, 0,
-			    getuid()) < 0)
+			    getuid()) < 0) {
 			debug("kill jobid=%u failed: %m", stepd->jobid);
-		close(fd);
+			stepd_disconnect(fd, false);
+		} else
+			stepd_disconnect(fd, true);
 	}
 	list_iterator_destroy(i);
 	FREE_NULL_LIST(steps);
@@ -4637,10 +4961,12 @@ _terminate_all_steps(uint32_t jobid, bool batch)
 		}
 
 		debug2("terminate job step %u.%u", jobid, stepd->stepid);
-		if (stepd_terminate(fd, stepd->protocol_version) < 0)
+		if (stepd_terminate(fd, stepd->protocol_version) < 0) {
 			debug("kill jobid=%u.%u failed: %m", jobid,
 			      stepd->stepid);
-		close(fd);
+			stepd_disconnect(fd, false);
+		} else
+			stepd_disconnect(fd, true);
 	}
 	list_iterator_destroy(i);
 	FREE_NULL_LIST(steps);
@@ -4671,10 +4997,10 @@ _job_still_running(uint32_t job_id)
 			if (stepd_state(fd, s->protocol_version)
 			    != SLURMSTEPD_NOT_RUNNING) {
 				retval = true;
-				close(fd);
+				stepd_disconnect(fd, true);
 				break;
 			}
-			close(fd);
+			stepd_disconnect(fd, false);
 		}
 	}
 	list_iterator_destroy(i);
@@ -4724,10 +5050,10 @@ _steps_completed_now(uint32_t jobid)
 			if (stepd_state(fd, stepd->protocol_version)
 			    != SLURMSTEPD_NOT_RUNNING) {
 				rc = false;
-				close(fd);
+				stepd_disconnect(fd, true);
 				break;
 			}
-			close(fd);
+			stepd_disconnect(fd, false);
 		}
 	}
 	list_iterator_destroy(i);
@@ -4984,7 +5310,7 @@ _rpc_suspend_job(slurm_msg_t *msg)
 						  req, 1) < 0) {
 					susp_fail_count++;
 				} else {
-					close(fd[x]);
+					stepd_disconnect(fd[x], true);
 					fd[x] = -1;
 				}
 			}
@@ -5001,8 +5327,11 @@ _rpc_suspend_job(slurm_msg_t *msg)
 					if (stepd_suspend(
 						    fd[x],
 						    protocol_version[x],
-						    req, 1) >= 0)
+						    req, 1) >= 0) {
+						stepd_disconnect(fd[x], true);
+						fd[x] = -1;
 						continue;
+					}
 					debug("Suspend of job %u failed: %m",
 					      req->job_id);
 				}
@@ -5021,13 +5350,16 @@ _rpc_suspend_job(slurm_msg_t *msg)
 						 req, 1) < 0) {
 					debug("Resume of job %u failed: %m",
 					      req->job_id);
+				} else {
+					stepd_disconnect(fd[x], true);
+					fd[x] = -1;
 				}
 			}
 		}
 		for (x = 0; x < fdi; x++) {
-			/* fd may have been closed by stepd_suspend */
+			/* fd is still set if its suspend or resume failed */
 			if (fd[x] != -1)
-				close(fd[x]);
+				stepd_disconnect(fd[x], false);
 		}
 
 		/* check for no more jobs */
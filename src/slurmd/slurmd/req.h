@@ -62,6 +62,14 @@ extern void record_launched_jobs(void);
 void file_bcast_init(void);
 void file_bcast_purge(void);
 
+/*
+ * Start or resize the pool of idle slurmstepd processes configured with
+ * LaunchParameters=stepd_pool=#. Called again on reconfiguration, which
+ * replaces the idle slurmstepds.
+ */
+extern void stepd_pool_init(void);
+extern void stepd_pool_fini(void);
+
 /*
  * ume_notify - Notify all jobs and steps on this node that a Uncorrectable
  *	Memory Error (UME) has occured by sending SIG_UME (to log event in
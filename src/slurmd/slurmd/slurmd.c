@@ -381,6 +381,7 @@ main (int argc, char **argv)
 		fatal("Unable to clear interconnect state.");
 	switch_g_slurmd_init();
 	file_bcast_init();
+	stepd_registry_init(conf->spooldir, conf->node_name);
 
 	_create_msg_socket();
 
@@ -393,6 +394,7 @@ main (int argc, char **argv)
 	_install_fork_handlers();
 	slurm_conf_install_fork_handlers();
 	record_launched_jobs();
+	stepd_pool_init();
 
 	run_script_health_check();
 
@@ -815,11 +817,11 @@ _fill_registration_msg(slurm_node_registration_status_msg_t *msg)
 			debug("stale domain socket for stepd %u.%u ",
 			      stepd->jobid, stepd->stepid);
 			--(msg->job_count);
-			close(fd);
+			stepd_disconnect(fd, false);
 			continue;
 		}
 
-		close(fd);
+		stepd_disconnect(fd, true);
 		if (stepd->stepid == NO_VAL) {
 			debug("%s: found apparently running job %u",
 			      __func__, stepd->jobid);
@@ -1221,6 +1223,9 @@ _reconfigure(void)
 	/* reconfigure energy */
 	acct_gather_energy_g_set_data(ENERGY_DATA_RECONFIG, NULL);
 
+	/* Replace idle slurmstepds sent the old configuration */
+	stepd_pool_init();
+
 	/*
 	 * XXX: reopen slurmd port?
 	 */
@@ -1971,6 +1976,8 @@ cleanup:
 static int
 _slurmd_fini(void)
 {
+	stepd_pool_fini();
+	stepd_registry_fini();
 	assoc_mgr_fini(false);
 	node_features_g_fini();
 	core_spec_g_fini();
@@ -2257,10 +2264,12 @@ static void _update_logging(void)
 			continue;
 
 		if (stepd_reconfig(fd, stepd->protocol_version)
-		    != SLURM_SUCCESS)
+		    != SLURM_SUCCESS) {
 			debug("Reconfig jobid=%u.%u failed: %m",
 			      stepd->jobid, stepd->stepid);
-		close(fd);
+			stepd_disconnect(fd, false);
+		} else
+			stepd_disconnect(fd, true);
 	}
 	list_iterator_destroy(i);
 	FREE_NULL_LIST(steps);
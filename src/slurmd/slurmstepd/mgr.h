@@ -78,6 +78,12 @@ void mgr_launch_batch_job_cleanup(stepd_step_rec_t *job, int rc);
  */
 int job_manager(stepd_step_rec_t *job);
 
+/*
+ * Load the plugins used by job_manager(). Done early by a slurmstepd
+ * waiting in the slurmd's pool so its launch does not pay for it.
+ */
+extern int mgr_load_plugins(void);
+
 /*
  * Register passwd entries so that we do not need to call initgroups(2)
  * frequently.
@@ -130,6 +130,8 @@ typedef struct {
 static pthread_mutex_t message_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t message_cond = PTHREAD_COND_INITIALIZER;
 static int message_connections = 0;
+static bool message_shutdown = false;
+static List idle_conn_list = NULL;	/* fds waiting for a request */
 static int msg_target_node_id = 0;
 
 /*
@@ -320,9 +322,21 @@ msg_thr_create(stepd_step_rec_t *job)
 static void _wait_for_connections(void)
 {
 	struct timespec ts = {0, 0};
-	int rc = 0;
+	ListIterator itr;
+	int rc = 0, *fd;
 
 	slurm_mutex_lock(&message_lock);
+	/*
+	 * slurmd keeps connections open between requests, end those waiting
+	 * for a request now rather than waiting for slurmd to close them
+	 */
+	message_shutdown = true;
+	if (idle_conn_list) {
+		itr = list_iterator_create(idle_conn_list);
+		while ((fd = list_next(itr)))
+			(void) shutdown(*fd, SHUT_RDWR);
+		list_iterator_destroy(itr);
+	}
 	ts.tv_sec = time(NULL) + STEPD_MESSAGE_COMP_WAIT;
 	while (message_connections > 0 && rc == 0)
 		rc = pthread_cond_timedwait(&message_cond, &message_lock, &ts);
@@ -330,6 +344,11 @@ static void _wait_for_connections(void)
 	slurm_mutex_unlock(&message_lock);
 }
 
+static int _find_ptr(void *x, void *key)
+{
+	return (x == key);
+}
+
 static void _decrement_message_connections(void)
 {
 	slurm_mutex_lock(&message_lock);
@@ -521,7 +540,23 @@ int _handle_request(int fd, stepd_step_rec_t *job, uid_t uid, pid_t remote_pid)
 	int req;
 
 	debug3("%s: entering", __func__);
-	if ((rc = read(fd, &req, sizeof(int))) != sizeof(int)) {
+	slurm_mutex_lock(&message_lock);
+	if (message_shutdown) {
+		slurm_mutex_unlock(&message_lock);
+		return -1;
+	}
+	if (!idle_conn_list)
+		idle_conn_list = list_create(NULL);
+	list_append(idle_conn_list, &fd);
+	slurm_mutex_unlock(&message_lock);
+
+	rc = read(fd, &req, sizeof(int));
+
+	slurm_mutex_lock(&message_lock);
+	list_delete_all(idle_conn_list, _find_ptr, &fd);
+	slurm_mutex_unlock(&message_lock);
+
+	if (rc != sizeof(int)) {
 		if (rc == 0) { /* EOF, normal */
 			return -1;
 		} else {
@@ -40,6 +40,7 @@
 
 #include "config.h"
 
+#include <poll.h>
 #include <signal.h>
 #include <stdlib.h>
 #include <sys/mman.h>
@@ -520,6 +521,7 @@ _init_from_slurmd(int sock, char **argv,
 	uint16_t port;
 	char buf[16];
 	uint32_t jobid = 0, stepid = 0;
+	struct pollfd pfd;
 
 	/* receive conf from slurmd */
 	if (!(conf = read_slurmd_conf_lite(sock)))
@@ -533,8 +535,22 @@ _init_from_slurmd(int sock, char **argv,
 	if (acct_gather_read_conf(sock) != SLURM_SUCCESS)
 		fatal("Failed to read acct_gather conf from slurmd");
 
+	/*
+	 * A slurmstepd from the slurmd's pool of idle slurmstepds waits here
+	 * for a step to launch, so load the plugins first. It is released
+	 * without a step by closing its stdin.
+	 */
+	pfd.fd = sock;
+	pfd.events = POLLIN;
+	if ((poll(&pfd, 1, 0) == 0) && (mgr_load_plugins() != SLURM_SUCCESS))
+		debug("%s: unable to load plugins in advance", __func__);
+
 	/* receive job type from slurmd */
-	safe_read(sock, &step_type, sizeof(int));
+	if ((len = read(sock, &step_type, sizeof(int))) == 0) {
+		debug("%s: released by slurmd", __func__);
+		exit(0);
+	} else if (len != sizeof(int))
+		goto rwfail;
 	debug3("step_type = %d", step_type);
 
 	/* receive reverse-tree info from slurmd */
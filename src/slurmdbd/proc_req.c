@@ -557,13 +557,27 @@ proc_req(void *conn, persist_msg_t *msg,
 		      slurmdbd_conn->conn->fd,
 		      slurmdbd_msg_type_2_str(msg->msg_type, 1));
 	else if (slurmdbd_conn->conn->rem_port
-		 && !slurmdbd_conf->commit_delay) {
+		 && !slurmdbd_conf->commit_delay
+		 && !slurmdbd_conn->mult_msg
+		 && (msg->msg_type != DBD_SEND_MULT_MSG)) {
 		/* If we are dealing with the slurmctld do the
 		   commit (SUCCESS or NOT) afterwards since we
 		   do transactions for performance reasons.
 		   (don't ever use autocommit with innodb)
 		*/
-		acct_storage_g_commit(slurmdbd_conn->db_conn, 1);
+		if ((acct_storage_g_commit(slurmdbd_conn->db_conn, 1) !=
+		     SLURM_SUCCESS) && (rc == SLURM_SUCCESS)) {
+			/* Not written, have the sender try it again */
+			comment = "Unable to commit to the database";
+			error("CONN:%u %s for %s", slurmdbd_conn->conn->fd,
+			      comment,
+			      slurmdbd_msg_type_2_str(msg->msg_type, 1));
+			rc = SLURM_ERROR;
+			free_buf(*out_buffer);
+			*out_buffer = slurm_persist_make_rc_msg(
+				slurmdbd_conn->conn, rc, comment,
+				msg->msg_type);
+		}
 	}
 
 	END_TIMER;
@@ -846,14 +860,18 @@ static int _add_tres(slurmdbd_conn_t *slurmdbd_conn,
 	rc = acct_storage_g_add_tres(slurmdbd_conn->db_conn, *uid,
 				     get_msg->my_list);
 
-	*out_buffer = slurm_persist_make_rc_msg(slurmdbd_conn->conn,
-						rc, comment, DBD_ADD_TRES);
-
 	/* This happens before the slurmctld registers and only when
 	   the slurmctld starts up.  So always commit, success or not.
 	   (don't ever use autocommit with innodb)
 	*/
-	acct_storage_g_commit(slurmdbd_conn->db_conn, 1);
+	if ((acct_storage_g_commit(slurmdbd_conn->db_conn, 1) !=
+	     SLURM_SUCCESS) && (rc == SLURM_SUCCESS)) {
+		comment = "Unable to commit to the database";
+		rc = SLURM_ERROR;
+	}
+
+	*out_buffer = slurm_persist_make_rc_msg(slurmdbd_conn->conn,
+						rc, comment, DBD_ADD_TRES);
 
 	return rc;
 }
@@ -3381,6 +3399,12 @@ static int   _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn,
 	}
 
 	list_msg.my_list = list_create(slurmdbd_free_buffer);
+	/*
+	 * Commit the whole batch once after the last message instead of
+	 * after each one so the database plugin can send the messages
+	 * together.
+	 */
+	slurmdbd_conn->mult_msg = true;
 	/* START_TIMER; */
 	itr = list_iterator_create(get_msg->my_list);
 	while ((req_buf = list_next(itr))) {
@@ -3404,6 +3428,23 @@ static int   _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn,
 			break;
 	}
 	list_iterator_destroy(itr);
+	slurmdbd_conn->mult_msg = false;
+
+	/*
+	 * The messages are only acknowledged once they are written, even
+	 * with CommitDelay. If the commit fails nothing is acknowledged and
+	 * the slurmctld sends them all again. The commit also fails if rows
+	 * queued by one message were lost while processing a later one.
+	 */
+	if (acct_storage_g_commit(slurmdbd_conn->db_conn, 1) != SLURM_SUCCESS) {
+		comment = "Unable to commit DBD_SEND_MULT_MSG to the database";
+		error("CONN:%u %s", slurmdbd_conn->conn->fd, comment);
+		FREE_NULL_LIST(list_msg.my_list);
+		*out_buffer = slurm_persist_make_rc_msg(slurmdbd_conn->conn,
+							SLURM_ERROR, comment,
+							DBD_SEND_MULT_MSG);
+		return SLURM_ERROR;
+	}
 	/* END_TIMER; */
 	/* info("%d multi took %s", list_count(get_msg->my_list), TIME_STR); */
 
@@ -48,7 +48,9 @@
 #include <termios.h>
 
 #include "src/common/read_config.h"
+#include "src/common/slurm_protocol_defs.h"
 #include "src/common/slurm_time.h"
+#include "src/common/xhash.h"
 #include "src/common/xstring.h"
 #include "src/squeue/squeue.h"
 
@@ -63,6 +65,8 @@ int max_line_size;
  *************/
 static int  _get_info(bool clear_old, bool log_cluster_name);
 static int  _get_window_width( void );
+static job_info_msg_t *_merge_job_delta(job_info_msg_t *old_msg,
+					job_info_msg_t *delta_msg);
 static int  _multi_cluster(List clusters);
 static int  _print_job(bool clear_old, bool log_cluster_name);
 static int  _print_job_steps( bool clear_old );
@@ -167,10 +171,78 @@ _get_window_width( void )
 }
 
 
+static void _job_info_id(void *item, const char **key, uint32_t *key_len)
+{
+	slurm_job_info_t *job_ptr = item;
+
+	*key = (const char *) &job_ptr->job_id;
+	*key_len = sizeof(uint32_t);
+}
+
+static void _job_id_id(void *item, const char **key, uint32_t *key_len)
+{
+	*key = (const char *) item;
+	*key_len = sizeof(uint32_t);
+}
+
+/*
+ * _merge_job_delta - apply a delta from slurm_load_jobs_delta() to the
+ *	previous job information
+ * IN old_msg - previous job information, freed here
+ * IN delta_msg - changed and removed jobs, freed here
+ * RET merged job information
+ */
+static job_info_msg_t *_merge_job_delta(job_info_msg_t *old_msg,
+					job_info_msg_t *delta_msg)
+{
+	xhash_t *changed, *removed;
+	slurm_job_info_t *job_array, *job_ptr;
+	uint32_t i, cnt = 0;
+
+	changed = xhash_init(_job_info_id, NULL);
+	for (i = 0; i < delta_msg->record_count; i++)
+		xhash_add(changed, &delta_msg->job_array[i]);
+	removed = xhash_init(_job_id_id, NULL);
+	for (i = 0; i < delta_msg->removed_job_count; i++)
+		xhash_add(removed, &delta_msg->removed_job_ids[i]);
+
+	job_array = xcalloc(old_msg->record_count + delta_msg->record_count,
+			    sizeof(slurm_job_info_t));
+	for (i = 0; i < old_msg->record_count; i++) {
+		job_ptr = &old_msg->job_array[i];
+		if (xhash_get(changed, (char *) &job_ptr->job_id,
+			      sizeof(uint32_t)) ||
+		    xhash_get(removed, (char *) &job_ptr->job_id,
+			      sizeof(uint32_t))) {
+			slurm_free_job_info_members(job_ptr);
+			continue;
+		}
+		job_array[cnt++] = *job_ptr;
+	}
+	for (i = 0; i < delta_msg->record_count; i++)
+		job_array[cnt++] = delta_msg->job_array[i];
+	xhash_free(changed);
+	xhash_free(removed);
+
+	xfree(delta_msg->job_array);
+	xfree(delta_msg->removed_job_ids);
+	delta_msg->removed_job_count = 0;
+	delta_msg->delta = 0;
+	delta_msg->job_array = job_array;
+	delta_msg->record_count = cnt;
+
+	xfree(old_msg->job_array);
+	old_msg->record_count = 0;
+	slurm_free_job_info_msg(old_msg);
+
+	return delta_msg;
+}
+
 /* _print_job - print the specified job's information */
 static int _print_job(bool clear_old, bool log_cluster_name)
 {
 	static job_info_msg_t *old_job_ptr;
+	static bool delta_ok = true;
 	job_info_msg_t *new_job_ptr = NULL;
 	int error_code;
 	uint16_t show_flags = 0;
@@ -202,11 +274,32 @@ static int _print_job(bool clear_old, bool log_cluster_name)
 		} else {
 			if (params.clusters)
 				show_flags |= SHOW_LOCAL;
-			error_code = slurm_load_jobs(
-				old_job_ptr->last_update,
-				&new_job_ptr, show_flags);
+			if (delta_ok && old_job_ptr->last_update &&
+			    !(show_flags & SHOW_FEDERATION)) {
+				error_code = slurm_load_jobs_delta(
+					old_job_ptr->last_update,
+					&new_job_ptr, show_flags);
+				/* slurmctld older than the delta RPC */
+				if (error_code &&
+				    ((slurm_get_errno() ==
+				      SLURM_PROTOCOL_VERSION_ERROR) ||
+				     (slurm_get_errno() ==
+				      SLURM_UNEXPECTED_MSG_ERROR))) {
+					delta_ok = false;
+					error_code = slurm_load_jobs(
+						old_job_ptr->last_update,
+						&new_job_ptr, show_flags);
+				}
+			} else {
+				error_code = slurm_load_jobs(
+					old_job_ptr->last_update,
+					&new_job_ptr, show_flags);
+			}
 		}
-		if (error_code ==  SLURM_SUCCESS)
+		if ((error_code == SLURM_SUCCESS) && new_job_ptr->delta)
+			new_job_ptr = _merge_job_delta(old_job_ptr,
+						       new_job_ptr);
+		else if (error_code ==  SLURM_SUCCESS)
 			slurm_free_job_info_msg( old_job_ptr );
 		else if (slurm_get_errno () == SLURM_NO_CHANGE_IN_DATA) {
 			error_code = SLURM_SUCCESS;
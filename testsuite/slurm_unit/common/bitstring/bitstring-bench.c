@@ -0,0 +1,77 @@
+/* Microbenchmark of the bulk operations in src/common/bitstring.c for each
+ * set of word kernels supported by this CPU.
+ * Usage: bitstring-bench [nbits] [iterations]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <src/common/bitstring.h>
+
+static double _now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec * 1e9) + ts.tv_nsec;
+}
+
+#define BENCH(_name, _op) do {						\
+	double _start = _now();						\
+	for (i = 0; i < iters; i++) {					\
+		_op;							\
+	}								\
+	printf("  %-20s %10.1f ns\n", _name, (_now() - _start) / iters); \
+} while (0)
+
+int
+main(int argc, char *argv[])
+{
+	const char *kernels[] = { "scalar", "avx2", "avx512" };
+	int nbits = (argc > 1) ? atoi(argv[1]) : 65536;
+	int iters = (argc > 2) ? atoi(argv[2]) : 100000;
+	bitstr_t *a, *b, *c;
+	volatile int sink = 0;
+	int i, k;
+
+	if ((nbits < 1) || (iters < 1)) {
+		fprintf(stderr, "Usage: %s [nbits] [iterations]\n", argv[0]);
+		return 1;
+	}
+
+	srand(1);
+	a = bit_alloc(nbits);
+	b = bit_alloc(nbits);
+	c = bit_alloc(nbits);
+	for (i = 0; i < nbits; i++) {
+		if (rand() & 1)
+			bit_set(a, i);
+		if (rand() & 1)
+			bit_set(b, i);
+	}
+	/* Keep the early exit tests from exiting early */
+	bit_nclear(a, 0, nbits / 2);
+	bit_copybits(c, a);
+	bit_or(c, b);
+
+	printf("%d bits, %d iterations\n", nbits, iters);
+	for (k = 0; k < 3; k++) {
+		if (!bit_kernels_select(kernels[k]))
+			continue;
+		printf("%s:\n", kernels[k]);
+		BENCH("bit_and", bit_and(c, b));
+		BENCH("bit_or", bit_or(c, a));
+		BENCH("bit_and_not", bit_and_not(c, a));
+		BENCH("bit_set_count", sink += bit_set_count(a));
+		BENCH("bit_overlap", sink += bit_overlap(a, b));
+		BENCH("bit_overlap_any", sink += bit_overlap_any(a, c));
+		BENCH("bit_and_not_count", sink += bit_and_not_count(a, b));
+		BENCH("bit_and_not_any", sink += bit_and_not_any(a, a));
+		BENCH("bit_super_set", sink += bit_super_set(a, a));
+		BENCH("bit_ffs", sink += bit_ffs(a));
+	}
+
+	bit_free(a);
+	bit_free(b);
+	bit_free(c);
+	return 0;
+}
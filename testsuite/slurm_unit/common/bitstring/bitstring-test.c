@@ -1,5 +1,6 @@
 /* Test of src/bitstring.c 
  */
+#include <stdbool.h>
 #include <stdlib.h>
 #include <src/common/bitstring.h>
 #include <sys/time.h>
@@ -21,6 +22,127 @@
 } while (0)
 
 
+/* Bitmap sizes covering partial words and each kernel's vector width */
+static const int kernel_sizes[] = { 1, 63, 64, 65, 255, 256, 257, 511, 512,
+				    513, 1000, 4099 };
+#define KERNEL_SIZE_CNT (sizeof(kernel_sizes) / sizeof(kernel_sizes[0]))
+
+static bitstr_t *_rand_bitmap(int nbits, int density)
+{
+	bitstr_t *b = bit_alloc(nbits);
+	int i;
+
+	for (i = 0; i < nbits; i++) {
+		if ((rand() % 100) < density)
+			bit_set(b, i);
+	}
+	return b;
+}
+
+/* Compare the bulk operations of the selected kernels to bit-by-bit results */
+static void _test_kernels(void)
+{
+	bool and_ok = true, and_not_ok = true, or_ok = true, or_not_ok = true;
+	bool count_ok = true, range_ok = true, overlap_ok = true;
+	bool overlap_any_ok = true, and_not_count_ok = true;
+	bool and_not_any_ok = true, super_ok = true, ffs_ok = true;
+	int d, i, n, bit, cnt, start, end;
+	int ref_and, ref_and_not, ref_ffs;
+	bitstr_t *a, *b, *c;
+
+	srand(1);
+	for (i = 0; i < (KERNEL_SIZE_CNT * 11); i++) {
+		n = kernel_sizes[i / 11];
+		d = (i % 11) * 10;	/* percent of bits set */
+		a = _rand_bitmap(n, d);
+		b = _rand_bitmap(n, 100 - d);
+		if (d == 50)	/* make a a subset of b */
+			bit_and(a, b);
+
+		ref_and = ref_and_not = cnt = 0;
+		ref_ffs = -1;
+		for (bit = 0; bit < n; bit++) {
+			if (bit_test(a, bit)) {
+				cnt++;
+				if (ref_ffs == -1)
+					ref_ffs = bit;
+				if (bit_test(b, bit))
+					ref_and++;
+				else
+					ref_and_not++;
+			}
+		}
+		if (bit_set_count(a) != cnt)
+			count_ok = false;
+		if (bit_ffs(a) != ref_ffs)
+			ffs_ok = false;
+		if (bit_overlap(a, b) != ref_and)
+			overlap_ok = false;
+		if (bit_overlap_any(a, b) != (ref_and != 0))
+			overlap_any_ok = false;
+		if (bit_and_not_count(a, b) != ref_and_not)
+			and_not_count_ok = false;
+		if (bit_and_not_any(a, b) != (ref_and_not != 0))
+			and_not_any_ok = false;
+		if (bit_super_set(a, b) != (ref_and_not == 0))
+			super_ok = false;
+
+		start = rand() % n;
+		end = start + (rand() % (n - start + 1));
+		cnt = 0;
+		for (bit = start; bit < end; bit++)
+			cnt += bit_test(a, bit);
+		if (bit_set_count_range(a, start, end) != cnt)
+			range_ok = false;
+
+		c = bit_copy(a);
+		bit_and(c, b);
+		for (bit = 0; bit < n; bit++) {
+			if (bit_test(c, bit) !=
+			    (bit_test(a, bit) && bit_test(b, bit)))
+				and_ok = false;
+		}
+		bit_copybits(c, a);
+		bit_and_not(c, b);
+		for (bit = 0; bit < n; bit++) {
+			if (bit_test(c, bit) !=
+			    (bit_test(a, bit) && !bit_test(b, bit)))
+				and_not_ok = false;
+		}
+		bit_copybits(c, a);
+		bit_or(c, b);
+		for (bit = 0; bit < n; bit++) {
+			if (bit_test(c, bit) !=
+			    (bit_test(a, bit) || bit_test(b, bit)))
+				or_ok = false;
+		}
+		bit_copybits(c, a);
+		bit_or_not(c, b);
+		for (bit = 0; bit < n; bit++) {
+			if (bit_test(c, bit) !=
+			    (bit_test(a, bit) || !bit_test(b, bit)))
+				or_not_ok = false;
+		}
+
+		bit_free(a);
+		bit_free(b);
+		bit_free(c);
+	}
+
+	TEST(and_ok, "bit_and");
+	TEST(and_not_ok, "bit_and_not");
+	TEST(or_ok, "bit_or");
+	TEST(or_not_ok, "bit_or_not");
+	TEST(count_ok, "bit_set_count");
+	TEST(range_ok, "bit_set_count_range");
+	TEST(overlap_ok, "bit_overlap");
+	TEST(overlap_any_ok, "bit_overlap_any");
+	TEST(and_not_count_ok, "bit_and_not_count");
+	TEST(and_not_any_ok, "bit_and_not_any");
+	TEST(super_ok, "bit_super_set");
+	TEST(ffs_ok, "bit_ffs");
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -207,6 +329,22 @@ main(int argc, char *argv[])
 		TEST(bit_equal(bs, bs2), "bitstring");
 	}
 
+	note("Testing bitstring kernels");
+	{
+		const char *kernels[] = { "scalar", "avx2", "avx512" };
+		int i;
+
+		for (i = 0; i < 3; i++) {
+			if (!bit_kernels_select(kernels[i])) {
+				note("%s kernels not supported", kernels[i]);
+				continue;
+			}
+			note("Testing %s kernels", kernels[i]);
+			_test_kernels();
+		}
+		bit_kernels_select(NULL);
+	}
+
 	totals();
 	return failed;
 }
@@ -0,0 +1,127 @@
+/* Microbenchmark of the range-native operations in src/common/hostlist.c
+ * on lists of a few ranges covering a large node table, with conversion to
+ * a bitmap one name at a time through a hash table for comparison.
+ * Usage: hostlist-bench [nodes] [iterations]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <src/common/bitstring.h>
+#include <src/common/hostlist.h>
+#include <src/common/xhash.h>
+#include <src/common/xmalloc.h>
+#include <src/common/xstring.h>
+
+static double _now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec * 1e9) + ts.tv_nsec;
+}
+
+#define BENCH(_name, _op) do {						\
+	double _start = _now();						\
+	for (i = 0; i < iters; i++) {					\
+		_op;							\
+	}								\
+	printf("  %-24s %12.1f ns\n", _name, (_now() - _start) / iters); \
+} while (0)
+
+typedef struct {
+	int inx;
+	char name[16];
+} node_t;
+
+static void _node_id(void *item, const char **key, uint32_t *key_len)
+{
+	*key = ((node_t *) item)->name;
+	*key_len = strlen(*key);
+}
+
+/* Convert hl to a bitmap by looking up every host name in a hash table */
+static void _hash_bitmap(xhash_t *hash, hostlist_t hl, bitstr_t *bitmap)
+{
+	hostlist_iterator_t itr = hostlist_iterator_create(hl);
+	node_t *node;
+	char *name;
+
+	while ((name = hostlist_next(itr))) {
+		if ((node = xhash_get_str(hash, name)))
+			bit_set(bitmap, node->inx);
+		free(name);
+	}
+	hostlist_iterator_destroy(itr);
+}
+
+int
+main(int argc, char *argv[])
+{
+	int nodes = (argc > 1) ? atoi(argv[1]) : 20000;
+	int iters = (argc > 2) ? atoi(argv[2]) : 100;
+	hostlist_t all, part1, part2, res;
+	hostlist_index_t idx;
+	xhash_t *hash;
+	bitstr_t *bitmap;
+	node_t *table;
+	char **names, *str = NULL;
+	volatile int sink = 0;
+	int i;
+
+	/* hostlist_create() accepts at most 64K hosts in a range */
+	if ((nodes < 4) || (nodes > 65536) || (iters < 1)) {
+		fprintf(stderr, "Usage: %s [nodes] [iterations]\n", argv[0]);
+		return 1;
+	}
+
+	table = xcalloc(nodes, sizeof(node_t));
+	names = xcalloc(nodes, sizeof(char *));
+	hash = xhash_init(_node_id, NULL);
+	for (i = 0; i < nodes; i++) {
+		table[i].inx = i;
+		snprintf(table[i].name, sizeof(table[i].name), "n%05d", i);
+		names[i] = table[i].name;
+		xhash_add(hash, &table[i]);
+	}
+	idx = hostlist_index_create(names, nodes);
+	bitmap = bit_alloc(nodes);
+
+	xstrfmtcat(str, "n[00000-%05d]", nodes - 1);
+	all = hostlist_create(str);
+	xfree(str);
+	xstrfmtcat(str, "n[00000-%05d,%05d-%05d]", nodes / 4, nodes / 2,
+		   (nodes * 3) / 4);
+	part1 = hostlist_create(str);
+	xfree(str);
+	xstrfmtcat(str, "n[%05d-%05d]", nodes / 8, (nodes * 5) / 8);
+	part2 = hostlist_create(str);
+
+	printf("%d nodes, %d iterations\n", nodes, iters);
+	BENCH("bitmap by name hash", _hash_bitmap(hash, all, bitmap));
+	BENCH("hostlist_index_bitmap",
+	      sink += hostlist_index_bitmap(idx, all, bitmap, NULL));
+	BENCH("hostlist_index_find",
+	      sink += hostlist_index_find(idx, names[i % nodes]));
+	BENCH("hostlist_find", sink += hostlist_find(part1, names[i % nodes]));
+	BENCH("hostlist_union",
+	      res = hostlist_union(part1, part2); hostlist_destroy(res));
+	BENCH("hostlist_intersection",
+	      res = hostlist_intersection(part1, part2); hostlist_destroy(res));
+	BENCH("hostlist_difference",
+	      res = hostlist_difference(all, part2); hostlist_destroy(res));
+	BENCH("hostlist_delete",
+	      res = hostlist_copy(all); sink += hostlist_delete(res, str);
+	      hostlist_destroy(res));
+
+	xfree(str);
+	hostlist_destroy(all);
+	hostlist_destroy(part1);
+	hostlist_destroy(part2);
+	hostlist_index_destroy(idx);
+	bit_free(bitmap);
+	xhash_free(hash);
+	xfree(names);
+	xfree(table);
+	return 0;
+}
@@ -0,0 +1,236 @@
+/* Test of the range-native operations in src/common/hostlist.c against
+ * results computed one host name at a time.
+ */
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <src/common/bitstring.h>
+#include <src/common/hostlist.h>
+#include <src/common/xmalloc.h>
+#include <src/common/xstring.h>
+
+#include <testsuite/dejagnu.h>
+
+/* Test for failure:
+*/
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+/* Prefixes covering zero padding, digits within and at the end of the
+ * prefix, and hosts without a numeric suffix */
+static const char *prefixes[] = { "n", "rack1-n", "nid0000", "tux" };
+#define PREFIX_CNT (sizeof(prefixes) / sizeof(prefixes[0]))
+
+static char *_rand_hosts(void)
+{
+	char *hosts = NULL, *sep = "";
+	int i, lo, cnt, width;
+
+	for (i = rand() % 12; i >= 0; i--) {
+		if ((rand() % 10) == 0) {
+			xstrfmtcat(hosts, "%slogin%c", sep, 'a' + (rand() % 3));
+		} else {
+			lo = rand() % 120;
+			cnt = rand() % 30;
+			width = rand() % 4;
+			xstrfmtcat(hosts, "%s%s[%0*d-%0*d]", sep,
+				   prefixes[rand() % PREFIX_CNT],
+				   width, lo, width, lo + cnt);
+		}
+		sep = ",";
+	}
+	return hosts;
+}
+
+static int _strcmp(const void *a, const void *b)
+{
+	return strcmp(*(char **) a, *(char **) b);
+}
+
+/* Expand hl into a sorted array of unique host names */
+static char **_names(hostlist_t hl, int *cnt)
+{
+	hostlist_iterator_t itr = hostlist_iterator_create(hl);
+	char **names = xcalloc(hostlist_count(hl) + 1, sizeof(char *));
+	char *name;
+	int i, n = 0;
+
+	while ((name = hostlist_next(itr)))
+		names[n++] = name;
+	hostlist_iterator_destroy(itr);
+
+	qsort(names, n, sizeof(char *), _strcmp);
+	for (i = 1, *cnt = n ? 1 : 0; i < n; i++) {
+		if (strcmp(names[i], names[*cnt - 1]))
+			names[(*cnt)++] = names[i];
+		else
+			free(names[i]);
+	}
+	return names;
+}
+
+static void _names_free(char **names, int cnt)
+{
+	int i;
+
+	for (i = 0; i < cnt; i++)
+		free(names[i]);
+	xfree(names);
+}
+
+static bool _in(char **names, int cnt, char *name)
+{
+	return bsearch(&name, names, cnt, sizeof(char *), _strcmp) != NULL;
+}
+
+/* Check the hosts of res against "op" of n1 and n2 computed by name */
+static bool _check(hostlist_t res, char **n1, int c1, char **n2, int c2,
+		   char op)
+{
+	char **nr, **ref = xcalloc(c1 + c2 + 1, sizeof(char *));
+	int i, cr, cnt = 0;
+	bool ok;
+
+	for (i = 0; i < c1; i++) {
+		if ((op == 'u') || ((op == 'i') == _in(n2, c2, n1[i])))
+			ref[cnt++] = n1[i];
+	}
+	for (i = 0; (op == 'u') && (i < c2); i++) {
+		if (!_in(n1, c1, n2[i]))
+			ref[cnt++] = n2[i];
+	}
+	qsort(ref, cnt, sizeof(char *), _strcmp);
+
+	nr = _names(res, &cr);
+	ok = (cr == cnt) && (hostlist_count(res) == cnt);
+	for (i = 0; ok && (i < cnt); i++)
+		ok = !strcmp(nr[i], ref[i]);
+	_names_free(nr, cr);
+	xfree(ref);
+	return ok;
+}
+
+static void _test_set_ops(void)
+{
+	bool union_ok = true, inter_ok = true, diff_ok = true;
+	bool within_ok = true, intersects_ok = true, delete_ok = true;
+	char *s1, *s2, **n1, **n2;
+	int c1, c2, cr, i, j, del;
+	hostlist_t hl1, hl2, res;
+	hostset_t hs;
+
+	srand(1);
+	for (i = 0; i < 500; i++) {
+		s1 = _rand_hosts();
+		s2 = _rand_hosts();
+		hl1 = hostlist_create(s1);
+		hl2 = hostlist_create(s2);
+		n1 = _names(hl1, &c1);
+		n2 = _names(hl2, &c2);
+
+		res = hostlist_union(hl1, hl2);
+		union_ok &= _check(res, n1, c1, n2, c2, 'u');
+		hostlist_destroy(res);
+		res = hostlist_intersection(hl1, hl2);
+		inter_ok &= _check(res, n1, c1, n2, c2, 'i');
+		hostlist_destroy(res);
+		res = hostlist_difference(hl1, hl2);
+		diff_ok &= _check(res, n1, c1, n2, c2, 'd');
+
+		hs = hostset_create(s1);
+		for (j = 0, cr = 0; j < c2; j++)
+			cr += _in(n1, c1, n2[j]);
+		intersects_ok &= (hostset_intersects(hs, s2) == (cr > 0));
+		within_ok &= (hostset_within(hs, s2) == (cr == c2));
+		hostset_destroy(hs);
+
+		/* Deleting from unique hosts leaves the difference */
+		hostlist_destroy(res);
+		res = hostlist_union(hl1, NULL);
+		del = hostlist_delete(res, s2);
+		delete_ok &= (del == (c1 - hostlist_count(res)));
+		delete_ok &= _check(res, n1, c1, n2, c2, 'd');
+		hostlist_destroy(res);
+
+		_names_free(n1, c1);
+		_names_free(n2, c2);
+		hostlist_destroy(hl1);
+		hostlist_destroy(hl2);
+		xfree(s1);
+		xfree(s2);
+	}
+
+	TEST(union_ok, "hostlist_union");
+	TEST(inter_ok, "hostlist_intersection");
+	TEST(diff_ok, "hostlist_difference");
+	TEST(intersects_ok, "hostset_intersects");
+	TEST(within_ok, "hostset_within");
+	TEST(delete_ok, "hostlist_delete");
+}
+
+static void _test_delete_order(void)
+{
+	hostlist_t hl = hostlist_create("b[1-10],a[1-5],b[3-4],a1");
+	char *str;
+	int n;
+
+	n = hostlist_delete(hl, "a[1-2],b[2-4],c7");
+	str = hostlist_ranged_string_xmalloc(hl);
+	TEST((n == 5) && !xstrcmp(str, "b[1,5-10],a[3-5],b[3-4],a1"),
+	     "hostlist_delete first occurrence in order");
+	xfree(str);
+	hostlist_destroy(hl);
+}
+
+static void _test_index(void)
+{
+	char *names[] = { "n07", "n08", "n09", "n10", "n11", "login", NULL,
+			  "n1", "n2", "nid00005", "n12", "rack1-n3" };
+	int cnt = sizeof(names) / sizeof(names[0]);
+	hostlist_index_t idx = hostlist_index_create(names, cnt);
+	hostlist_t hl, missing;
+	bitstr_t *bitmap = bit_alloc(cnt);
+	char *str;
+	bool find_ok = true;
+	int i, n;
+
+	for (i = 0; i < cnt; i++) {
+		if (names[i])
+			find_ok &= (hostlist_index_find(idx, names[i]) == i);
+	}
+	find_ok &= (hostlist_index_find(idx, "n7") == -1);
+	find_ok &= (hostlist_index_find(idx, "n007") == -1);
+	find_ok &= (hostlist_index_find(idx, "n13") == -1);
+	find_ok &= (hostlist_index_find(idx, "nid00005") == 9);
+	TEST(find_ok, "hostlist_index_find");
+
+	hl = hostlist_create("n[06-12],n[1-3],nid0000[4-5],login,rack1-n3");
+	missing = hostlist_create(NULL);
+	n = hostlist_index_bitmap(idx, hl, bitmap, missing);
+	str = hostlist_ranged_string_xmalloc(missing);
+	TEST((n == 3) && !xstrcmp(str, "n[06,3],nid00004") &&
+	     (bit_set_count(bitmap) == 11) && !bit_test(bitmap, 6),
+	     "hostlist_index_bitmap");
+	xfree(str);
+
+	hostlist_destroy(hl);
+	hostlist_destroy(missing);
+	bit_free(bitmap);
+	hostlist_index_destroy(idx);
+}
+
+int main(int argc, char *argv[])
+{
+	_test_set_ops();
+	_test_delete_order();
+	_test_index();
+
+	totals();
+	return failed;
+}
@@ -0,0 +1,273 @@
+/* Test of the slab caches and arenas in src/common/slab.c, and of xfree()
+ * and xrealloc() of the memory they hand out.
+ */
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <src/common/bitstring.h>
+#include <src/common/list.h>
+#include <src/common/pack.h>
+#include <src/common/slab.h>
+#include <src/common/slurm_protocol_common.h>
+#include <src/common/xmalloc.h>
+
+#include <testsuite/dejagnu.h>
+
+/* Test for failure:
+*/
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+#define OBJ_CNT 10000
+#define THREAD_CNT 8
+
+static slab_cache_t *cache = NULL;
+static char *objs[OBJ_CNT];
+
+static bool _zero(char *ptr, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < size; i++) {
+		if (ptr[i])
+			return false;
+	}
+	return true;
+}
+
+/* Free every other object allocated by the main thread, allocate and free
+ * some of our own and exit holding them in this thread's free list */
+static void *_thread(void *arg)
+{
+	long inx = (long) arg;
+	char *mine[64];
+	int i;
+
+	for (i = inx; i < OBJ_CNT; i += THREAD_CNT) {
+		if (i % 2)
+			xfree(objs[i]);
+	}
+	for (i = 0; i < 64; i++)
+		mine[i] = slab_alloc(cache);
+	for (i = 0; i < 64; i++)
+		xfree(mine[i]);
+	return NULL;
+}
+
+static void _test_slab(void)
+{
+	pthread_t threads[THREAD_CNT];
+	bool alloc_ok = true, distinct_ok = true;
+	char *p, *q;
+	long i;
+
+	cache = slab_cache_create("test", 40);
+	TEST(cache && (cache == slab_cache_create("test", 40)) &&
+	     (cache != slab_cache_create("test", 48)) &&
+	     (slab_cache_size(cache) == 40), "slab_cache_create");
+
+	for (i = 0; i < OBJ_CNT; i++) {
+		objs[i] = slab_alloc(cache);
+		alloc_ok &= _zero(objs[i], 40) && (xsize(objs[i]) == 40) &&
+			    !((unsigned long) objs[i] % 16);
+		memset(objs[i], 0xff, 40);
+		memcpy(objs[i], &i, sizeof(i));
+	}
+	TEST(alloc_ok, "slab_alloc zeroed and aligned");
+
+	for (i = 0; i < THREAD_CNT; i++)
+		pthread_create(&threads[i], NULL, _thread, (void *) i);
+	for (i = 0; i < THREAD_CNT; i++)
+		pthread_join(threads[i], NULL);
+
+	/* Objects freed by other threads are reused, live ones are not */
+	for (i = 1; i < OBJ_CNT; i += 2)
+		objs[i] = slab_alloc(cache);
+	for (i = 0; i < OBJ_CNT; i += 2)
+		distinct_ok &= !memcmp(objs[i], &i, sizeof(i)) &&
+			       (((unsigned char *) objs[i])[39] == 0xff);
+	TEST(distinct_ok, "slab objects freed by other threads");
+	for (i = 0; i < OBJ_CNT; i++)
+		xfree(objs[i]);
+	TEST(!objs[0], "xfree of slab object");
+
+	p = slab_alloc(cache);
+	memset(p, 0x5a, 40);
+	q = xrealloc(p, 4000);
+	TEST((xsize(q) == 4000) && (q[39] == 0x5a) && _zero(q + 40, 3960),
+	     "xrealloc of slab object");
+	xfree(q);
+}
+
+/* Return the kbytes of slabs held by caches of the given name, and the
+ * number of such caches in cache_cnt */
+static uint32_t _cache_kbytes(const char *name, int *cache_cnt)
+{
+	Buf buffer = init_buf(1024);
+	char **names = NULL;
+	uint32_t *sizes = NULL, *kbytes = NULL, cnt = 0, i, total = 0;
+
+	*cache_cnt = 0;
+	pack_slab_stats(buffer, SLURM_PROTOCOL_VERSION);
+	set_buf_offset(buffer, 0);
+	if ((unpackstr_array(&names, &cnt, buffer) != SLURM_SUCCESS) ||
+	    (unpack32_array(&sizes, &cnt, buffer) != SLURM_SUCCESS) ||
+	    (unpack32_array(&kbytes, &cnt, buffer) != SLURM_SUCCESS))
+		cnt = 0;
+	for (i = 0; i < cnt; i++) {
+		if (!strcmp(names[i], name)) {
+			(*cache_cnt)++;
+			total += kbytes[i];
+		}
+		xfree(names[i]);
+	}
+	xfree(names);
+	xfree(sizes);
+	xfree(kbytes);
+	free_buf(buffer);
+
+	return total;
+}
+
+/* Free the odd objects, leaving some in this thread's free list */
+static void *_retire_thread(void *arg)
+{
+	int i;
+
+	for (i = 1; i < OBJ_CNT; i += 2)
+		xfree(objs[i]);
+	return NULL;
+}
+
+static void _test_retire(void)
+{
+	slab_cache_t *retire;
+	pthread_t thread;
+	int i, cnt;
+	char *p;
+
+	retire = slab_cache_create("retire", 100);
+	for (i = 0; i < OBJ_CNT; i++)
+		objs[i] = slab_alloc(retire);
+	pthread_create(&thread, NULL, _retire_thread, NULL);
+	pthread_join(thread, NULL);
+
+	slab_cache_retire(retire);
+	TEST(_cache_kbytes("retire", &cnt) && (cnt == 1),
+	     "retired cache kept while in use");
+	/* Freed and allocated again, nothing is kept */
+	p = slab_alloc(retire);
+	xfree(p);
+	for (i = 0; i < OBJ_CNT; i += 2)
+		xfree(objs[i]);
+	TEST(!_cache_kbytes("retire", &cnt) && (cnt == 1),
+	     "retired cache released once drained");
+
+	TEST(slab_cache_create("retire", 100) == retire,
+	     "retired cache taken back");
+	p = slab_alloc(retire);
+	TEST(_cache_kbytes("retire", &cnt), "slab_alloc after retire");
+	xfree(p);
+}
+
+static void _test_arena(void)
+{
+	arena_t *arena = arena_create(), *prev;
+	char *a, *b, *c, *big;
+	bool arena_ok;
+	int i;
+
+	a = arena_alloc(100);
+	TEST(a && (xsize(a) == 100), "arena_alloc without arena");
+	xfree(a);
+
+	prev = arena_swap(arena);
+	TEST(!prev, "arena_swap");
+	a = arena_alloc(100);
+	b = arena_alloc(200);
+	memset(b, 1, 200);
+	arena_ok = (b > a) && ((b - a) < 200) && (xsize(b) == 200);
+	/* The last allocation grows in place and is reclaimed by xfree() */
+	c = b;
+	xrealloc(b, 1000);
+	arena_ok &= (b == c) && (b[199] == 1) && _zero(b + 200, 800);
+	xfree(b);
+	b = arena_alloc(10);
+	arena_ok &= (b == c);
+	TEST(arena_ok, "arena_alloc from arena");
+
+	/* Fill more than one block, large requests use xmalloc() */
+	for (i = 0; i < 100; i++)
+		memset(arena_alloc(4000), 0, 4000);
+	big = arena_alloc(1024 * 1024);
+	memset(big, 0, 1024 * 1024);
+	xrealloc(a, 100000);
+	TEST(xsize(a) == 100000, "xrealloc of arena memory");
+	xfree(a);
+	xfree(big);
+
+	arena_swap(prev);
+	arena_destroy(arena);
+}
+
+/* Lists, iterators and bitmaps are allocated from slab caches */
+static void _test_users(void)
+{
+	List l = list_create(xfree_ptr);
+	ListIterator itr;
+	bitstr_t *b1, *b2;
+	int i, cnt = 0;
+
+	for (i = 0; i < 1000; i++)
+		list_append(l, xmalloc(8));
+	itr = list_iterator_create(l);
+	while (list_next(itr)) {
+		if (cnt++ % 2)
+			list_delete_item(itr);
+	}
+	list_iterator_destroy(itr);
+	TEST(list_count(l) == 500, "list with slab nodes");
+	FREE_NULL_LIST(l);
+
+	bit_cache_size(1000);
+	bit_cache_size(1000);
+	_cache_kbytes("bitstr", &cnt);
+	TEST(cnt == 1, "bit_cache_size of the same size");
+	b1 = bit_alloc(1000);
+	bit_nset(b1, 10, 900);
+	b2 = bit_copy(b1);
+	b2 = bit_realloc(b2, 5000);
+	bit_set(b2, 4999);
+	TEST((bit_set_count(b1) == 891) && (bit_set_count(b2) == 892),
+	     "bitmaps from slab cache");
+	FREE_NULL_BITMAP(b2);
+
+	/* The cache of the old size is released once its bitmaps are freed */
+	bit_cache_size(2000);
+	b2 = bit_alloc(2000);
+	TEST(_cache_kbytes("bitstr", &cnt) && (cnt == 2),
+	     "bit_cache_size of a new size");
+	FREE_NULL_BITMAP(b1);
+	FREE_NULL_BITMAP(b2);
+	bit_cache_size(3000);
+	TEST(!_cache_kbytes("bitstr", &cnt) && (cnt == 3),
+	     "old bitmap caches released");
+}
+
+int main(int argc, char *argv[])
+{
+	slab_enable();
+	_test_slab();
+	_test_retire();
+	_test_arena();
+	_test_users();
+
+	totals();
+	return failed;
+}